@@ -0,0 +1,108 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& fileName) :
+	begin(NULL),
+	byteCount(0),
+	fileHandle(INVALID_HANDLE_VALUE),
+	mappingHandle(NULL)
+{
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("could not open \"" + fileName + "\" for mapping");
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize)) {
+		CloseHandle(fileHandle);
+		throw std::runtime_error("could not get the size of \"" + fileName + "\"");
+	}
+	byteCount = static_cast<size_t>(fileSize.QuadPart);
+	if (byteCount == 0) {
+		return;	// empty files can't be mapped
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle != NULL) {
+		begin = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (begin == NULL) {
+		if (mappingHandle != NULL) {
+			CloseHandle(mappingHandle);
+		}
+		CloseHandle(fileHandle);
+		throw std::runtime_error("could not map \"" + fileName + "\" into memory");
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (begin != NULL) {
+		UnmapViewOfFile(begin);
+	}
+	if (mappingHandle != NULL) {
+		CloseHandle(mappingHandle);
+	}
+	CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& fileName) :
+	begin(NULL),
+	byteCount(0),
+	fileDescriptor(-1)
+{
+	fileDescriptor = open(fileName.c_str(), O_RDONLY);
+	if (fileDescriptor == -1) {
+		throw std::runtime_error("could not open \"" + fileName + "\" for mapping");
+	}
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0) {
+		close(fileDescriptor);
+		throw std::runtime_error("could not get the size of \"" + fileName + "\"");
+	}
+	byteCount = static_cast<size_t>(fileStatus.st_size);
+	if (byteCount == 0) {
+		return;	// empty files can't be mapped
+	}
+	void* mapped = mmap(NULL, byteCount, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapped == MAP_FAILED) {
+		close(fileDescriptor);
+		throw std::runtime_error("could not map \"" + fileName + "\" into memory");
+	}
+	begin = static_cast<const char*>(mapped);
+}
+
+MappedFile::~MappedFile()
+{
+	if (begin != NULL) {
+		munmap(const_cast<char*>(begin), byteCount);
+	}
+	close(fileDescriptor);
+}
+
+#endif
+
+const char* MappedFile::data() const
+{
+	return begin;
+}
+
+size_t MappedFile::size() const
+{
+	return byteCount;
+}
@@ -0,0 +1,35 @@
+#ifndef MappedFile_hpp
+#define MappedFile_hpp
+
+/*
+A read-only view of a whole file mapped into memory.
+The operating system pages the file in on demand, so opening even a large file is cheap and nothing is copied until the data is used.
+The pointer returned by data() is valid as long as the MappedFile object exists.
+*/
+
+#include <string>
+#include <cstddef>
+
+class MappedFile {
+public:
+	MappedFile(const std::string& fileName);
+	~MappedFile();
+
+	const char* data() const;
+	size_t size() const;	// in bytes
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const char* begin;
+	size_t byteCount;
+#if defined(_WIN32)
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
+
+#endif
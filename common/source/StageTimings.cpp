@@ -0,0 +1,347 @@
+#include "StageTimings.hpp"
+#include "allocationCount.hpp"
+#include "system.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// the histogram covers wall times from 100 ns to 100000 s
+const double histogramMinWallTime = 1e-7;
+const size_t histogramBinsPerDecade = 50;
+const size_t histogramBinCount = 12 * histogramBinsPerDecade + 2;	// plus one bin each for shorter and longer times
+
+StageSample::StageSample() :
+	wallTime(0),
+	cpuTime(0),
+	allocationCount(0),
+	peakResidentSetGrowth(0),
+	itemCount(0)
+{
+}
+
+StageTimings::Stage::Stage() :
+	callCount(0),
+	total(),
+	firstStartTime(0),
+	minWallTime(0),
+	maxWallTime(0),
+	histogram(histogramBinCount, 0)
+{
+}
+
+StageTimings::StageTimings() :
+	clock(),
+	mutex(),
+	stageNames(),
+	stageIndices(),
+	stages(),
+	info(),
+	tracing(false),
+	traceEvents(),
+	threadIndices(),
+	scopes()
+{
+	clock.start();
+}
+
+void StageTimings::add(const std::string& stage, const StageSample& sample, Duration startTime)
+{
+	boost::mutex::scoped_lock lock(mutex);
+	std::map<std::string, size_t>::iterator indexIter = stageIndices.find(stage);
+	if (indexIter == stageIndices.end()) {
+		indexIter = stageIndices.insert(std::make_pair(stage, stages.size())).first;
+		stageNames.push_back(stage);
+		stages.push_back(Stage());
+		stages.back().firstStartTime = startTime;
+		stages.back().minWallTime = sample.wallTime;
+		stages.back().maxWallTime = sample.wallTime;
+	}
+	Stage& thisStage = stages[indexIter->second];
+	++thisStage.callCount;
+	thisStage.total.wallTime += sample.wallTime;
+	thisStage.total.cpuTime += sample.cpuTime;
+	thisStage.total.allocationCount += sample.allocationCount;
+	thisStage.total.peakResidentSetGrowth += sample.peakResidentSetGrowth;
+	thisStage.total.itemCount += sample.itemCount;
+	thisStage.firstStartTime = std::min(thisStage.firstStartTime, startTime);
+	thisStage.minWallTime = std::min(thisStage.minWallTime, sample.wallTime);
+	thisStage.maxWallTime = std::max(thisStage.maxWallTime, sample.wallTime);
+	++thisStage.histogram[getHistogramBin(sample.wallTime)];
+
+	if (tracing) {
+		std::map<boost::thread::id, size_t>::iterator threadIter = threadIndices.find(boost::this_thread::get_id());
+		if (threadIter == threadIndices.end()) {
+			threadIter = threadIndices.insert(std::make_pair(boost::this_thread::get_id(), threadIndices.size())).first;
+		}
+		TraceEvent event;
+		event.stageIndex = indexIter->second;
+		event.threadIndex = threadIter->second;
+		event.startTime = startTime;
+		event.wallTime = sample.wallTime;
+		traceEvents.push_back(event);
+	}
+}
+
+void StageTimings::setInfo(const std::string& key, const std::string& value)
+{
+	boost::mutex::scoped_lock lock(mutex);
+	info.push_back(std::make_pair(key, value));
+}
+
+void StageTimings::enableTrace()
+{
+	boost::mutex::scoped_lock lock(mutex);
+	tracing = true;
+}
+
+Duration StageTimings::now() const
+{
+	return clock.read();
+}
+
+std::string jsonString(const std::string& text)
+{
+	std::string ret("\"");
+	for (std::string::const_iterator iter = text.begin(); iter != text.end(); ++iter) {
+		const unsigned char character = *iter;
+		if (character == '"' || character == '\\') {
+			ret += '\\';
+			ret += character;
+		} else if (character < 0x20) {
+			char escaped[8];
+			std::sprintf(escaped, "\\u%04x", character);
+			ret += escaped;
+		} else {
+			ret += character;
+		}
+	}
+	return ret + "\"";
+}
+
+// whether one of the components of path is in scopes
+bool isInScopes(const std::string& path, const std::vector<std::string>& scopes)
+{
+	size_t begin = 0;
+	while (begin <= path.size()) {
+		size_t end = std::min(path.find('/', begin), path.size());
+		if (std::find(scopes.begin(), scopes.end(), path.substr(begin, end - begin)) != scopes.end()) {
+			return true;
+		}
+		begin = end + 1;
+	}
+	return false;
+}
+
+// the order in which writeJson lists the stages
+class FirstStartedBefore {
+public:
+	FirstStartedBefore(const std::vector<Duration>& firstStartTimes) :
+		firstStartTimes(firstStartTimes)
+	{
+	}
+
+	bool operator()(size_t left, size_t right) const
+	{
+		return firstStartTimes[left] < firstStartTimes[right] || (firstStartTimes[left] == firstStartTimes[right] && left < right);
+	}
+
+private:
+	const std::vector<Duration>& firstStartTimes;
+};
+
+void StageTimings::writeJson(std::ostream& out, const std::vector<std::string>& excludedScopes) const
+{
+	boost::mutex::scoped_lock lock(mutex);
+	std::streamsize oldPrecision = out.precision(9);
+	out << "{\n";
+	out << "\t\"info\": {";
+	for (size_t infoNumber = 0; infoNumber != info.size(); ++infoNumber) {
+		out << (infoNumber ? ",\n" : "\n") << "\t\t" << jsonString(info[infoNumber].first) << ": " << jsonString(info[infoNumber].second);
+	}
+	out << (info.empty() ? "\n" : ",\n") << "\t\t\"seconds\": " << now();
+	out << ",\n\t\t\"peakResidentSetBytes\": " << getPeakResidentSetSize();
+	out << "\n\t},\n";
+
+	// a scope is added when it ends, i.e. after the stages nested in it, but it starts before them
+	std::vector<Duration> firstStartTimes;
+	std::vector<size_t> order;
+	for (size_t stageIndex = 0; stageIndex != stages.size(); ++stageIndex) {
+		firstStartTimes.push_back(stages[stageIndex].firstStartTime);
+		if (!isInScopes(stageNames[stageIndex], excludedScopes)) {
+			order.push_back(stageIndex);
+		}
+	}
+	std::sort(order.begin(), order.end(), FirstStartedBefore(firstStartTimes));
+
+	out << "\t\"stages\": [";
+	for (size_t orderNumber = 0; orderNumber != order.size(); ++orderNumber) {
+		const std::string& name = stageNames[order[orderNumber]];
+		const Stage& stage = stages[order[orderNumber]];
+		const size_t slash = name.rfind('/');
+		out << (orderNumber ? ",\n" : "\n") << "\t\t{";
+		out << "\"name\": " << jsonString(name);
+		out << ", \"parent\": " << (slash == std::string::npos ? "null" : jsonString(name.substr(0, slash)));
+		out << ", \"calls\": " << stage.callCount;
+		out << ", \"items\": " << stage.total.itemCount;
+		out << ", \"seconds\": " << stage.total.wallTime;
+		out << ", \"cpuSeconds\": " << stage.total.cpuTime;
+		out << ", \"itemsPerSecond\": ";
+		if (stage.total.wallTime > 0) {
+			out << stage.total.itemCount / stage.total.wallTime;
+		} else {
+			out << "null";
+		}
+		out << ", \"minSeconds\": " << stage.minWallTime;
+		out << ", \"p50Seconds\": " << getPercentile(stage, 0.5);
+		out << ", \"p99Seconds\": " << getPercentile(stage, 0.99);
+		out << ", \"maxSeconds\": " << stage.maxWallTime;
+		out << ", \"peakResidentSetGrowthBytes\": " << stage.total.peakResidentSetGrowth;
+		out << ", \"allocationsPerItem\": ";
+		if (countsAllocations() && stage.total.itemCount) {
+			out << static_cast<double>(stage.total.allocationCount) / stage.total.itemCount;
+		} else {
+			out << "null";
+		}
+		out << "}";
+	}
+	out << (order.empty() ? "]\n" : "\n\t]\n");
+	out << "}\n";
+	out.precision(oldPrecision);
+}
+
+void StageTimings::writeChromeTrace(std::ostream& out) const
+{
+	boost::mutex::scoped_lock lock(mutex);
+	std::streamsize oldPrecision = out.precision(15);
+	out << "{\"traceEvents\": [";
+	for (size_t eventNumber = 0; eventNumber != traceEvents.size(); ++eventNumber) {
+		const TraceEvent& event = traceEvents[eventNumber];
+		out << (eventNumber ? ",\n" : "\n");
+		out << "{\"name\": " << jsonString(stageNames[event.stageIndex]) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.threadIndex;
+		out << ", \"ts\": " << event.startTime * 1e6 << ", \"dur\": " << event.wallTime * 1e6 << "}";	// in microseconds
+	}
+	out << "\n], \"displayTimeUnit\": \"ms\"}\n";
+	out.precision(oldPrecision);
+}
+
+std::string StageTimings::getPath(const std::string& stage) const
+{
+	const std::vector<std::string>* threadScopes = scopes.get();
+	if (!threadScopes || threadScopes->empty()) {
+		return stage;
+	}
+	return threadScopes->back() + "/" + stage;
+}
+
+void StageTimings::pushScope(const std::string& stage)
+{
+	if (!scopes.get()) {
+		scopes.reset(new std::vector<std::string>());
+	}
+	const std::string path = getPath(stage);
+	scopes->push_back(path);
+}
+
+void StageTimings::popScope()
+{
+	scopes->pop_back();
+}
+
+size_t StageTimings::getHistogramBin(Duration wallTime)
+{
+	if (!(wallTime >= histogramMinWallTime)) {
+		return 0;
+	}
+	const size_t bin = 1 + static_cast<size_t>(std::log10(wallTime / histogramMinWallTime) * histogramBinsPerDecade);
+	return std::min(bin, histogramBinCount - 1);
+}
+
+Duration StageTimings::getHistogramBinCenter(size_t bin)
+{
+	return histogramMinWallTime * std::pow(10.0, (bin - 0.5) / histogramBinsPerDecade);
+}
+
+// nearest-rank percentile, taken as the center of the histogram bin it falls into
+Duration StageTimings::getPercentile(const Stage& stage, double fraction)
+{
+	if (stage.callCount == 0) {
+		return 0;
+	}
+	const size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(fraction * stage.callCount)));
+	size_t callCount = 0;
+	for (size_t bin = 0; bin != stage.histogram.size(); ++bin) {
+		callCount += stage.histogram[bin];
+		if (callCount >= rank) {
+			if (bin == 0 || bin + 1 == stage.histogram.size()) {
+				return (bin == 0) ? stage.minWallTime : stage.maxWallTime;
+			}
+			return std::min(std::max(getHistogramBinCenter(bin), stage.minWallTime), stage.maxWallTime);
+		}
+	}
+	return stage.maxWallTime;
+}
+
+StageTimer::StageTimer(StageTimings* timings) :
+	timings(timings),
+	stopwatch(),
+	startTime(0),
+	cpuTime(0),
+	allocationCount(0),
+	peakResidentSetSize(0)
+{
+	start();
+}
+
+void StageTimer::start()
+{
+	if (!timings) {
+		return;
+	}
+	startTime = timings->now();
+	cpuTime = getThreadCpuTime();
+	allocationCount = getAllocationCount();
+	peakResidentSetSize = getPeakResidentSetSize();
+	stopwatch.set();
+	stopwatch.start();
+}
+
+void StageTimer::lap(const std::string& stage, size_t itemCount)
+{
+	if (!timings) {
+		return;
+	}
+	stopwatch.stop();
+	StageSample sample;
+	sample.wallTime = stopwatch.read();
+	sample.cpuTime = getThreadCpuTime() - cpuTime;
+	sample.allocationCount = getAllocationCount() - allocationCount;
+	sample.peakResidentSetGrowth = getPeakResidentSetSize() - peakResidentSetSize;
+	sample.itemCount = itemCount;
+	timings->add(timings->getPath(stage), sample, startTime);
+	start();	// doesn't count the time and allocations of add()
+}
+
+StageScope::StageScope(StageTimings* timings, const std::string& stage, size_t itemCount) :
+	timer(timings),
+	timings(timings),
+	stage(stage),
+	itemCount(itemCount)
+{
+	if (timings) {
+		timings->pushScope(stage);
+	}
+}
+
+StageScope::~StageScope()
+{
+	end();
+}
+
+void StageScope::end()
+{
+	if (timings) {
+		timings->popScope();
+		timer.lap(stage, itemCount);
+		timings = NULL;
+	}
+}
@@ -0,0 +1,131 @@
+#ifndef StageTimings_hpp
+#define StageTimings_hpp
+
+/*
+StageTimings profiles the stages of a program and writes the results as JSON, so the results of different builds can be compared.
+For each stage it records:
+- the number of calls and the total wall time
+- the throughput in items (e.g. frames) per second
+- the median and 99th percentile of the wall time of a call, from a histogram with 50 bins per decade, i.e. accurate to about 2%
+- the CPU time of the thread running the stage, which doesn't include work the stage hands to other threads
+- how much the peak resident set size of the process grew while the stage ran
+- the allocations per item if the build counts them (see allocationCount.hpp)
+Samples can be added from several threads at once.
+With enableTrace(), every call is also kept as an event for writeChromeTrace(), which chrome://tracing and Perfetto show as a timeline.
+
+Stages are named by paths like "postprocess/arena 01/solveOcclusions".
+A StageScope times the block it lives in, or until end(), as one stage, and the stages started on the same thread while it exists are nested below it.
+A StageTimer measures consecutive stages of the same code, like laps: each call to lap() adds the time since the previous lap, or since construction, to the given stage.
+*/
+
+#include "Stopwatch.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/thread/thread.hpp>
+
+struct StageSample {
+	StageSample();
+
+	Duration wallTime;
+	Duration cpuTime;
+	size_t allocationCount;
+	size_t peakResidentSetGrowth;	// in bytes
+	size_t itemCount;
+};
+
+class StageTimings {
+public:
+	StageTimings();
+
+	void add(const std::string& stage, const StageSample& sample, Duration startTime);	// stage is a full path; startTime as returned by now()
+	void setInfo(const std::string& key, const std::string& value);	// written along with the stages, e.g. the video and the number of threads
+	void enableTrace();
+	Duration now() const;	// the time since construction
+
+	// the stages in the order they were first started, each with the path of its parent
+	// stages with one of excludedScopes in their path are left out, e.g. the other arenas when writing the profile of one arena
+	void writeJson(std::ostream& out, const std::vector<std::string>& excludedScopes = std::vector<std::string>()) const;
+	void writeChromeTrace(std::ostream& out) const;
+
+	std::string getPath(const std::string& stage) const;	// stage, nested in the scopes open on the calling thread
+
+private:
+	StageTimings(const StageTimings&);	// not copyable
+	StageTimings& operator=(const StageTimings&);
+
+	friend class StageScope;
+	void pushScope(const std::string& stage);
+	void popScope();
+
+	struct Stage {
+		Stage();
+		size_t callCount;
+		StageSample total;
+		Duration firstStartTime;
+		Duration minWallTime;
+		Duration maxWallTime;
+		std::vector<size_t> histogram;	// call counts of logarithmically spaced wall times
+	};
+
+	struct TraceEvent {
+		size_t stageIndex;
+		size_t threadIndex;
+		Duration startTime;
+		Duration wallTime;
+	};
+
+	static size_t getHistogramBin(Duration wallTime);
+	static Duration getHistogramBinCenter(size_t bin);
+	static Duration getPercentile(const Stage& stage, double fraction);
+
+	Stopwatch clock;
+	mutable boost::mutex mutex;
+	std::vector<std::string> stageNames;	// in the order they were first added
+	std::map<std::string, size_t> stageIndices;
+	std::vector<Stage> stages;
+	std::vector<std::pair<std::string, std::string> > info;
+	bool tracing;
+	std::vector<TraceEvent> traceEvents;
+	std::map<boost::thread::id, size_t> threadIndices;
+	boost::thread_specific_ptr<std::vector<std::string> > scopes;	// the paths of the open scopes of each thread
+};
+
+class StageTimer {
+public:
+	explicit StageTimer(StageTimings* timings);	// does nothing if timings is NULL
+
+	void lap(const std::string& stage, size_t itemCount = 1);
+
+private:
+	void start();
+
+	StageTimings* timings;
+	Stopwatch stopwatch;
+	Duration startTime;
+	Duration cpuTime;
+	size_t allocationCount;
+	size_t peakResidentSetSize;
+};
+
+class StageScope {
+public:
+	StageScope(StageTimings* timings, const std::string& stage, size_t itemCount = 1);	// does nothing if timings is NULL
+	~StageScope();
+
+	void end();	// ends the stage before the scope does, e.g. to write the timings including it
+
+private:
+	StageScope(const StageScope&);	// not copyable
+	StageScope& operator=(const StageScope&);
+
+	StageTimer timer;
+	StageTimings* timings;
+	std::string stage;
+	size_t itemCount;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "ThreadPool.hpp"
+#include <stdexcept>
+#include <boost/bind.hpp>
+
+ThreadPool::ThreadPool(size_t threadCount) :
+	threadCount(threadCount),
+	taskCount(0),
+	nextTask(0),
+	unfinishedTasks(0),
+	batch(0),
+	stopping(false),
+	failed(false)
+{
+	// the calling thread works on tasks as well, so we need one thread less than requested
+	for (size_t threadNumber = 1; threadNumber < threadCount; ++threadNumber) {
+		threads.create_thread(boost::bind(&ThreadPool::work, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		stopping = true;
+	}
+	tasksAvailable.notify_all();
+	threads.join_all();
+}
+
+size_t ThreadPool::getThreadCount() const
+{
+	return threadCount;
+}
+
+void ThreadPool::run(const boost::function<void (size_t)>& newTask, size_t newTaskCount)
+{
+	if (threads.size() == 0) {
+		for (size_t taskNumber = 0; taskNumber != newTaskCount; ++taskNumber) {
+			newTask(taskNumber);
+		}
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		task = newTask;
+		taskCount = newTaskCount;
+		nextTask = 0;
+		unfinishedTasks = newTaskCount;
+		failed = false;
+		firstError.clear();
+		++batch;
+	}
+	tasksAvailable.notify_all();
+
+	processTasks();
+
+	boost::mutex::scoped_lock lock(mutex);
+	while (unfinishedTasks != 0) {
+		tasksFinished.wait(lock);
+	}
+	task.clear();
+	if (failed) {
+		throw std::runtime_error(firstError);
+	}
+}
+
+size_t ThreadPool::getHardwareConcurrency()
+{
+	size_t concurrency = boost::thread::hardware_concurrency();
+	return concurrency ? concurrency : 1;	// 0 means the information is not available
+}
+
+void ThreadPool::work()
+{
+	size_t lastBatch = 0;
+	while (true) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			while (!stopping && batch == lastBatch) {
+				tasksAvailable.wait(lock);
+			}
+			if (stopping) {
+				return;
+			}
+			lastBatch = batch;
+		}
+		processTasks();
+	}
+}
+
+void ThreadPool::processTasks()
+{
+	while (true) {
+		size_t taskNumber;
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			if (nextTask == taskCount) {
+				return;
+			}
+			taskNumber = nextTask++;
+		}
+
+		std::string error;
+		try {
+			task(taskNumber);
+		} catch (const std::exception& e) {
+			error = e.what();
+			if (error.empty()) {
+				error = "unknown error";
+			}
+		} catch (...) {
+			error = "unknown exception";
+		}
+
+		boost::mutex::scoped_lock lock(mutex);
+		if (!error.empty() && !failed) {
+			failed = true;
+			firstError = error;
+		}
+		if (--unfinishedTasks == 0) {
+			tasksFinished.notify_all();
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+/*
+A ThreadPool keeps a fixed set of worker threads alive and uses them to call task(i) for every i in [0, taskCount).
+run() blocks until all tasks have finished, so it can be used like a parallel for loop; the calling thread works on tasks as well.
+With a thread count of 0 or 1 the tasks are run sequentially on the calling thread and no threads are created.
+If a task throws, the remaining tasks are still run and the first error is rethrown from run() as a std::runtime_error.
+*/
+
+#include <string>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t threadCount);
+	~ThreadPool();
+
+	size_t getThreadCount() const;
+	void run(const boost::function<void (size_t)>& task, size_t taskCount);
+
+	static size_t getHardwareConcurrency();
+
+private:
+	ThreadPool(const ThreadPool&);	// not copyable
+	ThreadPool& operator=(const ThreadPool&);
+
+	void work();
+	void processTasks();
+
+	size_t threadCount;
+	boost::thread_group threads;
+	boost::mutex mutex;
+	boost::condition_variable tasksAvailable;
+	boost::condition_variable tasksFinished;
+
+	// the current batch of tasks, guarded by mutex (task itself is only written while no tasks are running)
+	boost::function<void (size_t)> task;
+	size_t taskCount;
+	size_t nextTask;
+	size_t unfinishedTasks;
+	size_t batch;	// incremented for each call to run() so sleeping workers know there's new work
+	bool stopping;
+	bool failed;
+	std::string firstError;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "allocationCount.hpp"
+
+#if defined(MATEBOOK_COUNT_ALLOCATIONS)
+
+#include <new>
+#include <cstdlib>
+#include <boost/detail/atomic_count.hpp>
+
+boost::detail::atomic_count operatorNewCallCount(0);
+
+void* operator new(std::size_t size) throw(std::bad_alloc)
+{
+	++operatorNewCallCount;
+	void* memory = std::malloc(size ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size) throw(std::bad_alloc)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) throw()
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+	std::free(memory);
+}
+
+bool countsAllocations()
+{
+	return true;
+}
+
+size_t getAllocationCount()
+{
+	return static_cast<size_t>(static_cast<long>(operatorNewCallCount));
+}
+
+#else
+
+bool countsAllocations()
+{
+	return false;
+}
+
+size_t getAllocationCount()
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef allocationCount_hpp
+#define allocationCount_hpp
+
+#include <cstddef>
+
+/*
+When compiled with MATEBOOK_COUNT_ALLOCATIONS, allocationCount.cpp replaces the global operator new and counts every call, from all threads.
+Memory OpenCV allocates for its images doesn't go through operator new and isn't counted.
+*/
+
+bool countsAllocations();	// whether this build counts allocations at all
+size_t getAllocationCount();	// the number of calls to operator new so far, or 0 if allocations aren't counted
+
+#endif
@@ -39,3 +39,18 @@ bool removeDirectory(std::string path)
 {
 	return fs::remove_all(fs::path(path)) > 0;
 }
+
+bool removeFile(std::string path)
+{
+	return fs::remove(fs::path(path));
+}
+
+void renameFile(std::string from, std::string to)
+{
+	fs::rename(fs::path(from), fs::path(to));
+}
+
+void resizeFile(std::string path, size_t size)
+{
+	fs::resize_file(fs::path(path), size);
+}
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <cstddef>
 
 std::vector<std::string> ls(std::string directory);
 
@@ -14,4 +15,8 @@ bool makePath(std::string path);
 
 bool removeDirectory(std::string path);
 
+bool removeFile(std::string path);
+void renameFile(std::string from, std::string to);	// replaces to if it exists, which happens atomically where the file system supports it
+void resizeFile(std::string path, size_t size);	// truncates or extends the file
+
 #endif
@@ -1,15 +1,65 @@
 #ifndef ordfilt_hpp
 #define ordfilt_hpp
 
+/*
+ordfilt() and its variants return for each element of a signal the given quantile of its neighborhood, like MATLAB's ordfilt2.
+
+The *_nth_element versions copy every neighborhood and run std::nth_element on it, which takes O(n * w) for n elements and neighborhoods of w elements.
+If the neighborhood is a range of consecutive offsets, which is the common case, ordfilt() and its variants slide a window along the signal instead:
+- quantiles 0 and 1 (erosion and dilation) are found with the van Herk/Gil-Werman algorithm in O(n),
+- types with few values (MyBool, unsigned char) are counted in a histogram in O(n),
+- other types are kept partially sorted in two multisets in O(n * log w).
+The results are the same as those of the *_nth_element versions. Neighborhoods containing NaN are passed to std::nth_element just like before,
+since the order it leaves NaNs in is what defines the result.
+*/
+
 #include <vector>
+#include <set>
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
 #include <cassert>
+#include <cstdlib>
+#include <cstddef>
+#include "MyBool.hpp"
+
+// maps an index outside of [0, signalSize) into it by mirroring the signal at its ends
+inline
+ptrdiff_t ordfiltMirrorIndex(ptrdiff_t signalIndex, ptrdiff_t signalSize)
+{
+	if (signalIndex < 0) {
+		if (std::abs(static_cast<int>(signalIndex / signalSize)) % 2 == 0) {	//TODO: remove the cast: it is a workaround for Win64
+			// use mirrored signal
+			return std::abs(static_cast<int>(signalIndex)) % signalSize;	//TODO: remove the cast: it is a workaround for Win64
+		} else {
+			// use non-mirrored signal
+			return signalIndex % signalSize + signalSize;
+		}
+	} else {
+		if ((signalIndex / signalSize) % 2 == 1) {
+			// use mirrored signal
+			return signalSize - 1 - (signalIndex % signalSize);
+		} else {
+			// use non-mirrored signal
+			return signalIndex % signalSize;
+		}
+	}
+}
+
+// maps an index outside of [0, signalSize) into it by repeating the signal
+inline
+ptrdiff_t ordfiltWrapIndex(ptrdiff_t signalIndex, ptrdiff_t signalSize)
+{
+	signalIndex %= signalSize;
+	if (signalIndex < 0) {
+		signalIndex += signalSize;
+	}
+	return signalIndex;
+}
 
 // neighborhood contains offsets from the current element that are to be considered
 template<class T>
-std::vector<T> ordfilt(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
+std::vector<T> ordfilt_nth_element(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
 {
 	if (quantile < 0 || quantile > 1) {
 		throw std::domain_error("quantile must be in [0,1]");
@@ -48,22 +98,9 @@ std::vector<T> ordfilt(const std::vector<T>& signal, double quantile, const std:
 	return ret;
 }
 
-// constructs a centered neighborhood with width elements and calls the function above
-template<class T>
-std::vector<T> ordfilt(const std::vector<T>& signal, double quantile, size_t width)
-{
-	ptrdiff_t signedWidth = static_cast<ptrdiff_t>(width);
-	std::vector<ptrdiff_t> neighborhood;
-	neighborhood.reserve(width);
-	for (ptrdiff_t offset = -(signedWidth / 2); offset <= (signedWidth / 2); ++offset) {
-		neighborhood.push_back(offset);
-	}
-	return ordfilt(signal, quantile, neighborhood);
-}
-
 // neighborhood contains offsets from the current element that are to be considered
 template<class T>
-std::vector<T> ordfilt_mirror(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
+std::vector<T> ordfilt_mirror_nth_element(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
 {
 	if (quantile < 0 || quantile > 1) {
 		throw std::domain_error("quantile must be in [0,1]");
@@ -81,26 +118,7 @@ std::vector<T> ordfilt_mirror(const std::vector<T>& signal, double quantile, con
 
 		for (std::vector<ptrdiff_t>::const_iterator neighborhoodIter = neighborhood.begin(); neighborhoodIter != neighborhood.end(); ++neighborhoodIter) {
 			ptrdiff_t offset = *neighborhoodIter;
-			ptrdiff_t signalIndex = i + offset;
-
-			if (signalIndex < 0) {
-				if (std::abs(static_cast<int>(signalIndex / signalSize)) % 2 == 0) {	//TODO: remove the cast: it is a workaround for Win64
-					// use mirrored signal
-					signalIndex = std::abs(static_cast<int>(signalIndex)) % signalSize;	//TODO: remove the cast: it is a workaround for Win64
-				} else {
-					// use non-mirrored signal
-					signalIndex = signalIndex % signalSize + signalSize;
-				}
-			} else {
-				if ((signalIndex / signalSize) % 2 == 1) {
-					// use mirrored signal
-					signalIndex = signalSize - 1 - (signalIndex % signalSize);
-				} else {
-					// use non-mirrored signal
-					signalIndex = signalIndex % signalSize;
-				}
-			}
-
+			ptrdiff_t signalIndex = ordfiltMirrorIndex(i + offset, signalSize);
 			assert(signalIndex >= 0 && signalIndex < signalSize);
 			neighborhoodValues.push_back(signal[signalIndex]);
 		}
@@ -124,7 +142,7 @@ std::vector<T> ordfilt_mirror(const std::vector<T>& signal, double quantile, con
 
 // neighborhood contains offsets from the current element that are to be considered
 template<class T>
-std::vector<T> ordfilt_wrap(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
+std::vector<T> ordfilt_wrap_nth_element(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
 {
 	if (quantile < 0 || quantile > 1) {
 		throw std::domain_error("quantile must be in [0,1]");
@@ -141,10 +159,7 @@ std::vector<T> ordfilt_wrap(const std::vector<T>& signal, double quantile, const
 
 		for (std::vector<ptrdiff_t>::const_iterator neighborhoodIter = neighborhood.begin(); neighborhoodIter != neighborhood.end(); ++neighborhoodIter) {
 			ptrdiff_t offset = *neighborhoodIter;
-			ptrdiff_t signalIndex = (i + offset) % static_cast<ptrdiff_t>(signal.size());
-			if (signalIndex < 0) {
-				signalIndex += static_cast<ptrdiff_t>(signal.size());
-			}
+			ptrdiff_t signalIndex = ordfiltWrapIndex(i + offset, signal.size());
 			assert(signalIndex >= 0 && signalIndex < signal.size());
 			neighborhoodValues.push_back(signal[signalIndex]);
 		}
@@ -166,4 +181,332 @@ std::vector<T> ordfilt_wrap(const std::vector<T>& signal, double quantile, const
 	return ret;
 }
 
+// the values in a sliding window, sorted just enough to get at one order statistic: the smallest ones are in low, all others in high
+template<class T>
+class OrdfiltSortedWindow {
+public:
+	OrdfiltSortedWindow() :
+		low(),
+		high(),
+		nans(0)
+	{
+	}
+
+	void add(const T& value)
+	{
+		if (value != value) {
+			++nans;
+		} else if (!high.empty() && !(value < *high.begin())) {
+			high.insert(value);
+		} else {
+			low.insert(value);
+		}
+	}
+
+	void remove(const T& value)
+	{
+		if (value != value) {
+			--nans;
+		} else if (!low.empty() && !(*low.rbegin() < value)) {
+			low.erase(low.find(value));
+		} else {
+			high.erase(high.find(value));
+		}
+	}
+
+	size_t size() const
+	{
+		return low.size() + high.size() + nans;
+	}
+
+	size_t nanCount() const
+	{
+		return nans;
+	}
+
+	// the value std::nth_element would put at position order; there must not be any NaNs in the window
+	T at(size_t order)
+	{
+		while (low.size() > order + 1) {
+			typename std::multiset<T>::iterator largest = --low.end();
+			high.insert(*largest);
+			low.erase(largest);
+		}
+		while (low.size() < order + 1) {
+			low.insert(*high.begin());
+			high.erase(high.begin());
+		}
+		return *low.rbegin();
+	}
+
+private:
+	std::multiset<T> low;
+	std::multiset<T> high;
+	size_t nans;
+};
+
+// the values in a sliding window, counted in a histogram with one bin for each of the valueCount values a T can have
+template<class T, size_t valueCount>
+class OrdfiltCountingWindow {
+public:
+	OrdfiltCountingWindow() :
+		histogram(valueCount, 0),
+		count(0),
+		bin(0),
+		belowBin(0)
+	{
+	}
+
+	void add(const T& value)
+	{
+		size_t valueBin = static_cast<size_t>(value);
+		++histogram[valueBin];
+		++count;
+		if (valueBin < bin) {
+			++belowBin;
+		}
+	}
+
+	void remove(const T& value)
+	{
+		size_t valueBin = static_cast<size_t>(value);
+		--histogram[valueBin];
+		--count;
+		if (valueBin < bin) {
+			--belowBin;
+		}
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	size_t nanCount() const
+	{
+		return 0;
+	}
+
+	// moves bin from where it was for the previous call until position order falls into it
+	T at(size_t order)
+	{
+		while (belowBin > order) {
+			--bin;
+			belowBin -= histogram[bin];
+		}
+		while (belowBin + histogram[bin] <= order) {
+			belowBin += histogram[bin];
+			++bin;
+		}
+		return static_cast<T>(bin);
+	}
+
+private:
+	std::vector<size_t> histogram;
+	size_t count;
+	size_t bin;
+	size_t belowBin;	// the number of values smaller than bin
+};
+
+// selects the window ordfilt_sliding uses for a type
+template<class T>
+class OrdfiltWindow {
+public:
+	typedef OrdfiltSortedWindow<T> Type;
+};
+
+template<>
+class OrdfiltWindow<unsigned char> {
+public:
+	typedef OrdfiltCountingWindow<unsigned char, 256> Type;
+};
+
+template<>
+class OrdfiltWindow<MyBool> {
+public:
+	typedef OrdfiltCountingWindow<MyBool, 2> Type;
+};
+
+// returns the order of the quantile in a neighborhood of size elements, the same way the *_nth_element versions do
+inline
+size_t ordfiltOrder(double quantile, size_t size)
+{
+	size_t order = static_cast<size_t>(quantile * size);
+	if (order == size) {	// extreme case where quantile was 1.0
+		--order;
+	}
+	return order;
+}
+
+// van Herk/Gil-Werman: the minimum (or maximum if dilate is set) of values[i + first, i + last], clipped to the values, for i in [0, outputCount)
+// the values are split into blocks of the window size; every window covers the end of one block and the beginning of the next
+template<class T>
+std::vector<T> ordfilt_erode_dilate(const std::vector<T>& values, bool dilate, ptrdiff_t first, ptrdiff_t last, size_t outputCount)
+{
+	const ptrdiff_t valueCount = values.size();
+	const ptrdiff_t blockSize = last - first + 1;
+
+	// extremes from the beginning of each block up to an element, and from an element to the end of its block
+	std::vector<T> fromBlockBegin(values.begin(), values.end());
+	std::vector<T> toBlockEnd(values.begin(), values.end());
+	for (ptrdiff_t i = 1; i < valueCount; ++i) {
+		if (i % blockSize != 0) {
+			fromBlockBegin[i] = dilate ? std::max(fromBlockBegin[i - 1], values[i]) : std::min(fromBlockBegin[i - 1], values[i]);
+		}
+	}
+	for (ptrdiff_t i = valueCount - 2; i >= 0; --i) {
+		if ((i + 1) % blockSize != 0) {
+			toBlockEnd[i] = dilate ? std::max(values[i], toBlockEnd[i + 1]) : std::min(values[i], toBlockEnd[i + 1]);
+		}
+	}
+
+	std::vector<T> ret;
+	ret.reserve(outputCount);
+	for (ptrdiff_t i = 0; i != static_cast<ptrdiff_t>(outputCount); ++i) {
+		ptrdiff_t windowBegin = std::max<ptrdiff_t>(i + first, 0);
+		ptrdiff_t windowLast = std::min<ptrdiff_t>(i + last, valueCount - 1);
+		if (windowBegin > windowLast) {
+			ret.push_back(std::numeric_limits<T>::quiet_NaN());
+		} else if (windowBegin / blockSize != windowLast / blockSize) {
+			ret.push_back(dilate ? std::max(toBlockEnd[windowBegin], fromBlockBegin[windowLast]) : std::min(toBlockEnd[windowBegin], fromBlockBegin[windowLast]));
+		} else if (windowBegin % blockSize == 0) {	// a window within a single block either starts at its beginning...
+			ret.push_back(fromBlockBegin[windowLast]);
+		} else {	// ...or has been clipped at the end of the values
+			ret.push_back(toBlockEnd[windowBegin]);
+		}
+	}
+	return ret;
+}
+
+// the quantile of values[i + first, i + last], clipped to the values, for i in [0, outputCount)
+template<class T>
+std::vector<T> ordfilt_sliding(const std::vector<T>& values, double quantile, ptrdiff_t first, ptrdiff_t last, size_t outputCount)
+{
+	const ptrdiff_t valueCount = values.size();
+
+	if (quantile == 0 || quantile == 1) {
+		bool hasNaN = false;
+		for (typename std::vector<T>::const_iterator iter = values.begin(); iter != values.end(); ++iter) {
+			if (*iter != *iter) {
+				hasNaN = true;
+				break;
+			}
+		}
+		if (!hasNaN) {
+			return ordfilt_erode_dilate(values, quantile == 1, first, last, outputCount);
+		}
+	}
+
+	typename OrdfiltWindow<T>::Type window;
+	ptrdiff_t windowBegin = 0;	// the values in [windowBegin, windowEnd) are in the window
+	ptrdiff_t windowEnd = 0;
+	std::vector<T> neighborhoodValues;
+
+	std::vector<T> ret;
+	ret.reserve(outputCount);
+	for (ptrdiff_t i = 0; i != static_cast<ptrdiff_t>(outputCount); ++i) {
+		// both ends only ever move forward, and the end is never before the beginning
+		const ptrdiff_t newBegin = std::min(std::max<ptrdiff_t>(i + first, 0), valueCount);
+		const ptrdiff_t newEnd = std::min(std::max<ptrdiff_t>(i + last + 1, 0), valueCount);
+		for (; windowEnd < newEnd; ++windowEnd) {
+			window.add(values[windowEnd]);
+		}
+		for (; windowBegin < newBegin; ++windowBegin) {
+			window.remove(values[windowBegin]);
+		}
+
+		if (window.size() == 0) {
+			ret.push_back(std::numeric_limits<T>::quiet_NaN());
+		} else if (window.nanCount() != 0) {
+			neighborhoodValues.assign(values.begin() + windowBegin, values.begin() + windowEnd);
+			typename std::vector<T>::iterator resultIter = neighborhoodValues.begin() + ordfiltOrder(quantile, neighborhoodValues.size());
+			std::nth_element(neighborhoodValues.begin(), resultIter, neighborhoodValues.end());
+			ret.push_back(*resultIter);
+		} else {
+			ret.push_back(window.at(ordfiltOrder(quantile, window.size())));
+		}
+	}
+	return ret;
+}
+
+// returns if the neighborhood is a range of consecutive offsets in ascending order
+inline
+bool ordfiltIsRange(const std::vector<ptrdiff_t>& neighborhood)
+{
+	if (neighborhood.empty()) {
+		return false;
+	}
+	for (size_t i = 1; i != neighborhood.size(); ++i) {
+		if (neighborhood[i] != neighborhood[0] + static_cast<ptrdiff_t>(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// neighborhood contains offsets from the current element that are to be considered; at the ends of the signal, the neighborhood is clipped
+template<class T>
+std::vector<T> ordfilt(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
+{
+	if (quantile < 0 || quantile > 1) {
+		throw std::domain_error("quantile must be in [0,1]");
+	}
+	if (!ordfiltIsRange(neighborhood)) {
+		return ordfilt_nth_element(signal, quantile, neighborhood);
+	}
+	return ordfilt_sliding(signal, quantile, neighborhood.front(), neighborhood.back(), signal.size());
+}
+
+// constructs a centered neighborhood with width elements and calls the function above
+template<class T>
+std::vector<T> ordfilt(const std::vector<T>& signal, double quantile, size_t width)
+{
+	ptrdiff_t signedWidth = static_cast<ptrdiff_t>(width);
+	std::vector<ptrdiff_t> neighborhood;
+	neighborhood.reserve(width);
+	for (ptrdiff_t offset = -(signedWidth / 2); offset <= (signedWidth / 2); ++offset) {
+		neighborhood.push_back(offset);
+	}
+	return ordfilt(signal, quantile, neighborhood);
+}
+
+// neighborhood contains offsets from the current element that are to be considered; the signal is mirrored at its ends
+template<class T>
+std::vector<T> ordfilt_mirror(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
+{
+	if (quantile < 0 || quantile > 1) {
+		throw std::domain_error("quantile must be in [0,1]");
+	}
+	if (!ordfiltIsRange(neighborhood) || signal.empty()) {
+		return ordfilt_mirror_nth_element(signal, quantile, neighborhood);
+	}
+	// slide along the signal extended by its mirror images, so that each window is in one piece
+	const ptrdiff_t signalSize = signal.size();
+	std::vector<T> extended;
+	extended.reserve(signalSize + neighborhood.size() - 1);
+	for (ptrdiff_t i = neighborhood.front(); i != signalSize + neighborhood.back(); ++i) {
+		extended.push_back(signal[ordfiltMirrorIndex(i, signalSize)]);
+	}
+	return ordfilt_sliding(extended, quantile, 0, neighborhood.size() - 1, signal.size());
+}
+
+// neighborhood contains offsets from the current element that are to be considered; the signal is repeated at its ends
+template<class T>
+std::vector<T> ordfilt_wrap(const std::vector<T>& signal, double quantile, const std::vector<ptrdiff_t>& neighborhood)
+{
+	if (quantile < 0 || quantile > 1) {
+		throw std::domain_error("quantile must be in [0,1]");
+	}
+	if (!ordfiltIsRange(neighborhood) || signal.empty()) {
+		return ordfilt_wrap_nth_element(signal, quantile, neighborhood);
+	}
+	const ptrdiff_t signalSize = signal.size();
+	std::vector<T> extended;
+	extended.reserve(signalSize + neighborhood.size() - 1);
+	for (ptrdiff_t i = neighborhood.front(); i != signalSize + neighborhood.back(); ++i) {
+		extended.push_back(signal[ordfiltWrapIndex(i, signalSize)]);
+	}
+	return ordfilt_sliding(extended, quantile, 0, neighborhood.size() - 1, signal.size());
+}
+
 #endif
@@ -3,6 +3,16 @@
 #include <cstdlib>
 #include <stdexcept>
 
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment(lib, "psapi.lib")
+#else
+	#include <time.h>
+	#include <sys/time.h>
+	#include <sys/resource.h>
+#endif
+
 std::string getUserName()
 {
 	const char* userName = NULL;
@@ -19,3 +29,52 @@ std::string getUserName()
 
 	return std::string(userName);
 }
+
+double getThreadCpuTime()
+{
+	#if defined(_WIN32)
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+			return 0;
+		}
+		ULARGE_INTEGER kernel, user;
+		kernel.LowPart = kernelTime.dwLowDateTime;
+		kernel.HighPart = kernelTime.dwHighDateTime;
+		user.LowPart = userTime.dwLowDateTime;
+		user.HighPart = userTime.dwHighDateTime;
+		return (kernel.QuadPart + user.QuadPart) / 1e7;	// in units of 100 ns
+	#elif defined(CLOCK_THREAD_CPUTIME_ID)
+		timespec now;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+			return 0;
+		}
+		return now.tv_sec + now.tv_nsec / 1e9;
+	#else
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+		return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+	#endif
+}
+
+size_t getPeakResidentSetSize()
+{
+	#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return 0;
+		}
+		return counters.PeakWorkingSetSize;
+	#else
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+		#if defined(__APPLE__)
+			return usage.ru_maxrss;	// in bytes
+		#else
+			return static_cast<size_t>(usage.ru_maxrss) * 1024;	// in kilobytes
+		#endif
+	#endif
+}
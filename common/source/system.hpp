@@ -2,7 +2,10 @@
 #define system_hpp
 
 #include <string>
+#include <cstddef>
 
 std::string getUserName();
+double getThreadCpuTime();	// seconds the calling thread has spent on a CPU, or the whole process where that can't be told apart
+size_t getPeakResidentSetSize();	// the most physical memory the process has used so far, in bytes
 
 #endif
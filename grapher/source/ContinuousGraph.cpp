@@ -60,6 +60,21 @@ ContinuousGraph::~ContinuousGraph()
 	vertexBuffers_.clear();
 }
 
+void ContinuousGraph::colorsChanged(size_t first, size_t last)
+{
+	for(size_t i = 0; i < vertexBuffers_.size(); ++i)
+	{
+		if(vertexBuffers_[i])
+		{
+			delete vertexBuffers_[i];
+			vertexBuffers_[i] = NULL;		
+		}
+	}
+	vertexBuffers_.clear();
+	
+	generateIndicesAndRegenerateVertexBuffer();
+}
+
 const QVector3D * ContinuousGraph::getDataPtr() const
 {
 	return & positions_[0];
@@ -118,20 +118,21 @@ public:
 	template<class ColorIterator>
 	void changeColor(ColorIterator colorsBegin, ColorIterator colorsEnd, size_t offset = 0)
 	{
-		for (size_t i = 0; offset + i < colors_.size() && colorsBegin != colorsEnd; ++i) {
+		size_t i = 0;
+		for (; offset + i < colors_.size() && colorsBegin != colorsEnd; ++i) {
 			colors_[offset + i] = *(colorsBegin++);
 		}
 		
-		for (size_t i = 0; i != vertexBuffers_.size(); ++i) {
-			if (vertexBuffers_[i]) {
-				delete vertexBuffers_[i];
-				vertexBuffers_[i] = NULL;		
-			}
-		}
-		vertexBuffers_.clear();
-		
-		//generateIndicesAndRegenerateVertexBuffer();
+		colorsChanged(offset, offset + i);
 	}
+	
+	/**
+	 *	updates the vertex buffers after the colors of a range of values have changed.
+	 *	by default the vertex buffers are regenerated
+	 *	@param	first the first value that changed
+	 *	@param	last one past the last value that changed
+	 */
+	virtual void colorsChanged(size_t first, size_t last);
 
 	//virtual void setErrorBars(const std::vector<float>& errorData);
 
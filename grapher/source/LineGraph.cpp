@@ -11,6 +11,16 @@
 #include <QGLWidget>
 #include <iostream>
 #include <QMatrix4x4>
+#include <algorithm>
+
+size_t LineGraph::tileSize = 65536;
+size_t LineGraph::maxResidentTiles = 32;
+size_t LineGraph::levelFactor = 4;
+
+LineGraph::~LineGraph()
+{
+	clearTiles();
+}
 
 void LineGraph::draw(QMatrix4x4 & view,
 					 QMatrix4x4 & projection,
@@ -23,6 +33,13 @@ void LineGraph::draw(QMatrix4x4 & view,
 					 bool rotated,
 					 float zoomFactor)
 {
+	if(positions_.empty())
+	{
+		return;
+	}
+	
+	++frame_;
+	
 	glPushMatrix();
 	
 	QMatrix4x4 modelView;
@@ -30,39 +47,69 @@ void LineGraph::draw(QMatrix4x4 & view,
 	glLineWidth(lineWidth_);
 	
 	/**
-	 *	looping over all the tiles of our graph
+	 *	choosing the level that has about one bin per pixel
 	 */
-	for(size_t i = 0; i < vertexBuffers_.size() ; ++i)
+	size_t level = chooseLevel((rightValue - leftValue) / std::max<size_t>(width, 1));
+	size_t numVertices = getNumberOfVertices(level);
+	
+	/**
+	 *	finding the vertices that are visible, the vertices of a level are sorted by x
+	 */
+	size_t firstVertex = 0;
+	size_t lastVertex = numVertices - 1;
 	{
-		VertexBuffer * current = vertexBuffers_[i];
-		
-		/**
-		 *	checking if the current graph tile is actually visible
-		 */
-		float xmin = offset_.x() + current->getXMin();
-		float xmax = offset_.x() + current->getXMax();
-		
-		if(xmax < leftValue || xmin > rightValue)
+		size_t low = 0;
+		size_t high = numVertices;
+		while(low < high)
 		{
-			//std::cout << xmax << " " << xmin << std::endl;
-			continue;
+			size_t middle = (low + high) / 2;
+			if(offset_.x() + positions_[getValueIndex(level, middle)].x() < leftValue)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
 		}
-		else
+		firstVertex = low > 0 ? low - 1 : 0;
+		
+		high = numVertices;
+		while(low < high)
 		{
-			/**
-			 *	translating the tile to its proper position
-			 */
-			modelView = view;
-			modelView.translate((offset_ + current->getBufferOffset()));
-			glLoadMatrixd(modelView.data());
-			
-			/**
-			 *	drawing the whole vertexbuffer
-			 */
-			current->bind();
-			glDrawElements(GL_LINE_STRIP, current->getNumberOfIndices(), GL_UNSIGNED_INT, (void*)0);
-			current->release();
+			size_t middle = (low + high) / 2;
+			if(offset_.x() + positions_[getValueIndex(level, middle)].x() <= rightValue)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
 		}
+		lastVertex = std::min(low, numVertices - 1);
+	}
+	
+	/**
+	 *	looping over the visible tiles of the level
+	 */
+	for(size_t i = firstVertex / tileSize; i <= lastVertex / tileSize && i * tileSize < numVertices; ++i)
+	{
+		VertexBuffer * current = getTile(level, i);
+		
+		/**
+		 *	translating the tile to its proper position
+		 */
+		modelView = view;
+		modelView.translate((offset_ + current->getBufferOffset()));
+		glLoadMatrixd(modelView.data());
+		
+		/**
+		 *	drawing the whole vertexbuffer
+		 */
+		current->bind();
+		glDrawElements(GL_LINE_STRIP, current->getNumberOfIndices(), GL_UNSIGNED_INT, (void*)0);
+		current->release();
 		
 		GLenum error = glGetError();
 		
@@ -70,108 +117,216 @@ void LineGraph::draw(QMatrix4x4 & view,
 		{
 			std::cout << gluErrorString(error) << std::endl;
 		}
-
-		
 	}
 	glPopMatrix();
+	
+	evictTiles();
 }
 
 void LineGraph::generateIndicesAndRegenerateVertexBuffer()
 {
 	/**
-	 *	builing the vertex buffer(s) from a given data set
-	 *	depending on ContinousGraph::splitThreshold we might end up with
-	 *	several vertex buffers, that are defined between x = [0, splitThreshold], and then
-	 *	moved into place
+	 *	the levels only depend on the data values, so they are only built once
 	 */
-	std::vector<int> curIndices;
-	std::vector<QVector3D> curPos;
-	std::vector<QVector4D> curColors;
+	clearTiles();
 	
-	size_t reserveValues = std::min(positions_.size(), ContinuousGraph::splitThreshold);
-	
-	curIndices.reserve(reserveValues);
-	curPos.reserve(reserveValues);
-	curColors.reserve(reserveValues);
-	
-	size_t counter = 0;
-	size_t min = 0;
-	size_t offsetIndex = 0;
-	fPoint offsetValue = 0;
-	
-	QVector3D tmpPos;
+	if(levels_.empty())
+	{
+		buildLevels();
+	}
+}
+
+void LineGraph::colorsChanged(size_t first, size_t last)
+{
+	std::vector<QVector4D> curColors;
 	
+	for(TileMap::iterator it = tiles_.begin(); it != tiles_.end(); ++it)
+	{
+		size_t level = it->first.first;
+		size_t begin = it->first.second * tileSize;
+		size_t end = std::min(begin + tileSize + 1, getNumberOfVertices(level));
+		
+		/**
+		 *	the vertices of a level are sorted by their data index, so the changed ones are contiguous
+		 */
+		size_t firstVertex = begin;
+		size_t lastVertex = end;
+		if(level == 0)
+		{
+			firstVertex = std::max(begin, first);
+			lastVertex = std::min(end, last);
+		}
+		else
+		{
+			const std::vector<unsigned int> & curLevel = levels_[level - 1];
+			firstVertex = std::lower_bound(curLevel.begin() + begin, curLevel.begin() + end, first) - curLevel.begin();
+			lastVertex = std::lower_bound(curLevel.begin() + begin, curLevel.begin() + end, last) - curLevel.begin();
+		}
+		
+		if(firstVertex >= lastVertex)
+		{
+			continue;
+		}
+		
+		curColors.resize(lastVertex - firstVertex);
+		for(size_t i = firstVertex; i < lastVertex; ++i)
+		{
+			curColors[i - firstVertex] = colors_[getValueIndex(level, i)];
+		}
+		it->second.buffer->updateColors(firstVertex - begin, &(curColors[0]), curColors.size());
+	}
+}
+
+void LineGraph::buildLevels()
+{
 	/**
-	 *	generating the positions. this time the actual (x,y) value and the corresponding color
+	 *	the bins of level 1 hold levelFactor data values, the bins of every further level levelFactor bins of the level below.
+	 *	each bin is represented by the data indices of its min and its max, in data order, so that a line strip through them
+	 *	covers everything in between.
 	 */
-	for(size_t i = 0; i < positions_.size(); ++i)
+	levels_.clear();
+	
+	size_t numBins = positions_.size();
+	size_t level = 0;
+	while(numBins > tileSize / 2)
 	{
-		curIndices.push_back((int)i - min);
-		tmpPos = positions_[i];
-		tmpPos.setX(tmpPos.x() - offsetValue);
-		curPos.push_back(tmpPos);
-		curColors.push_back(colors_[i]);
+		size_t binSize = (level == 0) ? levelFactor : 2 * levelFactor;
+		size_t numVertices = getNumberOfVertices(level);
 		
-		counter++;
+		std::vector<unsigned int> curLevel;
+		curLevel.reserve(2 * (numVertices / binSize + 1));
 		
-		/**
-		 *	encountered a split
-		 */
-		if((counter == ContinuousGraph::splitThreshold) && (i != (positions_.size() - 1)))
+		for(size_t begin = 0; begin < numVertices; begin += binSize)
 		{
-			/**
-			 *	create the vertexbuffer from the current data
-			 */
-			VertexBuffer * current = new VertexBuffer(curIndices, curPos, curColors);
-			current->setXMin(min);
-			current->setXMax(i);
-			min = i;
-			QVector3D bufferOffset(offsetValue, 0.0f, 0.0f);
-			current->setBufferOffset(bufferOffset);
-			
-			/**
-			 *	incremented the values for next vertexbuffer
-			 */
-			++offsetIndex;
-			offsetValue = offsetIndex * ContinuousGraph::splitThreshold;
+			size_t end = std::min(begin + binSize, numVertices);
+			size_t minIndex = getValueIndex(level, begin);
+			size_t maxIndex = minIndex;
 			
-			vertexBuffers_.push_back(current);
+			for(size_t j = begin + 1; j < end; ++j)
+			{
+				size_t index = getValueIndex(level, j);
+				if(positions_[index].y() < positions_[minIndex].y())
+				{
+					minIndex = index;
+				}
+				if(positions_[index].y() > positions_[maxIndex].y())
+				{
+					maxIndex = index;
+				}
+			}
 			
-			/**
-			 *	initialise next vertex buffer values
-			 */
-			std::vector<int> newIndices;
-			std::vector<QVector3D> newPos;
-			std::vector<QVector4D> newColors;
-			
-			newIndices.reserve(reserveValues);
-			newPos.reserve(reserveValues);
-			newColors.reserve(reserveValues);
-			
-			
-			curIndices.swap(newIndices);
-			curPos.swap(newPos);
-			curColors.swap(newColors);
-			
-			curIndices.push_back(0);
-			tmpPos = positions_[i];
-			tmpPos.setX(tmpPos.x() - offsetValue);
-			curPos.push_back(tmpPos);
-			curColors.push_back(colors_[i]);
-			
-			counter = 0;
+			curLevel.push_back(std::min(minIndex, maxIndex));
+			curLevel.push_back(std::max(minIndex, maxIndex));
 		}
 		
-	}	
+		levels_.push_back(std::vector<unsigned int>());
+		levels_.back().swap(curLevel);
+		
+		numBins = levels_.back().size() / 2;
+		++level;
+	}
+}
+
+size_t LineGraph::chooseLevel(float valuesPerPixel) const
+{
+	size_t level = 0;
+	float binSize = levelFactor;
+	
+	while(level < levels_.size() && binSize <= valuesPerPixel)
+	{
+		++level;
+		binSize *= levelFactor;
+	}
+	return level;
+}
+
+size_t LineGraph::getNumberOfVertices(size_t level) const
+{
+	return (level == 0) ? positions_.size() : levels_[level - 1].size();
+}
+
+size_t LineGraph::getValueIndex(size_t level, size_t vertex) const
+{
+	return (level == 0) ? vertex : levels_[level - 1][vertex];
+}
+
+VertexBuffer * LineGraph::getTile(size_t level, size_t tile)
+{
+	Tile & current = tiles_[std::make_pair(level, tile)];
+	current.lastDrawn = frame_;
+	
+	if(current.buffer)
+	{
+		return current.buffer;
+	}
 	
 	/**
-	 *	set the last vertexbuffer
+	 *	the tile shares its first vertex with the last one of the tile before, so the strips connect.
+	 *	the positions are relative to the first vertex to keep the float precision.
 	 */
-	VertexBuffer * current = new VertexBuffer(curIndices, curPos, curColors);
-	current->setXMin(min);
-	current->setXMax(positions_.size());
+	size_t begin = tile * tileSize;
+	size_t end = std::min(begin + tileSize + 1, getNumberOfVertices(level));
+	fPoint offsetValue = positions_[getValueIndex(level, begin)].x();
+	
+	std::vector<int> curIndices;
+	std::vector<QVector3D> curPos;
+	std::vector<QVector4D> curColors;
+	
+	curIndices.reserve(end - begin);
+	curPos.reserve(end - begin);
+	curColors.reserve(end - begin);
+	
+	for(size_t i = begin; i < end; ++i)
+	{
+		size_t index = getValueIndex(level, i);
+		QVector3D tmpPos = positions_[index];
+		tmpPos.setX(tmpPos.x() - offsetValue);
+		
+		curIndices.push_back((int)(i - begin));
+		curPos.push_back(tmpPos);
+		curColors.push_back(colors_[index]);
+	}
+	
+	current.buffer = new VertexBuffer(curIndices, curPos, curColors);
+	current.buffer->setXMin(offsetValue);
+	current.buffer->setXMax(positions_[getValueIndex(level, end - 1)].x());
 	QVector3D bufferOffset(offsetValue, 0.0f, 0.0f);
-	current->setBufferOffset(bufferOffset);
+	current.buffer->setBufferOffset(bufferOffset);
 	
-	vertexBuffers_.push_back(current);
+	return current.buffer;
+}
+
+void LineGraph::evictTiles()
+{
+	while(tiles_.size() > maxResidentTiles)
+	{
+		TileMap::iterator oldest = tiles_.begin();
+		for(TileMap::iterator it = tiles_.begin(); it != tiles_.end(); ++it)
+		{
+			if(it->second.lastDrawn < oldest->second.lastDrawn)
+			{
+				oldest = it;
+			}
+		}
+		
+		/**
+		 *	the tiles of the current frame are never evicted
+		 */
+		if(oldest->second.lastDrawn == frame_)
+		{
+			break;
+		}
+		
+		delete oldest->second.buffer;
+		tiles_.erase(oldest);
+	}
+}
+
+void LineGraph::clearTiles()
+{
+	for(TileMap::iterator it = tiles_.begin(); it != tiles_.end(); ++it)
+	{
+		delete it->second.buffer;
+	}
+	tiles_.clear();
 }
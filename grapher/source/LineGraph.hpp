@@ -11,11 +11,23 @@
 #define LINEGRAPH_HPP
 
 #include "ContinuousGraph.hpp"
+#include <map>
 
+/**
+ *	@class	LineGraph
+ *	@brief	class drawing the data as a line strip
+ *	long data sets are drawn from a pyramid of min/max decimated levels: every level keeps the smallest and the largest value
+ *	of each bin of levelFactor bins of the level below, so that the level drawn has about one bin per pixel and peaks don't get lost.
+ *	only the tiles of the level that are visible get uploaded, and at most maxResidentTiles are kept on the GPU.
+ */
 class LineGraph : public ContinuousGraph
 {
 public:
 	
+	static size_t tileSize;			/**< the number of vertices per vertex buffer. */
+	static size_t maxResidentTiles;	/**< the number of vertex buffers kept on the GPU. */
+	static size_t levelFactor;		/**< the number of bins of a level that make up one bin of the next level. */
+	
 	/**
 	 *	constructor
 	 *	@param	data the data to be displayed
@@ -34,7 +46,10 @@ public:
 						QVector3D offset = QVector3D(0.0, 0.0, 0.0), 
 						const std::string& unit = std::string()
 			  ) :
-	ContinuousGraph(dataBegin, dataEnd, color, lineWidth, offset, unit)
+	ContinuousGraph(dataBegin, dataEnd, color, lineWidth, offset, unit),
+	levels_(),
+	tiles_(),
+	frame_(0)
 	{
 		
 		generateIndicesAndRegenerateVertexBuffer();
@@ -57,12 +72,19 @@ public:
 						QVector3D offset = QVector3D(0.0, 0.0, 0.0), 
 						const std::string& unit = std::string()
 			  ) :
-	ContinuousGraph(dataBegin, dataEnd, colorsBegin, lineWidth, offset, unit)
+	ContinuousGraph(dataBegin, dataEnd, colorsBegin, lineWidth, offset, unit),
+	levels_(),
+	tiles_(),
+	frame_(0)
 	{
 		
 		generateIndicesAndRegenerateVertexBuffer();
 	}
 
+	/**
+	 *	destructor
+	 */
+	~LineGraph();
 	
     /**
 	 *	draws the graph at position
@@ -93,9 +115,78 @@ public:
 	 *	this method also regenerates the vertexbuffer with the added data
 	 */
 	virtual void generateIndicesAndRegenerateVertexBuffer();
+	
+	/**
+	 *	writes the changed colors into the tiles on the GPU that show any of the changed values
+	 *	@param	first the first value that changed
+	 *	@param	last one past the last value that changed
+	 */
+	virtual void colorsChanged(size_t first, size_t last);
 
 private:
 
+	/**
+	 *	@struct	Tile
+	 *	@brief	a vertex buffer holding tileSize vertices of one level
+	 */
+	struct Tile
+	{
+		Tile() : buffer(NULL), lastDrawn(0) {}
+		
+		VertexBuffer * buffer;		/**< the uploaded vertices. */
+		size_t lastDrawn;			/**< the frame the tile was last drawn in. */
+	};
+	
+	typedef std::map<std::pair<size_t, size_t>, Tile> TileMap;	/**< the tiles by level and tile number. */
+	
+	/**
+	 *	builds the decimated levels from the data
+	 */
+	void buildLevels();
+	
+	/**
+	 *	chooses the level that has about one bin per pixel
+	 *	@param	valuesPerPixel the number of data values per pixel on the screen
+	 *	@return	returns the level, 0 being the data itself
+	 */
+	size_t chooseLevel(float valuesPerPixel) const;
+	
+	/**
+	 *	gets the number of vertices of a level
+	 *	@param	level the level
+	 *	@return	returns the number of vertices
+	 */
+	size_t getNumberOfVertices(size_t level) const;
+	
+	/**
+	 *	gets the index of the data value a vertex of a level stands for
+	 *	@param	level the level
+	 *	@param	vertex the vertex
+	 *	@return	returns the index into the data
+	 */
+	size_t getValueIndex(size_t level, size_t vertex) const;
+	
+	/**
+	 *	gets a tile, uploading it if it isn't on the GPU
+	 *	@param	level the level
+	 *	@param	tile the tile number
+	 *	@return	returns the vertex buffer of the tile
+	 */
+	VertexBuffer * getTile(size_t level, size_t tile);
+	
+	/**
+	 *	deletes the least recently drawn tiles until at most maxResidentTiles are left
+	 */
+	void evictTiles();
+	
+	/**
+	 *	deletes all tiles
+	 */
+	void clearTiles();
+	
+	std::vector<std::vector<unsigned int> > levels_;	/**< the data indices of the min and max of each bin, in data order, for levels 1 and up. */
+	TileMap					tiles_;				/**< the tiles on the GPU. */
+	size_t					frame_;				/**< the number of frames drawn. */
 	
 };
 
@@ -5,17 +5,18 @@
 #endif
 
 #include "VertexBuffer.hpp"
+#include <algorithm>
 
 
-VertexBuffer::VertexBuffer(const std::vector<int> & indices, const std::vector<QVector3D> & positions) : indices_(indices), indexBuffer_(NULL), positions_(positions), positionBuffer_(NULL), colors_(NULL), colorBuffer_(NULL), texCoords_(), texCoordBuffer_(NULL)
+VertexBuffer::VertexBuffer(const std::vector<int> & indices, const std::vector<QVector3D> & positions) : indices_(indices), indexBuffer_(NULL), positions_(positions), positionBuffer_(NULL), colors_(NULL), colorBuffer_(NULL), dirtyColorsBegin_(0), dirtyColorsEnd_(0), texCoords_(), texCoordBuffer_(NULL)
 {
 }
 
-VertexBuffer::VertexBuffer(const std::vector<int> & indices, const std::vector<QVector3D> & positions, const std::vector<QVector4D> &colors) : indices_(indices), indexBuffer_(NULL), positions_(positions), positionBuffer_(NULL), colors_(colors), colorBuffer_(NULL), texCoords_(), texCoordBuffer_(NULL)
+VertexBuffer::VertexBuffer(const std::vector<int> & indices, const std::vector<QVector3D> & positions, const std::vector<QVector4D> &colors) : indices_(indices), indexBuffer_(NULL), positions_(positions), positionBuffer_(NULL), colors_(colors), colorBuffer_(NULL), dirtyColorsBegin_(0), dirtyColorsEnd_(0), texCoords_(), texCoordBuffer_(NULL)
 {
 }
 
-VertexBuffer::VertexBuffer(const std::vector<int> & indices, const std::vector<QVector3D> & positions, const std::vector<QVector2D> &texCoords) : indices_(indices), indexBuffer_(NULL), positions_(positions), positionBuffer_(NULL), colors_(), colorBuffer_(NULL), texCoords_(texCoords), texCoordBuffer_(NULL)
+VertexBuffer::VertexBuffer(const std::vector<int> & indices, const std::vector<QVector3D> & positions, const std::vector<QVector2D> &texCoords) : indices_(indices), indexBuffer_(NULL), positions_(positions), positionBuffer_(NULL), colors_(), colorBuffer_(NULL), dirtyColorsBegin_(0), dirtyColorsEnd_(0), texCoords_(texCoords), texCoordBuffer_(NULL)
 {
 }
 
@@ -41,6 +42,16 @@ void VertexBuffer::bind()
 	{
 		glEnableClientState(GL_COLOR_ARRAY);
 		colorBuffer_->bind();
+		
+		/**
+		 *	only the changed colors are written into the buffer
+		 */
+		if(dirtyColorsBegin_ < dirtyColorsEnd_)
+		{
+			colorBuffer_->write(sizeof(QVector4D) * dirtyColorsBegin_, &(colors_[dirtyColorsBegin_]), sizeof(QVector4D) * (dirtyColorsEnd_ - dirtyColorsBegin_));
+			dirtyColorsBegin_ = dirtyColorsEnd_ = 0;
+		}
+		
 		glColorPointer(4, GL_FLOAT, 0, 0);
 	}
 
@@ -107,6 +118,30 @@ const QVector3D & VertexBuffer::getBufferOffset() const
 	return bufferOffset_;
 }
 
+void VertexBuffer::updateColors(size_t firstVertex, const QVector4D * colors, size_t numColors)
+{
+	size_t lastVertex = std::min(firstVertex + numColors, colors_.size());
+	if(firstVertex >= lastVertex)
+	{
+		return;
+	}
+	std::copy(colors, colors + (lastVertex - firstVertex), colors_.begin() + firstVertex);
+	
+	if(colorBuffer_)
+	{
+		if(dirtyColorsBegin_ < dirtyColorsEnd_)
+		{
+			dirtyColorsBegin_ = std::min(dirtyColorsBegin_, firstVertex);
+			dirtyColorsEnd_ = std::max(dirtyColorsEnd_, lastVertex);
+		}
+		else
+		{
+			dirtyColorsBegin_ = firstVertex;
+			dirtyColorsEnd_ = lastVertex;
+		}
+	}
+}
+
 void VertexBuffer::upload()
 {
 	positionBuffer_ = new QGLBuffer(QGLBuffer::VertexBuffer);
@@ -122,7 +157,7 @@ void VertexBuffer::upload()
 		colorBuffer_ = new QGLBuffer(QGLBuffer::VertexBuffer);
 		if(colorBuffer_->create() && colorBuffer_->bind())
 		{
-			colorBuffer_->setUsagePattern(QGLBuffer::StaticDraw);
+			colorBuffer_->setUsagePattern(QGLBuffer::DynamicDraw);
 			colorBuffer_->allocate(&(colors_[0]), sizeof(QVector4D) * colors_.size());
 			colorBuffer_->release();
 		}
@@ -110,6 +110,15 @@ public:
 	 */
 	const QVector3D & getBufferOffset() const;
 	
+	/**
+	 *	changes the colors of a range of vertices.
+	 *	the colors are written into the existing color buffer the next time it is bound, instead of uploading everything again
+	 *	@param	firstVertex the first vertex to change
+	 *	@param	colors the new colors
+	 *	@param	numColors the number of vertices to change
+	 */
+	void updateColors(size_t firstVertex, const QVector4D * colors, size_t numColors);
+	
 private:
 	
 	/**
@@ -130,6 +139,8 @@ private:
 	
 	std::vector<QVector4D>	colors_;			/**< the colors of each vertex. */
 	QGLBuffer				* colorBuffer_;		/**< the color buffer. */
+	size_t					dirtyColorsBegin_;	/**< the first color that has changed since the upload. */
+	size_t					dirtyColorsEnd_;	/**< one past the last color that has changed since the upload. */
 	
 	std::vector<QVector2D>	texCoords_;			/**< the texture coordinates. */
 	QGLBuffer				* texCoordBuffer_;	/**< the texture coordinate buffer. */
@@ -21,6 +21,7 @@ HEADERS += \
 ../source/ArenasApprovedDelegate.hpp \
 ../source/ArenasDetectedAccessor.hpp \
 ../source/ArenaTab.hpp \
+../source/AttributeCache.hpp \
 ../source/AttributeGrapher.hpp \
 ../source/AttributeSelector.hpp \
 ../source/AudioStageAccessor.hpp \
@@ -50,6 +51,7 @@ HEADERS += \
 ../source/FilterSelector.hpp \
 ../source/FlyTrackingPage.hpp \
 ../source/FoldableGroupBox.hpp \
+../source/FrameCache.hpp \
 ../source/GenderDelegate.hpp \
 ../source/global.hpp \
 ../source/GraphicsPrimitives.hpp \
@@ -76,6 +78,9 @@ HEADERS += \
 ../source/ReadWriteAccessor.hpp \
 ../source/RuntimeError.hpp \
 ../source/SongAnalysisPage.hpp \
+../source/SongDetectionJob.hpp \
+../source/SongDetector.hpp \
+../source/SongDetectorTest.hpp \
 ../source/SongPlayer.hpp \
 ../source/SongResults.hpp \
 ../source/SongStatisticsViewer.hpp \
@@ -113,6 +118,7 @@ HEADERS += \
 ../../common/source/gaussian.hpp \
 ../../common/source/geometry.hpp \
 ../../common/source/interpolate.hpp \
+../../common/source/MappedFile.hpp \
 ../../common/source/mathematics.hpp \
 ../../common/source/MyBool.hpp \
 ../../common/source/MyTraits.hpp \
@@ -155,6 +161,7 @@ SOURCES += \
 ../source/ArenasApprovedDelegate.cpp \
 ../source/ArenasDetectedAccessor.cpp \
 ../source/ArenaTab.cpp \
+../source/AttributeCache.cpp \
 ../source/AttributeGrapher.cpp \
 ../source/AttributeSelector.cpp \
 ../source/BehaviorAnalysisPage.cpp \
@@ -179,6 +186,7 @@ SOURCES += \
 ../source/FilterSelector.cpp \
 ../source/FlyTrackingPage.cpp \
 ../source/FoldableGroupBox.cpp \
+../source/FrameCache.cpp \
 ../source/GenderDelegate.cpp \
 ../source/global.cpp \
 ../source/GraphicsPrimitives.cpp \
@@ -202,6 +210,9 @@ SOURCES += \
 ../source/PulseDetectionPage.cpp \
 ../source/RuntimeError.cpp \
 ../source/SongAnalysisPage.cpp \
+../source/SongDetectionJob.cpp \
+../source/SongDetector.cpp \
+../source/SongDetectorTest.cpp \
 ../source/SongPlayer.cpp \
 ../source/SongResults.cpp \
 ../source/SongStatisticsViewer.cpp \
@@ -224,6 +235,7 @@ SOURCES += \
 ../source/VideoTab.cpp \
 ../../common/source/debug.cpp \
 ../../common/source/fileUtilities.cpp \
+../../common/source/MappedFile.cpp \
 ../../common/source/Stopwatch.cpp \
 ../../common/source/stringUtilities.cpp \
 ../../common/source/system.cpp \
@@ -550,6 +550,7 @@ void ArenaItem::resetFlyTracking()
 		absoluteDataDirectory().remove("track_done_success.txt");
 		absoluteDataDirectory().remove("track_done_failed.txt");
 		absoluteDataDirectory().remove("track.tsv");
+		absoluteDataDirectory().remove("track.bin");
 		QString binariesDirPath = absoluteDataDirectory().filePath("track");
 		try {
 			FileUtilities2::removeDirectory(QDir(binariesDirPath));
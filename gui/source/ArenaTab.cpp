@@ -445,10 +445,11 @@ void ArenaTab::drawWing(size_t frameNumber)
 
 void ArenaTab::drawContour(size_t contourFileOffset, const QVector4D& color)
 {
-	const std::vector<char>& contours = currentResults->getContours();
+	const char* contours = currentResults->getContours();
+	const size_t contourByteCount = currentResults->getContourByteCount();
 
 	uint32_t segmentCount = 0;
-	if (contourFileOffset + sizeof(segmentCount) > contours.size()) {
+	if (contourFileOffset + sizeof(segmentCount) > contourByteCount) {
 		return;
 	}
 	segmentCount = *reinterpret_cast<const uint32_t*>(&contours[contourFileOffset]); contourFileOffset += sizeof(uint32_t);
@@ -459,11 +460,11 @@ void ArenaTab::drawContour(size_t contourFileOffset, const QVector4D& color)
 
 	for (uint32_t segmentNumber = 0; segmentNumber != segmentCount; ++segmentNumber) {
 		uint32_t vertexCount = 0;
-		if (contourFileOffset + sizeof(vertexCount) > contours.size()) {
+		if (contourFileOffset + sizeof(vertexCount) > contourByteCount) {
 			return;
 		}
 		vertexCount = *reinterpret_cast<const uint32_t*>(&contours[contourFileOffset]); contourFileOffset += sizeof(uint32_t);
-		if (contourFileOffset + vertexCount * 2 * sizeof(float) > contours.size()) {	// sanity check, *2 because we have x and y
+		if (contourFileOffset + vertexCount * 2 * sizeof(float) > contourByteCount) {	// sanity check, *2 because we have x and y
 			std::cerr << "drawContour: contour file is too small to contain " << vertexCount << " vertices; sanity check failed; skipping...\n";
 			return;
 		}
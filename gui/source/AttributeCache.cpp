@@ -0,0 +1,108 @@
+#include "AttributeCache.hpp"
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QString>
+
+AttributeCache::AttributeCache() :
+	mutex(),
+	entries(),
+	recency(),
+	byteCount(0),
+	capacity(512 * 1024 * 1024)
+{
+}
+
+boost::shared_ptr<AbstractAttribute> AttributeCache::get(const std::string& filePath, const AbstractAttribute& prototype)
+{
+	{
+		QMutexLocker locker(&mutex);
+		EntryMap::iterator iter = entries.find(filePath);
+		if (iter != entries.end() && iter->second.attribute->getType() == prototype.getType()) {
+			recency.splice(recency.begin(), recency, iter->second.recency);
+			return iter->second.attribute;
+		}
+	}
+
+	// the file is read without holding the lock, so that threads loading different files don't wait for each other
+	QFileInfo fileInfo(QString::fromStdString(filePath));
+	boost::shared_ptr<AbstractAttribute> attribute(prototype.clone());
+	attribute->clear();
+	attribute->readBinaries(filePath);
+
+	QMutexLocker locker(&mutex);
+	EntryMap::iterator iter = entries.find(filePath);
+	if (iter != entries.end() && iter->second.attribute->getType() == prototype.getType()) {
+		// another thread loaded the same file in the meantime; theirs is kept so that everyone shares one copy
+		recency.splice(recency.begin(), recency, iter->second.recency);
+		return iter->second.attribute;
+	}
+	if (iter != entries.end()) {
+		erase(iter);
+	}
+
+	recency.push_front(filePath);
+	Entry& entry = entries[filePath];
+	entry.attribute = attribute;
+	entry.byteCount = fileInfo.exists() ? static_cast<size_t>(fileInfo.size()) : 0;
+	entry.lastModified = fileInfo.lastModified();
+	entry.recency = recency.begin();
+	byteCount += entry.byteCount;
+	evict();
+	return attribute;
+}
+
+void AttributeCache::refresh(const std::string& directory)
+{
+	QMutexLocker locker(&mutex);
+	EntryMap::iterator iter = entries.lower_bound(directory);
+	while (iter != entries.end() && iter->first.compare(0, directory.size(), directory) == 0) {
+		QFileInfo fileInfo(QString::fromStdString(iter->first));
+		if (!fileInfo.exists() || static_cast<size_t>(fileInfo.size()) != iter->second.byteCount || fileInfo.lastModified() != iter->second.lastModified) {
+			erase(iter++);
+		} else {
+			++iter;
+		}
+	}
+}
+
+void AttributeCache::clear()
+{
+	QMutexLocker locker(&mutex);
+	entries.clear();
+	recency.clear();
+	byteCount = 0;
+}
+
+void AttributeCache::setCapacity(size_t byteCount)
+{
+	QMutexLocker locker(&mutex);
+	capacity = byteCount;
+	evict();
+}
+
+size_t AttributeCache::getCapacity() const
+{
+	QMutexLocker locker(&mutex);
+	return capacity;
+}
+
+size_t AttributeCache::getByteCount() const
+{
+	QMutexLocker locker(&mutex);
+	return byteCount;
+}
+
+void AttributeCache::erase(EntryMap::iterator iter)
+{
+	byteCount -= iter->second.byteCount;
+	recency.erase(iter->second.recency);
+	entries.erase(iter);
+}
+
+// drops the least recently used attributes until the rest fit, but always keeps the most recent one so it can be returned
+void AttributeCache::evict()
+{
+	while (byteCount > capacity && recency.size() > 1) {
+		erase(entries.find(recency.back()));
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef AttributeCache_hpp
+#define AttributeCache_hpp
+
+/*
+The AttributeCache loads attribute files on first use and keeps the most recently used ones in memory, up to a capacity in bytes.
+There is one cache for the whole application, Singleton<AttributeCache>::instance(), so the TrackingResults of all arenas share the capacity
+and an arena that is shown again doesn't have to be read again.
+An attribute that is evicted while someone still holds the shared_ptr to it stays alive until they let go of it.
+Files are identified by their path; refresh() drops the attributes of files that have changed since they were loaded, e.g. by tracking again.
+*/
+
+#include <string>
+#include <map>
+#include <list>
+#include <QMutex>
+#include <QDateTime>
+#include <boost/shared_ptr.hpp>
+#include "../../tracker/source/Attribute.hpp"
+
+class AttributeCache {
+public:
+	AttributeCache();
+
+	// a copy of prototype holding the data of the file, which is empty if the file doesn't exist
+	boost::shared_ptr<AbstractAttribute> get(const std::string& filePath, const AbstractAttribute& prototype);
+
+	void refresh(const std::string& directory);	// checks the files below directory
+	void clear();
+
+	void setCapacity(size_t byteCount);
+	size_t getCapacity() const;
+	size_t getByteCount() const;	// of the attributes in the cache
+
+private:
+	AttributeCache(const AttributeCache&);	// not copyable
+	AttributeCache& operator=(const AttributeCache&);
+
+	struct Entry {
+		boost::shared_ptr<AbstractAttribute> attribute;
+		size_t byteCount;
+		QDateTime lastModified;
+		std::list<std::string>::iterator recency;
+	};
+	typedef std::map<std::string, Entry> EntryMap;
+
+	void erase(EntryMap::iterator iter);
+	void evict();
+
+	mutable QMutex mutex;
+	EntryMap entries;
+	std::list<std::string> recency;	// the file paths, most recently used first
+	size_t byteCount;
+	size_t capacity;
+};
+
+#endif
@@ -178,33 +178,33 @@ void AttributeGrapher::attributeChanged()
 			QString attributeDescription("Cannot be displayed.");
 			if (currentResults->hasFrameAttribute<float>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<float>& data = currentResults->getFrameData<float>(attributeName);
-				plot->addLineFillGraph(data.begin(), data.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data.getUnit());
-				attributeDescription = QString::fromStdString(data.getDescription());
+				const boost::shared_ptr<const Attribute<float> > data = currentResults->getFrameView<float>(attributeName);
+				plot->addLineFillGraph(data->begin(), data->end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data->getUnit());
+				attributeDescription = QString::fromStdString(data->getDescription());
 			} else if (currentResults->hasFrameAttribute<MyBool>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<MyBool>& data = currentResults->getFrameData<MyBool>(attributeName);
-				plot->addLineFillGraph(data.begin(), data.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data.getUnit());
-				attributeDescription = QString::fromStdString(data.getDescription());
+				const boost::shared_ptr<const Attribute<MyBool> > data = currentResults->getFrameView<MyBool>(attributeName);
+				plot->addLineFillGraph(data->begin(), data->end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data->getUnit());
+				attributeDescription = QString::fromStdString(data->getDescription());
 			} else if (currentResults->hasFrameAttribute<uint32_t>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<uint32_t>& data = currentResults->getFrameData<uint32_t>(attributeName);
-				plot->addLineFillGraph(data.begin(), data.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data.getUnit());
-				attributeDescription = QString::fromStdString(data.getDescription());
+				const boost::shared_ptr<const Attribute<uint32_t> > data = currentResults->getFrameView<uint32_t>(attributeName);
+				plot->addLineFillGraph(data->begin(), data->end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data->getUnit());
+				attributeDescription = QString::fromStdString(data->getDescription());
 			} else if (currentResults->hasFrameAttribute<Vf2>(attributeName)) {
 				dimensionComboBox->blockSignals(true);
 				dimensionComboBox->addItem("X", 0);
 				dimensionComboBox->addItem("Y", 1);
 				dimensionComboBox->blockSignals(false);
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& data = currentResults->getFrameData<Vf2>(attributeName);
+				const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFrameView<Vf2>(attributeName);
 				std::vector<float> xOnly;
-				xOnly.reserve(data.size());
-				for (size_t i = 0; i != data.size(); ++i) {
-					xOnly.push_back(data[i][0]);
+				xOnly.reserve(data->size());
+				for (size_t i = 0; i != data->size(); ++i) {
+					xOnly.push_back((*data)[i][0]);
 				}
-				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data.getUnit());
-				attributeDescription = QString::fromStdString(data.getDescription());
+				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data->getUnit());
+				attributeDescription = QString::fromStdString(data->getDescription());
 			}
 			frame->setTitle("Frame attribute: " + attributeDescription);
 			return;
@@ -221,27 +221,27 @@ void AttributeGrapher::attributeChanged()
 			if (currentResults->hasFlyAttribute<float>(attributeName)) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<float>& data = currentResults->getFlyData<float>(flyNumber, attributeName);
-					plot->addLineFillGraph(data.begin(), data.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0, -0.1 * flyNumber - 0.1), data.getUnit());	//TODO: fix grapher near- and far-plane
+					const boost::shared_ptr<const Attribute<float> > data = currentResults->getFlyView<float>(flyNumber, attributeName);
+					plot->addLineFillGraph(data->begin(), data->end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0, -0.1 * flyNumber - 0.1), data->getUnit());	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 			} else if (currentResults->hasFlyAttribute<MyBool>(attributeName)) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<MyBool>& data = currentResults->getFlyData<MyBool>(flyNumber, attributeName);
-					plot->addLineFillGraph(data.begin(), data.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data.getUnit());	//TODO: fix grapher near- and far-plane
+					const boost::shared_ptr<const Attribute<MyBool> > data = currentResults->getFlyView<MyBool>(flyNumber, attributeName);
+					plot->addLineFillGraph(data->begin(), data->end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data->getUnit());	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 				frame->setTitle("Fly attribute " + QString::fromStdString(attributeName) + " shown");
 			} else if (currentResults->hasFlyAttribute<uint32_t>(attributeName)) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<uint32_t>& data = currentResults->getFlyData<uint32_t>(flyNumber, attributeName);
-					plot->addLineFillGraph(data.begin(), data.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data.getUnit());	//TODO: fix grapher near- and far-plane
+					const boost::shared_ptr<const Attribute<uint32_t> > data = currentResults->getFlyView<uint32_t>(flyNumber, attributeName);
+					plot->addLineFillGraph(data->begin(), data->end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data->getUnit());	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 			} else if (currentResults->hasFlyAttribute<Vf2>(attributeName)) {
 				dimensionComboBox->blockSignals(true);
@@ -250,15 +250,15 @@ void AttributeGrapher::attributeChanged()
 				dimensionComboBox->blockSignals(false);
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<Vf2>& data = currentResults->getFlyData<Vf2>(flyNumber, attributeName);
+					const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFlyView<Vf2>(flyNumber, attributeName);
 					std::vector<float> xOnly;
-					xOnly.reserve(data.size());
-					for (size_t i = 0; i != data.size(); ++i) {
-						xOnly.push_back(data[i][0]);
+					xOnly.reserve(data->size());
+					for (size_t i = 0; i != data->size(); ++i) {
+						xOnly.push_back((*data)[i][0]);
 					}
-					plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data.getUnit());	//TODO: fix grapher near- and far-plane
+					plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data->getUnit());	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 			}
 			frame->setTitle("Fly attribute: " + attributeDescription);
@@ -271,45 +271,45 @@ void AttributeGrapher::attributeChanged()
 			QString attributeDescription("Cannot be displayed.");
 			if (currentResults->hasPairAttribute<float>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<float>& fly0Data = currentResults->getPairData<float>(0, 1, attributeName);
-				plot->addLineFillGraph(fly0Data.begin(), fly0Data.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data.getUnit());
-				const Attribute<float>& fly1Data = currentResults->getPairData<float>(1, 0, attributeName);
-				plot->addLineFillGraph(fly1Data.begin(), fly1Data.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data.getUnit());
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				const boost::shared_ptr<const Attribute<float> > fly0Data = currentResults->getPairView<float>(0, 1, attributeName);
+				plot->addLineFillGraph(fly0Data->begin(), fly0Data->end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data->getUnit());
+				const boost::shared_ptr<const Attribute<float> > fly1Data = currentResults->getPairView<float>(1, 0, attributeName);
+				plot->addLineFillGraph(fly1Data->begin(), fly1Data->end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data->getUnit());
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			} else if (currentResults->hasPairAttribute<MyBool>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<MyBool>& fly0Data = currentResults->getPairData<MyBool>(0, 1, attributeName);
-				plot->addLineFillGraph(fly0Data.begin(), fly0Data.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data.getUnit());
-				const Attribute<MyBool>& fly1Data = currentResults->getPairData<MyBool>(1, 0, attributeName);
-				plot->addLineFillGraph(fly1Data.begin(), fly1Data.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data.getUnit());
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				const boost::shared_ptr<const Attribute<MyBool> > fly0Data = currentResults->getPairView<MyBool>(0, 1, attributeName);
+				plot->addLineFillGraph(fly0Data->begin(), fly0Data->end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data->getUnit());
+				const boost::shared_ptr<const Attribute<MyBool> > fly1Data = currentResults->getPairView<MyBool>(1, 0, attributeName);
+				plot->addLineFillGraph(fly1Data->begin(), fly1Data->end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data->getUnit());
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			} else if (currentResults->hasPairAttribute<uint32_t>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<uint32_t>& fly0Data = currentResults->getPairData<uint32_t>(0, 1, attributeName);
-				plot->addLineFillGraph(fly0Data.begin(), fly0Data.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data.getUnit());
-				const Attribute<uint32_t>& fly1Data = currentResults->getPairData<uint32_t>(1, 0, attributeName);
-				plot->addLineFillGraph(fly1Data.begin(), fly1Data.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data.getUnit());
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				const boost::shared_ptr<const Attribute<uint32_t> > fly0Data = currentResults->getPairView<uint32_t>(0, 1, attributeName);
+				plot->addLineFillGraph(fly0Data->begin(), fly0Data->end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data->getUnit());
+				const boost::shared_ptr<const Attribute<uint32_t> > fly1Data = currentResults->getPairView<uint32_t>(1, 0, attributeName);
+				plot->addLineFillGraph(fly1Data->begin(), fly1Data->end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data->getUnit());
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			} else if (currentResults->hasPairAttribute<Vf2>(attributeName)) {
 				dimensionComboBox->blockSignals(true);
 				dimensionComboBox->addItem("X", 0);
 				dimensionComboBox->addItem("Y", 1);
 				dimensionComboBox->blockSignals(false);
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& fly0Data = currentResults->getPairData<Vf2>(0, 1, attributeName);
+				const boost::shared_ptr<const Attribute<Vf2> > fly0Data = currentResults->getPairView<Vf2>(0, 1, attributeName);
 				std::vector<float> xOnly;
-				xOnly.reserve(fly0Data.size());
-				for (size_t i = 0; i != fly0Data.size(); ++i) {
-					xOnly.push_back(fly0Data[i][0]);
+				xOnly.reserve(fly0Data->size());
+				for (size_t i = 0; i != fly0Data->size(); ++i) {
+					xOnly.push_back((*fly0Data)[i][0]);
 				}
-				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data.getUnit());
-				const Attribute<Vf2>& fly1Data = currentResults->getPairData<Vf2>(1, 0, attributeName);
+				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data->getUnit());
+				const boost::shared_ptr<const Attribute<Vf2> > fly1Data = currentResults->getPairView<Vf2>(1, 0, attributeName);
 				xOnly.clear();
-				for (size_t i = 0; i != fly1Data.size(); ++i) {
-					xOnly.push_back(fly1Data[i][0]);
+				for (size_t i = 0; i != fly1Data->size(); ++i) {
+					xOnly.push_back((*fly1Data)[i][0]);
 				}
-				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data.getUnit());
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data->getUnit());
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			}
 			frame->setTitle("Pair attribute: " + attributeDescription);
 			return;
@@ -342,13 +342,13 @@ void AttributeGrapher::dimensionChanged(int index)
 			plot->addUnitGraph(1000, 1.0f, true, QVector4D(0.0, 0.0, 0.0, 1.0));
 			if (currentResults->hasFrameAttribute<Vf2>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& data = currentResults->getFrameData<Vf2>(attributeName);
+				const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFrameView<Vf2>(attributeName);
 				std::vector<float> xOnly;
-				xOnly.reserve(data.size());
-				for (size_t i = 0; i != data.size(); ++i) {
-					xOnly.push_back(data[i][index]);
+				xOnly.reserve(data->size());
+				for (size_t i = 0; i != data->size(); ++i) {
+					xOnly.push_back((*data)[i][index]);
 				}
-				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data.getUnit());
+				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), data->getUnit());
 			}
 			return;
 		}
@@ -358,13 +358,13 @@ void AttributeGrapher::dimensionChanged(int index)
 			if (currentResults->hasFlyAttribute<Vf2>(attributeName)) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<Vf2>& data = currentResults->getFlyData<Vf2>(flyNumber, attributeName);
+					const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFlyView<Vf2>(flyNumber, attributeName);
 					std::vector<float> xOnly;
-					xOnly.reserve(data.size());
-					for (size_t i = 0; i != data.size(); ++i) {
-						xOnly.push_back(data[i][index]);
+					xOnly.reserve(data->size());
+					for (size_t i = 0; i != data->size(); ++i) {
+						xOnly.push_back((*data)[i][index]);
 					}
-					plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data.getUnit());	//TODO: fix grapher near- and far-plane
+					plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), data->getUnit());	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
 				}
 			}
@@ -375,19 +375,19 @@ void AttributeGrapher::dimensionChanged(int index)
 			plot->addUnitGraph(1000, 1.0f, true, QVector4D(0.0, 0.0, 0.0, 1.0));
 			if (currentResults->hasPairAttribute<Vf2>(attributeName)) {
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& fly0Data = currentResults->getPairData<Vf2>(0, 1, attributeName);
+				const boost::shared_ptr<const Attribute<Vf2> > fly0Data = currentResults->getPairView<Vf2>(0, 1, attributeName);
 				std::vector<float> xOnly;
-				xOnly.reserve(fly0Data.size());
-				for (size_t i = 0; i != fly0Data.size(); ++i) {
-					xOnly.push_back(fly0Data[i][index]);
+				xOnly.reserve(fly0Data->size());
+				for (size_t i = 0; i != fly0Data->size(); ++i) {
+					xOnly.push_back((*fly0Data)[i][index]);
 				}
-				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data.getUnit());
-				const Attribute<Vf2>& fly1Data = currentResults->getPairData<Vf2>(1, 0, attributeName);
+				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly0Data->getUnit());
+				const boost::shared_ptr<const Attribute<Vf2> > fly1Data = currentResults->getPairView<Vf2>(1, 0, attributeName);
 				xOnly.clear();
-				for (size_t i = 0; i != fly1Data.size(); ++i) {
-					xOnly.push_back(fly1Data[i][index]);
+				for (size_t i = 0; i != fly1Data->size(); ++i) {
+					xOnly.push_back((*fly1Data)[i][index]);
 				}
-				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data.getUnit());
+				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), fly1Data->getUnit());
 			}
 			return;
 		}
@@ -14,6 +14,7 @@
 #include "global.hpp"
 #include "ExternalJob.hpp"
 #include "ClusterJob.hpp"
+#include "SongDetectionJob.hpp"
 #include "JobQueue.hpp"
 #include "ArenaItem.hpp"
 #include "MateBook.hpp"
@@ -809,6 +810,7 @@ void FileItem::childItemChanged(ArenaItem* child)
 // saves the options that were used for the analysis, creates a parameter string
 // this string is used for the matlab process and to be able to identify if two
 // files ran with the same parametrs (saved in video.tsv)
+// the song is detected in-process unless the UseFlysong option asks for the external flysong
 void FileItem::startPulseDetection(){
 	QString newPath(videoFilePath.c_str()); 
 
@@ -832,33 +834,39 @@ void FileItem::startPulseDetection(){
 			<< QString::number(pulseDetectionOptions["MaxPulseScaleFreq"]) << QString::number(pulseDetectionOptions["MinDogSperation"]) << QString::number(pulseDetectionOptions["MinMorletSeperation"]) 
 			<< QString::number(pulseDetectionOptions["PeakExpansionFact"]) << QString::number(pulseDetectionOptions["PeakToPeakVoltage"]) << QString::number(pulseDetectionOptions["MaxPulseDistance"]) 
 			<< QString::number(pulseDetectionOptions["MinPulseDistance"]) << QString::number(pulseDetectionOptions["PulseTimeWindow"]) << QString::number(pulseDetectionOptions["Exclude0Cycles"]);
-		songOptionId = noiseFileName + " " + QString(param.join(" ")).toStdString(); // id to see if songs ran with same options
+		const bool useFlysong = pulseDetectionOptions["UseFlysong"] != 0;
+		songOptionId = noiseFileName + " " + QString(param.join(" ")).toStdString() + (useFlysong ? " flysong" : ""); // id to see if songs ran with same options
 		
-		QStringList arguments;
-		
-		#if defined (__APPLE__)
-			QString flysongExecutable = QFileInfo(global::executableDir + "/run_flysong.sh").canonicalFilePath();
-			#if !defined(_DEBUG)
-				arguments << "/Applications/MATLAB/MATLAB_Compiler_Runtime/v715";
+		Job* jobToQueue = NULL;
+		if (useFlysong) {
+			QStringList arguments;
+			
+			#if defined (__APPLE__)
+				QString flysongExecutable = QFileInfo(global::executableDir + "/run_flysong.sh").canonicalFilePath();
+				#if !defined(_DEBUG)
+					arguments << "/Applications/MATLAB/MATLAB_Compiler_Runtime/v715";
+				#endif
+			#else
+				QString flysongExecutable = QFileInfo(global::executableDir + "/flysong.exe").canonicalFilePath();
 			#endif
-		#else
-			QString flysongExecutable = QFileInfo(global::executableDir + "/flysong.exe").canonicalFilePath();
-		#endif
-		QDir workingDirectory(absoluteDataDirectory());
-		#if defined(_DEBUG)
-			flysongExecutable = getMateBook()->getConfigDialog()->getMatlabExecutable();
-			#if defined(__APPLE__)
-				arguments << "-r" << "Process_Song_Save('" + absoluteDataDirectory().absolutePath() + "', '" + newPath + "', '" + QString::fromStdString(noiseFileName) + "', " + param.join(", ") + ");" /*<< "-logfile" << absoluteDataDirectory().absolutePath() + QString("/matlab.log")*/ << "-desktop";
-				workingDirectory = QDir(global::executableDir + "../../../../../../../flysong/source");
+			QDir workingDirectory(absoluteDataDirectory());
+			#if defined(_DEBUG)
+				flysongExecutable = getMateBook()->getConfigDialog()->getMatlabExecutable();
+				#if defined(__APPLE__)
+					arguments << "-r" << "Process_Song_Save('" + absoluteDataDirectory().absolutePath() + "', '" + newPath + "', '" + QString::fromStdString(noiseFileName) + "', " + param.join(", ") + ");" /*<< "-logfile" << absoluteDataDirectory().absolutePath() + QString("/matlab.log")*/ << "-desktop";
+					workingDirectory = QDir(global::executableDir + "../../../../../../../flysong/source");
+				#else
+					arguments << "-r" << "Process_Song_Save('" + absoluteDataDirectory().absolutePath() + "', '" + newPath + "', '" + QString::fromStdString(noiseFileName) + "', " + param.join(", ") + ");" << "-wait";
+					workingDirectory = QDir("../../flysong/source");
+				#endif
 			#else
-				arguments << "-r" << "Process_Song_Save('" + absoluteDataDirectory().absolutePath() + "', '" + newPath + "', '" + QString::fromStdString(noiseFileName) + "', " + param.join(", ") + ");" << "-wait";
-				workingDirectory = QDir("../../flysong/source");
+				arguments << absoluteDataDirectory().absolutePath() << newPath << QString::fromStdString(noiseFileName) << param;
 			#endif
-		#else
-			arguments << absoluteDataDirectory().absolutePath() << newPath << QString::fromStdString(noiseFileName) << param;
-		#endif
-		
-		Job* jobToQueue = new ExternalJob(flysongExecutable, arguments, workingDirectory);
+			
+			jobToQueue = new ExternalJob(flysongExecutable, arguments, workingDirectory);
+		} else {
+			jobToQueue = new SongDetectionJob(newPath, QString::fromStdString(noiseFileName), pulseDetectionOptions, absoluteDataDirectory());
+		}
 
 		connect(jobToQueue, SIGNAL(jobStarted(Job*)), this, SLOT(jobStarted(Job*)));
 		connect(jobToQueue, SIGNAL(jobFinished(Job*)), this, SLOT(jobFinished(Job*)));
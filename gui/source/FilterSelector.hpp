@@ -4,9 +4,12 @@
 #include <QWidget>
 #include <QDir>
 
+#include <algorithm>
 #include <boost/shared_ptr.hpp>
 #include "ArenaItem.hpp"
+#include "AttributeCache.hpp"
 #include "../../tracker/source/Attribute.hpp"
+#include "../../common/source/Singleton.hpp"
 
 QT_BEGIN_NAMESPACE
 class QComboBox;
@@ -20,6 +23,24 @@ QT_END_NAMESPACE
 
 class ColorButton;
 
+// one bit per frame, 64 frames per word; a filter clears the bits of the frames that don't pass it
+typedef std::vector<uint64_t> FrameMask;
+
+// a mask with the bits of all frames set
+inline FrameMask makeFrameMask(size_t frameCount)
+{
+	FrameMask mask((frameCount + 63) / 64, ~static_cast<uint64_t>(0));
+	if (frameCount % 64) {
+		mask.back() = (static_cast<uint64_t>(1) << (frameCount % 64)) - 1;
+	}
+	return mask;
+}
+
+inline bool isFrameSet(const FrameMask& mask, size_t frame)
+{
+	return (mask[frame / 64] >> (frame % 64)) & 1;
+}
+
 class Filter {
 public:
 	Filter(QString attributeName, QString attributeKind, unsigned int activeFly, unsigned int passiveFly) :
@@ -30,7 +51,12 @@ public:
 	{
 	}
 
-	virtual std::vector<size_t> apply(const ArenaItem& arenaItem, const std::vector<size_t> indexes) = 0;
+	virtual ~Filter()
+	{
+	}
+
+	// clears the frames of the mask that don't pass; the attribute columns come from the AttributeCache, so this may be called from several threads
+	virtual void apply(const QDir& dataDirectory, FrameMask& mask) const = 0;
 
 protected:
 	QString getAttributePath() const
@@ -53,7 +79,7 @@ private:
 template<class T>
 class KeepEqual {
 public:
-	bool operator()(const T& left, const T& right)
+	bool operator()(const T& left, const T& right) const
 	{
 		return left == right;
 	}
@@ -62,7 +88,7 @@ public:
 template<class T>
 class KeepLessThan {
 public:
-	bool operator()(const T& left, const T& right)
+	bool operator()(const T& left, const T& right) const
 	{
 		return left < right;
 	}
@@ -71,7 +97,7 @@ public:
 template<class T>
 class KeepGreaterThan {
 public:
-	bool operator()(const T& left, const T& right)
+	bool operator()(const T& left, const T& right) const
 	{
 		return left > right;
 	}
@@ -85,19 +111,25 @@ public:
 	{
 	}
 
-	std::vector<size_t> apply(const ArenaItem& arenaItem, const std::vector<size_t> indexes)
+	void apply(const QDir& dataDirectory, FrameMask& mask) const
 	{
-		QString attributePath = arenaItem.absoluteDataDirectory().filePath(getAttributePath());
-		Attribute<T> attribute;
-		attribute.readBinaries(attributePath.toStdString());
-		std::vector<size_t> passedIndexes;
-		passedIndexes.reserve(indexes.size());
-		for (std::vector<size_t>::const_iterator iter = indexes.begin(); iter != indexes.end(); ++iter) {
-			if (*iter < attribute.size() && OP<T>()(attribute[*iter], operand)) {
-				passedIndexes.push_back(*iter);
+		const boost::shared_ptr<AbstractAttribute> cachedAttribute = Singleton<AttributeCache>::instance().get(dataDirectory.filePath(getAttributePath()).toStdString(), Attribute<T>());
+		const Attribute<T>& attribute = *assert_cast<const Attribute<T>*>(cachedAttribute.get());
+		const size_t attributeSize = attribute.size();
+		const OP<T> op = OP<T>();
+		// frames beyond the end of the attribute don't pass
+		for (size_t word = 0; word != mask.size(); ++word) {
+			if (!mask[word]) {
+				continue;
 			}
+			const size_t begin = word * 64;
+			const size_t end = std::min(begin + 64, attributeSize);
+			uint64_t passed = 0;
+			for (size_t frame = begin; frame < end; ++frame) {
+				passed |= static_cast<uint64_t>(op(attribute[frame], operand)) << (frame - begin);
+			}
+			mask[word] &= passed;
 		}
-		return passedIndexes;
 	}
 
 private:
@@ -114,19 +146,24 @@ public:
 		assert(dimension < N);
 	}
 
-	std::vector<size_t> apply(const ArenaItem& arenaItem, const std::vector<size_t> indexes)
+	void apply(const QDir& dataDirectory, FrameMask& mask) const
 	{
-		QString attributePath = arenaItem.absoluteDataDirectory().filePath(getAttributePath());
-		Attribute<Vec<S, N> > attribute;
-		attribute.readBinaries(attributePath.toStdString());
-		std::vector<size_t> passedIndexes;
-		passedIndexes.reserve(indexes.size());
-		for (std::vector<size_t>::const_iterator iter = indexes.begin(); iter != indexes.end(); ++iter) {
-			if (*iter < attribute.size() && OP<S>()(attribute[*iter][dimension], operand)) {
-				passedIndexes.push_back(*iter);
+		const boost::shared_ptr<AbstractAttribute> cachedAttribute = Singleton<AttributeCache>::instance().get(dataDirectory.filePath(getAttributePath()).toStdString(), Attribute<Vec<S, N> >());
+		const Attribute<Vec<S, N> >& attribute = *assert_cast<const Attribute<Vec<S, N> >*>(cachedAttribute.get());
+		const size_t attributeSize = attribute.size();
+		const OP<S> op = OP<S>();
+		for (size_t word = 0; word != mask.size(); ++word) {
+			if (!mask[word]) {
+				continue;
+			}
+			const size_t begin = word * 64;
+			const size_t end = std::min(begin + 64, attributeSize);
+			uint64_t passed = 0;
+			for (size_t frame = begin; frame < end; ++frame) {
+				passed |= static_cast<uint64_t>(op(attribute[frame][dimension], operand)) << (frame - begin);
 			}
+			mask[word] &= passed;
 		}
-		return passedIndexes;
 	}
 
 private:
@@ -0,0 +1,172 @@
+#include "FrameCache.hpp"
+#include <QMutexLocker>
+#include <algorithm>
+
+FrameCache::FrameCache(boost::shared_ptr<mw::InputVideo> inputVideo, unsigned int frameCount, unsigned int frameWidth, unsigned int frameHeight, size_t byteCapacity) :
+	inputVideo(inputVideo),
+	frameCount(frameCount),
+	frameWidth(frameWidth),
+	frameHeight(frameHeight),
+	capacity(0),
+	leadingCount(0),
+	trailingCount(0),
+	mutex(),
+	currentFrameChanged(),
+	frameInserted(),
+	entries(),
+	recency(),
+	currentFrame(0),
+	backward(false),
+	stopping(false)
+{
+	const size_t frameByteCount = std::max<size_t>(static_cast<size_t>(frameWidth) * frameHeight * 3, 1);
+	capacity = std::max<size_t>(byteCapacity / frameByteCount, 4);
+	trailingCount = (capacity - 1) / 4;
+	leadingCount = capacity - 1 - trailingCount;
+	start(QThread::LowPriority);
+}
+
+FrameCache::~FrameCache()
+{
+	{
+		QMutexLocker locker(&mutex);
+		stopping = true;
+		currentFrameChanged.wakeAll();
+	}
+	wait();
+}
+
+void FrameCache::setCurrentFrame(unsigned int frameNumber)
+{
+	QMutexLocker locker(&mutex);
+	if (frameNumber == currentFrame) {
+		return;
+	}
+	backward = frameNumber < currentFrame;
+	currentFrame = frameNumber;
+	currentFrameChanged.wakeAll();
+}
+
+boost::shared_ptr<const FrameCache::Frame> FrameCache::getFrame(unsigned int frameNumber)
+{
+	if (frameNumber >= frameCount) {
+		return boost::shared_ptr<const Frame>(new Frame());
+	}
+	QMutexLocker locker(&mutex);
+	EntryMap::iterator iter = entries.find(frameNumber);
+	if (iter == entries.end()) {
+		return boost::shared_ptr<const Frame>();
+	}
+	recency.splice(recency.begin(), recency, iter->second.recency);
+	return iter->second.frame;
+}
+
+boost::shared_ptr<const FrameCache::Frame> FrameCache::waitForFrame(unsigned int frameNumber)
+{
+	if (frameNumber >= frameCount) {
+		return boost::shared_ptr<const Frame>(new Frame());
+	}
+	QMutexLocker locker(&mutex);
+	EntryMap::iterator iter = entries.find(frameNumber);
+	while (iter == entries.end()) {
+		frameInserted.wait(&mutex);
+		iter = entries.find(frameNumber);
+	}
+	recency.splice(recency.begin(), recency, iter->second.recency);
+	return iter->second.frame;
+}
+
+void FrameCache::run()
+{
+	QMutexLocker locker(&mutex);
+	while (!stopping) {
+		unsigned int frameNumber = 0;
+		if (!findMissingFrame(frameNumber)) {
+			currentFrameChanged.wait(&mutex);
+			continue;
+		}
+		locker.unlock();
+		boost::shared_ptr<Frame> frame(new Frame(static_cast<size_t>(frameWidth) * frameHeight * 3));
+		if (!inputVideo->seek(frameNumber) || !inputVideo->readFrame(PIX_FMT_RGB24, &(*frame)[0], frameWidth * 3)) {
+			frame->clear();	// remembered as undecodable, so it isn't tried again and again
+		}
+		locker.relock();
+		insert(frameNumber, frame);
+		frameInserted.wakeAll();
+	}
+}
+
+// the current frame comes first, then the ones it is stepped towards, then the ones it came from
+bool FrameCache::findMissingFrame(unsigned int& frameNumber) const
+{
+	if (entries.find(currentFrame) == entries.end()) {
+		frameNumber = currentFrame;
+		return true;
+	}
+	const unsigned int after = std::min(frameCount, currentFrame + 1 + (backward ? trailingCount : leadingCount));
+	if (!backward) {
+		return findMissingFrame(currentFrame + 1, after, frameNumber) || findMissingFrame(currentFrame - std::min(currentFrame, trailingCount), currentFrame, frameNumber);
+	}
+
+	// the frames before the current one can only be decoded in a forward pass from the keyframe before them,
+	// so they're refilled in one pass once half of them have been used up rather than one pass per step
+	const unsigned int before = currentFrame - std::min(currentFrame, leadingCount);
+	unsigned int cachedCount = 0;
+	while (cachedCount != currentFrame - before && entries.find(currentFrame - 1 - cachedCount) != entries.end()) {
+		++cachedCount;
+	}
+	if (cachedCount < (currentFrame - before + 1) / 2) {
+		return findMissingFrame(before, currentFrame, frameNumber);
+	}
+	return findMissingFrame(currentFrame + 1, after, frameNumber);
+}
+
+// the first frame in [begin, end) that isn't cached
+bool FrameCache::findMissingFrame(unsigned int begin, unsigned int end, unsigned int& frameNumber) const
+{
+	EntryMap::const_iterator iter = entries.lower_bound(begin);
+	for (unsigned int candidate = begin; candidate < end; ++candidate, ++iter) {
+		if (iter == entries.end() || iter->first != candidate) {
+			frameNumber = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FrameCache::isInWindow(unsigned int frameNumber) const
+{
+	const unsigned int beforeCount = backward ? leadingCount : trailingCount;
+	const unsigned int afterCount = backward ? trailingCount : leadingCount;
+	return frameNumber + beforeCount >= currentFrame && frameNumber <= currentFrame + afterCount;
+}
+
+void FrameCache::insert(unsigned int frameNumber, boost::shared_ptr<const Frame> frame)
+{
+	EntryMap::iterator iter = entries.find(frameNumber);
+	if (iter != entries.end()) {
+		recency.erase(iter->second.recency);
+		entries.erase(iter);
+	}
+	recency.push_front(frameNumber);
+	Entry& entry = entries[frameNumber];
+	entry.frame = frame;
+	entry.recency = recency.begin();
+
+	// drop the least recently used frames, but those around the current frame only if there's nothing else left
+	while (entries.size() > capacity) {
+		std::list<unsigned int>::iterator victim = recency.end();
+		for (std::list<unsigned int>::iterator candidate = recency.end(); candidate != recency.begin(); ) {
+			--candidate;
+			if (!isInWindow(*candidate)) {
+				victim = candidate;
+				break;
+			}
+		}
+		if (victim == recency.end()) {
+			--victim;
+		}
+		entries.erase(*victim);
+		recency.erase(victim);
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef FrameCache_hpp
+#define FrameCache_hpp
+
+/*
+The FrameCache decodes the frames of a video in a background thread and keeps them as RGB buffers, so that the GUI never waits for the decoder.
+It decodes the frames around the current frame, most of them in the direction the video was last stepped in and a few in the other,
+so that playing, scrubbing and stepping backward are served from memory.
+Once the cache is full, the least recently used frames outside of that window are dropped.
+The cache takes over the InputVideo it is given; nobody else may use it afterwards.
+*/
+
+#include <map>
+#include <list>
+#include <vector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <boost/shared_ptr.hpp>
+#include "../../mediawrapper/source/mediawrapper.hpp"
+
+class FrameCache : public QThread {
+public:
+	typedef std::vector<unsigned char> Frame;
+
+	FrameCache(boost::shared_ptr<mw::InputVideo> inputVideo, unsigned int frameCount, unsigned int frameWidth, unsigned int frameHeight, size_t byteCapacity = 256 * 1024 * 1024);
+	~FrameCache();	// stops the decoder
+
+	void setCurrentFrame(unsigned int frameNumber);	// the frames around it are decoded next
+
+	// the frame if it has been decoded, empty if it couldn't be, or NULL if it hasn't been decoded yet; never waits for the decoder
+	boost::shared_ptr<const Frame> getFrame(unsigned int frameNumber);
+	// like getFrame(), but waits for the decoder instead of returning NULL; the frame must be around the current frame, or it might never be decoded
+	boost::shared_ptr<const Frame> waitForFrame(unsigned int frameNumber);
+
+protected:
+	void run();
+
+private:
+	FrameCache(const FrameCache&);	// not copyable
+	FrameCache& operator=(const FrameCache&);
+
+	struct Entry {
+		boost::shared_ptr<const Frame> frame;
+		std::list<unsigned int>::iterator recency;
+	};
+	typedef std::map<unsigned int, Entry> EntryMap;
+
+	bool findMissingFrame(unsigned int& frameNumber) const;
+	bool findMissingFrame(unsigned int begin, unsigned int end, unsigned int& frameNumber) const;
+	bool isInWindow(unsigned int frameNumber) const;
+	void insert(unsigned int frameNumber, boost::shared_ptr<const Frame> frame);
+
+	boost::shared_ptr<mw::InputVideo> inputVideo;	// only used by the decoder thread
+	const unsigned int frameCount;
+	const unsigned int frameWidth;
+	const unsigned int frameHeight;
+	size_t capacity;	// in frames
+	unsigned int leadingCount;	// frames decoded in the direction of stepping
+	unsigned int trailingCount;	// frames decoded in the other direction
+
+	QMutex mutex;
+	QWaitCondition currentFrameChanged;
+	QWaitCondition frameInserted;
+	EntryMap entries;
+	std::list<unsigned int> recency;	// the frame numbers, most recently used first
+	unsigned int currentFrame;
+	bool backward;	// whether the video was last stepped backward
+	bool stopping;
+};
+
+#endif
@@ -8,6 +8,9 @@
 #include <algorithm>
 #include <numeric>
 #include <limits>
+#include <fstream>
+#include <stdint.h>
+#include <boost/shared_ptr.hpp>
 #include "GroupsTab.hpp"
 #include "ArenaItem.hpp"
 #include "RuntimeError.hpp"
@@ -26,6 +29,139 @@
 #include "../../common/source/debug.hpp"
 #include "../../common/source/mathematics.hpp"
 
+// a splitmix64 generator: fast, and good enough to shuffle with; each chunk of rounds seeds its own so the p-values don't depend on the number of threads
+class PermutationRandom {
+public:
+	PermutationRandom(uint64_t seed) :
+		state(seed)
+	{
+	}
+
+	uint64_t next()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	// uniform in [0, bound) for bounds well below 2^32
+	size_t below(size_t bound)
+	{
+		return static_cast<size_t>(((next() >> 32) * bound) >> 32);
+	}
+
+private:
+	uint64_t state;
+};
+
+double getLearningIndex(double naiveSum, size_t naiveCount, double trainedSum, size_t trainedCount)
+{
+	return 1 - (trainedSum / trainedCount) / (naiveSum / naiveCount);
+}
+
+struct PermutationPair {
+	size_t first;	// the naive group
+	size_t second;	// the trained group
+	double naiveSum;
+	double totalSum;	// of both groups, summed in the order the workers pool them
+	double learningIndex;	// the actual one, computed the way the workers compute the random ones
+	size_t exceededCount;	// how often the random learning index exceeded the actual one
+};
+
+PermutationPair makePermutationPair(const std::vector<std::vector<float> >& groupMeans, size_t first, size_t second)
+{
+	PermutationPair pair;
+	pair.first = first;
+	pair.second = second;
+	const std::vector<float>& naive = groupMeans[first];
+	const std::vector<float>& trained = groupMeans[second];
+	pair.naiveSum = std::accumulate(naive.begin(), naive.end(), 0.0);
+	pair.totalSum = std::accumulate(trained.begin(), trained.end(), pair.naiveSum);
+	pair.learningIndex = getLearningIndex(pair.naiveSum, naive.size(), pair.totalSum - pair.naiveSum, trained.size());
+	pair.exceededCount = 0;
+	return pair;
+}
+
+// the rounds of all pairs are split into chunks, which the workers take turns picking up
+class PermutationWorker : public QThread {
+public:
+	static const size_t chunkRounds = 16384;
+	static const uint64_t seed = 0x4D617465426F6F6BULL;	// fixed so that running a test again gives the same p-values
+
+	PermutationWorker(const std::vector<std::vector<float> >& groupMeans, std::vector<PermutationPair>& pairs, size_t rounds, size_t chunkCount, size_t& nextChunk, size_t& completedRounds, QMutex& mutex, const volatile bool& stopRequested) :
+		groupMeans(groupMeans),
+		pairs(pairs),
+		rounds(rounds),
+		chunkCount(chunkCount),
+		nextChunk(nextChunk),
+		completedRounds(completedRounds),
+		mutex(mutex),
+		stopRequested(stopRequested)
+	{
+	}
+
+protected:
+	void run()
+	{
+		const size_t chunksPerPair = chunkCount / std::max<size_t>(pairs.size(), 1);
+		std::vector<float> pooled;	// outside the loop to avoid reallocations
+		size_t chunkNumber = 0;
+		size_t exceededCount = 0;
+		size_t chunkRoundCount = 0;
+		while (true) {
+			{
+				QMutexLocker locker(&mutex);
+				if (chunkRoundCount != 0) {
+					pairs[chunkNumber / chunksPerPair].exceededCount += exceededCount;
+					completedRounds += chunkRoundCount;
+				}
+				if (nextChunk == chunkCount || stopRequested) {
+					return;
+				}
+				chunkNumber = nextChunk++;
+			}
+			const PermutationPair& pair = pairs[chunkNumber / chunksPerPair];
+			const size_t firstRound = (chunkNumber % chunksPerPair) * chunkRounds;
+			chunkRoundCount = std::min(rounds - firstRound, chunkRounds);
+			const std::vector<float>& naive = groupMeans[pair.first];
+			const std::vector<float>& trained = groupMeans[pair.second];
+			pooled = naive;
+			pooled.insert(pooled.end(), trained.begin(), trained.end());
+
+			// only the smaller group is drawn, with a partial Fisher-Yates shuffle; the rest of the pool is the other group
+			const bool drawNaive = naive.size() <= trained.size();
+			const size_t drawCount = std::min(naive.size(), trained.size());
+			PermutationRandom random(seed ^ PermutationRandom(chunkNumber).next());
+			exceededCount = 0;
+			for (size_t round = 0; round != chunkRoundCount; ++round) {
+				double drawnSum = 0;
+				for (size_t drawn = 0; drawn != drawCount; ++drawn) {
+					std::swap(pooled[drawn], pooled[drawn + random.below(pooled.size() - drawn)]);
+					drawnSum += pooled[drawn];
+				}
+				const double naiveSum = drawNaive ? drawnSum : pair.totalSum - drawnSum;
+				if (getLearningIndex(naiveSum, naive.size(), pair.totalSum - naiveSum, trained.size()) >= pair.learningIndex) {
+					++exceededCount;
+				}
+			}
+		}
+	}
+
+private:
+	const std::vector<std::vector<float> >& groupMeans;
+	std::vector<PermutationPair>& pairs;
+	const size_t rounds;
+	const size_t chunkCount;
+	size_t& nextChunk;
+	size_t& completedRounds;
+	QMutex& mutex;
+	const volatile bool& stopRequested;
+};
+
+const size_t PermutationWorker::chunkRounds;
+const uint64_t PermutationWorker::seed;
+
 GroupsTab::GroupsTab(QWidget* parent) : AbstractTab(parent),
 	currentProject(NULL)
 {
@@ -171,20 +307,11 @@ void GroupsTab::runPermutationTest()
 		return;
 	}
 
-	QString resultFileName(currentProject->getDirectory().canonicalPath() + "/" + "permutationTest_" + QDateTime::currentDateTime().toString("yyyy-MM-ddThh.mm.ss.zzz") + "_" + QString::number(qrand()) + ".tsv");
-	std::ofstream resultFile(resultFileName.toStdString().c_str());
-	char separator = '\t';
-	resultFile <<
-		"1st Group" << separator << "Count" << separator << "Mean" << separator << "Standard Deviation" << separator << "S.E.M." << separator <<
-		"2nd Group" << separator << "Count" << separator << "Mean" << separator << "Standard Deviation" << separator << "S.E.M." << separator <<
-		"Learning Index" << separator << "p" << '\n';
-
 	const size_t rounds = roundsSpinBox->value();
 
 	//TODO: this should not be hardcoded
 	const size_t maleCourtingIndex = 18;	// the column in the TSV file
 
-	//TODO: this should be implemented with caching...there's a lot of overhead in reading the means for each pair
 	const std::vector<AbstractGroupItem*>& groups = currentProject->getGroupTree()->getGroups();
 	const std::map<QString, size_t>& groupIndexes = currentProject->getGroupTree()->getGroupIndexes();
 
@@ -198,73 +325,103 @@ void GroupsTab::runPermutationTest()
 		groupedGroups[replaced].insert(iter->second);
 	}
 
-	// we're defining them outside to avoid reallocations
-	std::vector<float> shuffledIndexes;
-	std::vector<float> naiveIndexes;
-	std::vector<float> trainedIndexes;
-
+	// each group's means are read only once, no matter how many pairs it is part of
+	std::vector<std::vector<float> > groupMeans(groups.size());
+	std::vector<PermutationPair> pairs;
 	for (std::map<QString, std::set<size_t> >::const_iterator iter = groupedGroups.begin(); iter != groupedGroups.end(); ++iter) {
-		std::set<size_t> thisGroupIndexes = iter->second;
+		const std::set<size_t>& thisGroupIndexes = iter->second;
+		for (std::set<size_t>::const_iterator groupIter = thisGroupIndexes.begin(); groupIter != thisGroupIndexes.end(); ++groupIter) {
+			groupMeans[*groupIter] = assert_cast<GroupItem*>(groups[*groupIter])->getMeans(maleCourtingIndex);
+		}
 		for (std::set<size_t>::const_iterator firstIter = thisGroupIndexes.begin(); firstIter != thisGroupIndexes.end(); ++firstIter) {
-			GroupItem* firstGroup = assert_cast<GroupItem*>(groups[*firstIter]);
-			naiveIndexes = firstGroup->getMeans(maleCourtingIndex);
-			float naiveMean = mean(naiveIndexes);
-
 			for (std::set<size_t>::const_iterator secondIter = thisGroupIndexes.begin(); secondIter != thisGroupIndexes.end(); ++secondIter) {
-				GroupItem* secondGroup = assert_cast<GroupItem*>(groups[*secondIter]);
-				trainedIndexes = secondGroup->getMeans(maleCourtingIndex);
-				float trainedMean = mean(trainedIndexes);
-				float learningIndex = 1 - trainedMean / naiveMean;
-
-				shuffledIndexes = naiveIndexes;
-				shuffledIndexes.insert(shuffledIndexes.end(), trainedIndexes.begin(), trainedIndexes.end());
-
-				size_t exceededCount = 0;	// how often the random learning index exceeded the actual one
-				for (size_t round = 0; round < rounds; ++round) {
-					std::random_shuffle(shuffledIndexes.begin(), shuffledIndexes.end());
-					float firstMean = mean(shuffledIndexes.begin(), shuffledIndexes.begin() + naiveIndexes.size());
-					float secondMean = mean(shuffledIndexes.begin() + naiveIndexes.size(), shuffledIndexes.end());
-					float randomLearningIndex = 1 - secondMean / firstMean;
-					if (randomLearningIndex >= learningIndex) {
-						++exceededCount;
-					}
-				}
+				pairs.push_back(makePermutationPair(groupMeans, *firstIter, *secondIter));
+			}
+		}
+	}
+
+	const size_t chunkCount = pairs.size() * ((rounds + PermutationWorker::chunkRounds - 1) / PermutationWorker::chunkRounds);
+	size_t nextChunk = 0;
+	size_t completedRounds = 0;
+	volatile bool stopRequested = false;
+	QMutex mutex;
+	std::vector<boost::shared_ptr<PermutationWorker> > workers;
+	for (int workerNumber = 0; workerNumber < std::max(QThread::idealThreadCount(), 1); ++workerNumber) {
+		workers.push_back(boost::shared_ptr<PermutationWorker>(new PermutationWorker(groupMeans, pairs, rounds, chunkCount, nextChunk, completedRounds, mutex, stopRequested)));
+		workers.back()->start();
+	}
 
-				float p = static_cast<float>(exceededCount) / static_cast<float>(rounds);
-
-				if (naiveIndexes.size() >= 2) {
-					resultFile <<
-						firstGroup->getName().toStdString() << separator <<
-						naiveIndexes.size() << separator <<
-						naiveMean << separator <<
-						stddev(naiveIndexes) << separator <<
-						sem(naiveIndexes) << separator;
-				} else {
-					resultFile <<
-						firstGroup->getName().toStdString() << separator <<
-						naiveIndexes.size() << separator <<
-						naiveMean << separator <<
-						"" << separator <<
-						"" << separator;
+	{	// the workers are polled for their progress until they're done
+		QProgressDialog progressDialog("Running permutation test...", "Abort", 0, 1000, this);
+		progressDialog.setWindowModality(Qt::WindowModal);
+		const double totalRounds = static_cast<double>(pairs.size()) * rounds;
+		for (size_t workerNumber = 0; workerNumber != workers.size(); ++workerNumber) {
+			while (!workers[workerNumber]->wait(100)) {
+				double completed = 0;
+				{
+					QMutexLocker locker(&mutex);
+					completed = completedRounds;
 				}
-				if (trainedIndexes.size() >= 2) {
-					resultFile <<
-						secondGroup->getName().toStdString() << separator <<
-						trainedIndexes.size() << separator <<
-						trainedMean << separator <<
-						stddev(trainedIndexes) << separator <<
-						sem(trainedIndexes) << separator;
-				} else {
-					resultFile <<
-						secondGroup->getName().toStdString() << separator <<
-						trainedIndexes.size() << separator <<
-						trainedMean << separator <<
-						"" << separator <<
-						"" << separator;
+				progressDialog.setValue(static_cast<int>(1000 * completed / totalRounds));
+				if (progressDialog.wasCanceled()) {
+					stopRequested = true;
 				}
-				resultFile << learningIndex << separator << p << '\n';
 			}
 		}
+		progressDialog.reset();
+	}
+	if (stopRequested) {
+		return;
+	}
+
+	QString resultFileName(currentProject->getDirectory().canonicalPath() + "/" + "permutationTest_" + QDateTime::currentDateTime().toString("yyyy-MM-ddThh.mm.ss.zzz") + "_" + QString::number(qrand()) + ".tsv");
+	std::ofstream resultFile(resultFileName.toStdString().c_str());
+	char separator = '\t';
+	resultFile <<
+		"1st Group" << separator << "Count" << separator << "Mean" << separator << "Standard Deviation" << separator << "S.E.M." << separator <<
+		"2nd Group" << separator << "Count" << separator << "Mean" << separator << "Standard Deviation" << separator << "S.E.M." << separator <<
+		"Learning Index" << separator << "p" << '\n';
+
+	for (std::vector<PermutationPair>::const_iterator pairIter = pairs.begin(); pairIter != pairs.end(); ++pairIter) {
+		const std::vector<float>& naiveIndexes = groupMeans[pairIter->first];
+		const std::vector<float>& trainedIndexes = groupMeans[pairIter->second];
+		float naiveMean = mean(naiveIndexes);
+		float trainedMean = mean(trainedIndexes);
+		float learningIndex = 1 - trainedMean / naiveMean;
+
+		float p = static_cast<float>(pairIter->exceededCount) / static_cast<float>(rounds);
+
+		if (naiveIndexes.size() >= 2) {
+			resultFile <<
+				groups[pairIter->first]->getName().toStdString() << separator <<
+				naiveIndexes.size() << separator <<
+				naiveMean << separator <<
+				stddev(naiveIndexes) << separator <<
+				sem(naiveIndexes) << separator;
+		} else {
+			resultFile <<
+				groups[pairIter->first]->getName().toStdString() << separator <<
+				naiveIndexes.size() << separator <<
+				naiveMean << separator <<
+				"" << separator <<
+				"" << separator;
+		}
+		if (trainedIndexes.size() >= 2) {
+			resultFile <<
+				groups[pairIter->second]->getName().toStdString() << separator <<
+				trainedIndexes.size() << separator <<
+				trainedMean << separator <<
+				stddev(trainedIndexes) << separator <<
+				sem(trainedIndexes) << separator;
+		} else {
+			resultFile <<
+				groups[pairIter->second]->getName().toStdString() << separator <<
+				trainedIndexes.size() << separator <<
+				trainedMean << separator <<
+				"" << separator <<
+				"" << separator;
+		}
+		resultFile << learningIndex << separator << p << '\n';
 	}
 	resultFile.close();
 	QDesktopServices::openUrl(QUrl("file:///" + resultFileName));
@@ -5,14 +5,19 @@
 #include <iostream>
 #include <stdexcept>
 #include <limits>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
 #include "Heatmapper.hpp"
 #include "ArenaItem.hpp"
 #include "VerticalWidgetList.hpp"
 #include "FilterSelector.hpp"
+#include "AttributeCache.hpp"
 #include "../../tracker/source/FrameAttributes.hpp"
 #include "../../tracker/source/FlyAttributes.hpp"
 #include "../../tracker/source/PairAttributes.hpp"
 #include "../../common/source/mathematics.hpp"
+#include "../../common/source/Singleton.hpp"
 
 // helper function for the VerticalWidgetList
 QWidget* createFilter()
@@ -20,6 +25,131 @@ QWidget* createFilter()
 	return new FilterSelector;
 }
 
+// the frames of an arena that pass all filters, and the file of the attribute to be heatmapped
+struct HeatmapArena {
+	QDir dataDirectory;
+	std::string attributePath;
+	FrameMask mask;
+	bool isFiltered;
+};
+
+// takes the next arena from the shared list until there are none left, filters it and then either finds the range of its values or bins them;
+// every worker keeps its own range and counts, which are merged once all arenas are done
+class HeatmapWorker : public QThread {
+public:
+	HeatmapWorker(std::vector<HeatmapArena>& arenas, const std::vector<boost::shared_ptr<Filter> >& filters, size_t& nextArena, QMutex& mutex) :
+		minX(std::numeric_limits<float>::infinity()),
+		maxX(-std::numeric_limits<float>::infinity()),
+		minY(std::numeric_limits<float>::infinity()),
+		maxY(-std::numeric_limits<float>::infinity()),
+		counts(),
+		arenas(arenas),
+		filters(filters),
+		nextArena(nextArena),
+		mutex(mutex),
+		binMinX(0),
+		binMinY(0),
+		binSizeX(0),
+		binSizeY(0),
+		horizontalBins(0),
+		verticalBins(0)
+	{
+	}
+
+	void setBins(float minX, float minY, float binSizeX, float binSizeY, int horizontalBins, int verticalBins)
+	{
+		binMinX = minX;
+		binMinY = minY;
+		this->binSizeX = binSizeX;
+		this->binSizeY = binSizeY;
+		this->horizontalBins = horizontalBins;
+		this->verticalBins = verticalBins;
+		counts.assign(horizontalBins * verticalBins, 0);
+	}
+
+	float minX;
+	float maxX;
+	float minY;
+	float maxY;
+	std::vector<size_t> counts;
+
+protected:
+	void run()
+	{
+		while (true) {
+			size_t arenaNumber = 0;
+			{
+				QMutexLocker locker(&mutex);
+				if (nextArena == arenas.size()) {
+					return;
+				}
+				arenaNumber = nextArena++;
+			}
+			HeatmapArena& arena = arenas[arenaNumber];
+
+			const boost::shared_ptr<AbstractAttribute> cachedAttribute = Singleton<AttributeCache>::instance().get(arena.attributePath, Attribute<Vf2>());
+			const Attribute<Vf2>& attribute = *assert_cast<const Attribute<Vf2>*>(cachedAttribute.get());
+
+			if (!arena.isFiltered) {
+				arena.mask = makeFrameMask(attribute.size());
+				for (std::vector<boost::shared_ptr<Filter> >::const_iterator filterIter = filters.begin(); filterIter != filters.end(); ++filterIter) {
+					(*filterIter)->apply(arena.dataDirectory, arena.mask);
+				}
+				arena.isFiltered = true;
+			}
+
+			for (size_t word = 0; word != arena.mask.size(); ++word) {
+				if (!arena.mask[word]) {
+					continue;
+				}
+				const size_t end = std::min(word * 64 + 64, attribute.size());
+				for (size_t frame = word * 64; frame < end; ++frame) {
+					if (!isFrameSet(arena.mask, frame)) {
+						continue;
+					}
+					const Vf2& value = attribute[frame];
+					if (counts.empty()) {
+						minX = std::min(minX, value[0]);
+						maxX = std::max(maxX, value[0]);
+						minY = std::min(minY, value[1]);
+						maxY = std::max(maxY, value[1]);
+					} else {
+						const int binX = (value[0] - binMinX) / binSizeX;
+						const int binY = (value[1] - binMinY) / binSizeY;
+						if (binX >= 0 && binX < horizontalBins && binY >= 0 && binY < verticalBins) {
+							++counts[horizontalBins * binY + binX];
+						}
+					}
+				}
+			}
+		}
+	}
+
+private:
+	std::vector<HeatmapArena>& arenas;
+	const std::vector<boost::shared_ptr<Filter> >& filters;
+	size_t& nextArena;
+	QMutex& mutex;
+	float binMinX;
+	float binMinY;
+	float binSizeX;
+	float binSizeY;
+	int horizontalBins;
+	int verticalBins;
+};
+
+// runs the workers over all arenas, one thread per core
+void runHeatmapWorkers(std::vector<boost::shared_ptr<HeatmapWorker> >& workers, size_t& nextArena)
+{
+	nextArena = 0;
+	for (size_t workerNumber = 0; workerNumber != workers.size(); ++workerNumber) {
+		workers[workerNumber]->start();
+	}
+	for (size_t workerNumber = 0; workerNumber != workers.size(); ++workerNumber) {
+		workers[workerNumber]->wait();
+	}
+}
+
 Heatmapper::Heatmapper(QWidget* parent) : QWidget(parent)
 {
 	QVBoxLayout* verticalLayout = new QVBoxLayout;
@@ -172,40 +302,37 @@ QImage Heatmapper::drawHeatmap(const std::vector<ArenaItem*>& arenaItems)
 		}
 	}
 
-	std::vector<Vf2> allValues;
-
-	for (std::vector<ArenaItem*>::const_iterator arenaIter = arenaItems.begin(); arenaIter != arenaItems.end(); ++arenaIter) {
-		// load attribute that will be heatmapped
-		QString attributePath = (*arenaIter)->absoluteDataDirectory().filePath(getAttributePath());
-		Attribute<Vf2> attribute;
-		attribute.readBinaries(attributePath.toStdString());
-
-		// create a vector of all indexes and apply all filters
-		size_t attributeSize = attribute.size();
-		std::vector<size_t> indexes;
-		for (size_t index = 0; index != attributeSize; ++index) {
-			indexes.push_back(index);
-		}
-		for (std::vector<boost::shared_ptr<Filter> >::const_iterator filterIter = filters.begin(); filterIter != filters.end(); ++filterIter) {
-			indexes = (*filterIter)->apply(*(*arenaIter), indexes);
-		}
+	// the data directories are looked up here, as the items may only be used by the GUI thread
+	std::vector<HeatmapArena> arenas(arenaItems.size());
+	for (size_t arenaNumber = 0; arenaNumber != arenaItems.size(); ++arenaNumber) {
+		arenas[arenaNumber].dataDirectory = arenaItems[arenaNumber]->absoluteDataDirectory();
+		arenas[arenaNumber].attributePath = arenas[arenaNumber].dataDirectory.filePath(getAttributePath()).toStdString();
+		arenas[arenaNumber].isFiltered = false;
+	}
 
-		// select the attribute values based on all indexes that made it through the filters
-		for (std::vector<size_t>::const_iterator indexIter = indexes.begin(); indexIter != indexes.end(); ++indexIter) {
-			allValues.push_back(attribute[*indexIter]);
-		}
+	size_t nextArena = 0;
+	QMutex mutex;
+	std::vector<boost::shared_ptr<HeatmapWorker> > workers;
+	for (int workerNumber = 0; workerNumber < std::max(QThread::idealThreadCount(), 1); ++workerNumber) {
+		workers.push_back(boost::shared_ptr<HeatmapWorker>(new HeatmapWorker(arenas, filters, nextArena, mutex)));
 	}
 
-	// find overall min and max x,y data values to be shown in the heatmap
+	const int horizontalBins = horizontalBinsSpinBox->value();
+	const int verticalBins = verticalBinsSpinBox->value();
+
+	// find overall min and max x,y data values to be shown in the heatmap, unless the user provided scale factors for both
 	float minX = std::numeric_limits<float>::infinity();
 	float maxX = -std::numeric_limits<float>::infinity();
 	float minY = std::numeric_limits<float>::infinity();
 	float maxY = -std::numeric_limits<float>::infinity();
-	for (std::vector<Vf2>::const_iterator iter = allValues.begin(); iter != allValues.end(); ++iter) {
-		minX = std::min(minX, (*iter)[0]);
-		maxX = std::max(maxX, (*iter)[0]);
-		minY = std::min(minY, (*iter)[1]);
-		maxY = std::max(maxY, (*iter)[1]);
+	if (!horizontalScaleFactorSpinBox->value() || !verticalScaleFactorSpinBox->value()) {
+		runHeatmapWorkers(workers, nextArena);
+		for (size_t workerNumber = 0; workerNumber != workers.size(); ++workerNumber) {
+			minX = std::min(minX, workers[workerNumber]->minX);
+			maxX = std::max(maxX, workers[workerNumber]->maxX);
+			minY = std::min(minY, workers[workerNumber]->minY);
+			maxY = std::max(maxY, workers[workerNumber]->maxY);
+		}
 	}
 	// increase the range to put the given center in the middle
 	if (centerXSpinBox->value() - minX > maxX - centerXSpinBox->value()) {
@@ -242,18 +369,18 @@ QImage Heatmapper::drawHeatmap(const std::vector<ArenaItem*>& arenaItems)
 		return QImage();
 	}
 
-	int horizontalBins = horizontalBinsSpinBox->value();
-	int verticalBins = verticalBinsSpinBox->value();
-
 	float binSizeX = (maxX - minX) / horizontalBins;
 	float binSizeY = (maxY - minY) / verticalBins;
 
+	// the masks of the first pass are kept, so the filters aren't applied again
+	for (size_t workerNumber = 0; workerNumber != workers.size(); ++workerNumber) {
+		workers[workerNumber]->setBins(minX, minY, binSizeX, binSizeY, horizontalBins, verticalBins);
+	}
+	runHeatmapWorkers(workers, nextArena);
 	std::vector<size_t> counts(horizontalBins * verticalBins, 0);
-	for (std::vector<Vf2>::const_iterator iter = allValues.begin(); iter != allValues.end(); ++iter) {
-		int binX = ((*iter)[0] - minX) / binSizeX;
-		int binY = ((*iter)[1] - minY) / binSizeY;
-		if (binX >= 0 && binX < horizontalBins && binY >= 0 && binY < verticalBins) {
-			++counts[horizontalBins * binY + binX];
+	for (size_t workerNumber = 0; workerNumber != workers.size(); ++workerNumber) {
+		for (size_t bin = 0; bin != counts.size(); ++bin) {
+			counts[bin] += workers[workerNumber]->counts[bin];
 		}
 	}
 
@@ -385,33 +512,33 @@ void Heatmapper::attributeChanged()
 			QString attributeDescription("Cannot be displayed.");
 			if (currentResults->hasFrameAttribute<float>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<float>& data = currentResults->getFrameData<float>(attributeName.toStdString());
-				plot->addLineFillGraph(data.begin(), data.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(data.getDescription());
+				const boost::shared_ptr<const Attribute<float> > data = currentResults->getFrameView<float>(attributeName.toStdString());
+				plot->addLineFillGraph(data->begin(), data->end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				attributeDescription = QString::fromStdString(data->getDescription());
 			} else if (currentResults->hasFrameAttribute<MyBool>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<MyBool>& data = currentResults->getFrameData<MyBool>(attributeName.toStdString());
-				plot->addLineFillGraph(data.begin(), data.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(data.getDescription());
+				const boost::shared_ptr<const Attribute<MyBool> > data = currentResults->getFrameView<MyBool>(attributeName.toStdString());
+				plot->addLineFillGraph(data->begin(), data->end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				attributeDescription = QString::fromStdString(data->getDescription());
 			} else if (currentResults->hasFrameAttribute<uint32_t>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<uint32_t>& data = currentResults->getFrameData<uint32_t>(attributeName.toStdString());
-				plot->addLineFillGraph(data.begin(), data.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(data.getDescription());
+				const boost::shared_ptr<const Attribute<uint32_t> > data = currentResults->getFrameView<uint32_t>(attributeName.toStdString());
+				plot->addLineFillGraph(data->begin(), data->end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				attributeDescription = QString::fromStdString(data->getDescription());
 			} else if (currentResults->hasFrameAttribute<Vf2>(attributeName.toStdString())) {
 				dimensionComboBox->blockSignals(true);
 				dimensionComboBox->addItem("X", 0);
 				dimensionComboBox->addItem("Y", 1);
 				dimensionComboBox->blockSignals(false);
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& data = currentResults->getFrameData<Vf2>(attributeName.toStdString());
+				const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFrameView<Vf2>(attributeName.toStdString());
 				std::vector<float> xOnly;
-				xOnly.reserve(data.size());
-				for (size_t i = 0; i != data.size(); ++i) {
-					xOnly.push_back(data[i][0]);
+				xOnly.reserve(data->size());
+				for (size_t i = 0; i != data->size(); ++i) {
+					xOnly.push_back((*data)[i][0]);
 				}
 				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(data.getDescription());
+				attributeDescription = QString::fromStdString(data->getDescription());
 			}
 			frame->setTitle("Frame attribute: " + attributeDescription);
 			return;
@@ -428,27 +555,27 @@ void Heatmapper::attributeChanged()
 			if (currentResults->hasFlyAttribute<float>(attributeName.toStdString())) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<float>& data = currentResults->getFlyData<float>(flyNumber, attributeName.toStdString());
-					plot->addLineFillGraph(data.begin(), data.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0, -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
+					const boost::shared_ptr<const Attribute<float> > data = currentResults->getFlyView<float>(flyNumber, attributeName.toStdString());
+					plot->addLineFillGraph(data->begin(), data->end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0, -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 			} else if (currentResults->hasFlyAttribute<MyBool>(attributeName.toStdString())) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<MyBool>& data = currentResults->getFlyData<MyBool>(flyNumber, attributeName.toStdString());
-					plot->addLineFillGraph(data.begin(), data.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
+					const boost::shared_ptr<const Attribute<MyBool> > data = currentResults->getFlyView<MyBool>(flyNumber, attributeName.toStdString());
+					plot->addLineFillGraph(data->begin(), data->end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 				frame->setTitle("Fly attribute " + attributeName + " shown");
 			} else if (currentResults->hasFlyAttribute<uint32_t>(attributeName.toStdString())) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<uint32_t>& data = currentResults->getFlyData<uint32_t>(flyNumber, attributeName.toStdString());
-					plot->addLineFillGraph(data.begin(), data.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
+					const boost::shared_ptr<const Attribute<uint32_t> > data = currentResults->getFlyView<uint32_t>(flyNumber, attributeName.toStdString());
+					plot->addLineFillGraph(data->begin(), data->end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 			} else if (currentResults->hasFlyAttribute<Vf2>(attributeName.toStdString())) {
 				dimensionComboBox->blockSignals(true);
@@ -457,15 +584,15 @@ void Heatmapper::attributeChanged()
 				dimensionComboBox->blockSignals(false);
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<Vf2>& data = currentResults->getFlyData<Vf2>(flyNumber, attributeName.toStdString());
+					const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFlyView<Vf2>(flyNumber, attributeName.toStdString());
 					std::vector<float> xOnly;
-					xOnly.reserve(data.size());
-					for (size_t i = 0; i != data.size(); ++i) {
-						xOnly.push_back(data[i][0]);
+					xOnly.reserve(data->size());
+					for (size_t i = 0; i != data->size(); ++i) {
+						xOnly.push_back((*data)[i][0]);
 					}
 					plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
-					attributeDescription = QString::fromStdString(data.getDescription());
+					attributeDescription = QString::fromStdString(data->getDescription());
 				}
 			}
 			frame->setTitle("Fly attribute: " + attributeDescription);
@@ -478,45 +605,45 @@ void Heatmapper::attributeChanged()
 			QString attributeDescription("Cannot be displayed.");
 			if (currentResults->hasPairAttribute<float>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<float>& fly0Data = currentResults->getPairData<float>(0, 1, attributeName.toStdString());
-				plot->addLineFillGraph(fly0Data.begin(), fly0Data.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				const Attribute<float>& fly1Data = currentResults->getPairData<float>(1, 0, attributeName.toStdString());
-				plot->addLineFillGraph(fly1Data.begin(), fly1Data.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				const boost::shared_ptr<const Attribute<float> > fly0Data = currentResults->getPairView<float>(0, 1, attributeName.toStdString());
+				plot->addLineFillGraph(fly0Data->begin(), fly0Data->end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				const boost::shared_ptr<const Attribute<float> > fly1Data = currentResults->getPairView<float>(1, 0, attributeName.toStdString());
+				plot->addLineFillGraph(fly1Data->begin(), fly1Data->end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			} else if (currentResults->hasPairAttribute<MyBool>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<MyBool>& fly0Data = currentResults->getPairData<MyBool>(0, 1, attributeName.toStdString());
-				plot->addLineFillGraph(fly0Data.begin(), fly0Data.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				const Attribute<MyBool>& fly1Data = currentResults->getPairData<MyBool>(1, 0, attributeName.toStdString());
-				plot->addLineFillGraph(fly1Data.begin(), fly1Data.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				const boost::shared_ptr<const Attribute<MyBool> > fly0Data = currentResults->getPairView<MyBool>(0, 1, attributeName.toStdString());
+				plot->addLineFillGraph(fly0Data->begin(), fly0Data->end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				const boost::shared_ptr<const Attribute<MyBool> > fly1Data = currentResults->getPairView<MyBool>(1, 0, attributeName.toStdString());
+				plot->addLineFillGraph(fly1Data->begin(), fly1Data->end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			} else if (currentResults->hasPairAttribute<uint32_t>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<uint32_t>& fly0Data = currentResults->getPairData<uint32_t>(0, 1, attributeName.toStdString());
-				plot->addLineFillGraph(fly0Data.begin(), fly0Data.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				const Attribute<uint32_t>& fly1Data = currentResults->getPairData<uint32_t>(1, 0, attributeName.toStdString());
-				plot->addLineFillGraph(fly1Data.begin(), fly1Data.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				const boost::shared_ptr<const Attribute<uint32_t> > fly0Data = currentResults->getPairView<uint32_t>(0, 1, attributeName.toStdString());
+				plot->addLineFillGraph(fly0Data->begin(), fly0Data->end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				const boost::shared_ptr<const Attribute<uint32_t> > fly1Data = currentResults->getPairView<uint32_t>(1, 0, attributeName.toStdString());
+				plot->addLineFillGraph(fly1Data->begin(), fly1Data->end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			} else if (currentResults->hasPairAttribute<Vf2>(attributeName.toStdString())) {
 				dimensionComboBox->blockSignals(true);
 				dimensionComboBox->addItem("X", 0);
 				dimensionComboBox->addItem("Y", 1);
 				dimensionComboBox->blockSignals(false);
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& fly0Data = currentResults->getPairData<Vf2>(0, 1, attributeName.toStdString());
+				const boost::shared_ptr<const Attribute<Vf2> > fly0Data = currentResults->getPairView<Vf2>(0, 1, attributeName.toStdString());
 				std::vector<float> xOnly;
-				xOnly.reserve(fly0Data.size());
-				for (size_t i = 0; i != fly0Data.size(); ++i) {
-					xOnly.push_back(fly0Data[i][0]);
+				xOnly.reserve(fly0Data->size());
+				for (size_t i = 0; i != fly0Data->size(); ++i) {
+					xOnly.push_back((*fly0Data)[i][0]);
 				}
 				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				const Attribute<Vf2>& fly1Data = currentResults->getPairData<Vf2>(1, 0, attributeName.toStdString());
+				const boost::shared_ptr<const Attribute<Vf2> > fly1Data = currentResults->getPairView<Vf2>(1, 0, attributeName.toStdString());
 				xOnly.clear();
-				for (size_t i = 0; i != fly1Data.size(); ++i) {
-					xOnly.push_back(fly1Data[i][0]);
+				for (size_t i = 0; i != fly1Data->size(); ++i) {
+					xOnly.push_back((*fly1Data)[i][0]);
 				}
 				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				attributeDescription = QString::fromStdString(fly0Data.getDescription());
+				attributeDescription = QString::fromStdString(fly0Data->getDescription());
 			}
 			frame->setTitle("Pair attribute: " + attributeDescription);
 			return;
@@ -548,11 +675,11 @@ void Heatmapper::dimensionChanged(int index)
 			plot->addUnitGraph(1000, 1.0f, true, QVector4D(0.0, 0.0, 0.0, 1.0));
 			if (currentResults->hasFrameAttribute<Vf2>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& data = currentResults->getFrameData<Vf2>(attributeName.toStdString());
+				const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFrameView<Vf2>(attributeName.toStdString());
 				std::vector<float> xOnly;
-				xOnly.reserve(data.size());
-				for (size_t i = 0; i != data.size(); ++i) {
-					xOnly.push_back(data[i][index]);
+				xOnly.reserve(data->size());
+				for (size_t i = 0; i != data->size(); ++i) {
+					xOnly.push_back((*data)[i][index]);
 				}
 				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), QVector4D(0, 0, 0, 1), 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
 			}
@@ -564,11 +691,11 @@ void Heatmapper::dimensionChanged(int index)
 			if (currentResults->hasFlyAttribute<Vf2>(attributeName.toStdString())) {
 				for (size_t flyNumber = 0; flyNumber != currentResults->getFlyCount(); ++flyNumber) {
 					//TODO: check if the data is actually available
-					const Attribute<Vf2>& data = currentResults->getFlyData<Vf2>(flyNumber, attributeName.toStdString());
+					const boost::shared_ptr<const Attribute<Vf2> > data = currentResults->getFlyView<Vf2>(flyNumber, attributeName.toStdString());
 					std::vector<float> xOnly;
-					xOnly.reserve(data.size());
-					for (size_t i = 0; i != data.size(); ++i) {
-						xOnly.push_back(data[i][index]);
+					xOnly.reserve(data->size());
+					for (size_t i = 0; i != data->size(); ++i) {
+						xOnly.push_back((*data)[i][index]);
 					}
 					plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[flyNumber], 0.5, 1, QVector3D(currentResults->getOffset(), 0,  -0.1 * flyNumber - 0.1), "TODO:unit");	//TODO: fix grapher near- and far-plane
 //					flyComboBox->addItem(QString("fly ") + QString::number(flyNumber), QVariant());
@@ -581,17 +708,17 @@ void Heatmapper::dimensionChanged(int index)
 			plot->addUnitGraph(1000, 1.0f, true, QVector4D(0.0, 0.0, 0.0, 1.0));
 			if (currentResults->hasPairAttribute<Vf2>(attributeName.toStdString())) {
 				//TODO: check if the data is actually available
-				const Attribute<Vf2>& fly0Data = currentResults->getPairData<Vf2>(0, 1, attributeName.toStdString());
+				const boost::shared_ptr<const Attribute<Vf2> > fly0Data = currentResults->getPairView<Vf2>(0, 1, attributeName.toStdString());
 				std::vector<float> xOnly;
-				xOnly.reserve(fly0Data.size());
-				for (size_t i = 0; i != fly0Data.size(); ++i) {
-					xOnly.push_back(fly0Data[i][index]);
+				xOnly.reserve(fly0Data->size());
+				for (size_t i = 0; i != fly0Data->size(); ++i) {
+					xOnly.push_back((*fly0Data)[i][index]);
 				}
 				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[0], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
-				const Attribute<Vf2>& fly1Data = currentResults->getPairData<Vf2>(1, 0, attributeName.toStdString());
+				const boost::shared_ptr<const Attribute<Vf2> > fly1Data = currentResults->getPairView<Vf2>(1, 0, attributeName.toStdString());
 				xOnly.clear();
-				for (size_t i = 0; i != fly1Data.size(); ++i) {
-					xOnly.push_back(fly1Data[i][index]);
+				for (size_t i = 0; i != fly1Data->size(); ++i) {
+					xOnly.push_back((*fly1Data)[i][index]);
 				}
 				plot->addLineFillGraph(xOnly.begin(), xOnly.end(), flyColors[1], 0.5, 1, QVector3D(currentResults->getOffset(), 0, 0), "TODO:unit");
 			}
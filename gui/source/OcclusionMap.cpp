@@ -41,7 +41,8 @@ bool Occlusion::isSwitched() const
 
 OcclusionMap::OcclusionMap() :
 	offset(0),
-	frameCount(0)
+	frameCount(0),
+	revision(0)
 {
 }
 
@@ -166,6 +167,16 @@ const std::vector<bool>& OcclusionMap::getSwitchMask() const
 	return switchMask;
 }
 
+const std::vector<bool>& OcclusionMap::getCurrentSwitchedMask() const
+{
+	return currentSwitchedMask;
+}
+
+size_t OcclusionMap::getRevision() const
+{
+	return revision;
+}
+
 void OcclusionMap::buildSwitchMask()
 {
 	std::fill(switchMask.begin(), switchMask.end(), false);
@@ -178,6 +189,11 @@ void OcclusionMap::buildSwitchMask()
 		for (size_t frameNumber = iter->getBegin(); frameNumber != iter->getEnd(); ++frameNumber) {
 			switchMask[frameNumber - offset] = switched;
 		}
+		// the frames up to the next occlusion, where getCurrentOcclusion() returns this one
+		const size_t currentEnd = (iter + 1 == occlusions.end()) ? frameCount + offset : (iter + 1)->getBegin();
+		for (size_t frameNumber = iter->getBegin(); frameNumber < currentEnd; ++frameNumber) {
+			currentSwitchedMask[frameNumber - offset] = iter->isSwitched();
+		}
 		// build switchMask for the sequence directly after this occlusion
 		if (switched) {
 			if (iter + 1 == occlusions.end()) {
@@ -192,4 +208,5 @@ void OcclusionMap::buildSwitchMask()
 			}
 		}
 	}
+	++revision;
 }
@@ -45,7 +45,9 @@ public:
 	OcclusionMap(const std::vector<T>& isOcclusion, size_t offset) :
 		offset(offset),
 		frameCount(isOcclusion.size()),
-		switchMask(frameCount, false)
+		switchMask(frameCount, false),
+		currentSwitchedMask(frameCount, false),
+		revision(0)
 	{
 		size_t occlusionNumber = 0;
 
@@ -89,6 +91,8 @@ public:
 	void switchAfter(size_t occlusionNumber);
 
 	const std::vector<bool>& getSwitchMask() const;
+	const std::vector<bool>& getCurrentSwitchedMask() const;	// getCurrentOcclusion(frameNumber).isSwitched() for every frame, counted from offset
+	size_t getRevision() const;	// changes whenever one of the masks does
 
 private:
 	void buildSwitchMask();
@@ -97,6 +101,8 @@ private:
 	size_t offset;
 	size_t frameCount;
 	std::vector<bool> switchMask;
+	std::vector<bool> currentSwitchedMask;
+	size_t revision;
 };
 
 #endif
@@ -19,7 +19,7 @@
 
 PulseDetectionPage::PulseDetectionPage(Settings& trackerSettings, QWidget* parent) : ConfigPage(trackerSettings, parent)
 {
-	allOptions.reserve(23); // 23 options
+	allOptions.reserve(24); // 24 options
 	// sine options
 	QLabel *lblTapersBandWSize = new QLabel(tr("Tapers time-bandwidth:"));
 	QDoubleSpinBox* spinbTapersTimeBandwith = new QDoubleSpinBox(); // standard-value: 12
@@ -108,13 +108,13 @@ PulseDetectionPage::PulseDetectionPage(Settings& trackerSettings, QWidget* paren
 	spinbCutoff->setToolTip("NoiseCutofF");
 	allOptions.push_back(spinbCutoff);
 
-	QLabel *lblExpandRange = new QLabel(tr("Train expand range:"));
+	QLabel *lblExpandRange = new QLabel(tr("Train expand range (window steps):"));
 	QDoubleSpinBox* spinbExpandRange = new QDoubleSpinBox(); // standard-value: 1.3
 	spinbExpandRange->setValue(1.3);
 	spinbExpandRange->setToolTip("TrainExpandRange");
 	allOptions.push_back(spinbExpandRange);
 
-	QLabel *lblCombineTim = new QLabel(tr("Combine step size:"));
+	QLabel *lblCombineTim = new QLabel(tr("Combine step size (window steps):"));
 	QDoubleSpinBox* spinbCombineTime = new QDoubleSpinBox();	// standard-value: 15
 	spinbCombineTime->setValue(15);
 	spinbCombineTime->setToolTip("CombineStepSize");
@@ -166,7 +166,7 @@ PulseDetectionPage::PulseDetectionPage(Settings& trackerSettings, QWidget* paren
 	spinbMorletSeperatePeaks->setToolTip("MinMorletSeperation");
 	allOptions.push_back(spinbMorletSeperatePeaks);
 
-	QLabel *lblPeakExpandToPulseFactor = new QLabel(tr("Peak expansion factor (ms):"));
+	QLabel *lblPeakExpandToPulseFactor = new QLabel(tr("Peak expansion factor (per kHz sampling rate):"));
 	QDoubleSpinBox* spinbPeakExpandToPulseFactor = new QDoubleSpinBox(); // standard-value: fs/3000
 	spinbPeakExpandToPulseFactor->setMaximum(1000);
 	spinbPeakExpandToPulseFactor->setValue(0.333);
@@ -205,6 +205,10 @@ PulseDetectionPage::PulseDetectionPage(Settings& trackerSettings, QWidget* paren
 	chbExclude0Cycles->setToolTip("Exclude0Cycles");
 	allOptions.push_back(chbExclude0Cycles);
 
+	QCheckBox* chbUseFlysong = new QCheckBox("Detect with flysong (MATLAB)"); // standard-value: off, the built-in detector
+	chbUseFlysong->setToolTip("UseFlysong");
+	allOptions.push_back(chbUseFlysong);
+
 	QVBoxLayout* vertPulseOLayout = new QVBoxLayout;
 	vertPulseOLayout->setAlignment(Qt::AlignTop);
 	vertPulseOLayout->addWidget(lblCutoffFactor);
@@ -228,6 +232,7 @@ PulseDetectionPage::PulseDetectionPage(Settings& trackerSettings, QWidget* paren
 	vertPulseOLayout->addWidget(lblPulseTimeWindow);
 	vertPulseOLayout->addWidget(spinbPulseTimeWindow);
 	vertPulseOLayout->addWidget(chbExclude0Cycles);
+	vertPulseOLayout->addWidget(chbUseFlysong);
 
 	QGroupBox* grpPulseOptions = new QGroupBox("Pulse Options");
 	grpPulseOptions->setLayout(vertPulseOLayout);
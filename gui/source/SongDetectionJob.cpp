@@ -0,0 +1,97 @@
+#include "SongDetectionJob.hpp"
+#include <QFile>
+#include <QDateTime>
+#include <stdexcept>
+#include "SongDetector.hpp"
+#include "SongResults.hpp"
+#include "Video.hpp"
+
+SongDetectionJob::SongDetectionJob(const QString& songFileName, const QString& noiseFileName, const std::map<QString, float>& options, const QDir& dataDirectory) : Job(),
+	songFileName(songFileName),
+	noiseFileName(noiseFileName),
+	options(options),
+	dataDirectory(dataDirectory),
+	worker(*this),
+	stopRequested(false),
+	errorMessage()
+{
+	connect(&worker, SIGNAL(finished()), this, SLOT(detectionFinished()));
+}
+
+SongDetectionJob::~SongDetectionJob()
+{
+	stop();
+}
+
+float SongDetectionJob::getCpuLoad() const
+{
+	return 1;
+}
+
+void SongDetectionJob::start()
+{
+	setLogFile(dataDirectory.path() + "/songdetection_" + QDateTime::currentDateTime().toString("yyyy-MM-ddThh.mm.ss.zzz") + ".log");
+	stopRequested = false;
+	errorMessage.clear();
+	emit jobStarted(this);
+	worker.start(QThread::LowPriority);
+}
+
+void SongDetectionJob::stop()
+{
+	stopRequested = true;
+	worker.wait();
+}
+
+QString SongDetectionJob::getDescription() const
+{
+	return "song detection: " + songFileName;
+}
+
+void SongDetectionJob::detectionFinished()
+{
+	if (errorMessage.isEmpty()) {
+		log("song detection finished\n");
+	} else {
+		log(("song detection failed: " + errorMessage + "\n").toLocal8Bit());
+	}
+	emit jobFinished(this);
+}
+
+// runs in the worker thread; the outcome is left in the files FileItem reads its state from
+void SongDetectionJob::detect()
+{
+	dataDirectory.remove("songprocess_done_success.txt");
+	dataDirectory.remove("songprocess_done_failed.txt");
+	try {
+		Video song(songFileName.toStdString());
+		SongDetector detector(options, song.getSampleRate());
+		if (!noiseFileName.isEmpty()) {
+			Video noise(noiseFileName.toStdString());
+			detector.setNoise(noise.getSong());
+		}
+		detector.detect(song.getSong(), &stopRequested);
+
+		SongResults results(dataDirectory.absolutePath().toStdString());
+		results.setDetectedData(detector.getPulses(), detector.getPulseCenters(), detector.getPulseCycles(), detector.getSines(), detector.getTrains());
+
+		QFile doneFile(dataDirectory.filePath("songprocess_done_success.txt"));
+		doneFile.open(QIODevice::WriteOnly);
+	} catch (std::exception& e) {
+		errorMessage = QString::fromStdString(e.what());
+		QFile doneFile(dataDirectory.filePath("songprocess_done_failed.txt"));
+		if (doneFile.open(QIODevice::WriteOnly)) {
+			doneFile.write(errorMessage.toLocal8Bit());
+		}
+	}
+}
+
+SongDetectionJob::Worker::Worker(SongDetectionJob& job) :
+	job(job)
+{
+}
+
+void SongDetectionJob::Worker::run()
+{
+	job.detect();
+}
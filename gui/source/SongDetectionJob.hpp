@@ -0,0 +1,55 @@
+#ifndef SongDetectionJob_hpp
+#define SongDetectionJob_hpp
+
+/*
+The SongDetectionJob runs the SongDetector on the song of a file in a thread of its own.
+Like the flysong job, which is still run instead when the UseFlysong option is set, it leaves the raw and current song files in the data directory,
+along with songprocess_done_success.txt or songprocess_done_failed.txt.
+*/
+
+#include <map>
+#include <QString>
+#include <QDir>
+#include <QThread>
+#include "Job.hpp"
+
+class SongDetectionJob : public Job {
+	Q_OBJECT
+
+public:
+	SongDetectionJob(const QString& songFileName, const QString& noiseFileName, const std::map<QString, float>& options, const QDir& dataDirectory);
+	virtual ~SongDetectionJob();
+
+	virtual float getCpuLoad() const;
+
+	virtual void start();
+	virtual void stop();
+	QString getDescription() const;
+
+private slots:
+	void detectionFinished();
+
+private:
+	Q_DISABLE_COPY(SongDetectionJob);
+
+	class Worker : public QThread {
+	public:
+		Worker(SongDetectionJob& job);
+	protected:
+		void run();
+	private:
+		SongDetectionJob& job;
+	};
+
+	void detect();
+
+	QString songFileName;
+	QString noiseFileName;
+	std::map<QString, float> options;
+	QDir dataDirectory;
+	Worker worker;
+	volatile bool stopRequested;
+	QString errorMessage;	// set by the worker
+};
+
+#endif
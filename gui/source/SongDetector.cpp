@@ -0,0 +1,741 @@
+#include "SongDetector.hpp"
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <cstddef>
+#include <stdexcept>
+#include "SongResults.hpp"
+#include "../../common/source/mathematics.hpp"
+
+typedef std::complex<float> Complex;
+
+size_t nextPowerOfTwo(size_t number)
+{
+	size_t power = 1;
+	while (power < number) {
+		power <<= 1;
+	}
+	return power;
+}
+
+// an iterative radix-2 FFT of a fixed size, which has to be a power of two; the inverse isn't scaled
+class Fft {
+public:
+	Fft(size_t size) :
+		size(size),
+		twiddles(size / 2)
+	{
+		for (size_t k = 0; k != twiddles.size(); ++k) {
+			const double angle = -2 * constant::PI * k / size;
+			twiddles[k] = Complex(std::cos(angle), std::sin(angle));
+		}
+	}
+
+	void transform(std::vector<Complex>& data, bool inverse) const
+	{
+		for (size_t i = 1, j = 0; i < size; ++i) {
+			size_t bit = size >> 1;
+			for (; j & bit; bit >>= 1) {
+				j ^= bit;
+			}
+			j ^= bit;
+			if (i < j) {
+				std::swap(data[i], data[j]);
+			}
+		}
+		for (size_t length = 2; length <= size; length <<= 1) {
+			const size_t half = length / 2;
+			const size_t stride = size / length;
+			for (size_t start = 0; start < size; start += length) {
+				Complex* even = &data[start];
+				Complex* odd = &data[start + half];
+				for (size_t k = 0; k != half; ++k) {
+					const Complex twiddle = inverse ? std::conj(twiddles[k * stride]) : twiddles[k * stride];
+					const Complex product = odd[k] * twiddle;
+					odd[k] = even[k] - product;
+					even[k] += product;
+				}
+			}
+		}
+	}
+
+private:
+	size_t size;
+	std::vector<Complex> twiddles;
+};
+
+// the discrete prolate spheroidal sequences with the largest concentrations, i.e. the eigenvectors of the largest eigenvalues of a symmetric tridiagonal matrix,
+// found by bisection for the eigenvalues and inverse iteration for the eigenvectors
+std::vector<std::vector<float> > makeSlepianTapers(size_t length, double timeBandwidth, size_t count)
+{
+	const double bandwidth = timeBandwidth / length;
+	std::vector<double> diagonal(length);
+	std::vector<double> offDiagonal(length);	// offDiagonal[i] couples i - 1 and i
+	for (size_t i = 0; i != length; ++i) {
+		const double center = (length - 1 - 2.0 * i) / 2;
+		diagonal[i] = center * center * std::cos(2 * constant::PI * bandwidth);
+		offDiagonal[i] = i * (length - i) / 2.0;
+	}
+
+	double lowerBound = 0;
+	double upperBound = 0;
+	for (size_t i = 0; i != length; ++i) {
+		const double radius = offDiagonal[i] + (i + 1 < length ? offDiagonal[i + 1] : 0);
+		lowerBound = std::min(lowerBound, diagonal[i] - radius);
+		upperBound = std::max(upperBound, diagonal[i] + radius);
+	}
+
+	std::vector<std::vector<float> > tapers;
+	std::vector<std::vector<double> > vectors;
+	for (size_t taperNumber = 0; taperNumber != count && taperNumber != length; ++taperNumber) {
+		// the number of eigenvalues below a value is the number of negative pivots of the LDL' decomposition
+		const size_t rank = length - 1 - taperNumber;
+		double low = lowerBound;
+		double high = upperBound;
+		for (size_t iteration = 0; iteration != 100; ++iteration) {
+			const double middle = (low + high) / 2;
+			size_t below = 0;
+			double pivot = 1;
+			for (size_t i = 0; i != length; ++i) {
+				pivot = diagonal[i] - middle - (i ? offDiagonal[i] * offDiagonal[i] / pivot : 0);
+				if (pivot == 0) {
+					pivot = 1e-300;
+				}
+				below += pivot < 0;
+			}
+			if (below > rank) {
+				high = middle;
+			} else {
+				low = middle;
+			}
+		}
+		const double eigenvalue = (low + high) / 2 + 1e-10 * (upperBound - lowerBound);
+
+		std::vector<double> vector(length);
+		for (size_t i = 0; i != length; ++i) {
+			vector[i] = 1 + 0.1 * std::sin(i + 1.0);
+		}
+		std::vector<double> upper(length);
+		std::vector<double> right(length);
+		for (size_t iteration = 0; iteration != 3; ++iteration) {
+			// solve (T - eigenvalue) x = vector with the Thomas algorithm
+			double pivot = diagonal[0] - eigenvalue;
+			for (size_t i = 0; i != length; ++i) {
+				if (i) {
+					pivot = diagonal[i] - eigenvalue - offDiagonal[i] * upper[i - 1];
+				}
+				if (std::abs(pivot) < 1e-300) {
+					pivot = 1e-300;
+				}
+				upper[i] = (i + 1 < length ? offDiagonal[i + 1] : 0) / pivot;
+				right[i] = (vector[i] - (i ? offDiagonal[i] * right[i - 1] : 0)) / pivot;
+			}
+			for (size_t i = length; i-- != 0; ) {
+				vector[i] = right[i] - (i + 1 < length ? upper[i] * vector[i + 1] : 0);
+			}
+			for (size_t previous = 0; previous != vectors.size(); ++previous) {
+				const double overlap = std::inner_product(vector.begin(), vector.end(), vectors[previous].begin(), 0.0);
+				for (size_t i = 0; i != length; ++i) {
+					vector[i] -= overlap * vectors[previous][i];
+				}
+			}
+			const double norm = std::sqrt(std::inner_product(vector.begin(), vector.end(), vector.begin(), 0.0));
+			for (size_t i = 0; i != length; ++i) {
+				vector[i] /= norm;
+			}
+		}
+
+		// symmetric tapers have a positive sum, antisymmetric ones start positive
+		double orientation = 0;
+		for (size_t i = 0; i != length; ++i) {
+			orientation += (taperNumber % 2 ? (length - 1 - 2.0 * i) : 1.0) * vector[i];
+		}
+		if (orientation < 0) {
+			for (size_t i = 0; i != length; ++i) {
+				vector[i] = -vector[i];
+			}
+		}
+		vectors.push_back(vector);
+		tapers.push_back(std::vector<float>(vector.begin(), vector.end()));
+	}
+	return tapers;
+}
+
+float quantile(std::vector<float> values, float probability)
+{
+	if (values.empty()) {
+		return 0;
+	}
+	const size_t index = std::min(values.size() - 1, static_cast<size_t>(probability * values.size()));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+// the RMS of windows overlapping by half
+std::vector<float> getEnvelope(const std::vector<float>& samples, size_t windowLength)
+{
+	std::vector<float> envelope;
+	const size_t step = std::max<size_t>(windowLength / 2, 1);
+	for (size_t begin = 0; begin + windowLength <= samples.size(); begin += step) {
+		float sum = 0;
+		for (size_t i = begin; i != begin + windowLength; ++i) {
+			sum += samples[i] * samples[i];
+		}
+		envelope.push_back(std::sqrt(sum / windowLength));
+	}
+	return envelope;
+}
+
+SongDetector::SongDetector(const std::map<QString, float>& options, unsigned int sampleRate) :
+	options(options),
+	sampleRate(sampleRate),
+	noise(),
+	stopRequested(NULL),
+	noiseDeviation(0),
+	noiseEnvelopeThreshold(0),
+	wavelets(),
+	waveletBlockSizes(),
+	waveletLength(0)
+{
+	if (sampleRate == 0) {
+		throw std::runtime_error("the song has no sample rate");
+	}
+}
+
+void SongDetector::setNoise(const std::vector<float>& noise)
+{
+	this->noise = noise;
+}
+
+void SongDetector::detect(const std::vector<float>& song, const volatile bool* stopRequested)
+{
+	this->stopRequested = stopRequested;
+	pulses.clear();
+	pulseCenters.clear();
+	pulseCycles.clear();
+	sines.clear();
+	trains.clear();
+
+	estimateNoise(song);
+	detectSines(song);
+	detectPulses(song, findPulseRegions(song));
+	findTrains();
+}
+
+const std::map<size_t, size_t>& SongDetector::getPulses() const
+{
+	return pulses;
+}
+
+const std::map<size_t, size_t>& SongDetector::getPulseCenters() const
+{
+	return pulseCenters;
+}
+
+const std::map<size_t, size_t>& SongDetector::getPulseCycles() const
+{
+	return pulseCycles;
+}
+
+const std::map<size_t, size_t>& SongDetector::getSines() const
+{
+	return sines;
+}
+
+const std::map<size_t, size_t>& SongDetector::getTrains() const
+{
+	return trains;
+}
+
+float SongDetector::getOption(const char* name, float defaultValue) const
+{
+	std::map<QString, float>::const_iterator iter = options.find(name);
+	return iter == options.end() ? defaultValue : iter->second;
+}
+
+size_t SongDetector::toSamples(float milliseconds) const
+{
+	return static_cast<size_t>(std::max(0.0f, milliseconds) * sampleRate / 1000 + 0.5f);
+}
+
+size_t SongDetector::getWindowStep() const
+{
+	return std::max<size_t>(static_cast<size_t>(getOption("WindowStepSize", 0.01f) * sampleRate), 1);
+}
+
+void SongDetector::checkStop() const
+{
+	if (stopRequested && *stopRequested) {
+		throw std::runtime_error("pulse detection was stopped");
+	}
+}
+
+// the deviation of the samples is taken robustly from their median absolute deviation, so that song in the noise estimate doesn't matter much
+void SongDetector::estimateNoise(const std::vector<float>& song)
+{
+	const std::vector<float>& source = noise.empty() ? song : noise;
+	const size_t stride = std::max<size_t>(source.size() / 1000000, 1);
+	std::vector<float> samples;
+	samples.reserve(source.size() / stride + 1);
+	for (size_t i = 0; i < source.size(); i += stride) {
+		samples.push_back(source[i]);
+	}
+	const float median = quantile(samples, 0.5f);
+	for (size_t i = 0; i != samples.size(); ++i) {
+		samples[i] = std::abs(samples[i] - median);
+	}
+	noiseDeviation = quantile(samples, 0.5f) / 0.6745f;
+
+	noiseEnvelopeThreshold = quantile(getEnvelope(source, 2 * getWindowStep()), getOption("NoiseCutofF", 0.8f));
+}
+
+void SongDetector::detectSines(const std::vector<float>& song)
+{
+	const size_t windowLength = std::max<size_t>(static_cast<size_t>(getOption("WindowLength", 0.1f) * sampleRate), 2);
+	const size_t stepSize = getWindowStep();
+	const size_t taperCount = std::max(static_cast<size_t>(getOption("IndependentTapersCount", 20)), static_cast<size_t>(2));
+	const std::vector<std::vector<float> > tapers = makeSlepianTapers(windowLength, getOption("TapersTimeBandwith", 12), taperCount);
+	const float criticalP = getOption("FTestCrit", 0.05f) / windowLength;	// corrected for testing every frequency
+	const float sineRange = getOption("SineRangePerc", 0.2f);
+	const size_t minSineWindows = std::max(static_cast<size_t>(getOption("MinSineSize", 3)), static_cast<size_t>(1));
+	if (song.size() < windowLength || tapers.size() < 2) {
+		return;
+	}
+
+	const size_t fftSize = nextPowerOfTwo(windowLength);
+	const Fft fft(fftSize);
+	const size_t lowestBin = std::max<size_t>(static_cast<size_t>(std::ceil(getOption("LowestSineFS", 100) * fftSize / sampleRate)), 1);
+	const size_t highestBin = std::min(static_cast<size_t>(getOption("HighestSineFS", 300) * fftSize / sampleRate), fftSize / 2 - 1);
+	const size_t usedTaperCount = tapers.size();
+
+	std::vector<float> taperSums(usedTaperCount);
+	float taperSumSquares = 0;
+	for (size_t taperNumber = 0; taperNumber != usedTaperCount; ++taperNumber) {
+		taperSums[taperNumber] = std::accumulate(tapers[taperNumber].begin(), tapers[taperNumber].end(), 0.0f);
+		taperSumSquares += taperSums[taperNumber] * taperSums[taperNumber];
+	}
+
+	std::vector<Complex> buffer(fftSize);
+	std::vector<std::vector<Complex> > spectra(usedTaperCount, std::vector<Complex>(highestBin + 1));
+	std::vector<float> frequencies;	// of the line in each window, 0 if there is none
+	for (size_t begin = 0; begin + windowLength <= song.size(); begin += stepSize) {
+		if (frequencies.size() % 1024 == 0) {
+			checkStop();
+		}
+
+		// two real tapered windows go into one complex FFT, one as the real and one as the imaginary part
+		for (size_t taperNumber = 0; taperNumber < usedTaperCount; taperNumber += 2) {
+			const std::vector<float>& first = tapers[taperNumber];
+			const bool hasSecond = taperNumber + 1 < usedTaperCount;
+			for (size_t i = 0; i != windowLength; ++i) {
+				buffer[i] = Complex(song[begin + i] * first[i], hasSecond ? song[begin + i] * tapers[taperNumber + 1][i] : 0);
+			}
+			std::fill(buffer.begin() + windowLength, buffer.end(), Complex(0));
+			fft.transform(buffer, false);
+			for (size_t bin = lowestBin; bin <= highestBin; ++bin) {
+				const Complex value = buffer[bin];
+				const Complex mirrored = std::conj(buffer[fftSize - bin]);
+				spectra[taperNumber][bin] = (value + mirrored) * 0.5f;
+				if (hasSecond) {
+					spectra[taperNumber + 1][bin] = (value - mirrored) * Complex(0, -0.5f);
+				}
+			}
+		}
+
+		// Thomson's F-test for a line component at each frequency, which has 2 and 2K-2 degrees of freedom
+		float bestF = 0;
+		size_t bestBin = 0;
+		for (size_t bin = lowestBin; bin <= highestBin; ++bin) {
+			Complex amplitude(0);
+			for (size_t taperNumber = 0; taperNumber != usedTaperCount; ++taperNumber) {
+				amplitude += taperSums[taperNumber] * spectra[taperNumber][bin];
+			}
+			amplitude /= taperSumSquares;
+			float residual = 0;
+			for (size_t taperNumber = 0; taperNumber != usedTaperCount; ++taperNumber) {
+				residual += std::norm(spectra[taperNumber][bin] - amplitude * taperSums[taperNumber]);
+			}
+			const float f = (usedTaperCount - 1) * std::norm(amplitude) * taperSumSquares / std::max(residual, 1e-30f);
+			if (f > bestF) {
+				bestF = f;
+				bestBin = bin;
+			}
+		}
+		const double p = std::pow(1.0 + bestF / (usedTaperCount - 1), -static_cast<double>(usedTaperCount - 1));
+		frequencies.push_back(bestBin && p < criticalP ? static_cast<float>(bestBin) * sampleRate / fftSize : 0);
+	}
+
+	// windows with lines close enough in frequency make up a sine, which reaches half a step beyond their centers
+	for (size_t first = 0; first < frequencies.size(); ) {
+		if (frequencies[first] == 0) {
+			++first;
+			continue;
+		}
+		size_t last = first;
+		while (last + 1 < frequencies.size() && frequencies[last + 1] != 0 && std::abs(frequencies[last + 1] - frequencies[last]) <= sineRange * frequencies[last]) {
+			++last;
+		}
+		if (last - first + 1 >= minSineWindows) {
+			const size_t start = first * stepSize + windowLength / 2 - std::min(first * stepSize + windowLength / 2, stepSize / 2);
+			const size_t end = std::min(last * stepSize + windowLength / 2 + stepSize / 2, song.size() - 1);
+			sines[start] = end;
+		}
+		first = last + 1;
+	}
+}
+
+// the regions whose RMS is above the noise, combined when they're close and expanded on either side;
+// like in Process_Song_Save, CombineStepSize and TrainExpandRange count steps of the sine windows
+std::vector<std::pair<size_t, size_t> > SongDetector::findPulseRegions(const std::vector<float>& song) const
+{
+	const size_t step = getWindowStep();
+	const size_t windowLength = 2 * step;
+	const size_t combineDistance = static_cast<size_t>(std::max(getOption("CombineStepSize", 15), 0.0f) * step + 0.5f);
+	const size_t expansion = static_cast<size_t>(std::max(getOption("TrainExpandRange", 1.3f), 0.0f) * step + 0.5f);
+	const std::vector<float> envelope = getEnvelope(song, windowLength);
+
+	std::vector<std::pair<size_t, size_t> > regions;
+	for (size_t window = 0; window != envelope.size(); ++window) {
+		if (envelope[window] <= noiseEnvelopeThreshold) {
+			continue;
+		}
+		const size_t begin = window * step;
+		const size_t end = begin + windowLength;
+		if (!regions.empty() && begin <= regions.back().second + combineDistance) {
+			regions.back().second = end;
+		} else {
+			regions.push_back(std::make_pair(begin, end));
+		}
+	}
+
+	std::vector<std::pair<size_t, size_t> > expanded;
+	for (std::vector<std::pair<size_t, size_t> >::const_iterator iter = regions.begin(); iter != regions.end(); ++iter) {
+		const size_t begin = iter->first - std::min(iter->first, expansion);
+		const size_t end = std::min(iter->second + expansion, song.size());
+		if (!expanded.empty() && begin <= expanded.back().second) {
+			expanded.back().second = std::max(expanded.back().second, end);
+		} else {
+			expanded.push_back(std::make_pair(begin, end));
+		}
+	}
+	return expanded;
+}
+
+// derivatives of Gaussians of order 1 to 3 and Morlet wavelets, tuned to frequencies from 100 Hz up to MaxPulseScaleFreq in steps of 25 Hz;
+// they have unit energy and no DC, so that on noise their coefficients have the deviation of the noise
+void SongDetector::makeWavelets(size_t maxRegionLength)
+{
+	const float maxFrequency = std::min(getOption("MaxPulseScaleFreq", 700), sampleRate * 0.45f);
+	const float morletCenter = 5;
+	std::vector<std::pair<int, float> > shapes;	// order of the derivative of Gaussian or 0 for a Morlet wavelet, standard deviation of the Gaussian in samples
+	for (float frequency = std::min(100.0f, maxFrequency); frequency <= maxFrequency; frequency += 25) {
+		for (int order = 1; order <= 3; ++order) {
+			shapes.push_back(std::make_pair(order, static_cast<float>(std::sqrt(static_cast<double>(order)) / (2 * constant::PI * frequency) * sampleRate)));
+		}
+		shapes.push_back(std::make_pair(0, static_cast<float>(morletCenter / (2 * constant::PI * frequency) * sampleRate)));
+	}
+
+	std::vector<std::vector<float> > taps(shapes.size());
+	waveletLength = 1;
+	for (size_t waveletNumber = 0; waveletNumber != shapes.size(); ++waveletNumber) {
+		const int order = shapes[waveletNumber].first;
+		const float sigma = shapes[waveletNumber].second;
+		const int halfLength = static_cast<int>(std::ceil((order ? 5 : 4) * sigma));
+		std::vector<float>& wavelet = taps[waveletNumber];
+		for (int i = -halfLength; i <= halfLength; ++i) {
+			const float t = i / sigma;
+			const float gaussian = std::exp(-t * t / 2);
+			switch (order) {
+			case 0:
+				wavelet.push_back(gaussian * std::cos(morletCenter * t));
+				break;
+			case 1:
+				wavelet.push_back(-t * gaussian);
+				break;
+			case 2:
+				wavelet.push_back((t * t - 1) * gaussian);
+				break;
+			default:
+				wavelet.push_back((3 * t - t * t * t) * gaussian);
+			}
+		}
+		const float mean = std::accumulate(wavelet.begin(), wavelet.end(), 0.0f) / wavelet.size();
+		float energy = 0;
+		for (size_t i = 0; i != wavelet.size(); ++i) {
+			wavelet[i] -= mean;
+			energy += wavelet[i] * wavelet[i];
+		}
+		for (size_t i = 0; i != wavelet.size(); ++i) {
+			wavelet[i] /= std::sqrt(energy);
+		}
+		waveletLength = std::max(waveletLength, wavelet.size());
+	}
+
+	// short regions are done in small blocks, long ones in blocks that are big enough for them but at most 64k so that the wavelet spectra fit in memory
+	waveletBlockSizes.clear();
+	waveletBlockSizes.push_back(nextPowerOfTwo(waveletLength * 2));
+	const size_t largeBlockSize = std::min(nextPowerOfTwo(maxRegionLength + waveletLength), static_cast<size_t>(65536));
+	if (largeBlockSize > waveletBlockSizes.back()) {
+		waveletBlockSizes.push_back(largeBlockSize);
+	}
+
+	wavelets.resize(shapes.size());
+	for (size_t waveletNumber = 0; waveletNumber != shapes.size(); ++waveletNumber) {
+		Wavelet& wavelet = wavelets[waveletNumber];
+		wavelet.isDoG = shapes[waveletNumber].first != 0;
+		wavelet.scale = static_cast<float>(std::sqrt(2.0) * shapes[waveletNumber].second);	// MATLAB's gaus wavelets derive exp(-t^2)
+		wavelet.spectra.clear();
+	}
+	for (std::vector<size_t>::const_iterator blockSize = waveletBlockSizes.begin(); blockSize != waveletBlockSizes.end(); ++blockSize) {
+		const Fft fft(*blockSize);
+		for (size_t waveletNumber = 0; waveletNumber != shapes.size(); ++waveletNumber) {
+			std::vector<Complex>& spectrum = wavelets[waveletNumber].spectra[*blockSize];
+			spectrum.assign(*blockSize, Complex(0));
+			const size_t offset = (waveletLength - taps[waveletNumber].size()) / 2;	// all wavelets are centered at the same tap
+			for (size_t i = 0; i != taps[waveletNumber].size(); ++i) {
+				spectrum[offset + i] = taps[waveletNumber][i];
+			}
+			fft.transform(spectrum, false);
+			for (size_t i = 0; i != *blockSize; ++i) {
+				spectrum[i] = std::conj(spectrum[i]) / static_cast<float>(*blockSize);
+			}
+		}
+	}
+}
+
+void SongDetector::detectPulses(const std::vector<float>& song, const std::vector<std::pair<size_t, size_t> >& regions)
+{
+	size_t maxRegionLength = 0;
+	for (std::vector<std::pair<size_t, size_t> >::const_iterator iter = regions.begin(); iter != regions.end(); ++iter) {
+		maxRegionLength = std::max(maxRegionLength, iter->second - iter->first);
+	}
+	makeWavelets(maxRegionLength);
+
+	std::vector<Pulse> candidates;
+	for (std::vector<std::pair<size_t, size_t> >::const_iterator iter = regions.begin(); iter != regions.end(); ++iter) {
+		checkStop();
+		const size_t smallBlockSize = waveletBlockSizes.front();
+		const size_t blockSize = iter->second - iter->first + waveletLength <= smallBlockSize ? smallBlockSize : waveletBlockSizes.back();
+		findPulsesInRegion(song, iter->first, iter->second, blockSize, candidates);
+	}
+	selectPulses(song, candidates);
+}
+
+// correlates the region with all wavelets block by block (overlap-save), and takes the peaks where a derivative-of-Gaussian matches best;
+// the peaks are picked after each block, so only the coefficients of one block and the margin around its peaks are kept
+void SongDetector::findPulsesInRegion(const std::vector<float>& song, size_t begin, size_t end, size_t blockSize, std::vector<Pulse>& found) const
+{
+	const size_t length = end - begin;
+	const size_t dogSeparation = std::max<size_t>(toSamples(getOption("MinDogSperation", 1)), 1);
+	const size_t morletSeparation = std::max<size_t>(toSamples(getOption("MinMorletSeperation", 1)), 1);
+	const size_t maxHalfWidth = std::max<size_t>(toSamples(getOption("PulseTimeWindow", 5)), 1);
+	const size_t margin = std::max(std::max(morletSeparation, maxHalfWidth), 4 * dogSeparation) + 1;	// how far pickPulses looks around a peak
+	WaveletMaxima maxima;
+	maxima.begin = 0;
+	std::map<size_t, float> acceptedDog;	// carried from block to block
+	size_t pickedEnd = 0;
+
+	const Fft fft(blockSize);
+	const size_t center = (waveletLength - 1) / 2;
+	const size_t validCount = blockSize - waveletLength + 1;
+	std::vector<Complex> block(blockSize);
+	std::vector<Complex> product(blockSize);
+	for (size_t blockBegin = 0; blockBegin < length; blockBegin += validCount) {
+		// block[n] holds the sample at begin + blockBegin + n - center, whose coefficient ends up at n - center
+		for (size_t n = 0; n != blockSize; ++n) {
+			const ptrdiff_t sample = static_cast<ptrdiff_t>(begin + blockBegin + n) - static_cast<ptrdiff_t>(center);
+			block[n] = (sample >= 0 && sample < static_cast<ptrdiff_t>(song.size())) ? song[sample] : 0;
+		}
+		fft.transform(block, false);
+
+		const size_t outputCount = std::min(validCount, length - blockBegin);
+		const size_t offset = blockBegin - maxima.begin;	// of the block in maxima
+		maxima.dogMax.resize(offset + outputCount, 0);
+		maxima.dogScale.resize(offset + outputCount, 0);
+		maxima.morletMax.resize(offset + outputCount, 0);
+		// two wavelets per inverse FFT: as both correlations are real, one comes out as the real and one as the imaginary part
+		for (size_t waveletNumber = 0; waveletNumber < wavelets.size(); waveletNumber += 2) {
+			const Wavelet& first = wavelets[waveletNumber];
+			const Wavelet* second = waveletNumber + 1 < wavelets.size() ? &wavelets[waveletNumber + 1] : NULL;
+			const Complex* firstSpectrum = &first.spectra.find(blockSize)->second[0];
+			const Complex* secondSpectrum = second ? &second->spectra.find(blockSize)->second[0] : NULL;
+			for (size_t i = 0; i != blockSize; ++i) {
+				product[i] = block[i] * (secondSpectrum ? firstSpectrum[i] + Complex(0, 1) * secondSpectrum[i] : firstSpectrum[i]);
+			}
+			fft.transform(product, true);
+			for (size_t n = 0; n != outputCount; ++n) {
+				const size_t index = offset + n;
+				const float firstValue = std::abs(product[n].real());
+				const float secondValue = std::abs(product[n].imag());
+				if (first.isDoG) {
+					if (firstValue > maxima.dogMax[index]) {
+						maxima.dogMax[index] = firstValue;
+						maxima.dogScale[index] = first.scale;
+					}
+				} else {
+					maxima.morletMax[index] = std::max(maxima.morletMax[index], firstValue);
+				}
+				if (second) {
+					if (second->isDoG) {
+						if (secondValue > maxima.dogMax[index]) {
+							maxima.dogMax[index] = secondValue;
+							maxima.dogScale[index] = second->scale;
+						}
+					} else {
+						maxima.morletMax[index] = std::max(maxima.morletMax[index], secondValue);
+					}
+				}
+			}
+		}
+
+		// peaks can be picked up to the margin before the coefficients that are still missing
+		const size_t computedEnd = blockBegin + outputCount;
+		const size_t pickEnd = computedEnd == length ? length : computedEnd - std::min(computedEnd, margin);
+		if (pickEnd > pickedEnd) {
+			pickPulses(song, begin, length, maxima, pickedEnd, pickEnd, acceptedDog, found);
+			pickedEnd = pickEnd;
+		}
+
+		// the next peaks only need the margin before them
+		const size_t keepBegin = pickedEnd - std::min(pickedEnd, margin);
+		if (keepBegin > maxima.begin) {
+			const size_t dropCount = keepBegin - maxima.begin;
+			maxima.dogMax.erase(maxima.dogMax.begin(), maxima.dogMax.begin() + dropCount);
+			maxima.dogScale.erase(maxima.dogScale.begin(), maxima.dogScale.begin() + dropCount);
+			maxima.morletMax.erase(maxima.morletMax.begin(), maxima.morletMax.begin() + dropCount);
+			maxima.begin = keepBegin;
+		}
+	}
+}
+
+// the highest local maxima above the threshold at positions [pickBegin, pickEnd) of the region, each keeping the others out of its separation distance;
+// acceptedDog holds the peaks accepted before, which keep peaks out across pickBegin.
+// the maxima after pickEnd are picked again with the next block, but as higher ones keep out lower ones, they take part here as well,
+// so that the peaks are the same as if the whole region was picked at once unless a chain of ever higher peaks reaches beyond them
+void SongDetector::pickPulses(const std::vector<float>& song, size_t begin, size_t length, const WaveletMaxima& maxima, size_t pickBegin, size_t pickEnd, std::map<size_t, float>& acceptedDog, std::vector<Pulse>& found) const
+{
+	const float threshold = getOption("CutoffFactor", 5) * noiseDeviation;
+	const size_t dogSeparation = std::max<size_t>(toSamples(getOption("MinDogSperation", 1)), 1);
+	const size_t morletSeparation = std::max<size_t>(toSamples(getOption("MinMorletSeperation", 1)), 1);
+	const std::vector<float>& dogMax = maxima.dogMax;
+	std::vector<std::pair<float, size_t> > dogPeaks;
+	const size_t lookEnd = maxima.begin + dogMax.size();
+	for (size_t i = std::max<size_t>(pickBegin, 1); i + 1 < lookEnd && i + 1 < length; ++i) {
+		const size_t index = i - maxima.begin;
+		if (dogMax[index] > threshold && dogMax[index] >= dogMax[index - 1] && dogMax[index] > dogMax[index + 1]) {
+			dogPeaks.push_back(std::make_pair(dogMax[index], i));
+		}
+	}
+	std::sort(dogPeaks.rbegin(), dogPeaks.rend());
+
+	// PeakExpansionFact is given per kHz of sampling rate, e.g. 0.333 for the fs/3000 of Process_Song_Save, and multiplied by the scale of the best derivative of Gaussian
+	const float expansionFactor = getOption("PeakExpansionFact", 0.333f) * sampleRate / 1000;
+	const size_t maxHalfWidth = std::max<size_t>(toSamples(getOption("PulseTimeWindow", 5)), 1);
+	const size_t voltageHalfWindow = toSamples(getOption("PeakToPeakVoltage", 20)) / 2;
+	const float minHeight = getOption("MinPulseHeight", 10) * noiseDeviation;
+	std::map<size_t, float> accepted(acceptedDog);	// including those after pickEnd
+	for (size_t peakNumber = 0; peakNumber != dogPeaks.size(); ++peakNumber) {
+		const size_t position = dogPeaks[peakNumber].second;
+		const float height = dogPeaks[peakNumber].first;
+		std::map<size_t, float>::const_iterator next = accepted.lower_bound(position > dogSeparation ? position - dogSeparation : 0);
+		if (next != accepted.end() && next->first <= position + dogSeparation) {
+			continue;
+		}
+		accepted[position] = height;
+		if (position >= pickEnd) {
+			continue;
+		}
+		acceptedDog[position] = height;
+
+		// where a Morlet wavelet matches better anywhere within the pulse, this is sine song rather than a pulse
+		const size_t halfWidth = std::min(std::max(static_cast<size_t>(expansionFactor * maxima.dogScale[position - maxima.begin] + 0.5f), static_cast<size_t>(1)), maxHalfWidth);
+		const size_t morletDistance = std::max(morletSeparation, halfWidth);
+		const size_t morletBegin = position - std::min(position, morletDistance);
+		const size_t morletEnd = std::min(position + morletDistance + 1, length);
+		if (*std::max_element(maxima.morletMax.begin() + (morletBegin - maxima.begin), maxima.morletMax.begin() + (morletEnd - maxima.begin)) > height) {
+			continue;
+		}
+
+		const size_t peak = begin + position;
+		const size_t voltageBegin = peak - std::min(peak, voltageHalfWindow);
+		const size_t voltageEnd = std::min(peak + voltageHalfWindow + 1, song.size());
+		const float lowest = *std::min_element(song.begin() + voltageBegin, song.begin() + voltageEnd);
+		const float highest = *std::max_element(song.begin() + voltageBegin, song.begin() + voltageEnd);
+		if (highest - lowest < minHeight) {
+			continue;
+		}
+
+		Pulse pulse;
+		pulse.peak = peak;
+		pulse.start = peak - std::min(peak, halfWidth);
+		pulse.end = std::min(peak + halfWidth, song.size() - 1);
+		pulse.height = height;
+		found.push_back(pulse);
+	}
+
+	// peaks further back than the separation distance can't keep out any of the next ones
+	acceptedDog.erase(acceptedDog.begin(), acceptedDog.lower_bound(pickEnd - std::min(pickEnd, dogSeparation)));
+}
+
+bool isHigher(const std::pair<float, size_t>& first, const std::pair<float, size_t>& second)
+{
+	return first.first > second.first;
+}
+
+// keeps the pulses that are far enough from higher ones and close enough to some other pulse
+void SongDetector::selectPulses(const std::vector<float>& song, std::vector<Pulse> candidates)
+{
+	const size_t minDistance = toSamples(getOption("MinPulseDistance", 15));
+	const size_t maxDistance = toSamples(getOption("MaxPulseDistance", 80));
+	const bool excludeZeroCycles = getOption("Exclude0Cycles", 0) != 0;
+
+	std::vector<std::pair<float, size_t> > byHeight;
+	for (size_t candidateNumber = 0; candidateNumber != candidates.size(); ++candidateNumber) {
+		byHeight.push_back(std::make_pair(candidates[candidateNumber].height, candidateNumber));
+	}
+	std::stable_sort(byHeight.begin(), byHeight.end(), isHigher);
+	std::map<size_t, const Pulse*> kept;	// by peak
+	for (size_t i = 0; i != byHeight.size(); ++i) {
+		const Pulse& pulse = candidates[byHeight[i].second];
+		std::map<size_t, const Pulse*>::const_iterator next = kept.lower_bound(pulse.peak > minDistance ? pulse.peak - minDistance : 0);
+		if (next != kept.end() && next->first < pulse.peak + minDistance) {
+			continue;
+		}
+		if (excludeZeroCycles && SongResults::countPeakCycles(song, pulse.start, pulse.end) == 0) {
+			continue;
+		}
+		kept[pulse.peak] = &pulse;
+	}
+
+	for (std::map<size_t, const Pulse*>::const_iterator iter = kept.begin(); iter != kept.end(); ++iter) {
+		std::map<size_t, const Pulse*>::const_iterator previous = iter;
+		std::map<size_t, const Pulse*>::const_iterator next = iter;
+		++next;
+		const bool hasNeighbor = (iter != kept.begin() && iter->first - (--previous)->first <= maxDistance) || (next != kept.end() && next->first - iter->first <= maxDistance);
+		if (!hasNeighbor) {
+			continue;
+		}
+		const Pulse& pulse = *iter->second;
+		pulses[pulse.start] = pulse.end;
+		pulseCenters[pulse.start] = SongResults::findPulseCenter(song, pulse.start, pulse.end);
+		pulseCycles[pulse.start] = SongResults::countPeakCycles(song, pulse.start, pulse.end);
+	}
+}
+
+// a train is a run of at least two pulses that are no further than MaxPulseDistance apart
+void SongDetector::findTrains()
+{
+	const size_t maxDistance = toSamples(getOption("MaxPulseDistance", 80));
+	std::map<size_t, size_t>::const_iterator first = pulses.begin();
+	while (first != pulses.end()) {
+		std::map<size_t, size_t>::const_iterator last = first;
+		std::map<size_t, size_t>::const_iterator next = first;
+		while (++next != pulses.end() && next->first - last->first <= maxDistance) {
+			last = next;
+		}
+		if (last != first) {
+			trains[first->first] = last->first;
+		}
+		first = next;
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef SongDetector_hpp
+#define SongDetector_hpp
+
+/*
+The SongDetector finds sine song and pulse song in a recording.
+It takes the options of the PulseDetectionPage, by the same names, and runs in the MateBook process instead of an external flysong executable:
+- Sine song is found with a multitaper F-test for spectral lines in sliding windows; windows whose line frequency stays within range of each other make up a sine.
+- The noise level is measured in a recording of the background noise if there is one, or estimated from the song itself.
+- Pulse song is looked for in the regions that stand out from the noise, by matching derivative-of-Gaussian and Morlet wavelets to them:
+  a pulse is where a derivative-of-Gaussian matches better than the Morlet wavelets, which match sine song.
+The song is processed in blocks, so that the FFTs stay small no matter how long the recording is.
+All positions are in samples. The options have the units of Process_Song_Save, the MATLAB flysong entry point: milliseconds where the PulseDetectionPage says so,
+CombineStepSize and TrainExpandRange in steps of the sine windows, and PeakExpansionFact per kHz of sampling rate as a factor of the wavelet scale.
+MateBook --testSongDetector checks it on synthetic song.
+*/
+
+#include <map>
+#include <vector>
+#include <complex>
+#include <QString>
+
+class SongDetector {
+public:
+	SongDetector(const std::map<QString, float>& options, unsigned int sampleRate);
+
+	void setNoise(const std::vector<float>& noise);	// a recording of the background noise
+	void detect(const std::vector<float>& song, const volatile bool* stopRequested = NULL);	// throws a std::runtime_error when stopped
+
+	const std::map<size_t, size_t>& getPulses() const;	// pulse start, pulse end
+	const std::map<size_t, size_t>& getPulseCenters() const;	// pulse start, position of the largest amplitude
+	const std::map<size_t, size_t>& getPulseCycles() const;	// pulse start, number of cycles
+	const std::map<size_t, size_t>& getSines() const;	// sine start, sine end
+	const std::map<size_t, size_t>& getTrains() const;	// first pulse start, last pulse start
+
+private:
+	struct Wavelet {
+		bool isDoG;	// a derivative of a Gaussian, or else a Morlet wavelet
+		float scale;	// in samples, as in MATLAB's cwt: the Gaussian is exp(-(t / scale)^2), so this is sqrt(2) times its standard deviation
+		std::map<size_t, std::vector<std::complex<float> > > spectra;	// conjugated, for correlating with a block of the song, by FFT size
+	};
+
+	struct Pulse {
+		size_t peak;
+		size_t start;
+		size_t end;
+		float height;	// of the best matching derivative-of-Gaussian
+	};
+
+	// the best matches of the wavelets at positions [begin, begin + dogMax.size()) of a region
+	struct WaveletMaxima {
+		size_t begin;
+		std::vector<float> dogMax;
+		std::vector<float> dogScale;	// of the derivative of Gaussian that matches best
+		std::vector<float> morletMax;
+	};
+
+	float getOption(const char* name, float defaultValue) const;
+	size_t toSamples(float milliseconds) const;
+	size_t getWindowStep() const;	// the step of the sine windows, in samples
+	void checkStop() const;
+
+	void estimateNoise(const std::vector<float>& song);
+	void detectSines(const std::vector<float>& song);
+	std::vector<std::pair<size_t, size_t> > findPulseRegions(const std::vector<float>& song) const;
+	void makeWavelets(size_t maxRegionLength);
+	void detectPulses(const std::vector<float>& song, const std::vector<std::pair<size_t, size_t> >& regions);
+	void findPulsesInRegion(const std::vector<float>& song, size_t begin, size_t end, size_t blockSize, std::vector<Pulse>& found) const;
+	void pickPulses(const std::vector<float>& song, size_t begin, size_t length, const WaveletMaxima& maxima, size_t pickBegin, size_t pickEnd, std::map<size_t, float>& acceptedDog, std::vector<Pulse>& found) const;
+	void selectPulses(const std::vector<float>& song, std::vector<Pulse> candidates);
+	void findTrains();
+
+	std::map<QString, float> options;
+	unsigned int sampleRate;
+	std::vector<float> noise;
+	const volatile bool* stopRequested;
+
+	float noiseDeviation;	// of the samples
+	float noiseEnvelopeThreshold;	// the RMS above which a region may contain pulses
+
+	std::vector<Wavelet> wavelets;
+	std::vector<size_t> waveletBlockSizes;	// FFT sizes the wavelet spectra were computed for, ascending
+	size_t waveletLength;	// number of taps of the longest wavelet, which all wavelets are centered in
+
+	std::map<size_t, size_t> pulses;
+	std::map<size_t, size_t> pulseCenters;
+	std::map<size_t, size_t> pulseCycles;
+	std::map<size_t, size_t> sines;
+	std::map<size_t, size_t> trains;
+};
+
+#endif
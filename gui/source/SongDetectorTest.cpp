@@ -0,0 +1,177 @@
+#include "SongDetectorTest.hpp"
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+#include "SongDetector.hpp"
+#include "../../common/source/mathematics.hpp"
+#include "../../common/source/mystdint.h"
+
+const unsigned int testSampleRate = 10000;
+const float testNoiseDeviation = 0.01f;
+
+// Gaussian noise from a fixed seed, so that every platform tests the same recording
+std::vector<float> makeTestNoise(float seconds, uint32_t seed)
+{
+	std::vector<float> samples(static_cast<size_t>(seconds * testSampleRate));
+	uint32_t state = seed;
+	for (size_t i = 0; i != samples.size(); ++i) {
+		float sum = 0;	// of 12 uniform numbers, which has a variance of 1
+		for (int term = 0; term != 12; ++term) {
+			state = state * 1664525u + 1013904223u;
+			sum += (state >> 8) / 16777216.0f;
+		}
+		samples[i] = (sum - 6) * testNoiseDeviation;
+	}
+	return samples;
+}
+
+// a few cycles of a carrier under a Gaussian envelope, centered at center
+void addTestPulse(std::vector<float>& song, size_t center, float frequency, float envelopeSeconds, float amplitude)
+{
+	const int halfLength = static_cast<int>(4 * envelopeSeconds * testSampleRate);
+	for (int i = -halfLength; i <= halfLength; ++i) {
+		if (static_cast<ptrdiff_t>(center) + i < 0 || center + i >= song.size()) {
+			continue;
+		}
+		const float t = static_cast<float>(i) / testSampleRate;
+		song[center + i] += amplitude * std::exp(-t * t / (2 * envelopeSeconds * envelopeSeconds)) * std::sin(2 * constant::PI * frequency * t + constant::PI / 2);
+	}
+}
+
+// reports whether what was detected matches what is expected
+class SongDetectorCheck {
+public:
+	SongDetectorCheck(const std::string& name) :
+		name(name),
+		failed(false)
+	{
+	}
+
+	void expect(bool condition, const std::string& message)
+	{
+		if (!condition) {
+			std::cerr << "error: " << name << ": " << message << std::endl;
+			failed = true;
+		}
+	}
+
+	bool hasFailed() const
+	{
+		return failed;
+	}
+
+private:
+	std::string name;
+	bool failed;
+};
+
+// the number of intervals that overlap [begin, end]
+size_t countOverlaps(const std::map<size_t, size_t>& intervals, size_t begin, size_t end)
+{
+	size_t count = 0;
+	for (std::map<size_t, size_t>::const_iterator iter = intervals.begin(); iter != intervals.end(); ++iter) {
+		count += iter->first <= end && iter->second >= begin;
+	}
+	return count;
+}
+
+bool testNoiseOnly()
+{
+	SongDetectorCheck check("noise");
+	SongDetector detector(std::map<QString, float>(), testSampleRate);
+	detector.detect(makeTestNoise(3, 1));
+	std::cout << "noise: " << detector.getPulses().size() << " pulses, " << detector.getSines().size() << " sines" << std::endl;
+	check.expect(detector.getPulses().empty(), "found pulses in noise");
+	check.expect(detector.getSines().empty(), "found sine song in noise");
+	return !check.hasFailed();
+}
+
+bool testSine()
+{
+	SongDetectorCheck check("sine");
+	std::vector<float> song = makeTestNoise(3, 2);
+	const size_t sineBegin = testSampleRate;
+	const size_t sineEnd = 2 * testSampleRate;
+	for (size_t i = sineBegin; i != sineEnd; ++i) {
+		song[i] += 10 * testNoiseDeviation * std::sin(2 * constant::PI * 150 * (i - sineBegin) / testSampleRate);
+	}
+	SongDetector detector(std::map<QString, float>(), testSampleRate);
+	detector.detect(song);
+	const std::map<size_t, size_t>& sines = detector.getSines();
+	std::cout << "sine: " << detector.getPulses().size() << " pulses, " << sines.size() << " sines";
+	for (std::map<size_t, size_t>::const_iterator iter = sines.begin(); iter != sines.end(); ++iter) {
+		std::cout << " [" << iter->first << ", " << iter->second << "]";
+	}
+	std::cout << std::endl;
+
+	// the windows are 100 ms long, so a sine can be found up to half a window beyond its ends
+	const size_t tolerance = testSampleRate / 20;
+	check.expect(sines.size() == 1, "the sine song was not found as one sine");
+	if (!sines.empty()) {
+		check.expect(sines.begin()->first + tolerance >= sineBegin && sines.begin()->first <= sineBegin + tolerance, "the sine starts at the wrong time");
+		check.expect(sines.rbegin()->second + tolerance >= sineEnd && sines.rbegin()->second <= sineEnd + tolerance, "the sine ends at the wrong time");
+	}
+	check.expect(countOverlaps(detector.getPulses(), sineBegin + tolerance, sineEnd - tolerance) == 0, "found pulses in sine song");
+	return !check.hasFailed();
+}
+
+bool testPulseTrain()
+{
+	SongDetectorCheck check("pulse train");
+	std::vector<float> song = makeTestNoise(3, 3);
+	const size_t pulseCount = 20;
+	const size_t firstPulse = static_cast<size_t>(0.8f * testSampleRate);
+	const size_t interval = static_cast<size_t>(0.035f * testSampleRate);
+	std::vector<size_t> centers;
+	for (size_t pulseNumber = 0; pulseNumber != pulseCount; ++pulseNumber) {
+		centers.push_back(firstPulse + pulseNumber * interval);
+		addTestPulse(song, centers.back(), 250, 0.0015f, 20 * testNoiseDeviation);
+	}
+	SongDetector detector(std::map<QString, float>(), testSampleRate);
+	detector.detect(song);
+	const std::map<size_t, size_t>& pulses = detector.getPulses();
+	const std::map<size_t, size_t>& pulseCenters = detector.getPulseCenters();
+	std::cout << "pulse train: " << pulses.size() << " of " << pulseCount << " pulses, " << detector.getTrains().size() << " trains" << std::endl;
+
+	// every pulse is found once, with its largest amplitude within a quarter of a cycle of where it was put
+	const size_t tolerance = testSampleRate / 1000;
+	size_t foundCount = 0;
+	for (size_t pulseNumber = 0; pulseNumber != pulseCount; ++pulseNumber) {
+		size_t matches = 0;
+		for (std::map<size_t, size_t>::const_iterator iter = pulseCenters.begin(); iter != pulseCenters.end(); ++iter) {
+			matches += iter->second + tolerance >= centers[pulseNumber] && iter->second <= centers[pulseNumber] + tolerance;
+		}
+		check.expect(matches <= 1, "a pulse was found more than once");
+		foundCount += matches != 0;
+	}
+	check.expect(foundCount == pulseCount, "missed pulses");
+	check.expect(pulses.size() == foundCount, "found pulses where there are none");
+
+	// the pulses are inside [start, end]
+	for (std::map<size_t, size_t>::const_iterator iter = pulses.begin(); iter != pulses.end(); ++iter) {
+		std::map<size_t, size_t>::const_iterator center = pulseCenters.find(iter->first);
+		check.expect(center != pulseCenters.end() && iter->first <= center->second && center->second <= iter->second, "a pulse center is outside of its pulse");
+	}
+
+	check.expect(detector.getTrains().size() == 1, "the pulses were not found as one train");
+	return !check.hasFailed();
+}
+
+int runSongDetectorTest()
+{
+	bool passed = true;
+	try {
+		passed = testNoiseOnly() && passed;
+		passed = testSine() && passed;
+		passed = testPulseTrain() && passed;
+	} catch (std::exception& e) {
+		std::cerr << "error: song detection failed: " << e.what() << std::endl;
+		passed = false;
+	}
+	std::cout << (passed ? "song detector test passed" : "song detector test failed") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#ifndef SongDetectorTest_hpp
+#define SongDetectorTest_hpp
+
+/*
+The --testSongDetector option of MateBook. It runs the SongDetector with the default options on synthetic recordings,
+background noise alone, noise with a stretch of sine song and noise with a pulse train, and checks that it finds what was put in.
+It returns the exit code for MateBook, which ends after running it: 1 if anything was missed or found where there is nothing, 0 otherwise.
+*/
+
+int runSongDetectorTest();
+
+#endif
@@ -150,8 +150,7 @@ void SongPlayer::setCurrentAudio(boost::shared_ptr<Video> audio)
 // changes the current graphs color within the given interval
 void SongPlayer::changeColor(std::pair<int, int> indexRange, const std::vector<QVector4D>& newColors)
 {
-	audioGraph->changeColor(newColors.begin(), newColors.end(), indexRange.first);
-	audioGraph->generateIndicesAndRegenerateVertexBuffer();
+	audioGraph->changeColor(newColors.begin(), newColors.end(), indexRange.first);	// only the changed range is written to the GPU
 	songGrapher->redraw();	// otherwise we would have to move the mouse
 }
 
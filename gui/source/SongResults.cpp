@@ -54,14 +54,8 @@ bool SongResults::createPulse(const Video& media, std::pair<int, int> indexRange
 		if(indexRange.first != indexRange.second){
 			pulses.insert(pulses.begin(), std::pair<size_t, size_t>(indexRange.first, indexRange.second)); 
 
-			size_t biggest = indexRange.first;
-			for(size_t i = indexRange.first+1; i < currentSong.size() && i <= indexRange.second; ++i){
-				if(abs(currentSong[i]) > abs(currentSong[biggest])){
-					biggest = i;
-				}
-			}
-			pulseCenters.insert(pulseCenters.begin(), std::pair<size_t, size_t>(indexRange.first, biggest)); 
-			pulseCycles.insert(pulseCycles.begin(), std::pair<size_t, size_t>(indexRange.first, countPeakCycles(media, indexRange.first, indexRange.second)));
+			pulseCenters.insert(pulseCenters.begin(), std::pair<size_t, size_t>(indexRange.first, findPulseCenter(currentSong, indexRange.first, indexRange.second))); 
+			pulseCycles.insert(pulseCycles.begin(), std::pair<size_t, size_t>(indexRange.first, countPeakCycles(currentSong, indexRange.first, indexRange.second)));
 			return true;
 		}
 	}
@@ -344,6 +338,36 @@ void SongResults::clearAllData()
 	pulsePerMinuteAllCount = 0;
 }
 
+void SongResults::setDetectedData(const std::map<size_t, size_t>& pulses, const std::map<size_t, size_t>& pulseCenters, const std::map<size_t, size_t>& pulseCycles, const std::map<size_t, size_t>& sines, const std::map<size_t, size_t>& trains)
+{
+	deleteStatisticFilesAndData();
+	ipi.clear();
+	this->pulses = pulses;
+	this->pulseCenters = pulseCenters;
+	this->pulseCycles = pulseCycles;
+	this->sines = sines;
+	this->trains = trains;
+	saveData();
+	writePairFile<size_t, size_t>(pulses, std::string(fileName + "/raw_songpulses.txt").c_str());
+	writePairFile<size_t, size_t>(pulseCenters, std::string(fileName + "/raw_songpulsecenters.txt").c_str());
+	writePairFile<size_t, size_t>(pulseCycles, std::string(fileName + "/raw_songpulsecycles.txt").c_str());
+	writePairFile<size_t, size_t>(sines, std::string(fileName + "/raw_songsines.txt").c_str());
+	writePairFile<size_t, size_t>(trains, std::string(fileName + "/raw_songtrains.txt").c_str());
+	QFile::remove(std::string(fileName + "/songfile_was_cleaned.txt").c_str());
+}
+
+// the sample with the largest amplitude
+size_t SongResults::findPulseCenter(const std::vector<float>& song, size_t pulseStart, size_t pulseEnd)
+{
+	size_t biggest = pulseStart;
+	for(size_t i = pulseStart+1; i < song.size() && i <= pulseEnd; ++i){
+		if(std::abs(song[i]) > std::abs(song[biggest])){
+			biggest = i;
+		}
+	}
+	return biggest;
+}
+
 void SongResults::calculateStatisticalValues(std::map<QString, float> statisticOptions, size_t sampleRate, float samples, size_t startSample, size_t endSample)
 {
 	deleteStatisticFilesAndData();
@@ -632,10 +656,8 @@ void SongResults::copyFile(const char* srcPath, const char* dstPath)
 // if the positive peaks are higher than 1/3 of the highest positive peak and if the negative peaks are higher
 // than 1/3 of the highest negative peak. The minimum of the remaining positive and negative peaks is returned
 // as cycles per pulse
-size_t SongResults::countPeakCycles(const Video& media, size_t pulseStart, size_t pulseEnd)
+size_t SongResults::countPeakCycles(const std::vector<float>& currentSong, size_t pulseStart, size_t pulseEnd)
 {
-	const std::vector<float>& currentSong = media.getSong();
-
 	std::vector<float> posPeaks;
 	std::vector<float> negPeaks;
 	if(pulseStart < 1){
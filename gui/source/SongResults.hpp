@@ -59,6 +59,12 @@ public:
 	void saveCleanData();
 	void clearAllData();
 
+	// replaces all data with freshly detected song, which is saved both as the current and as the raw data
+	void setDetectedData(const std::map<size_t, size_t>& pulses, const std::map<size_t, size_t>& pulseCenters, const std::map<size_t, size_t>& pulseCycles, const std::map<size_t, size_t>& sines, const std::map<size_t, size_t>& trains);
+
+	static size_t findPulseCenter(const std::vector<float>& song, size_t pulseStart, size_t pulseEnd);
+	static size_t countPeakCycles(const std::vector<float>& song, size_t pulseStart, size_t pulseEnd);
+
 	void calculateStatisticalValues(std::map<QString, float> statisticOptions, size_t sampleRate, float samples, size_t startSample, size_t endSample);
 
 private:
@@ -131,8 +137,6 @@ private:
 	void writeBinningFile(const binStruct& data, const char* filename);
 
 	void copyFile(const char* srcPath, const char* dstPath);
-
-	size_t countPeakCycles(const Video& media, size_t pulseStart, size_t pulseEnd);
 };
 
 #endif
@@ -1079,31 +1079,28 @@ void SongTab::drawColors(std::pair<int, int> indexRange)
 	size_t startSample = indexRange.first;
 	size_t endSample = indexRange.second + 1;
 
-	//TODO: much more efficient than going through the whole thing would be to search the map with lower_bound
 	if (highlightTrainsCheckBox->isChecked()) {
 		const std::map<size_t, size_t>& trains = songResults.getTrains();
-		for (std::map<size_t, size_t>::const_iterator it = trains.begin(); it != trains.end(); ++it) {
-			if (it->first >= startSample && it->first < endSample && it->second >= startSample && it->second < endSample) {
+		for (std::map<size_t, size_t>::const_iterator it = trains.lower_bound(startSample); it != trains.end() && it->first < endSample; ++it) {
+			if (it->second >= startSample && it->second < endSample) {
 				std::fill(drawingPad.begin() + (it->first - startSample), drawingPad.begin() + (it->second - startSample), QVector4D(0.0, 1.0, 0.0, 1.0));
 			}
 		}
 	}
 
-	//TODO: much more efficient than going through the whole thing would be to search the map with lower_bound
 	if (highlightSinesCheckBox->isChecked()) {
 		const std::map<size_t, size_t>& sines = songResults.getSines();
-		for (std::map<size_t, size_t>::const_iterator it = sines.begin(); it != sines.end(); ++it) {
-			if (it->first >= startSample && it->first < endSample && it->second >= startSample && it->second < endSample) {
+		for (std::map<size_t, size_t>::const_iterator it = sines.lower_bound(startSample); it != sines.end() && it->first < endSample; ++it) {
+			if (it->second >= startSample && it->second < endSample) {
 				std::fill(drawingPad.begin() + (it->first - startSample), drawingPad.begin() + (it->second - startSample), QVector4D(0.0, 0.0, 1.0, 1.0));
 			}
 		}
 	}
 
-	//TODO: much more efficient than going through the whole thing would be to search the map with lower_bound
 	if (highlightPulsesCheckBox->isChecked()) {
 		const std::map<size_t, size_t>& pulses = songResults.getPulses();
-		for (std::map<size_t, size_t>::const_iterator it = pulses.begin(); it != pulses.end(); ++it) {
-			if (it->first >= startSample && it->first < endSample && it->second >= startSample && it->second < endSample) {
+		for (std::map<size_t, size_t>::const_iterator it = pulses.lower_bound(startSample); it != pulses.end() && it->first < endSample; ++it) {
+			if (it->second >= startSample && it->second < endSample) {
 				std::fill(drawingPad.begin() + (it->first - startSample), drawingPad.begin() + (it->second - startSample), QVector4D(1.0, 0.0, 0.0, 1.0));
 			}
 		}
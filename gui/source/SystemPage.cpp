@@ -3,6 +3,7 @@
 #include "SystemPage.hpp"
 #include "global.hpp"
 #include "JobQueue.hpp"
+#include "AttributeCache.hpp"
 #include "Version.hpp"
 #include "../../common/source/Settings.hpp"
 #include "../../common/source/Singleton.hpp"
@@ -78,6 +79,32 @@ SystemPage::SystemPage(Settings& trackerSettings, QWidget* parent) : ConfigPage(
 	pathLayout->itemAt(pathLayout->count() - 2)->widget()->setToolTip(QString("Run at most this many processing jobs concurrently in the background."));
 	pathLayout->itemAt(pathLayout->count() - 1)->widget()->setToolTip(QString::number(maxJobsSpinBox->minimum()) + "..." + QString::number(maxJobsSpinBox->maximum()));
 
+	attributeCacheSize = new QSpinBox(this);
+	connect(attributeCacheSize, SIGNAL(valueChanged(int)), this, SLOT(setAttributeCacheSize(int)));
+	attributeCacheSize->setRange(16, 65536);
+	attributeCacheSize->setValue(512);
+	attributeCacheSize->setSuffix(" MB");
+	pathLayout->addRow(QString("Attribute Cache Size: "), attributeCacheSize);
+	pathLayout->itemAt(pathLayout->count() - 2)->widget()->setToolTip(QString("How much of the tracking results to keep in memory for the arenas shown recently."));
+	pathLayout->itemAt(pathLayout->count() - 1)->widget()->setToolTip(QString::number(attributeCacheSize->minimum()) + "..." + QString::number(attributeCacheSize->maximum()));
+
+	decodingThreadCount = new QSpinBox(this);
+	decodingThreadCount->setRange(0, 64);
+	decodingThreadCount->setValue(1);
+	decodingThreadCount->setSpecialValueText("One per Core");
+	pathLayout->addRow(QString("Decoding Threads per Job: "), decodingThreadCount);
+	pathLayout->itemAt(pathLayout->count() - 2)->widget()->setToolTip(QString("Number of threads the tracker decodes the video with."));
+	pathLayout->itemAt(pathLayout->count() - 1)->widget()->setToolTip(QString::number(decodingThreadCount->minimum()) + "..." + QString::number(decodingThreadCount->maximum()));
+	trackerSettings.add<int>("decoding_threadCount", boost::bind(&QSpinBox::value, decodingThreadCount), boost::bind(&QSpinBox::setValue, decodingThreadCount, _1));
+
+	decodingThreadType = new QComboBox(this);
+	decodingThreadType->addItem("Frames");	// index 0 matches mw::VideoCodec::frameThreading
+	decodingThreadType->addItem("Slices");	// index 1 matches mw::VideoCodec::sliceThreading
+	pathLayout->addRow(QString("Decode in Parallel: "), decodingThreadType);
+	pathLayout->itemAt(pathLayout->count() - 2)->widget()->setToolTip(QString("Decode several frames at once, or the slices of a frame. Slices only help if the video was encoded with several slices per frame."));
+	pathLayout->itemAt(pathLayout->count() - 1)->widget()->setToolTip(QString("Decode several frames at once, or the slices of a frame. Slices only help if the video was encoded with several slices per frame."));
+	trackerSettings.add<int>("decoding_threadType", boost::bind(&QComboBox::currentIndex, decodingThreadType), boost::bind(&QComboBox::setCurrentIndex, decodingThreadType, _1));
+
 	attachDebugger = new QCheckBox(this);
 	attachDebugger->setText("Attach Debugger");
 	attachDebugger->setToolTip("Attaches the debugger to the tracker process.");
@@ -181,6 +208,7 @@ void SystemPage::readGuiSettings(const QSettings& settings)
 	liveVisualization->setChecked(settings.value("liveVisualization", false).toBool());
 	int maxJobs = settings.value("maxJobsSpinBox", QThread::idealThreadCount()).toInt();
 	maxJobsSpinBox->setValue(maxJobs < 0 ? 1 : maxJobs);
+	attributeCacheSize->setValue(settings.value("attributeCacheSize", 512).toInt());
 	sshTransferHost->setText(settings.value("sshTransferHost", "albert").toString());
 	sshHostKey->setText(settings.value("sshHostKey", "0x23,0xb8573b6e21dfd2b72fe747d43ccc5572f53c74f8e99230b8c81bef31f3be74ae4d5692c08a62ff2b72e0a9c2d0a3d7ee0220213f3954e53e5ea9131235e9d9e5111e0a9e5c1e8e5e126cab0394c4f3ca0d241f87b4f6acf0583146f9881a559b3e59f3aab0ece7623bb0ecc439048d9ddaa2f8847b8207769e4e6d90c3deebd8f6ce993a1d2e093706845685ef13af299005422992d8e284e3f427316b81ae4bef6c435afebce66d4e1e703061a8cf6410928416420d2aaf46dc588c33672cfca890a7fc2ad6ffd0fa471d93fe8543ee99ddc69f1d1cfe7dac633e9b09977d52e5ce0de288e22faf33d94e2ac0eb58ee60d8a106e985213b7e0eb549e1dd119d").toString());
 	commitSshHostKey();
@@ -191,6 +219,7 @@ void SystemPage::writeGuiSettings(QSettings& settings) const
 	settings.setValue("attachDebugger", attachDebugger->isChecked());
 	settings.setValue("liveVisualization", liveVisualization->isChecked());
 	settings.setValue("maxJobsSpinBox", maxJobsSpinBox->value());
+	settings.setValue("attributeCacheSize", attributeCacheSize->value());
 	settings.setValue("sshTransferHost", sshTransferHost->text());
 	settings.setValue("sshHostKey", sshHostKey->text());
 }
@@ -250,6 +279,11 @@ int SystemPage::getPollingInterval() const
 	return pollingInterval->value();
 }
 
+void SystemPage::setAttributeCacheSize(int megabytes)
+{
+	Singleton<AttributeCache>::instance().setCapacity(static_cast<size_t>(megabytes) * 1024 * 1024);
+}
+
 void SystemPage::commitSshHostKey()
 {
 	#if defined(WIN32)
@@ -39,12 +39,16 @@ public:
 	int getPollingInterval() const;
 
 private slots:
+	void setAttributeCacheSize(int megabytes);
 	void commitSshHostKey();
 
 private:
 	QComboBox* matlabExecutable;
 	QComboBox* trackerExecutable;
 	QSpinBox* maxJobsSpinBox;
+	QSpinBox* attributeCacheSize;
+	QSpinBox* decodingThreadCount;
+	QComboBox* decodingThreadType;
 	QCheckBox* attachDebugger;
 	QCheckBox* liveVisualization;
 	QComboBox* sshClient;
@@ -17,17 +17,13 @@ TrackingResults::TrackingResults(const std::string& fileName, const std::string&
 	fileName(fileName),
 	contourFileName(contourFileName),
 	smoothHistogramFileName(smoothHistogramFileName),
-	flyCount(0)
+	flyCount(0),
+	offset(0),
+	frameCount(0),
+	viewRevision(0)
 {
-	QStringList frameAttribFiles = QDir(QString::fromStdString(fileName + "/frame/")).entryList();
-	foreach (QString file, frameAttribFiles) {
-		std::string fileStdString = file.toStdString();
-		if (frameAttributes.has(fileStdString)) {
-			frameAttributes.getEmpty(fileStdString).readBinaries(fileName + "/frame/" + fileStdString);
-		} else {
-			std::cerr << "warning: skipping unknown attribute " << file.toStdString() << std::endl;
-		}
-	}
+	// the attributes are loaded when they're first used, so we only need to know how many flies and pairs there are
+	Singleton<AttributeCache>::instance().refresh(fileName + "/");
 
 	QStringList flyAttribDirs = QDir(QString::fromStdString(fileName + "/fly/")).entryList();
 	foreach (QString dir, flyAttribDirs) {
@@ -38,16 +34,6 @@ TrackingResults::TrackingResults(const std::string& fileName, const std::string&
 			if (flyNumber + 1 > flyAttributes.size()) {
 				flyAttributes.resize(flyNumber + 1);
 			}
-
-			QStringList flyAttribFiles = QDir(QString::fromStdString(fileName + "/fly/" + dir.toStdString())).entryList();
-			foreach (QString file, flyAttribFiles) {
-				std::string fileStdString = file.toStdString();
-				if (flyAttributes[flyNumber].has(fileStdString)) {
-					flyAttributes[flyNumber].getEmpty(fileStdString).readBinaries(fileName + "/fly/" + dir.toStdString() + "/" + fileStdString);
-				} else {
-					std::cerr << "warning: skipping unknown attribute " << file.toStdString() << std::endl;
-				}
-			}
 		}
 	}
 	flyCount = flyAttributes.size();
@@ -71,24 +57,14 @@ TrackingResults::TrackingResults(const std::string& fileName, const std::string&
 					if (passiveNumber + 1 > pairAttributes[activeNumber].size()) {
 						pairAttributes[activeNumber].resize(passiveNumber + 1);
 					}
-
-
-					QStringList pairAttribFiles = QDir(QString::fromStdString(fileName + "/pair/" + activeDir.toStdString() + "/" + passiveDir.toStdString())).entryList();
-					foreach (QString file, pairAttribFiles) {
-						std::string fileStdString = file.toStdString();
-						if (pairAttributes[activeNumber][passiveNumber].has(fileStdString)) {
-							pairAttributes[activeNumber][passiveNumber].getEmpty(fileStdString).readBinaries(fileName + "/pair/" + activeDir.toStdString() + "/" + passiveDir.toStdString() + "/" + fileStdString);
-						} else {
-							std::cerr << "warning: skipping unknown attribute " << file.toStdString() << std::endl;
-						}
-					}
 				}
 			}
 		}
 	}
 
 	// sanity check videoFrame numbers: they have to be contiguous
-	const Attribute<uint32_t>& videoFrame = getFrameData<uint32_t>("videoFrame");
+	const boost::shared_ptr<AbstractAttribute> videoFrameAttribute = Singleton<AttributeCache>::instance().get(getFrameDirectory() + "videoFrame", frameAttributes.get<uint32_t>("videoFrame"));
+	const std::vector<uint32_t>& videoFrame = assert_cast<const Attribute<uint32_t>*>(videoFrameAttribute.get())->getData();
 	if (!videoFrame.empty()) {
 		size_t videoFrameNumber = videoFrame.front();
 		for (std::vector<uint32_t>::const_iterator iter = videoFrame.begin(); iter != videoFrame.end(); ++iter) {
@@ -97,48 +73,11 @@ TrackingResults::TrackingResults(const std::string& fileName, const std::string&
 			}
 			++videoFrameNumber;
 		}
+		offset = videoFrame.front();
+		frameCount = videoFrame.size();
 	}
 
-	occlusionMap = OcclusionMap(getFrameData<MyBool>("isOcclusion").getData(), getOffset());
-
-	//TODO: load the contours into a VBO...how do we share it between contexts?
-	std::ifstream contourFile(contourFileName.c_str(), std::ios::in | std::ios::binary);
-	if (contourFile) {
-		contourFile.seekg(0, std::ios::beg);
-		std::streampos fbegin = contourFile.tellg();
-		contourFile.seekg(0, std::ios::end);
-		std::streampos fend = contourFile.tellg();
-		contourFile.seekg(0, std::ios::beg);
-		size_t fileSize = fend - fbegin;	// in bytes
-
-		contours.resize(fileSize);
-		if (fileSize != 0) {
-			if (!contourFile.read(&contours[0], fileSize)) {
-				std::cerr << "couldn't read the expected number of bytes from " << contourFileName << std::endl;
-			}
-		}
-	}
-
-	std::ifstream smoothHistogramFile(smoothHistogramFileName.c_str(), std::ios::in | std::ios::binary);
-	if (smoothHistogramFile) {
-		smoothHistogramFile.seekg(0, std::ios::beg);
-		std::streampos fbegin = smoothHistogramFile.tellg();
-		smoothHistogramFile.seekg(0, std::ios::end);
-		std::streampos fend = smoothHistogramFile.tellg();
-		smoothHistogramFile.seekg(0, std::ios::beg);
-		size_t fileSize = fend - fbegin;	// in bytes
-
-		if (fileSize % (256 * sizeof(float)) != 0) {
-			std::cerr << "couldn't read the expected number of bytes from " << smoothHistogramFileName << std::endl;
-		} else {
-			smoothHistograms.resize(fileSize / sizeof(float));
-			if (fileSize != 0) {
-				if (!smoothHistogramFile.read(reinterpret_cast<char*>(&smoothHistograms[0]), fileSize)) {
-					std::cerr << "couldn't read the expected number of bytes from " << smoothHistogramFileName << std::endl;
-				}
-			}
-		}
-	}
+	occlusionMap = OcclusionMap(loadFrameAttribute<MyBool>("isOcclusion")->getData(), getOffset());
 }
 
 TrackingResults::~TrackingResults()
@@ -157,11 +96,7 @@ size_t TrackingResults::getFlyCount() const
 
 bool TrackingResults::hasData(size_t videoFrameNumber) const
 {
-	const Attribute<uint32_t>& videoFrame = getFrameData<uint32_t>("videoFrame");
-	if (videoFrame.empty()) {
-		return false;
-	}
-	return videoFrame.front() <= videoFrameNumber && videoFrameNumber <= videoFrame.back();
+	return offset <= videoFrameNumber && videoFrameNumber < offset + frameCount;
 }
 
 std::vector<std::string> TrackingResults::getFrameAttributeNames() const
@@ -195,26 +130,61 @@ OcclusionMap& TrackingResults::getOcclusionMap()
 	return occlusionMap;
 }
 
-const std::vector<char>& TrackingResults::getContours() const
+// maps the file on first use; a missing file maps to NULL, and is looked for again next time
+const MappedFile* mapFile(boost::shared_ptr<MappedFile>& mappedFile, const std::string& fileName)
 {
-	return contours;
+	if (!mappedFile) {
+		try {
+			mappedFile.reset(new MappedFile(fileName));
+		} catch (const std::runtime_error&) {
+			return NULL;
+		}
+	}
+	return mappedFile.get();
+}
+
+const char* TrackingResults::getContours() const
+{
+	const MappedFile* file = mapFile(contours, contourFileName);
+	return file ? file->data() : NULL;
+}
+
+size_t TrackingResults::getContourByteCount() const
+{
+	const MappedFile* file = mapFile(contours, contourFileName);
+	return file ? file->size() : 0;
 }
 
 const float* TrackingResults::getSmoothHistogram(size_t videoFrameNumber) const
 {
-	size_t offset = getOffset();
-	if (videoFrameNumber < offset || (videoFrameNumber - offset + 1) * 256 > smoothHistograms.size()) {
+	const MappedFile* file = mapFile(smoothHistograms, smoothHistogramFileName);
+	if (!file || file->size() % (256 * sizeof(float)) != 0) {
+		return NULL;
+	}
+	if (videoFrameNumber < offset || (videoFrameNumber - offset + 1) * 256 * sizeof(float) > file->size()) {
 		return NULL;
 	}
-	return &smoothHistograms[(videoFrameNumber - offset) * 256];
+	return reinterpret_cast<const float*>(file->data()) + (videoFrameNumber - offset) * 256;
 }
 
 size_t TrackingResults::getOffset() const
 {
-	if (getFrameData<uint32_t>("videoFrame").size() == 0) {
-		return 0;
-	}
-	return getFrameData<uint32_t>("videoFrame").front();
+	return offset;
+}
+
+std::string TrackingResults::getFrameDirectory() const
+{
+	return fileName + "/frame/";
+}
+
+std::string TrackingResults::getFlyDirectory(size_t flyNumber) const
+{
+	return fileName + "/fly/" + stringify(flyNumber) + "/";
+}
+
+std::string TrackingResults::getPairDirectory(size_t activeFly, size_t passiveFly) const
+{
+	return fileName + "/pair/" + stringify(activeFly) + "/" + stringify(passiveFly) + "/";
 }
 
 void TrackingResults::saveAnnotation(const std::string& fileName) const
@@ -256,16 +226,27 @@ void TrackingResults::saveAnnotation(const std::string& fileName) const
 	annotationFile << ::transpose(trans.str());
 }
 
+// the views are only valid for the occlusion map they were switched with, and there shouldn't be more of them than the user is looking at
+void TrackingResults::storeView(const std::string& key, const boost::shared_ptr<AbstractAttribute>& view) const
+{
+	const size_t maxViewCount = 64;
+	if (viewRevision != occlusionMap.getRevision() || views.size() >= maxViewCount) {
+		views.clear();
+		viewRevision = occlusionMap.getRevision();
+	}
+	views[key] = view;
+}
+
 std::auto_ptr<AbstractAttribute> TrackingResults::getFrameData(std::string attributeName) const
 {
 	if (hasFrameAttribute<MyBool>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFrameData<MyBool>(attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFrameView<MyBool>(attributeName)->clone());
 	} else if (hasFrameAttribute<float>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFrameData<float>(attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFrameView<float>(attributeName)->clone());
 	} else if (hasFrameAttribute<uint32_t>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFrameData<uint32_t>(attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFrameView<uint32_t>(attributeName)->clone());
 	} else if (hasFrameAttribute<Vf2>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFrameData<Vf2>(attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFrameView<Vf2>(attributeName)->clone());
 	}
 	return std::auto_ptr<AbstractAttribute>();
 }
@@ -273,13 +254,13 @@ std::auto_ptr<AbstractAttribute> TrackingResults::getFrameData(std::string attri
 std::auto_ptr<AbstractAttribute> TrackingResults::getFlyData(size_t flyNumber, std::string attributeName) const
 {
 	if (hasFlyAttribute<MyBool>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFlyData<MyBool>(flyNumber, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFlyView<MyBool>(flyNumber, attributeName)->clone());
 	} else if (hasFlyAttribute<float>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFlyData<float>(flyNumber, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFlyView<float>(flyNumber, attributeName)->clone());
 	} else if (hasFlyAttribute<uint32_t>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFlyData<uint32_t>(flyNumber, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFlyView<uint32_t>(flyNumber, attributeName)->clone());
 	} else if (hasFlyAttribute<Vf2>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getFlyData<Vf2>(flyNumber, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getFlyView<Vf2>(flyNumber, attributeName)->clone());
 	}
 	return std::auto_ptr<AbstractAttribute>();
 }
@@ -287,13 +268,13 @@ std::auto_ptr<AbstractAttribute> TrackingResults::getFlyData(size_t flyNumber, s
 std::auto_ptr<AbstractAttribute> TrackingResults::getPairData(size_t activeFly, size_t passiveFly, std::string attributeName) const
 {
 	if (hasPairAttribute<MyBool>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getPairData<MyBool>(activeFly, passiveFly, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getPairView<MyBool>(activeFly, passiveFly, attributeName)->clone());
 	} else if (hasPairAttribute<float>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getPairData<float>(activeFly, passiveFly, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getPairView<float>(activeFly, passiveFly, attributeName)->clone());
 	} else if (hasPairAttribute<uint32_t>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getPairData<uint32_t>(activeFly, passiveFly, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getPairView<uint32_t>(activeFly, passiveFly, attributeName)->clone());
 	} else if (hasPairAttribute<Vf2>(attributeName)) {
-		return std::auto_ptr<AbstractAttribute>(getPairData<Vf2>(activeFly, passiveFly, attributeName).clone());
+		return std::auto_ptr<AbstractAttribute>(getPairView<Vf2>(activeFly, passiveFly, attributeName)->clone());
 	}
 	return std::auto_ptr<AbstractAttribute>();
 }
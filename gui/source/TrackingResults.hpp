@@ -1,6 +1,12 @@
 #ifndef TrackingResults_hpp
 #define TrackingResults_hpp
 
+/*
+TrackingResults gives access to the attributes, contours and histograms the tracker wrote for an arena.
+Apart from videoFrame and isOcclusion, which it needs right away, nothing is read until it's asked for:
+attributes are loaded through the shared AttributeCache, and the contour and histogram files are mapped into memory on first use.
+*/
+
 #include <map>
 #include <string>
 #include <vector>
@@ -8,8 +14,14 @@
 #include "../../tracker/source/FrameAttributes.hpp"
 #include "../../tracker/source/FlyAttributes.hpp"
 #include "../../tracker/source/PairAttributes.hpp"
+#include "../../common/source/MappedFile.hpp"
+#include "../../common/source/Singleton.hpp"
+#include "../../common/source/debug.hpp"
+#include "AttributeCache.hpp"
 
 #include <memory>
+#include <stdexcept>
+#include <boost/shared_ptr.hpp>
 
 class TrackingResults {
 public:
@@ -50,121 +62,128 @@ public:
 		return pairAttributes[0][0].has<T>(attributeName);
 	}
 
+	// the views show the data the way the user sees it, i.e. with the switches of the occlusion map applied
+	// data that doesn't need switching is shared with the AttributeCache; the rest is switched once and kept until the occlusion map changes
 	template<class T>
-	Attribute<T> getFrameData(std::string attributeName) const
+	boost::shared_ptr<const Attribute<T> > getFrameView(std::string attributeName) const
 	{
-		if (frameAttributes.isOcclusionSScore(attributeName)) {
-			const std::vector<bool>& switchMask = getOcclusionMap().getSwitchMask();
-			Attribute<T> ret(frameAttributes.getFilled<T>(attributeName));
-			assert(switchMask.size() == ret.size());
-			for (size_t frameNumber = 0; frameNumber != ret.size(); ++frameNumber) {
-				if (switchMask[frameNumber]) {
-					ret[frameNumber] = -ret[frameNumber];
-				}
-			}
-			return ret;
-		} else if (frameAttributes.isOcclusionTScore(attributeName)) {
-			Attribute<T> ret(frameAttributes.getFilled<T>(attributeName));
-			for (size_t frameNumber = 0; frameNumber != ret.size(); ++frameNumber) {
-				if (getOcclusionMap().getCurrentOcclusion(frameNumber + getOffset()).isSwitched()) {
-					ret[frameNumber] = -ret[frameNumber];
-				}
-			}
-			return ret;
-		} else if (frameAttributes.isOcclusionSProb(attributeName)) {
-			const std::vector<bool>& switchMask = getOcclusionMap().getSwitchMask();
-			Attribute<T> ret(frameAttributes.getFilled<T>(attributeName));
-			assert(switchMask.size() == ret.size());
-			for (size_t frameNumber = 0; frameNumber != ret.size(); ++frameNumber) {
-				if (switchMask[frameNumber]) {
-					ret[frameNumber] = T(1) - ret[frameNumber];
-				}
-			}
-			return ret;
-		} else if (frameAttributes.isOcclusionTProb(attributeName)) {
-			Attribute<T> ret(frameAttributes.getFilled<T>(attributeName));
-			for (size_t frameNumber = 0; frameNumber != ret.size(); ++frameNumber) {
-				if (getOcclusionMap().getCurrentOcclusion(frameNumber + getOffset()).isSwitched()) {
-					ret[frameNumber] = T(1) - ret[frameNumber];
-				}
+		const bool isSwitchedByMask = frameAttributes.isOcclusionSScore(attributeName) || frameAttributes.isOcclusionSProb(attributeName);
+		const bool isSwitchedByOcclusion = frameAttributes.isOcclusionTScore(attributeName) || frameAttributes.isOcclusionTProb(attributeName);
+		if (!isSwitchedByMask && !isSwitchedByOcclusion) {
+			return loadFrameAttribute<T>(attributeName);
+		}
+		const std::string key = getFrameDirectory() + attributeName;
+		boost::shared_ptr<const Attribute<T> > view = findView<T>(key);
+		if (view) {
+			return view;
+		}
+		const std::vector<bool>& switchMask = isSwitchedByMask ? getOcclusionMap().getSwitchMask() : getOcclusionMap().getCurrentSwitchedMask();
+		boost::shared_ptr<Attribute<T> > ret(assert_cast<Attribute<T>*>(loadFrameAttribute<T>(attributeName)->clone()));
+		assert(switchMask.size() == ret->size());
+		for (size_t frameNumber = 0; frameNumber != ret->size(); ++frameNumber) {
+			if (switchMask[frameNumber]) {
+				(*ret)[frameNumber] = switchFrameValue(attributeName, (*ret)[frameNumber]);
 			}
-			return ret;
 		}
-		return frameAttributes.getFilled<T>(attributeName);
+		storeView(key, ret);
+		return ret;
 	}
 
 	template<class T>
-	T getFrameData(std::string attributeName, size_t videoFrameNumber) const
+	boost::shared_ptr<const Attribute<T> > getFlyView(size_t flyNumber, std::string attributeName) const
 	{
-		return getFrameData<T>(attributeName)[videoFrameNumber - getOffset()];
+		assert(flyNumber < flyCount);
+		if (flyCount != 2) {
+			return loadFlyAttribute<T>(flyNumber, attributeName);	// only pairs of flies can be switched
+		}
+		const std::string key = getFlyDirectory(flyNumber) + attributeName;
+		boost::shared_ptr<const Attribute<T> > view = findView<T>(key);
+		if (view) {
+			return view;
+		}
+		return switchFlies(key, loadFlyAttribute<T>(flyNumber, attributeName), loadFlyAttribute<T>(1 - flyNumber, attributeName));
 	}
 
 	template<class T>
-	void setFrameData(std::string attributeName, size_t videoFrameNumber, const T& value)
+	boost::shared_ptr<const Attribute<T> > getPairView(size_t activeFly, size_t passiveFly, std::string attributeName) const
+	{
+		assert(flyCount == 2);
+		assert(activeFly < flyCount && passiveFly < flyCount && activeFly != passiveFly);
+		const std::string key = getPairDirectory(activeFly, passiveFly) + attributeName;
+		boost::shared_ptr<const Attribute<T> > view = findView<T>(key);
+		if (view) {
+			return view;
+		}
+		return switchFlies(key, loadPairAttribute<T>(activeFly, passiveFly, attributeName), loadPairAttribute<T>(passiveFly, activeFly, attributeName));
+	}
+
+	// copies of the views, for callers that want to change them
+	template<class T>
+	Attribute<T> getFrameData(std::string attributeName) const
 	{
-		frameAttributes.getFilled<T>(attributeName)[videoFrameNumber - getOffset()] = value;
+		return *getFrameView<T>(attributeName);
 	}
 
 	template<class T>
 	Attribute<T> getFlyData(size_t flyNumber, std::string attributeName) const
 	{
-		assert(flyNumber < flyCount);
-		if (flyCount == 1) {
-			return flyAttributes[0].getFilled<T>(attributeName);
-		} else if (flyCount == 2) {
-			const std::vector<bool>& switchMask = getOcclusionMap().getSwitchMask();
-			Attribute<T> ret = flyAttributes[0].getFilled<T>(attributeName);	// initialized with fly0's data
-			const Attribute<T>& retFly1 = flyAttributes[1].getFilled<T>(attributeName);
-			const Attribute<MyBool>& isOcclusion = getFrameData<MyBool>("isOcclusion");
-			assert(ret.size() == switchMask.size() && retFly1.size() == switchMask.size() && isOcclusion.size() == switchMask.size());
-			for (size_t frameNumber = 0; frameNumber != switchMask.size(); ++frameNumber) {
-				if (isOcclusion[frameNumber] && getOcclusionMap().getCurrentOcclusion(frameNumber + getOffset()).isSwitched()) {
-					ret[frameNumber] = T();
-				} else if (flyNumber != switchMask[frameNumber]) {
-					ret[frameNumber] = retFly1[frameNumber];
-				}
-			}
-			return ret;
+		return *getFlyView<T>(flyNumber, attributeName);
+	}
+
+	template<class T>
+	Attribute<T> getPairData(size_t activeFly, size_t passiveFly, std::string attributeName) const
+	{
+		return *getPairView<T>(activeFly, passiveFly, attributeName);
+	}
+
+	// single values of the views, in constant time
+	template<class T>
+	T getFrameData(std::string attributeName, size_t videoFrameNumber) const
+	{
+		const size_t frameNumber = videoFrameNumber - getOffset();
+		const T value = loadFrameAttribute<T>(attributeName)->getData()[frameNumber];
+		if (((frameAttributes.isOcclusionSScore(attributeName) || frameAttributes.isOcclusionSProb(attributeName)) && getOcclusionMap().getSwitchMask()[frameNumber]) ||
+			((frameAttributes.isOcclusionTScore(attributeName) || frameAttributes.isOcclusionTProb(attributeName)) && getOcclusionMap().getCurrentSwitchedMask()[frameNumber]))
+		{
+			return switchFrameValue(attributeName, value);
 		}
-		assert(false);	//TODO: make this work for an arbitrary number of flies	
-		return Attribute<T>();
+		return value;
 	}
 
 	template<class T>
-	T getFlyData(size_t flyNumber, std::string attributeName, size_t videoFrameNumber) const
+	void setFrameData(std::string attributeName, size_t videoFrameNumber, const T& value)
 	{
-		bool switchFlies = getOcclusionMap().getSwitchMask()[videoFrameNumber - getOffset()];
-		if (getFrameData<MyBool>("isOcclusion", videoFrameNumber) && getOcclusionMap().getCurrentOcclusion(videoFrameNumber).isSwitched()) {
-			return T();
-		} else {
-			return getRawFlyData<T>(flyNumber != switchFlies, attributeName)[videoFrameNumber - getOffset()];
+		// edited attributes are kept out of the cache, which could evict them before they're saved
+		const std::string filePath = getFrameDirectory() + attributeName;
+		std::map<std::string, boost::shared_ptr<AbstractAttribute> >::iterator edited = editedAttributes.find(filePath);
+		if (edited == editedAttributes.end()) {
+			boost::shared_ptr<AbstractAttribute> copy(loadFrameAttribute<T>(attributeName)->clone());
+			edited = editedAttributes.insert(std::make_pair(filePath, copy)).first;
 		}
+		(*assert_cast<Attribute<T>*>(edited->second.get()))[videoFrameNumber - getOffset()] = value;
+		views.erase(filePath);
 	}
 
 	template<class T>
-	Attribute<T> getPairData(size_t activeFly, size_t passiveFly, std::string attributeName) const
+	T getFlyData(size_t flyNumber, std::string attributeName, size_t videoFrameNumber) const
 	{
-		assert(flyCount == 2);
-		assert(activeFly < flyCount && passiveFly < flyCount && activeFly != passiveFly);
-		const std::vector<bool>& switchMask = getOcclusionMap().getSwitchMask();
-		Attribute<T> ret = pairAttributes[0][1].getFilled<T>(attributeName);	// initialized with the [0][1] pair's data
-		const Attribute<T>& retFly1 = pairAttributes[1][0].getFilled<T>(attributeName);
-		const Attribute<MyBool>& isOcclusion = getFrameData<MyBool>("isOcclusion");
-		assert(ret.size() == switchMask.size() && retFly1.size() == switchMask.size() && isOcclusion.size() == switchMask.size());
-		for (size_t frameNumber = 0; frameNumber != switchMask.size(); ++frameNumber) {
-			if (isOcclusion[frameNumber] && getOcclusionMap().getCurrentOcclusion(frameNumber + getOffset()).isSwitched()) {
-				ret[frameNumber] = T();
-			} else if (activeFly != switchMask[frameNumber]) {
-				ret[frameNumber] = retFly1[frameNumber];
-			}
+		assert(flyNumber < flyCount);
+		const size_t frameNumber = videoFrameNumber - getOffset();
+		if (flyCount != 2) {
+			return loadFlyAttribute<T>(flyNumber, attributeName)->getData()[frameNumber];
 		}
-		return ret;
+		if (loadFrameAttribute<MyBool>("isOcclusion")->getData()[frameNumber] && getOcclusionMap().getCurrentSwitchedMask()[frameNumber]) {
+			return T();
+		}
+		const size_t sourceFly = getOcclusionMap().getSwitchMask()[frameNumber] ? 1 - flyNumber : flyNumber;
+		return loadFlyAttribute<T>(sourceFly, attributeName)->getData()[frameNumber];
 	}
 
 	const OcclusionMap& getOcclusionMap() const;
 	OcclusionMap& getOcclusionMap();
 
-	const std::vector<char>& getContours() const;
+	const char* getContours() const;	// the contents of the contour file, NULL if there is none
+	size_t getContourByteCount() const;
 	const float* getSmoothHistogram(size_t videoFrameNumber) const;
 
 	size_t getOffset() const;	// number of frames at the beginning of the video that were skipped
@@ -172,33 +191,90 @@ public:
 	void saveAnnotation(const std::string& fileName) const;
 
 private:
-	// the getRaw* methods return the data without performing the switch operations
-	// therefore they are much faster than their public get* couterparts
+	// the load* methods return the data as stored, i.e. without performing the switch operations
+	// frameAttributes, flyAttributes and pairAttributes stay empty; they only tell which attributes there are and of which type
 	template<class T>
-	const std::vector<T>& getRawFrameData(std::string attributeName) const
+	boost::shared_ptr<const Attribute<T> > loadAttribute(const AttributeCollection& prototypes, const std::string& directory, const std::string& attributeName) const
 	{
-		return frameAttributes.getFilled<T>(attributeName).getData();
+		const std::string filePath = directory + attributeName;
+		std::map<std::string, boost::shared_ptr<AbstractAttribute> >::const_iterator edited = editedAttributes.find(filePath);
+		boost::shared_ptr<AbstractAttribute> attribute;
+		if (edited != editedAttributes.end()) {
+			attribute = edited->second;
+		} else {
+			attribute = Singleton<AttributeCache>::instance().get(filePath, prototypes.get<T>(attributeName));
+		}
+		if (attribute->empty()) {
+			throw std::logic_error("attribute \"" + attributeName + "\" is empty");
+		}
+		return boost::static_pointer_cast<const Attribute<T> >(attribute);
 	}
 
 	template<class T>
-	T getRawFrameData(std::string attributeName, size_t videoFrameNumber) const
+	boost::shared_ptr<const Attribute<T> > loadFrameAttribute(std::string attributeName) const
 	{
-		return getRawFrameData<T>(attributeName)[videoFrameNumber - getOffset()];
+		return loadAttribute<T>(frameAttributes, getFrameDirectory(), attributeName);
 	}
 
 	template<class T>
-	const std::vector<T>& getRawFlyData(size_t flyNumber, std::string attributeName) const
+	boost::shared_ptr<const Attribute<T> > loadFlyAttribute(size_t flyNumber, std::string attributeName) const
 	{
 		assert(flyNumber < flyCount);
-		return flyAttributes[flyNumber].getFilled<T>(attributeName).getData();
+		return loadAttribute<T>(flyAttributes[flyNumber], getFlyDirectory(flyNumber), attributeName);
+	}
+
+	template<class T>
+	boost::shared_ptr<const Attribute<T> > loadPairAttribute(size_t activeFly, size_t passiveFly, std::string attributeName) const
+	{
+		return loadAttribute<T>(pairAttributes[activeFly][passiveFly], getPairDirectory(activeFly, passiveFly), attributeName);
+	}
+
+	// a score changes its sign when the flies are switched, a probability becomes its complement
+	template<class T>
+	T switchFrameValue(const std::string& attributeName, const T& value) const
+	{
+		if (frameAttributes.isOcclusionSScore(attributeName) || frameAttributes.isOcclusionTScore(attributeName)) {
+			return -value;
+		}
+		return T(1) - value;
+	}
+
+	// first where the flies aren't switched, second where they are, and T() within switched occlusions, where the flies can't be told apart
+	template<class T>
+	boost::shared_ptr<const Attribute<T> > switchFlies(const std::string& key, const boost::shared_ptr<const Attribute<T> >& first, const boost::shared_ptr<const Attribute<T> >& second) const
+	{
+		const std::vector<bool>& switchMask = getOcclusionMap().getSwitchMask();
+		const std::vector<bool>& currentSwitchedMask = getOcclusionMap().getCurrentSwitchedMask();
+		const boost::shared_ptr<const Attribute<MyBool> > isOcclusion = loadFrameAttribute<MyBool>("isOcclusion");
+		assert(first->size() == switchMask.size() && second->size() == switchMask.size() && isOcclusion->size() == switchMask.size());
+		boost::shared_ptr<Attribute<T> > ret(assert_cast<Attribute<T>*>(first->clone()));
+		for (size_t frameNumber = 0; frameNumber != switchMask.size(); ++frameNumber) {
+			if ((*isOcclusion)[frameNumber] && currentSwitchedMask[frameNumber]) {
+				(*ret)[frameNumber] = T();
+			} else if (switchMask[frameNumber]) {
+				(*ret)[frameNumber] = (*second)[frameNumber];
+			}
+		}
+		storeView(key, ret);
+		return ret;
 	}
 
 	template<class T>
-	T getRawFlyData(size_t flyNumber, std::string attributeName, size_t videoFrameNumber) const
+	boost::shared_ptr<const Attribute<T> > findView(const std::string& key) const
 	{
-		return getRawFlyData<T>(flyNumber, attributeName)[videoFrameNumber - getOffset()];
+		std::map<std::string, boost::shared_ptr<AbstractAttribute> >::const_iterator iter = views.find(key);
+		if (iter == views.end() || viewRevision != getOcclusionMap().getRevision()) {
+			return boost::shared_ptr<const Attribute<T> >();
+		}
+		return boost::static_pointer_cast<const Attribute<T> >(iter->second);
 	}
 
+	void storeView(const std::string& key, const boost::shared_ptr<AbstractAttribute>& view) const;
+
+	std::string getFrameDirectory() const;
+	std::string getFlyDirectory(size_t flyNumber) const;
+	std::string getPairDirectory(size_t activeFly, size_t passiveFly) const;
+
 	// these get* methods return AbstractAttribute objects and are needed for saving annotations
 	std::auto_ptr<AbstractAttribute> getFrameData(std::string attributeName) const;
 	std::auto_ptr<AbstractAttribute> getFlyData(size_t flyNumber, std::string attributeName) const;
@@ -208,15 +284,20 @@ private:
 	std::string contourFileName;
 	std::string smoothHistogramFileName;
 	size_t flyCount;
+	size_t offset;
+	size_t frameCount;
 
 	FrameAttributes frameAttributes;
 	std::vector<FlyAttributes> flyAttributes;	// [flyNumber]
 	std::vector<std::vector<PairAttributes> > pairAttributes;	// [activeFly][passiveFly]
+	std::map<std::string, boost::shared_ptr<AbstractAttribute> > editedAttributes;	// by file path
+	mutable std::map<std::string, boost::shared_ptr<AbstractAttribute> > views;	// the switched attributes, by the file path of what they show
+	mutable size_t viewRevision;	// of the occlusion map the views were switched with
 
 	OcclusionMap occlusionMap;
 
-	std::vector<char> contours;
-	std::vector<float> smoothHistograms;
+	mutable boost::shared_ptr<MappedFile> contours;	// mapped on first use
+	mutable boost::shared_ptr<MappedFile> smoothHistograms;
 };
 
 #endif
@@ -12,13 +12,16 @@
 #include "../../common/source/BinaryReader.hpp"
 
 Video::Video() :
-	fileName()
+	fileName(),
+	currentFrameNumber(0)
 {
 }
 
 Video::Video(const std::string& fileName) :
 	fileName(fileName),
 	inputVideo(new mw::InputVideo(fileName)),
+	frameCache(),
+	currentFrameNumber(0),
 	width(),
 	height(),
 	fps(),
@@ -47,6 +50,7 @@ Video::Video(const std::string& fileName) :
 
 Video::~Video()
 {
+	frameCache.reset();
 	inputVideo.reset();
 }
 
@@ -95,17 +99,14 @@ const std::vector<float>& Video::getSong() const
 	return song;
 }
 
-unsigned char* Video::getCurrentFrame()
+boost::shared_ptr<const FrameCache::Frame> Video::getCurrentFrame()
 {
-	return inputVideo->getFrameBuffer(PIX_FMT_RGB24);
+	return getFrameCache().getFrame(currentFrameNumber);
 }
 
-unsigned char* Video::getNextFrame()
+boost::shared_ptr<const FrameCache::Frame> Video::waitForCurrentFrame()
 {
-	if (inputVideo->seek(inputVideo->getCurrentFrameNumber() + 1)) {
-		return inputVideo->getFrameBuffer(PIX_FMT_RGB24);
-	}
-	return NULL;
+	return getFrameCache().waitForFrame(currentFrameNumber);
 }
 
 bool Video::isVideo()
@@ -115,17 +116,32 @@ bool Video::isVideo()
 
 unsigned int Video::getCurrentFrameNumber() const
 {
-	return inputVideo->getCurrentFrameNumber();
+	return currentFrameNumber;
 }
 
+// only moves the current frame; it is decoded in the background
 void Video::seek(unsigned int frameNumber)
 {
-	inputVideo->seek(frameNumber);
+	if (frameNumber >= numFrames) {
+		return;
+	}
+	currentFrameNumber = frameNumber;
+	getFrameCache().setCurrentFrame(frameNumber);
+}
+
+// the decoder thread is only started once frames are needed, since many videos are only opened for their meta data
+FrameCache& Video::getFrameCache()
+{
+	if (!frameCache) {
+		frameCache.reset(new FrameCache(inputVideo, numFrames, width, height));
+		frameCache->setCurrentFrame(currentFrameNumber);
+	}
+	return *frameCache;
 }
 
 void Video::rewind()
 {
-	inputVideo->seek(0);
+	seek(0);
 }
 
 	struct WaveHeader {
@@ -6,6 +6,7 @@
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include "../../mediawrapper/source/mediawrapper.hpp"
+#include "FrameCache.hpp"
 
 class SongMatlabDataLoader;
 /**
@@ -33,8 +34,9 @@ public:
 	unsigned int getSampleRate() const;
 	const std::vector<float>& getSong() const;
 
-	unsigned char* getCurrentFrame();
-	unsigned char* getNextFrame();
+	// the RGB data of the current frame, or NULL while it is still being decoded in the background
+	boost::shared_ptr<const FrameCache::Frame> getCurrentFrame();
+	boost::shared_ptr<const FrameCache::Frame> waitForCurrentFrame();	// blocks until the current frame has been decoded
 	bool isVideo();
 	unsigned int getCurrentFrameNumber() const;
 	void seek(unsigned int frameNumber);
@@ -42,7 +44,9 @@ public:
 
 private:
 	std::string fileName;
-	boost::shared_ptr<mw::InputVideo> inputVideo;
+	boost::shared_ptr<mw::InputVideo> inputVideo;	// handed over to the frameCache once frames are needed
+	boost::shared_ptr<FrameCache> frameCache;
+	unsigned int currentFrameNumber;
 	int width;
 	int height;
 	double fps;
@@ -52,6 +56,7 @@ private:
 	std::vector<float> song;
 
 	void readWaveFile(const std::string& path);
+	FrameCache& getFrameCache();
 };
 
 #endif
@@ -229,7 +229,9 @@ void VideoPlayer::displayCurrentFrame()
 	frameSpinBox->blockSignals(true);
 	frameSpinBox->setValue(currentVideo->getCurrentFrameNumber());
 	frameSpinBox->blockSignals(false);
-	emit frameDisplayed(currentVideo->getCurrentFrameNumber());
+	if (!videoRenderer->isFramePending()) {
+		emit frameDisplayed(currentVideo->getCurrentFrameNumber());
+	}
 }
 
 void VideoPlayer::rendererClicked(QPoint point)
@@ -280,6 +282,11 @@ void VideoPlayer::displayNextFrame()
 		currentVideo->seek(seekTo);
 		seekPending = false;
 		displayCurrentFrame();
+	} else if (videoRenderer->isFramePending()) {
+		videoRenderer->updateGL();	// the frame may have been decoded by now; playing doesn't run ahead of the decoder
+		if (!videoRenderer->isFramePending()) {
+			emit frameDisplayed(currentVideo->getCurrentFrameNumber());
+		}
 	} else if (currentMode == Play) {
 		unsigned int currentFrameNumber = currentVideo->getCurrentFrameNumber();
 		if (playBackward) {
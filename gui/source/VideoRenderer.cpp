@@ -10,6 +10,7 @@
 #include <sstream>
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
 #include "VideoRenderer.hpp"
 #include "Video.hpp"
 
@@ -22,8 +23,8 @@ VideoRenderer::VideoRenderer(QWidget *parent, QGLWidget *shareWidget) : QGLWidge
 	roiTop(0),
 	roiWidth(1),
 	roiHeight(1),
-	frameData(NULL),
-	lastFrameDecoded(-1),
+	frameData(),
+	lastFrameUploaded(-1),
 	projectionRatio(1),
 	lastPos(),
 	startPos(),
@@ -32,8 +33,12 @@ VideoRenderer::VideoRenderer(QWidget *parent, QGLWidget *shareWidget) : QGLWidge
 	dragMode(false),
 	zoomFactor(1),
 	panX(0), panY(0),
+	nextPixelBuffer(0),
 	offscreenBuffer(NULL)
 {
+	for (size_t i = 0; i < bufferSize; ++i) {
+		pixelBuffers[i] = NULL;
+	}
 	setFocusPolicy(Qt::ClickFocus);
 	setMouseTracking(true);
 }
@@ -42,6 +47,9 @@ VideoRenderer::~VideoRenderer()
 {
 	makeCurrent();
 	glDeleteTextures(bufferSize, &textures[0]);
+	for (size_t i = 0; i < bufferSize; ++i) {
+		delete pixelBuffers[i];
+	}
 	
 	if(offscreenBuffer)
 	{
@@ -77,8 +85,8 @@ void VideoRenderer::pan(float dX, float dY)
 
 void VideoRenderer::setCurrentVideo(boost::shared_ptr<Video> video)
 {
-	frameData = NULL;
-	lastFrameDecoded = -1;
+	frameData.reset();
+	lastFrameUploaded = -1;
 
 	if (!video) {
 		// null pointer passed, so unset the current video
@@ -121,8 +129,8 @@ void VideoRenderer::setCurrentVideo(boost::shared_ptr<Video> video)
 
 void VideoRenderer::setCurrentVideo(boost::shared_ptr<Video> video, unsigned int roiLeft, unsigned int roiTop, unsigned int roiWidth, unsigned int roiHeight)
 {
-	frameData = NULL;
-	lastFrameDecoded = -1;
+	frameData.reset();
+	lastFrameUploaded = -1;
 
 	if (!video) {
 		// null pointer passed, so unset the current video
@@ -247,6 +255,12 @@ void VideoRenderer::initializeGL()
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 //		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAPS, GL_FALSE);
 	}
+
+	for (size_t i = 0; i < bufferSize; ++i) {
+		pixelBuffers[i] = new QGLBuffer(QGLBuffer::PixelUnpackBuffer);
+		pixelBuffers[i]->setUsagePattern(QGLBuffer::StreamDraw);
+		pixelBuffers[i]->create();	// fails without pixel buffer object support, in which case frames are uploaded directly
+	}
 }
 
 void VideoRenderer::paintGL()
@@ -343,6 +357,11 @@ void VideoRenderer::paintGL()
 		
 	}
 	
+	if (isFramePending()) {
+		// the overlays are drawn for the current frame, which isn't on screen yet
+		return;
+	}
+	
 	if (recording) {
 //		glNewList(overlayDisplayList, GL_COMPILE_AND_EXECUTE);
 	}
@@ -643,19 +662,14 @@ void VideoRenderer::renderToTexture()
 	if (!currentVideo) {
 		return;
 	}
-	if (currentVideo->getCurrentFrameNumber() != lastFrameDecoded) {
-		frameData = currentVideo->getCurrentFrame();
-		lastFrameDecoded = currentVideo->getCurrentFrameNumber();
-		//		std::cout << "last frame decoded " << lastFrameDecoded << std::endl;
-		if (frameData) {
-			glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
-			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-			glPixelStorei(GL_UNPACK_ROW_LENGTH, currentVideo->getWidth());
-			glPixelStorei(GL_UNPACK_SKIP_PIXELS, roiLeft);
-			glPixelStorei(GL_UNPACK_SKIP_ROWS, roiTop);
-			glBindTexture(GL_TEXTURE_2D, textures[0]);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (int)roiWidth, (int)roiHeight, GL_RGB, GL_UNSIGNED_BYTE, frameData);
-			glPopClientAttrib();
+	if (isFramePending()) {
+		// until the current frame has been decoded, the last one stays on screen; a recording waits for the decoder instead so that it doesn't repeat frames
+		if (boost::shared_ptr<const std::vector<unsigned char> > frame = recording ? currentVideo->waitForCurrentFrame() : currentVideo->getCurrentFrame()) {
+			lastFrameUploaded = currentVideo->getCurrentFrameNumber();
+			if (!frame->empty()) {
+				uploadFrame(&(*frame)[0]);
+				frameData = frame;
+			}
 		}
 	}
 	if (frameData) {
@@ -682,6 +696,46 @@ void VideoRenderer::renderToTexture()
 	}
 }
 
+bool VideoRenderer::isFramePending() const
+{
+	return currentVideo && (int)currentVideo->getCurrentFrameNumber() != lastFrameUploaded;
+}
+
+void VideoRenderer::uploadFrame(const unsigned char* frame)
+{
+	QGLBuffer* pixelBuffer = pixelBuffers[nextPixelBuffer];
+	nextPixelBuffer = (nextPixelBuffer + 1) % bufferSize;
+
+	const size_t rowByteCount = roiWidth * 3;
+	unsigned char* mapped = NULL;
+	if (pixelBuffer && pixelBuffer->isCreated() && pixelBuffer->bind()) {
+		pixelBuffer->allocate(rowByteCount * roiHeight);	// orphans the old storage instead of waiting for the driver to be done with it
+		mapped = static_cast<unsigned char*>(pixelBuffer->map(QGLBuffer::WriteOnly));
+		if (!mapped) {
+			pixelBuffer->release();
+		}
+	}
+
+	glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, textures[0]);
+	if (mapped) {
+		// only the region of interest goes into the pixel buffer
+		for (unsigned int row = 0; row != roiHeight; ++row) {
+			std::copy(frame + ((roiTop + row) * currentVideo->getWidth() + roiLeft) * 3, frame + ((roiTop + row) * currentVideo->getWidth() + roiLeft) * 3 + rowByteCount, mapped + row * rowByteCount);
+		}
+		pixelBuffer->unmap();
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (int)roiWidth, (int)roiHeight, GL_RGB, GL_UNSIGNED_BYTE, 0);	// from the pixel buffer; returns before the transfer is done
+		pixelBuffer->release();
+	} else {
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, currentVideo->getWidth());
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, roiLeft);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, roiTop);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (int)roiWidth, (int)roiHeight, GL_RGB, GL_UNSIGNED_BYTE, frame);
+	}
+	glPopClientAttrib();
+}
+
 void VideoRenderer::moveImage(QPoint from, QPoint to)
 {
 	QPoint delta = to - from;
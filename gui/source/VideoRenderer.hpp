@@ -3,6 +3,7 @@
 
 #include <QGLWidget>
 #include <QGLFramebufferObject>
+#include <QGLBuffer>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include "../../mediawrapper/source/mediawrapper.hpp"
@@ -34,6 +35,8 @@ public:
 	void bindExtraTexture(const QString& fileName);
 	void deleteExtraTextures();
 
+	bool isFramePending() const;	// whether the current frame of the video hasn't been shown yet because it is still being decoded
+
 signals:
 	void clicked(QPoint);
 	void doubleClicked(QPoint);
@@ -58,6 +61,7 @@ private:
 	void drawVideoFrame();
 	
 	void renderToTexture();
+	void uploadFrame(const unsigned char* frame);
 	
 	void moveImage(QPoint from, QPoint to);
 
@@ -70,8 +74,8 @@ private:
 	unsigned int roiWidth;
 	unsigned int roiHeight;
 
-	unsigned char* frameData;	// memory owned by mediawrapper
-	int lastFrameDecoded;
+	boost::shared_ptr<const std::vector<unsigned char> > frameData;	// the frame shown
+	int lastFrameUploaded;
 
 	float projectionRatio; // width / height of the space projected to the viewport
 
@@ -85,6 +89,8 @@ private:
 
 	static const size_t bufferSize = 2;
 	GLuint textures[bufferSize];
+	QGLBuffer* pixelBuffers[bufferSize];	// frames are uploaded through them in turns, so writing one doesn't wait for the upload from the other
+	size_t nextPixelBuffer;
 
 	std::map<QString, GLuint> extraTextures;	// textures added via bindTexture
 	
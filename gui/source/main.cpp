@@ -10,12 +10,18 @@
 #include "../../common/source/Settings.hpp"
 #include "../../mediawrapper/source/mediawrapper.hpp"
 #include "../../common/source/debug.hpp"
+#include "SongDetectorTest.hpp"
 
 int main(int argc, char *argv[])
 {
 	for (int i = 0; i < argc; ++i) {
 		std::cout << argv[i] << std::endl;
 	}
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--testSongDetector") {
+			return runSongDetectorTest();
+		}
+	}
 
 	//initMemoryLeakDetection();
 	mw::initialize();
@@ -18,7 +18,7 @@ TARGET = MateBook
 BIN_DIR = \"${BIN_DIR}\"
 DEFINES += ${OS} GL_GLEXT_PROTOTYPES "'BIN_DIR=\$\${BIN_DIR}'"
 CONFIG += debug console
-LIBS += -lopencv_core -lopencv_highgui -lopencv_imgproc -lboost_system -lboost_filesystem -lavdevice -lavfilter -lavformat -lavutil -lavcodec -lswresample -lswscale
+LIBS += -lopencv_core -lopencv_highgui -lopencv_imgproc -lboost_system -lboost_filesystem -lboost_thread -lavdevice -lavfilter -lavformat -lavutil -lavcodec -lswresample -lswscale
 INCLUDEPATH += ${MB_DIR}/usr/include
 QMAKE_LIBDIR += ${MB_DIR}/usr/lib
 END_OF_HEAD
@@ -35,7 +35,9 @@ extern "C"
 
 namespace mw
 {
-	InputVideo::InputVideo(std::string mFileName) :
+	InputVideo::InputVideo(std::string mFileName,
+						   int mDecodingThreadCount/* = 1*/,
+						   VideoCodec::threadType mDecodingThreadType/* = VideoCodec::frameThreading*/) :
 	fileName_(mFileName),
 	videoFormat_(NULL),
 	videoCodec_(NULL),
@@ -53,6 +55,8 @@ namespace mw
 	framesBeforeKey_(0),
 	loadNextKeyFrame_(false),
 	audioStreamIndices_(),
+	keyFrameIndex_(),
+	keyFrameIndexDone_(false),
 	scaleContext(NULL),
 	colorConvertContext(NULL),
 	cFormat(PIX_FMT_RGB24),
@@ -100,7 +104,7 @@ namespace mw
 			 *	we load the codec for the given stream
 			 */
 			videoCodec_ = new VideoCodec();
-			videoCodec_->loadCodec(videoFormat_, firstStream_);
+			videoCodec_->loadCodec(videoFormat_, firstStream_, mDecodingThreadCount, mDecodingThreadType);
 			
 			/**
 			 *	in some videos, a pixel is not square but a rectangle.
@@ -173,6 +177,12 @@ namespace mw
 			 *	when the wrong fps value is reported
 			 */
 			numFrames_ = (int64_t) std::floor((videoFormat_->getAVFormatContext()->duration - start) * fps_ / AV_TIME_BASE + 0.5f);
+			
+			/**
+			 *	the keyframe index lets us seek directly to the keyframe before any frame.
+			 *	if it isn't stored yet, building it needs to read the whole video, which is left to the first seek that needs it
+			 */
+			keyFrameIndexDone_ = this->loadKeyFrameIndex();
 		}
 		
 		/**
@@ -241,6 +251,16 @@ namespace mw
 		return gopSize_;
 	}
 	
+	size_t InputVideo::getKeyFrameCount() const
+	{
+		return keyFrameIndex_.size();
+	}
+	
+	int64_t InputVideo::getDiscardedFrameCount() const
+	{
+		return frame ? frame->getDiscardedFrameCount() : 0;
+	}
+	
 	unsigned int InputVideo::getCurrentFrameNumber()
 	{
 		return lastFrame_;
@@ -277,8 +297,11 @@ namespace mw
 		/**
 		 *	we mark our seeked_ flag as true and also since we seeked to an exact frame
 		 *	we have to make sure we load the frame, and not just the next keyframe.
-		 *	use seekApprox if you want to get only the keyframe
+		 *	use seekApprox if you want to get only the keyframe.
+		 *	whether a frame was read since the last seek is remembered, because only then
+		 *	does the decoder stand at curFrame_
 		 */
+		bool wasSeeked = seeked_;
 		seeked_ = true;
 		loadNextKeyFrame_ = false;
 		
@@ -292,11 +315,38 @@ namespace mw
 		 *	in case we want to only read the next frame, we are done, since this is
 		 *	the default behaviour once a frame is loaded.
 		 */
-		if(mFrameNumber == curFrame_ + 1)
+		bool nextFrame = (mFrameNumber == curFrame_ + 1);
+		
+		/**
+		 *	building the index moves the decoder back to the start of the video
+		 */
+		if(!nextFrame && this->buildKeyFrameIndexForSeek(mFrameNumber))
+		{
+			wasSeeked = true;
+		}
+		
+		if(nextFrame)
 		{
 			curFrame_ = mFrameNumber;
 			result = true;
 		}
+		else if(const KeyFrameIndex::KeyFrame * keyFrame = keyFrameIndex_.findKeyFrameBefore(mFrameNumber))
+		{
+			/**
+			 *	with the index we know which keyframe comes before the frame we want.
+			 *	if the last frame read lies between that keyframe and the frame we want,
+			 *	we don't seek at all and decoding simply continues up to the frame we want
+			 */
+			if(!wasSeeked && keyFrame->frameNumber <= curFrame_ && curFrame_ < mFrameNumber)
+			{
+				result = true;
+			}
+			else
+			{
+				curFrame_ = keyFrame->frameNumber;
+				result = this->seekToTimeStamp(keyFrame->timeStamp);
+			}
+		}
 		else
 		{
 			/**
@@ -334,6 +384,16 @@ namespace mw
 		 */
 		loadNextKeyFrame_ = true;
 		seeked_ = true;
+		/**
+		 *	if we have an index we can seek directly to the keyframe before mFrameNumber
+		 */
+		this->buildKeyFrameIndexForSeek(mFrameNumber);
+		if(const KeyFrameIndex::KeyFrame * keyFrame = keyFrameIndex_.findKeyFrameBefore(mFrameNumber))
+		{
+			curFrame_ = lastFrame_ = keyFrame->frameNumber;
+			return this->seekToTimeStamp(keyFrame->timeStamp);
+		}
+		
 		/**
 		 *	sometimes the first frame in a video is not a key frame, thus we have to
 		 *	calculate the offset
@@ -467,6 +527,21 @@ namespace mw
 		return NULL;
 	}
 	
+	bool InputVideo::readFrame(colorFormat mColorFormat, uint8_t* mBuffer, int mLineSize)
+	{
+		/**
+		 *	the frame converts into the caller's buffer for this one load only,
+		 *	so getFrameBuffer keeps working as before
+		 */
+		if (!frame) {
+			return false;
+		}
+		frame->setOutputBuffer(mBuffer, mLineSize);
+		VideoFrame* videoFrame = getVideoFrame(mColorFormat);
+		frame->setOutputBuffer(NULL, 0);
+		return videoFrame != NULL;
+	}
+	
 	int InputVideo::getAudioStreamCount()
 	{
 		return (int) audioStreamIndices_.size();
@@ -622,13 +697,20 @@ namespace mw
 	{
 		/**
 		 *	we need to calculate the time stamp for our given frame number.
-		 *	since we are seeking we have to reset global_video_pkt_pts, since otherwise
-		 *	the pts of the next read frame is wrong.
 		 */
-		global_video_pkt_pts = AV_NOPTS_VALUE;
 		int64_t timestamp = videoFormat_->frameNumberToTimeStamp(mFrameNumber,
 																 interlaced_,
 																 firstStream_);
+		return this->seekToTimeStamp(timestamp);
+	}
+	
+	bool InputVideo::seekToTimeStamp(int64_t mTimeStamp)
+	{
+		/**
+		 *	since we are seeking we have to reset global_video_pkt_pts, since otherwise
+		 *	the pts of the next read frame is wrong.
+		 */
+		global_video_pkt_pts = AV_NOPTS_VALUE;
 		
 		/**
 		 *	depending on the given codec of the video, we need separate flags for seeking
@@ -643,7 +725,7 @@ namespace mw
 		}
 		else
 		{
-			flags = (timestamp == 0) ? AVSEEK_FLAG_FRAME : AVSEEK_FLAG_BACKWARD;
+			flags = (mTimeStamp == 0) ? AVSEEK_FLAG_FRAME : AVSEEK_FLAG_BACKWARD;
 		}
 		
 		/**
@@ -651,7 +733,7 @@ namespace mw
 		 */
 		result = av_seek_frame(videoFormat_->getAVFormatContext(),
 							   firstStream_,
-							   timestamp,
+							   mTimeStamp,
 							   flags);
 		
 		/**
@@ -667,4 +749,67 @@ namespace mw
 		
 		return true;
 	}
+	
+	bool InputVideo::loadKeyFrameIndex()
+	{
+		/**
+		 *	the index is stored next to the video, or in the cache directory of the user if that wasn't possible,
+		 *	so it only has to be built the first time a video is opened
+		 */
+		int64_t fileSize = avio_size(videoFormat_->getAVFormatContext()->pb);
+		if(keyFrameIndex_.recall(fileName_, fileSize))
+		{
+			return true;
+		}
+		std::string cacheFileName;
+		if(keyFrameIndex_.load(KeyFrameIndex::getFileName(fileName_), fileSize) ||
+		   (!(cacheFileName = KeyFrameIndex::getCacheFileName(fileName_)).empty() && keyFrameIndex_.load(cacheFileName, fileSize)))
+		{
+			keyFrameIndex_.remember(fileName_, fileSize);
+			return true;
+		}
+		return false;
+	}
+	
+	bool InputVideo::buildKeyFrameIndexForSeek(int64_t mFrameNumber)
+	{
+		if(keyFrameIndexDone_ || mFrameNumber < framesBeforeKey_ + gopSize_)
+		{
+			return false;
+		}
+		
+		/**
+		 *	whatever happens, the video is read only once per open
+		 */
+		keyFrameIndexDone_ = true;
+		int64_t fileSize = avio_size(videoFormat_->getAVFormatContext()->pb);
+		keyFrameIndex_.build(videoFormat_, firstStream_, fps_, videoFormat_->getFirstFramePts());
+		
+		/**
+		 *	building the index read the whole video, so we reset it to the start the same way getFrameStats does
+		 */
+		avcodec_flush_buffers(videoCodec_->getAVCodecContext());
+		if(av_seek_frame(videoFormat_->getAVFormatContext(),
+						 -1,
+						 0,
+						 (videoCodec_->getAVCodec()->id == CODEC_ID_H264) ? AVSEEK_FLAG_BACKWARD : AVSEEK_FLAG_ANY) < 0)
+		{
+			std::cerr << "Resetting Video failed!" << std::endl;
+		}
+		
+		if(!keyFrameIndex_.empty())
+		{
+			keyFrameIndex_.remember(fileName_, fileSize);
+			std::string indexFileName = KeyFrameIndex::getFileName(fileName_);
+			if(!keyFrameIndex_.save(indexFileName, fileSize))
+			{
+				std::string cacheFileName = KeyFrameIndex::getCacheFileName(fileName_);
+				if(cacheFileName.empty() || !keyFrameIndex_.save(cacheFileName, fileSize))
+				{
+					std::cerr << "warning: could not write keyframe index " << indexFileName << std::endl;
+				}
+			}
+		}
+		return true;
+	}
 }
@@ -10,6 +10,8 @@
 
 #include "Video.hpp"
 #include "ColorFormat.hpp"
+#include "KeyFrameIndex.hpp"
+#include "VideoCodec.hpp"
 
 #include <vector>
 #include <string>
@@ -27,8 +29,12 @@ namespace mw
 		
 		/**
 		 *	@param	mFileName the file name of the video
+		 *	@param	mDecodingThreadCount the number of threads the video stream is decoded with, 0 lets ffmpeg use one per core
+		 *	@param	mDecodingThreadType how decoding is split between the threads
 		 */
-		InputVideo(std::string mFileName);
+		InputVideo(std::string mFileName,
+				   int mDecodingThreadCount = 1,
+				   VideoCodec::threadType mDecodingThreadType = VideoCodec::frameThreading);
 		
 		/**
 		 *	destructor
@@ -89,6 +95,19 @@ namespace mw
 		 */
 		unsigned int getCurrentFrameNumber();
 		
+		/**
+		 *	returns the number of keyframes in the keyframe index
+		 *	@return	returns the number of keyframes, or 0 if seeking falls back to the gop size.
+		 *			an index that isn't stored yet is only built by the first seek past the first gop
+		 */
+		size_t getKeyFrameCount() const;
+		
+		/**
+		 *	returns how many frames had to be decoded and thrown away to get to the frames that were seeked to
+		 *	@return	returns the number of discarded frames since the video was opened
+		 */
+		int64_t getDiscardedFrameCount() const;
+		
 		/**
 		 *	seeks to the given framenumber and stores it in the video object to use for reading
 		 *	it when the mFrameNumber is different than lastFrameRead+1 it actually seeks to the
@@ -113,6 +132,17 @@ namespace mw
 		 */
 		uint8_t* getFrameBuffer(colorFormat mColorFormat);
 		
+		/**
+		 *	loads the current frame and converts it straight into a buffer owned by the caller,
+		 *	which saves copying the frame out of the buffer returned by getFrameBuffer.
+		 *	only packed color formats (e.g. PIX_FMT_BGR24) are supported.
+		 *	@param	mColorFormat the color format that the final frame should be
+		 *	@param	mBuffer where the frame is written to; must hold getFrameHeight() rows of mLineSize bytes
+		 *	@param	mLineSize the number of bytes from the start of one row to the start of the next row in mBuffer
+		 *	@return	returns if loading the frame was successful; if not, mBuffer is left unchanged
+		 */
+		bool readFrame(colorFormat mColorFormat, uint8_t* mBuffer, int mLineSize);
+		
 		/**
 		 *	gets the number of audio streams
 		 *	@return	returns the number of audio streams
@@ -181,6 +211,28 @@ namespace mw
 		 */
 		bool seekToKeyFrame(int64_t mFrameNumber);
 		
+		/**
+		 *	seeks to the keyframe with the given time stamp
+		 *	@param	mTimeStamp the time stamp in the time base of the video stream
+		 *	@return	returns if success
+		 */
+		bool seekToTimeStamp(int64_t mTimeStamp);
+		
+		/**
+		 *	loads the keyframe index from memory, its sidecar file or the cache directory of the user
+		 *	@return	returns if there was a valid index
+		 */
+		bool loadKeyFrameIndex();
+		
+		/**
+		 *	builds and stores the keyframe index if it wasn't loaded yet and seeking to the given frame needs it.
+		 *	frames in the first gop are reached from the start of the video, so opening a video and reading
+		 *	it from the beginning never reads the whole video first
+		 *	@param	mFrameNumber the frame that is seeked to
+		 *	@return	returns if the index was built, which leaves the video at its start
+		 */
+		bool buildKeyFrameIndexForSeek(int64_t mFrameNumber);
+		
 
 		std::string fileName_;
 		VideoFormat			* videoFormat_;			/**< pointer to the format of the current video. */
@@ -202,6 +254,8 @@ namespace mw
 		bool				  loadNextKeyFrame_;	/**< if the next frame to be loaded should be a keyframe. */
 		
 		std::vector<unsigned int> audioStreamIndices_;	/**< the indices of the audio streams. */
+		KeyFrameIndex		  keyFrameIndex_;		/**< the keyframes of the video stream; if empty, keyframes are estimated using gopSize_. */
+		bool				  keyFrameIndexDone_;	/**< if the keyframe index was loaded or built, so it is not built (again) on seeking. */
 		
 		SwsContext				* scaleContext;			/**< the software scale context. */
 		SwsContext				* colorConvertContext;	/**< the context used for color conversion. */
@@ -0,0 +1,266 @@
+/**
+ *  @file	KeyFrameIndex.cpp
+ *  @brief	contains the implementation for the KeyFrameIndex class
+ */
+
+#define __STDC_CONSTANT_MACROS
+#include <stdint.h>
+
+#include "KeyFrameIndex.hpp"
+#include "VideoFormat.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/thread/mutex.hpp>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+namespace mw
+{
+	const char * const indexHeader = "mediawrapper keyframe index";
+	const int indexVersion = 2;
+	
+	/**
+	 *	the indices built or read in this process, by the file name of their video.
+	 *	videos are opened from several threads, e.g. by the gui, so the map is guarded by a mutex
+	 */
+	std::map<std::string, std::pair<int64_t, KeyFrameIndex> > rememberedIndices;
+	boost::mutex rememberedIndicesMutex;
+	
+	KeyFrameIndex::KeyFrameIndex() :
+	keyFrames_()
+	{
+	}
+	
+	std::string KeyFrameIndex::getFileName(const std::string& mVideoFileName)
+	{
+		return mVideoFileName + ".keyframes";
+	}
+	
+	std::string KeyFrameIndex::getCacheFileName(const std::string& mVideoFileName)
+	{
+#if defined(_WIN32)
+		const char * cacheRoot = std::getenv("LOCALAPPDATA");
+#else
+		const char * cacheRoot = std::getenv("XDG_CACHE_HOME");
+		std::string homeCache;
+		if(!cacheRoot || !*cacheRoot)
+		{
+			const char * home = std::getenv("HOME");
+			if(home && *home)
+			{
+				homeCache = std::string(home) + "/.cache";
+				cacheRoot = homeCache.c_str();
+			}
+		}
+#endif
+		if(!cacheRoot || !*cacheRoot)
+		{
+			return std::string();
+		}
+		
+		/**
+		 *	the index is named after the full path of the video, so videos with the same name in different directories don't collide
+		 */
+		std::string cacheName;
+		try
+		{
+			cacheName = boost::filesystem::system_complete(mVideoFileName).string();
+			boost::filesystem::path cacheDirectory = boost::filesystem::path(cacheRoot) / "mediawrapper";
+			boost::filesystem::create_directories(cacheDirectory);
+			for(std::string::iterator iter = cacheName.begin(); iter != cacheName.end(); ++iter)
+			{
+				if(*iter == '/' || *iter == '\\' || *iter == ':')
+				{
+					*iter = '_';
+				}
+			}
+			return (cacheDirectory / getFileName(cacheName)).string();
+		}
+		catch(const boost::filesystem::filesystem_error&)
+		{
+			return std::string();
+		}
+	}
+	
+	bool KeyFrameIndex::recall(const std::string& mVideoFileName, int64_t mVideoFileSize)
+	{
+		boost::mutex::scoped_lock lock(rememberedIndicesMutex);
+		std::map<std::string, std::pair<int64_t, KeyFrameIndex> >::const_iterator iter = rememberedIndices.find(mVideoFileName);
+		if(iter == rememberedIndices.end() || iter->second.first != mVideoFileSize)
+		{
+			return false;
+		}
+		keyFrames_ = iter->second.second.keyFrames_;
+		return true;
+	}
+	
+	void KeyFrameIndex::remember(const std::string& mVideoFileName, int64_t mVideoFileSize) const
+	{
+		boost::mutex::scoped_lock lock(rememberedIndicesMutex);
+		rememberedIndices[mVideoFileName] = std::make_pair(mVideoFileSize, *this);
+	}
+	
+	bool KeyFrameIndex::load(const std::string& mFileName, int64_t mVideoFileSize)
+	{
+		keyFrames_.clear();
+		std::ifstream in(mFileName.c_str());
+		if(!in)
+		{
+			return false;
+		}
+		
+		/**
+		 *	the header holds the version of the format and the size of the video the index was built for,
+		 *	so an index left over from a different video with the same name is not used
+		 */
+		std::string header;
+		int version = 0;
+		int64_t videoFileSize = -1;
+		size_t keyFrameCount = 0;
+		if(!std::getline(in, header, '\t') || header != indexHeader ||
+		   !(in >> version >> videoFileSize >> keyFrameCount) ||
+		   version != indexVersion || videoFileSize != mVideoFileSize)
+		{
+			return false;
+		}
+		
+		keyFrames_.reserve(keyFrameCount);
+		KeyFrame keyFrame;
+		while(in >> keyFrame.frameNumber >> keyFrame.timeStamp)
+		{
+			keyFrames_.push_back(keyFrame);
+		}
+		if(keyFrames_.size() != keyFrameCount)
+		{
+			keyFrames_.clear();
+			return false;
+		}
+		return true;
+	}
+	
+	bool KeyFrameIndex::save(const std::string& mFileName, int64_t mVideoFileSize) const
+	{
+		/**
+		 *	several processes may open the same video at once, e.g. when it is tracked in shards,
+		 *	so the index is written to a file of this process and then renamed into place.
+		 *	that way nobody ever reads a partially written index
+		 */
+		std::ostringstream temporaryFileName;
+#if defined(_WIN32)
+		temporaryFileName << mFileName << '.' << _getpid() << ".tmp";
+#else
+		temporaryFileName << mFileName << '.' << getpid() << ".tmp";
+#endif
+		{
+			std::ofstream out(temporaryFileName.str().c_str());
+			if(!out)
+			{
+				return false;
+			}
+			out << indexHeader << '\t' << indexVersion << '\t' << mVideoFileSize << '\t' << keyFrames_.size() << '\n';
+			for(std::vector<KeyFrame>::const_iterator iter = keyFrames_.begin(); iter != keyFrames_.end(); ++iter)
+			{
+				out << iter->frameNumber << '\t' << iter->timeStamp << '\n';
+			}
+			out.close();
+			if(!out)
+			{
+				std::remove(temporaryFileName.str().c_str());
+				return false;
+			}
+		}
+#if defined(_WIN32)
+		bool renamed = MoveFileExA(temporaryFileName.str().c_str(), mFileName.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		bool renamed = std::rename(temporaryFileName.str().c_str(), mFileName.c_str()) == 0;
+#endif
+		if(!renamed)
+		{
+			std::remove(temporaryFileName.str().c_str());
+		}
+		return renamed;
+	}
+	
+	void KeyFrameIndex::build(const VideoFormat * mFormat, unsigned int mStreamIndex, float mFps, float mFirstFramePts)
+	{
+		keyFrames_.clear();
+		AVFormatContext * formatContext = mFormat->getAVFormatContext();
+		double timeBase = av_q2d(formatContext->streams[mStreamIndex]->time_base);
+		
+		/**
+		 *	only the packets are read, nothing is decoded.
+		 *	the frame number of a keyframe is derived from its time stamp the same way
+		 *	VideoFrame::loadFrame derives the time stamp of the frame it is looking for.
+		 *	keyframes without a presentation time stamp are left out: their decoding time stamp comes before
+		 *	their presentation on streams with b-frames, so it would give the wrong frame number, and seeking
+		 *	falls back to an earlier keyframe of the index instead
+		 */
+		AVPacket packet;
+		while(av_read_frame(formatContext, & packet) >= 0)
+		{
+			if(packet.stream_index == (int)mStreamIndex && (packet.flags & AV_PKT_FLAG_KEY))
+			{
+				int64_t timeStamp = packet.pts;
+				if(timeStamp != (int64_t)AV_NOPTS_VALUE)
+				{
+					KeyFrame keyFrame;
+					keyFrame.frameNumber = (int64_t) std::floor((timeStamp * timeBase - mFirstFramePts) * mFps + 0.5);
+					keyFrame.timeStamp = timeStamp;
+					if(keyFrame.frameNumber >= 0)
+					{
+						keyFrames_.push_back(keyFrame);
+					}
+				}
+			}
+			av_free_packet(& packet);
+		}
+		std::stable_sort(keyFrames_.begin(), keyFrames_.end(), compareFrameNumbers);
+	}
+	
+	bool KeyFrameIndex::compareFrameNumbers(const KeyFrame & mLeft, const KeyFrame & mRight)
+	{
+		return mLeft.frameNumber < mRight.frameNumber;
+	}
+	
+	bool KeyFrameIndex::empty() const
+	{
+		return keyFrames_.empty();
+	}
+	
+	size_t KeyFrameIndex::size() const
+	{
+		return keyFrames_.size();
+	}
+	
+	const KeyFrameIndex::KeyFrame * KeyFrameIndex::findKeyFrameBefore(int64_t mFrameNumber) const
+	{
+		KeyFrame key;
+		key.frameNumber = mFrameNumber;
+		key.timeStamp = 0;
+		std::vector<KeyFrame>::const_iterator iter = std::upper_bound(keyFrames_.begin(), keyFrames_.end(), key, compareFrameNumbers);
+		if(iter == keyFrames_.begin())
+		{
+			return NULL;
+		}
+		return &*(iter - 1);
+	}
+}
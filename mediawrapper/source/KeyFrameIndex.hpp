@@ -0,0 +1,128 @@
+/**
+ *  @file	KeyFrameIndex.hpp
+ *  @brief	contains the interface for the KeyFrameIndex class
+ */
+
+#ifndef __key_frame_index_h
+#define __key_frame_index_h
+
+#include <string>
+#include <vector>
+
+#include "../../common/source/mystdint.h"
+
+namespace mw
+{
+	class VideoFormat;
+	
+	/**
+	 *	@class	KeyFrameIndex
+	 *	@brief	the frame numbers and time stamps of all keyframes of a video stream
+	 *
+	 *	the index is built once by reading (but not decoding) all packets of the video and
+	 *	is stored in a sidecar file next to the video, so later opens of the same video,
+	 *	e.g. by the gui and the tracker, can reuse it. where the sidecar can't be written,
+	 *	e.g. on read-only media, it is stored in the cache directory of the user instead,
+	 *	and it is always kept in memory for the rest of the process.
+	 *	with the index, seeking can jump directly to the keyframe before any frame instead of
+	 *	guessing its position from the gop size.
+	 */
+	class KeyFrameIndex
+	{
+	public:
+		
+		/**
+		 *	a single keyframe
+		 */
+		struct KeyFrame
+		{
+			int64_t frameNumber;	/**< the number of the frame, counted from the first frame of the video. */
+			int64_t timeStamp;		/**< the time stamp of the frame in the time base of its stream. */
+		};
+		
+		KeyFrameIndex();
+		
+		/**
+		 *	returns the name of the sidecar file used for the given video
+		 *	@param	mVideoFileName the file name of the video
+		 *	@return	returns the file name of the index
+		 */
+		static std::string getFileName(const std::string& mVideoFileName);
+		
+		/**
+		 *	returns the name of the index file in the cache directory of the user, creating the directory if needed
+		 *	@param	mVideoFileName the file name of the video
+		 *	@return	returns the file name of the index, or an empty string if there is no cache directory
+		 */
+		static std::string getCacheFileName(const std::string& mVideoFileName);
+		
+		/**
+		 *	reads the index from the indices kept in memory by remember()
+		 *	@param	mVideoFileName the file name of the video
+		 *	@param	mVideoFileSize the size of the video in bytes; an index remembered for a different size is not used
+		 *	@return	returns if an index was found
+		 */
+		bool recall(const std::string& mVideoFileName, int64_t mVideoFileSize);
+		
+		/**
+		 *	keeps a copy of the index in memory, so opening the same video again in this process doesn't need to read a file
+		 *	@param	mVideoFileName the file name of the video
+		 *	@param	mVideoFileSize the size of the video in bytes
+		 */
+		void remember(const std::string& mVideoFileName, int64_t mVideoFileSize) const;
+		
+		/**
+		 *	reads the index from a sidecar file
+		 *	@param	mFileName the file name of the index
+		 *	@param	mVideoFileSize the size of the video in bytes; an index written for a different size is rejected
+		 *	@return	returns if a valid index was read
+		 */
+		bool load(const std::string& mFileName, int64_t mVideoFileSize);
+		
+		/**
+		 *	writes the index to a sidecar file
+		 *	@param	mFileName the file name of the index
+		 *	@param	mVideoFileSize the size of the video in bytes
+		 *	@return	returns if writing was successful
+		 */
+		bool save(const std::string& mFileName, int64_t mVideoFileSize) const;
+		
+		/**
+		 *	builds the index by reading all packets of the given stream.
+		 *	the position in the video is undefined afterwards, the caller has to seek.
+		 *	@param	mFormat the format of the video
+		 *	@param	mStreamIndex the index of the video stream
+		 *	@param	mFps the frame rate used to convert time stamps to frame numbers
+		 *	@param	mFirstFramePts the presentation time of the first frame in seconds
+		 */
+		void build(const VideoFormat * mFormat, unsigned int mStreamIndex, float mFps, float mFirstFramePts);
+		
+		/**
+		 *	@return	returns if there are no keyframes in the index
+		 */
+		bool empty() const;
+		
+		/**
+		 *	@return	returns the number of keyframes in the index
+		 */
+		size_t size() const;
+		
+		/**
+		 *	finds the last keyframe at or before a given frame
+		 *	@param	mFrameNumber the number of the frame
+		 *	@return	returns the keyframe, or NULL if there is none before mFrameNumber
+		 */
+		const KeyFrame * findKeyFrameBefore(int64_t mFrameNumber) const;
+		
+	private:
+		
+		/**
+		 *	orders keyframes by their frame number
+		 */
+		static bool compareFrameNumbers(const KeyFrame & mLeft, const KeyFrame & mRight);
+		
+		std::vector<KeyFrame> keyFrames_;	/**< the keyframes sorted by frame number. */
+	};
+}
+
+#endif //__key_frame_index_h
@@ -80,7 +80,9 @@ namespace mw
 	}
 	
 	bool VideoCodec::loadCodec(const VideoFormat * mFormat,
-							   unsigned int mStreamNumber/* = 0*/)
+							   unsigned int mStreamNumber/* = 0*/,
+							   int mThreadCount/* = 1*/,
+							   threadType mThreadType/* = frameThreading*/)
 	{
 		/**
 		 *	loads a codec for decoding videos
@@ -106,6 +108,13 @@ namespace mw
 			return false;
 		}	
 		
+		/**
+		 *	threading has to be configured before the codec is opened.
+		 *	ffmpeg falls back to fewer threads or another threading type if the codec doesn't support the one asked for
+		 */
+		codecContext_->thread_count = mThreadCount;
+		codecContext_->thread_type = (mThreadType == sliceThreading) ? FF_THREAD_SLICE : FF_THREAD_FRAME;
+		
 		/**
 		 *	based on the information of before, we open the codec
 		 */
@@ -252,5 +261,15 @@ namespace mw
 		
 		return result;
 	}
+	
+	bool VideoCodec::usesFrameThreading() const
+	{
+		return codecContext_->thread_count > 1 && (codecContext_->active_thread_type & FF_THREAD_FRAME);
+	}
+	
+	int VideoCodec::getThreadCount() const
+	{
+		return codecContext_->thread_count;
+	}
 }
 
@@ -45,14 +45,27 @@ namespace mw
 		 */
 		~VideoCodec();
 		
+		/**
+		 *	how ffmpeg splits decoding between several threads
+		 */
+		enum threadType
+		{
+			frameThreading = 0,	/**< consecutive frames are decoded in parallel, each frame is returned one packet later per thread */
+			sliceThreading = 1	/**< the slices of a single frame are decoded in parallel, only helps if the video has several slices per frame */
+		};
+		
 		/**
 		 *	loads the codec from the given Video Format
 		 *	@param	mFormat the given VideoFromat
 		 *	@param	mStreamNumber the given streamnumber
+		 *	@param	mThreadCount the number of threads used for decoding, 0 lets ffmpeg use one per core
+		 *	@param	mThreadType how decoding is split between the threads
 		 *	@return	returns if the codec is supported.
 		 */
 		bool loadCodec(const VideoFormat * mFormat,
-					   unsigned int mStreamNumber = 0);
+					   unsigned int mStreamNumber = 0,
+					   int mThreadCount = 1,
+					   threadType mThreadType = frameThreading);
 		
 		/**
 		 *	loads the codec from the given stream
@@ -95,6 +108,20 @@ namespace mw
 		 */
 		std::string getCodecInformation() const;
 		
+		/**
+		 *	checks if the opened codec decodes several frames in parallel.
+		 *	in that case a decoded frame does not belong to the packet that was decoded last,
+		 *	so its time stamp has to be taken from the frame itself
+		 *	@return	returns if frame threading is active
+		 */
+		bool usesFrameThreading() const;
+		
+		/**
+		 *	returns the number of threads the codec decodes with
+		 *	@return	returns the thread count of the codec context
+		 */
+		int getThreadCount() const;
+		
 	private:
 		
 		AVCodecContext	* codecContext_;			/**< codeccontext of the current file. */
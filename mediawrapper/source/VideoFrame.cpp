@@ -46,6 +46,9 @@ namespace mw
 	fullSizeFrame_(NULL),
 	fullSizeNumBytes_(0),
 	fullSizeImageBuffer_(NULL),
+	outputBuffer_(NULL),
+	outputLineSize_(0),
+	discardedFrames_(0),
 	height_(0),
 	width_(0),
 	pts_(0)
@@ -69,6 +72,9 @@ namespace mw
 	fullSizeFrame_(NULL),
 	fullSizeNumBytes_(0),
 	fullSizeImageBuffer_(NULL),
+	outputBuffer_(NULL),
+	outputLineSize_(0),
+	discardedFrames_(0),
 	height_(mHeight),
 	width_(mWidth),
 	pts_(0)
@@ -202,6 +208,17 @@ namespace mw
 		return imageBuffer_;
 	}
 	
+	int64_t VideoFrame::getDiscardedFrameCount() const
+	{
+		return discardedFrames_;
+	}
+	
+	void VideoFrame::setOutputBuffer(uint8_t * mBuffer, int mLineSize)
+	{
+		outputBuffer_ = mBuffer;
+		outputLineSize_ = mLineSize;
+	}
+	
 	void VideoFrame::convertRGBToPixelFormat(unsigned int mPixelFormat)
 	{
 		/**
@@ -409,6 +426,20 @@ namespace mw
 			toScaleData = fullSizeImageBuffer_;
 		}
 		
+		/**
+		 *	the converted frame goes to the caller's buffer if one has been set,
+		 *	otherwise to our own imageBuffer_
+		 */
+		uint8_t * outputData[4] = { outputBuffer_, NULL, NULL, NULL };
+		int outputLineSize[4] = { outputLineSize_, 0, 0, 0 };
+		uint8_t ** targetData = outputData;
+		int * targetLineSize = outputLineSize;
+		if(!outputBuffer_)
+		{
+			targetData = frameRGB_->data;
+			targetLineSize = frameRGB_->linesize;
+		}
+		
 		/**
 		 *	we do the color conversion here last, 
 		 *	since this is the order that seems to be fastest
@@ -419,14 +450,14 @@ namespace mw
 				  toScaleFrame->linesize,
 				  0,
 				  height_,
-				  frameRGB_->data,
-				  frameRGB_->linesize
+				  targetData,
+				  targetLineSize
 				  );
 		
 #if !defined(USE_FFMPEG_DEINTERLACE)
 		if(mTempFrame->interlaced_frame)
 		{
-			this->deinterlaceSkipField();
+			this->deinterlaceSkipField(targetData[0], targetLineSize[0]);
 		}
 #endif
 	}
@@ -503,7 +534,16 @@ namespace mw
 					/**
 					 *	calculation of the frame pts
 					 */
-					if(packet.dts == AV_NOPTS_VALUE &&
+					if(mCodec->usesFrameThreading() &&
+					   decodedFrame_->pkt_pts != (int64_t)AV_NOPTS_VALUE)
+					{
+						/**
+						 *	with frame threading the frame was started several packets ago,
+						 *	so neither the current packet nor global_video_pkt_pts belong to it
+						 */
+						pts_ = decodedFrame_->pkt_pts;
+					}
+					else if(packet.dts == AV_NOPTS_VALUE &&
 					   decodedFrame_->opaque &&
 					   *(uint64_t*)decodedFrame_->opaque != AV_NOPTS_VALUE)
 					{
@@ -674,11 +714,26 @@ namespace mw
 		std::cerr << std::endl << "loadFrame: targetNumber: " << mTargetFrameNumber << " start read for targetPtsSeconds : " << std::fixed << targetPtsSeconds << "; " ;
 #endif
 		/**
-		 *	we read the next frame into our temporary packet
+		 *	we read the next frame into our temporary packet.
+		 *	at the end of the stream the decoder can still hold delayed frames, one per thread
+		 *	with frame threading, so we keep feeding it empty packets until none is returned
 		 */
-		while(av_read_frame(mFormat->getAVFormatContext(),
-							& packet) >= 0)
+		bool flushing = false;
+		while(true)
 		{
+			if(!flushing &&
+			   av_read_frame(mFormat->getAVFormatContext(), & packet) < 0)
+			{
+				flushing = true;
+			}
+			if(flushing)
+			{
+				av_init_packet(& packet);
+				packet.data = NULL;
+				packet.size = 0;
+				packet.stream_index = mStreamIndex;
+			}
+			
 			/**
 			 *	check if the packet is from the stream we are interested in
 			 */
@@ -706,7 +761,16 @@ namespace mw
 					 *	custom decoding functions defined in the Codec class.
 					 *	the code comes from somewhere on the ffmpeg mailing list
 					 */
-					if(packet.dts == AV_NOPTS_VALUE &&
+					if(mCodec->usesFrameThreading() &&
+					   decodedFrame_->pkt_pts != (int64_t)AV_NOPTS_VALUE)
+					{
+						/**
+						 *	with frame threading the frame was started several packets ago,
+						 *	so neither the current packet nor global_video_pkt_pts belong to it
+						 */
+						pts_ = decodedFrame_->pkt_pts;
+					}
+					else if(packet.dts == AV_NOPTS_VALUE &&
 					   decodedFrame_->opaque &&
 					   *(uint64_t*)decodedFrame_->opaque != AV_NOPTS_VALUE)
 					{
@@ -827,6 +891,14 @@ namespace mw
 						}
 					}
 					
+					/**
+					 *	we decoded this frame only to get to the one we are looking for
+					 */
+					++discardedFrames_;
+				}
+				else if(flushing)
+				{
+					break;
 				}
 			}
 			/**
@@ -985,17 +1057,17 @@ namespace mw
 		}
 	}
 	
-	void VideoFrame::deinterlaceSkipField()
+	void VideoFrame::deinterlaceSkipField(uint8_t * mData, int mLineSize)
 	{
 		/**
 		 *	this routine can be activated in the convertframe method.
 		 *	it does deinterlacing by duplicating every nth line into the (n+1)th line
 		 *	ffmpeg does a faster and better job at it though (now)
 		 */
-		for (int i = 0; i < height_; i +=2) {
+		for (int i = 0; i + 1 < height_; i +=2) {
 			memcpy(
-				   (void *)(imageBuffer_ + (i * width_ * 3)),
-				   (void *)(imageBuffer_ + ((i + 1) * width_ * 3)),
+				   (void *)(mData + (i * mLineSize)),
+				   (void *)(mData + ((i + 1) * mLineSize)),
 				   width_ * 3
 				   );
 		}
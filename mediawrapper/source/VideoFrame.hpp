@@ -98,6 +98,22 @@ namespace mw
 		 */
 		uint8_t * getRawBufferPtr();
 		
+		/**
+		 *	returns the number of frames loadFrame has decoded without returning them,
+		 *	i.e. the frames between a keyframe and the frame that was seeked to
+		 *	@return	returns discardedFrames_
+		 */
+		int64_t getDiscardedFrameCount() const;
+		
+		/**
+		 *	makes loadFrame convert the frame straight into a buffer owned by the caller instead of imageBuffer_.
+		 *	only packed pixel formats (one plane, e.g. PIX_FMT_BGR24) can be written this way.
+		 *	while set, getRawBufferPtr does not point to the current frame.
+		 *	@param	mBuffer the buffer to convert into, or NULL to use imageBuffer_ again
+		 *	@param	mLineSize the number of bytes from the start of one row to the start of the next row in mBuffer
+		 */
+		void setOutputBuffer(uint8_t * mBuffer, int mLineSize);
+		
 		/**
 		 *	converts the current frame to a given pixelformat.
 		 *	the frameData_ array is not used any more and the 
@@ -204,8 +220,10 @@ namespace mw
 		/**
 		 *	deinterlaces the current frame by using the skip field technique.
 		 *	only to be called on the rgb frame!
+		 *	@param	mData the first row of the rgb frame
+		 *	@param	mLineSize the number of bytes from one row to the next
 		 */
-		void deinterlaceSkipField();
+		void deinterlaceSkipField(uint8_t * mData, int mLineSize);
 		
 		AVFrame		* frameRGB_;			/**< AVFrame pointer storing the single frame in RGB. The format conversion is already done after loading. */
 		int			  numBytes_;			/**< number of bytes that the imageBuffer_ actually has. */
@@ -223,6 +241,10 @@ namespace mw
 		int			  fullSizeNumBytes_;		/**< number of bytes that the fullSizeImageBuffer_ actually has. */
 		uint8_t		* fullSizeImageBuffer_;		/**< Buffer where the actual image data is stored. It is linked with the AVFrame struct. */
 		
+		uint8_t		* outputBuffer_;		/**< Buffer owned by the caller that converted frames are written to instead of imageBuffer_, or NULL. */
+		int			  outputLineSize_;		/**< number of bytes per row of outputBuffer_. */
+		int64_t		  discardedFrames_;		/**< number of frames decoded by loadFrame but not returned. */
+		
 		int			  height_;				/**< height of frame. */
 		int			  width_;				/**< width of frame. */
 		double		  pts_;					/**< presentation time of frame. */
@@ -0,0 +1,54 @@
+#!/usr/bin/perl -w
+
+# compares the stage timings two tracker builds wrote with --benchmarkJson, e.g. from "make bench" in tracker/build.gcc
+# usage: benchCompare.pl old.json new.json [tolerance]
+# prints the median time per call and the allocations per item of each stage and exits with 1 if the median of any stage grew by more than tolerance (default 0.1, i.e. 10%)
+
+use strict;
+
+use JSON::PP;
+
+my ($oldFile, $newFile, $tolerance) = @ARGV;
+die "usage: $0 old.json new.json [tolerance]\n" unless defined $newFile;
+$tolerance = 0.1 unless defined $tolerance;
+my $minSeconds = 0.000001;	# medians below this are too short to compare
+
+sub readStages {
+	my ($fileName) = @_;
+	local $/ = undef;
+	open(my $file, '<', $fileName) or die "$fileName: $!\n";
+	my $json = decode_json(<$file>);
+	close($file);
+	my %stages = map { $_->{name} => $_ } @{$json->{stages}};
+	return (\%stages, [map { $_->{name} } @{$json->{stages}}]);
+}
+
+my ($oldStages) = readStages($oldFile);
+my ($newStages, $newOrder) = readStages($newFile);
+
+my $slowerCount = 0;
+printf("%-50s %12s %12s %8s %10s %10s\n", 'stage', 'old p50 [s]', 'new p50 [s]', 'ratio', 'old alloc', 'new alloc');
+for my $name (@$newOrder) {
+	my $new = $newStages->{$name};
+	my $old = $oldStages->{$name};
+	if (!defined $old) {
+		printf("%-50s %12s %12.6g\n", $name, '-', $new->{p50Seconds});
+		next;
+	}
+	my $ratio = ($old->{p50Seconds} > $minSeconds) ? $new->{p50Seconds} / $old->{p50Seconds} : 1;
+	my $slower = ($new->{p50Seconds} > $minSeconds && $ratio > 1 + $tolerance);
+	++$slowerCount if $slower;
+	printf("%-50s %12.6g %12.6g %8.3f %10s %10s%s\n", $name, $old->{p50Seconds}, $new->{p50Seconds}, $ratio,
+		defined $old->{allocationsPerItem} ? sprintf('%.1f', $old->{allocationsPerItem}) : '-',
+		defined $new->{allocationsPerItem} ? sprintf('%.1f', $new->{allocationsPerItem}) : '-',
+		$slower ? '  SLOWER' : '');
+}
+for my $name (sort keys %$oldStages) {
+	print "$name: missing from $newFile\n" unless exists $newStages->{$name};
+}
+
+if ($slowerCount) {
+	print "$slowerCount stage(s) got slower by more than " . ($tolerance * 100) . "%\n";
+	exit 1;
+}
+exit 0;
@@ -90,12 +90,19 @@ for (;;++$revision) {
 
 	# test
 	print "Testing.\n";
+	my $testError = 0;
 	if ($^O eq 'MSWin32') {
+		$testError ||= system('trunk\gui\binaries\Win32\Release\MateBook.exe --testSongDetector');
 	} elsif ($^O eq 'darwin') {
+		$testError ||= system('trunk/gui/binaries/OSX/Release/MateBook.app/Contents/MacOS/MateBook --testSongDetector');
 	} elsif ($^O eq 'linux') {
 	} else {
 		print "I don't know how to test on $^O.\n";
 	}
+	if ($testError) {
+		print "Testing failed...skipping.\n";
+		next;
+	}
 	
 	# package
 	my $packageName = 'MateBook_' . $revision . '_' . $^O;
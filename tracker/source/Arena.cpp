@@ -5,9 +5,11 @@
 #include <streambuf>
 #include <numeric>
 #include <limits>
+#include <map>
 #include <cstdlib>
 #include <stdint.h>
 #include "global.hpp"
+#include "../../common/source/StageTimings.hpp"
 #include "../../common/source/serialization.hpp"
 #include "getBodyThreshold.hpp"
 #include "inpaint.hpp"
@@ -15,17 +17,23 @@
 #include "../../common/source/gaussian.hpp"
 #include "../../common/source/convolve.hpp"
 #include "hofacker.hpp"
+#include "hofackerPermutations.hpp"
 #include "drawFly.hpp"
 #include "euclideanDistance.hpp"
 #include "hungarian.hpp"
 #include "../../common/source/interpolate.hpp"
 #include "score2prob.hpp"
 #include "prob2logodd.hpp"
+#include "signTest.hpp"
 #include "SequenceMap.hpp"
+#include "../../common/source/mathematics.hpp"
 #include "../../common/source/geometry.hpp"
 #include "../../common/source/stringUtilities.hpp"
 #include "../../common/source/arrayOperations.hpp"
 #include "areaFromContour.hpp"
+#include "segmentation.hpp"
+#include "TrackFile.hpp"
+#include "checkpoint.hpp"
 #include "../../common/source/fileUtilities.hpp"
 
 // for removing small contours that would trip up fitEllipse
@@ -49,6 +57,7 @@ Arena::Arena(const std::string& id, double sourceFrameRate, size_t flyCount, con
 	boundingBox(boundingBox),
 	mask(mask),
 	background(background),
+	trackingDirectory(global::outDir + "/" + id),
 	contourFileOffset(0)
 {
 	if (boundingBox.size() != mask.size()) {
@@ -70,6 +79,11 @@ std::string Arena::getId() const
 	return id;
 }
 
+void Arena::setTrackingDirectory(const std::string& directory)
+{
+	trackingDirectory = directory;
+}
+
 cv::Rect Arena::getBoundingBox() const
 {
 	return boundingBox;
@@ -87,11 +101,8 @@ TrackedFrame& Arena::frame(size_t i)
 
 size_t Arena::getFrameCount() const
 {
-	if (frames.empty()) {	// after normalizeTrackingData has been called
-		return frameAttributes.get<uint32_t>("trackedFrame").getData().size();
-	}
-	// before normalizeTrackingData() has finished
-	return frames.size();
+	// frames already moved into the attributes, by normalizeTrackingData() or while streaming, and those that are still kept as TrackedFrame objects
+	return frameAttributes.get<uint32_t>("trackedFrame").getData().size() + frames.size();
 }
 
 size_t Arena::getFlyCount() const
@@ -113,46 +124,6 @@ struct SplittableWingContour {
 	bool split;	// whether the area is resulting from a split
 };
 
-// remove vertically moving wave as found in some of our older movies by subtracting from each row its median
-cv::Mat removeVerticalWave(const cv::Mat& image)
-{
-	cv::Mat ret = image.clone();
-	for (int row = 0; row != ret.rows; ++row) {
-		unsigned char* retRowPointer = ret.ptr<uchar>(row);
-		unsigned char* medianPointer = retRowPointer + ret.cols / 2;
-		std::nth_element(retRowPointer, medianPointer, retRowPointer + ret.cols);
-		unsigned char median = *medianPointer;
-		const unsigned char* imageRowPointer = image.ptr<uchar>(row);
-		for (int col = 0; col != ret.cols; ++col) {
-			if (imageRowPointer[col] >= median) {
-				retRowPointer[col] = imageRowPointer[col] - median;
-			} else {
-				// saturate
-				retRowPointer[col] = 0;
-			}
-		}
-	}
-	return ret;
-}
-
-// stretch the histogram of an image so that values between newMin and newMax are mapped to the full range of the data type
-cv::Mat stretch(const cv::Mat& image, const unsigned char newMin, const unsigned char newMax)
-{
-	cv::Mat ret = image.clone();
-	float factor = 255.0f / (newMax - newMin);
-	for (size_t i = 0; i != image.rows * image.cols; ++i) {
-		float newValue = (image.data[i] - newMin) * factor;
-		if (newValue < 0.0f) {
-			newValue = 0.0f;
-		}
-		if (newValue >= 255.0f) {
-			newValue = 255.0f;
-		}
-		ret.data[i] = static_cast<unsigned char>(newValue);
-	}
-	return ret;
-}
-
 // grow the bw-image given in seed to edges found in image (but only allow filling in mask) and return the grown bw-image
 cv::Mat gradientCorrect(const cv::Mat& image, const cv::Mat& seed, const cv::Mat& mask)
 {
@@ -221,10 +192,10 @@ cv::Mat gradientCorrect(const cv::Mat& image, const cv::Mat& seed, const cv::Mat
 	return ret;
 }
 
-void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, const size_t videoFrameTotalCount, const size_t trackFrameTotalCount, cv::Mat& visualizedContours, float thresholdOffset, float minFlyBodySizeSquareMillimeter, float maxFlyBodySizeSquareMillimeter, bool gradientCorrection, bool fullyMergeMissegmentations, bool splitBodies, bool splitWings, bool saveContours, bool saveHistograms)
+void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, const size_t videoFrameTotalCount, const size_t trackFrameTotalCount, cv::Mat& arenaContours, float thresholdOffset, float minFlyBodySizeSquareMillimeter, float maxFlyBodySizeSquareMillimeter, bool gradientCorrection, bool fullyMergeMissegmentations, bool splitBodies, bool splitWings, bool saveContours, bool saveHistograms, bool incrementalWaveRemoval, bool streamAttributes)
 {
-	if (frames.empty() && saveContours) {	// this is the first frame we have tracked, so we have to open the contourFile
-		std::string contourFileName(global::outDir + "/" + getId() + "/contour.bin");
+	if (getFrameCount() == 0 && saveContours) {	// this is the first frame we have tracked, so we have to open the contourFile
+		std::string contourFileName(trackingDirectory + "/contour.bin");
 		contourFile = boost::shared_ptr<std::ofstream>(new std::ofstream(contourFileName.c_str(), std::ios::out | std::ios::binary));
 		// we are adding an empty contour at the beginning of the file by writing a 0 (meaning "zero segments")
 		// flies and frames can point to it using an offset of 0 when the contour is missing
@@ -232,6 +203,8 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 		contourFile->write((char*)&noSegments, sizeof(noSegments)); contourFileOffset += sizeof(noSegments);
 	}
 
+	StageScope frameScope(global::stageTimings, "tracking/arena " + getId() + "/frame");	// runs on a worker thread, which doesn't see the scopes of the main thread
+	StageTimer timer(global::stageTimings);
 	bool saveDebugImages = false;
 	bool missegmented = false;
 
@@ -246,13 +219,14 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 	std::vector<cv::Point> carry1;
 	float bocScoreCalculated = 0.0f;	// calculated at the end of an occlusion
 
-	cv::Mat arenaContours(visualizedContours, getBoundingBox());
-
 	cv::Mat frame(entireFrame, getBoundingBox());
 
+	// bounding boxes of neighboring arenas can overlap, so each arena draws into its own image and the caller puts them together
+	frame.copyTo(arenaContours);
+
 	cv::Mat smoothForeground;
-	cvtColor(smoothBackground - frame, smoothForeground, CV_BGR2GRAY);
-	smoothForeground = smoothForeground & mask;
+	grayForeground(smoothBackground, frame, mask, smoothForeground);
+	timer.lap("foreground");
 
 //	for (int row = 0; row != arenaContours.rows; ++row) {
 //		for (int col = 0; col != arenaContours.cols; ++col) {
@@ -264,8 +238,8 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 
 	if (saveHistograms) {
 		// write the histograms from the current frame
-		if (frames.empty()) {	// this is the first frame we have tracked, so we have to open the histogramFile first
-			std::string fileName(global::outDir + "/" + getId() + "/smoothHistogram.bin256f");
+		if (getFrameCount() == 0) {	// this is the first frame we have tracked, so we have to open the histogramFile first
+			std::string fileName(trackingDirectory + "/smoothHistogram.bin256f");
 			smoothHistogramFile = boost::shared_ptr<std::ofstream>(new std::ofstream(fileName.c_str(), std::ios::out | std::ios::binary));
 		}
 	}
@@ -285,10 +259,12 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 	cv::Mat bwBodies;
 	threshold(smoothForeground, bwBodies, bodyThreshold, 255, cv::THRESH_BINARY);
 	morphologyEx(bwBodies, bwBodies, cv::MORPH_OPEN, cv::Mat(4, 4, CV_8UC1, 255));
+	timer.lap("threshold");
 
 	if (gradientCorrection) {
 		const unsigned char minDifferenceToFill = 40;
 		bwBodies = gradientCorrect(frame, bwBodies, mask & (smoothForeground >= minDifferenceToFill));
+		timer.lap("gradientCorrect");
 	}
 
 	// determine the number of body contour pixels
@@ -304,32 +280,23 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 	if (contourFile) {
 		bodyContourOffset = writeContour(allBodyContours);
 	}
+	timer.lap("findBodyContours");
 
 	// get wing areas
 	//TODO: why don't we use smoothForeground?
-	cv::Mat fgMedian;
-	cvtColor(background - frame, fgMedian, CV_BGR2GRAY);
-	fgMedian = removeVerticalWave(fgMedian);
-
-	cv::Mat fgSaturatedWings = fgMedian & mask & ~bwBodies;
+	cv::Mat fgSaturatedWings;
+	wingForeground(background, frame, mask, bwBodies, fgSaturatedWings, incrementalWaveRemoval ? &waveRowMedians : NULL);
 	size_t totalPixelCount = fgSaturatedWings.rows * fgSaturatedWings.cols;
 	size_t pixelsToSaturate = 3 * bodyContourPixelCount;	// doSegmentation.m in MATLAB tracker uses factor 3
 	if (pixelsToSaturate == 0 || pixelsToSaturate >= totalPixelCount) {
 		std::cerr << "warning: pixelsToSaturate (" << pixelsToSaturate << ") must be between 0 and totalPixelCount (" << totalPixelCount << ") ... skipping saturation step of wing segmentation!" << std::endl;
+		visualizeGray(fgSaturatedWings, arenaContours);
 	} else {
 		cv::Mat fgSaturatedWingsClone = fgSaturatedWings.clone();
 		assert(fgSaturatedWingsClone.isContinuous());
 		std::nth_element(fgSaturatedWingsClone.data, fgSaturatedWingsClone.data + (totalPixelCount - pixelsToSaturate), fgSaturatedWingsClone.data + totalPixelCount);
 		unsigned char saturateAbove = *(fgSaturatedWingsClone.data + (totalPixelCount - pixelsToSaturate));
-		fgSaturatedWings = stretch(fgSaturatedWings, 0, saturateAbove);
-	}
-
-	for (int row = 0; row != arenaContours.rows; ++row) {
-		for (int col = 0; col != arenaContours.cols; ++col) {
-			arenaContours.ptr<uchar>(row)[3*col] = fgSaturatedWings.ptr<uchar>(row)[col];
-			arenaContours.ptr<uchar>(row)[3*col+1] = fgSaturatedWings.ptr<uchar>(row)[col];
-			arenaContours.ptr<uchar>(row)[3*col+2] = fgSaturatedWings.ptr<uchar>(row)[col];
-		}
+		stretchAndVisualize(fgSaturatedWings, 0, saturateAbove, arenaContours);
 	}
 
 	cv::Mat bwWings;
@@ -350,9 +317,12 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 		imwrite(global::outDir + "/" + getId() + "/" + stringify(videoFrameNumber) + "_bwWings_after_legremoval.png", bwWings);
 	}
 
+	timer.lap("wings");
+
 	// remove wings that have no bodies by filling the wings using the bodies as seed
 	bwWings = reconstruct((bwBodies & bwWings) > 0, bwWings > 0, 8);
 	bwWings = bwWings * 255;
+	timer.lap("reconstruct");
 
 	if (saveDebugImages) {
 		imwrite(global::outDir + "/" + getId() + "/" + stringify(videoFrameNumber) + "_bwWings_after_reconstruct.png", bwWings);
@@ -377,6 +347,7 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 	if (contourFile) {
 		wingContourOffset = writeContour(wingContours);
 	}
+	timer.lap("findWingContours");
 
 	// if there are more wing regions than flyCount, remove the smallest ones
 	//TODO: use cv::contourArea instead of borderpixelcount?
@@ -921,6 +892,8 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 		}
 	}
 
+	timer.lap("assignBodies");
+
 	for (size_t bodyIndex = 0; bodyIndex != mergeableBodyContours.size(); ++bodyIndex) {
 		try {
 			std::vector<std::vector<cv::Point> > finalBodyContour(1, mergeableBodyContours[bodyIndex].contour);
@@ -960,6 +933,7 @@ void Arena::track(const cv::Mat& entireFrame, const size_t videoFrameNumber, con
 			std::cerr << "warning: " << e.what() << std::endl;
 		}
 	}
+	timer.lap("flies");
 
 	if (saveDebugImages) {
 		imwrite(global::outDir + "/" + getId() + "/" + stringify(videoFrameNumber) + "_bwBodies.png", bwBodies);
@@ -985,9 +959,9 @@ DONE_TRACKING_THIS_FRAME:
 		frame.size(),
 		sourceFrameRate,
 		videoFrameNumber,
-		frames.size(),
+		getFrameCount(),
 		1.0f * videoFrameNumber / videoFrameTotalCount,
-		1.0f * frames.size() / trackFrameTotalCount,
+		1.0f * getFrameCount() / trackFrameTotalCount,
 		fliesInThisFrame,
 		getFlyCount(),
 		missegmented,
@@ -1017,6 +991,202 @@ DONE_TRACKING_THIS_FRAME:
 	}
 
 	frames.push_back(thisFrame);
+
+	// Except for the last frame, which the next one is compared to, a frame can only be changed by spreading back the bocScore of an occlusion.
+	// This stops at the last frame that is neither occluded nor missegmented, so once the second to last frame is such a frame, all frames but the last one are final.
+	if (streamAttributes && frames.size() > 1) {
+		const TrackedFrame& secondToLast = frames[frames.size() - 2];
+		if (!secondToLast.get_isOcclusionTouched() && !secondToLast.get_isMissegmented()) {
+			for (size_t frameNumber = 0; frameNumber != frames.size() - 1; ++frameNumber) {
+				appendToAttributes(frames[frameNumber]);
+			}
+			frames.erase(frames.begin(), frames.end() - 1);
+		}
+	}
+	timer.lap("storeFrame");
+}
+
+void Arena::appendToAttributes(const TrackedFrame& trackedFrame)
+{
+	if (flyAttributes.size() != getFlyCount()) {
+		flyAttributes.resize(getFlyCount());
+	}
+	frameAttributes.appendFrame(trackedFrame);
+	for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
+		if (flyNumber < trackedFrame.flyCount()) {
+			flyAttributes[flyNumber].appendFly(trackedFrame.fly(flyNumber));
+		} else {
+			flyAttributes[flyNumber].appendEmpty();
+		}
+	}
+}
+
+std::string getCheckpointFileName(const std::string& trackingDirectory, bool previous)
+{
+	return trackingDirectory + (previous ? "/checkpoint.previous.bin" : "/checkpoint.bin");
+}
+
+void Arena::writeCheckpoint(size_t nextVideoFrame, const std::string& fingerprint) const
+{
+	// everything tracked so far has to be in the files before their sizes are recorded
+	if (contourFile) {
+		contourFile->flush();
+	}
+	uint64_t histogramFileSize = 0;
+	if (smoothHistogramFile) {
+		smoothHistogramFile->flush();
+		histogramFileSize = static_cast<uint64_t>(smoothHistogramFile->tellp());
+	}
+
+	const std::string fileName = getCheckpointFileName(trackingDirectory, false);
+	const std::string tempFileName = fileName + ".tmp";
+	{
+		std::ofstream out(tempFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write(checkpointMagic, sizeof(checkpointMagic));
+		writeCheckpointValue(out, checkpointVersion);
+		writeCheckpointString(out, fingerprint);
+		writeCheckpointValue<uint64_t>(out, nextVideoFrame);
+		writeCheckpointValue<uint8_t>(out, contourFile ? 1 : 0);
+		writeCheckpointValue<uint64_t>(out, contourFileOffset);
+		writeCheckpointValue<uint8_t>(out, smoothHistogramFile ? 1 : 0);
+		writeCheckpointValue<uint64_t>(out, histogramFileSize);
+
+		// the attributes of the frames that have been streamed; the others are still empty
+		std::vector<std::pair<const AttributeCollection*, int32_t> > collections;
+		collections.push_back(std::make_pair(&frameAttributes, -1));
+		for (size_t flyNumber = 0; flyNumber != flyAttributes.size(); ++flyNumber) {
+			collections.push_back(std::make_pair(&flyAttributes[flyNumber], static_cast<int32_t>(flyNumber)));
+		}
+		std::vector<std::pair<size_t, std::string> > columns;	// collection and name
+		for (size_t collectionNumber = 0; collectionNumber != collections.size(); ++collectionNumber) {
+			std::vector<std::string> names = collections[collectionNumber].first->getNames();
+			for (std::vector<std::string>::const_iterator iter = names.begin(); iter != names.end(); ++iter) {
+				if (!collections[collectionNumber].first->get(*iter).empty()) {
+					columns.push_back(std::make_pair(collectionNumber, *iter));
+				}
+			}
+		}
+		writeCheckpointValue<uint32_t>(out, columns.size());
+		for (size_t columnNumber = 0; columnNumber != columns.size(); ++columnNumber) {
+			const AbstractAttribute& attribute = collections[columns[columnNumber].first].first->get(columns[columnNumber].second);
+			writeCheckpointString(out, columns[columnNumber].second);
+			writeCheckpointString(out, attribute.getType());
+			writeCheckpointValue(out, collections[columns[columnNumber].first].second);
+			writeCheckpointValue<uint64_t>(out, attribute.size());
+			const std::streampos byteCountPosition = out.tellp();
+			writeCheckpointValue<uint64_t>(out, 0);	// patched below
+			const std::streampos columnBegin = out.tellp();
+			attribute.writeBinaries(out);
+			const std::streampos columnEnd = out.tellp();
+			out.seekp(byteCountPosition);
+			writeCheckpointValue<uint64_t>(out, static_cast<uint64_t>(columnEnd - columnBegin));
+			out.seekp(columnEnd);
+		}
+
+		writeCheckpointValue<uint32_t>(out, frames.size());
+		for (size_t frameNumber = 0; frameNumber != frames.size(); ++frameNumber) {
+			frames[frameNumber].writeCheckpoint(out);
+		}
+		out.write(checkpointEndMagic, sizeof(checkpointEndMagic));
+		if (!out) {
+			throw std::runtime_error("could not write \"" + tempFileName + "\"");
+		}
+	}
+
+	// there's always at least one complete checkpoint, even if we're killed in between
+	if (isFile(fileName)) {
+		renameFile(fileName, getCheckpointFileName(trackingDirectory, true));
+	}
+	renameFile(tempFileName, fileName);
+}
+
+std::vector<size_t> Arena::getCheckpointFrames(const std::string& fingerprint) const
+{
+	std::vector<size_t> ret;
+	for (int previous = 0; previous != 2; ++previous) {
+		const size_t nextVideoFrame = getCheckpointFrame(getCheckpointFileName(trackingDirectory, previous != 0), fingerprint);
+		if (nextVideoFrame) {
+			ret.push_back(nextVideoFrame);
+		}
+	}
+	return ret;
+}
+
+void Arena::resumeFromCheckpoint(size_t nextVideoFrame, const std::string& fingerprint)
+{
+	if (getFrameCount() != 0) {
+		throw std::logic_error("arena " + getId() + " can only resume from a checkpoint before it has tracked any frames");
+	}
+	std::string fileName = getCheckpointFileName(trackingDirectory, false);
+	if (getCheckpointFrame(fileName, fingerprint) != nextVideoFrame) {
+		fileName = getCheckpointFileName(trackingDirectory, true);
+		if (getCheckpointFrame(fileName, fingerprint) != nextVideoFrame) {
+			throw std::runtime_error("arena " + getId() + " has no checkpoint at frame " + stringify(nextVideoFrame));
+		}
+	}
+
+	std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+	in.seekg(sizeof(checkpointMagic));
+	readCheckpointValue<uint32_t>(in);	// version
+	readCheckpointString(in);	// fingerprint
+	readCheckpointValue<uint64_t>(in);	// nextVideoFrame
+	const bool hasContourFile = readCheckpointValue<uint8_t>(in) != 0;
+	const uint64_t contourFileSize = readCheckpointValue<uint64_t>(in);
+	const bool hasHistogramFile = readCheckpointValue<uint8_t>(in) != 0;
+	const uint64_t histogramFileSize = readCheckpointValue<uint64_t>(in);
+
+	flyAttributes.resize(getFlyCount());
+	const uint32_t columnCount = readCheckpointValue<uint32_t>(in);
+	std::vector<char> data;
+	for (uint32_t columnNumber = 0; columnNumber != columnCount; ++columnNumber) {
+		const std::string name = readCheckpointString(in);
+		const std::string type = readCheckpointString(in);
+		const int32_t fly = readCheckpointValue<int32_t>(in);
+		const uint64_t count = readCheckpointValue<uint64_t>(in);
+		const uint64_t byteCount = readCheckpointValue<uint64_t>(in);
+		data.resize(byteCount);
+		if (byteCount && !in.read(&data[0], byteCount)) {
+			throw std::runtime_error("checkpoint \"" + fileName + "\" is truncated");
+		}
+		if (fly < -1 || fly >= static_cast<int32_t>(getFlyCount())) {
+			throw std::runtime_error("checkpoint \"" + fileName + "\" has attributes of fly " + stringify(fly));
+		}
+		AttributeCollection& attributes = (fly == -1) ? static_cast<AttributeCollection&>(frameAttributes) : flyAttributes[fly];
+		if (!attributes.has(name) || attributes.get(name).getType() != type) {
+			throw std::runtime_error("checkpoint \"" + fileName + "\" has an unknown attribute \"" + name + "\" of type " + type);
+		}
+		AbstractAttribute& attribute = attributes.getEmpty(name);
+		attribute.assignBinaries(data.empty() ? NULL : &data[0], byteCount);
+		if (attribute.size() != count) {
+			throw std::runtime_error("checkpoint \"" + fileName + "\" has an invalid attribute \"" + name + "\"");
+		}
+	}
+
+	const uint32_t frameCount = readCheckpointValue<uint32_t>(in);
+	for (uint32_t frameNumber = 0; frameNumber != frameCount; ++frameNumber) {
+		frames.push_back(TrackedFrame(in));
+	}
+
+	// continue writing the contours and histograms where the checkpoint left off
+	if (hasContourFile) {
+		std::string contourFileName(trackingDirectory + "/contour.bin");
+		resizeFile(contourFileName, contourFileSize);
+		contourFile = boost::shared_ptr<std::ofstream>(new std::ofstream(contourFileName.c_str(), std::ios::out | std::ios::binary | std::ios::app));
+		contourFileOffset = contourFileSize;
+	}
+	if (hasHistogramFile) {
+		std::string histogramFileName(trackingDirectory + "/smoothHistogram.bin256f");
+		resizeFile(histogramFileName, histogramFileSize);
+		smoothHistogramFile = boost::shared_ptr<std::ofstream>(new std::ofstream(histogramFileName.c_str(), std::ios::out | std::ios::binary | std::ios::app));
+	}
+}
+
+void Arena::removeCheckpoints() const
+{
+	const std::string fileName = getCheckpointFileName(trackingDirectory, false);
+	removeFile(fileName);
+	removeFile(fileName + ".tmp");
+	removeFile(getCheckpointFileName(trackingDirectory, true));
 }
 
 void Arena::normalizeTrackingData()
@@ -1046,32 +1216,217 @@ void Arena::normalizeTrackingData()
 		}
 	}
 
-	// copy tracking frame attributes
-	for (size_t frameNumber = 0; frameNumber != getFrameCount(); ++frameNumber) {
-		frameAttributes.appendFrame(frames[frameNumber]);
+	// copy the tracking attributes of the frames that haven't been streamed
+	for (size_t frameNumber = 0; frameNumber != frames.size(); ++frameNumber) {
+		appendToAttributes(frames[frameNumber]);
 	}
+	
+	// free some memory
+	std::vector<TrackedFrame> emptyFrames;
+	frames.swap(emptyFrames);
+}
 
-	const Attribute<MyBool>& isOcclusionTouched = frameAttributes.getFilled<MyBool>("isOcclusionTouched");
+void Arena::exportShard(const std::string& filePath) const
+{
+	// unlike exportTrackFile, this keeps the attributes without a short name, which postprocessing needs
+	TrackFileWriter trackFile(filePath);
+	std::vector<std::string> names = frameAttributes.getNames();
+	for (std::vector<std::string>::const_iterator iter = names.begin(); iter != names.end(); ++iter) {
+		if (!frameAttributes.get(*iter).empty()) {
+			trackFile.add(*iter, frameAttributes.get(*iter));
+		}
+	}
+	for (size_t flyNumber = 0; flyNumber != flyAttributes.size(); ++flyNumber) {
+		names = flyAttributes[flyNumber].getNames();
+		for (std::vector<std::string>::const_iterator iter = names.begin(); iter != names.end(); ++iter) {
+			if (!flyAttributes[flyNumber].get(*iter).empty()) {
+				trackFile.add(*iter, flyAttributes[flyNumber].get(*iter), flyNumber);
+			}
+		}
+	}
+	trackFile.close();
+}
 
-	for (size_t frameNumber = 0; frameNumber != getFrameCount(); ++frameNumber) {
-		if (isOcclusionTouched[frameNumber]) {
-			for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
-				if (flyNumber < frames[frameNumber].flyCount()) {
-					flyAttributes[flyNumber].appendFly(frames[frameNumber].fly(flyNumber));
-				} else {
-					flyAttributes[flyNumber].appendEmpty();
+// appends the file to out, leaving out its first skipBytes bytes, and returns the number of bytes appended
+uint64_t appendFile(std::ostream& out, const std::string& fileName, uint64_t skipBytes)
+{
+	std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (!in || !in.seekg(skipBytes)) {
+		throw std::runtime_error("could not read \"" + fileName + "\"");
+	}
+	std::vector<char> buffer(1 << 20);
+	uint64_t byteCount = 0;
+	while (in) {
+		in.read(&buffer[0], buffer.size());
+		out.write(&buffer[0], in.gcount());
+		byteCount += in.gcount();
+	}
+	if (!out) {
+		throw std::runtime_error("could not append \"" + fileName + "\"");
+	}
+	return byteCount;
+}
+
+// adds offset to the contour offsets in [begin, end), except to 0, which points to the empty contour at the beginning of every contour file
+void rebaseContourOffsets(std::vector<uint32_t>& offsets, size_t begin, size_t end, uint64_t offset)
+{
+	for (size_t frameNumber = begin; frameNumber != end; ++frameNumber) {
+		if (offsets[frameNumber] != 0) {
+			const uint64_t rebased = offsets[frameNumber] + offset;
+			if (rebased > std::numeric_limits<uint32_t>::max()) {
+				throw std::runtime_error("the merged contour file is too large for the 32 bit contour offsets");
+			}
+			offsets[frameNumber] = static_cast<uint32_t>(rebased);
+		}
+	}
+}
+
+void Arena::mergeShards(const std::vector<std::string>& shardDirectories)
+{
+	resizeAttributes();
+	if (shardDirectories.empty()) {
+		return;
+	}
+
+	// the contours and histograms are only merged if every shard has them
+	bool mergeContours = true;
+	bool mergeHistograms = true;
+	for (size_t shardNumber = 0; shardNumber != shardDirectories.size(); ++shardNumber) {
+		mergeContours = mergeContours && isFile(shardDirectories[shardNumber] + "/contour.bin");
+		mergeHistograms = mergeHistograms && isFile(shardDirectories[shardNumber] + "/smoothHistogram.bin256f");
+	}
+	std::ofstream contourFile;
+	if (mergeContours) {
+		contourFile.open((trackingDirectory + "/contour.bin").c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	}
+	std::ofstream histogramFile;
+	if (mergeHistograms) {
+		histogramFile.open((trackingDirectory + "/smoothHistogram.bin256f").c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	}
+
+	// concatenate the columns of all shards
+	typedef std::map<std::pair<int, std::string>, std::pair<std::string, std::vector<char> > > ColumnMap;	// (fly or -1, name) -> (type, data)
+	ColumnMap columnData;
+	std::vector<size_t> shardBegins;	// the first frame of each shard in the merged attributes
+	std::vector<uint64_t> contourOffsets;	// what to add to the contour offsets of each shard
+	size_t frameCount = 0;
+	uint64_t contourFileSize = 0;
+	for (size_t shardNumber = 0; shardNumber != shardDirectories.size(); ++shardNumber) {
+		const std::string& shardDirectory = shardDirectories[shardNumber];
+		TrackFile shard(shardDirectory + "/track.bin");
+		const std::vector<TrackFile::Column>& columns = shard.getColumns();
+		size_t shardFrameCount = 0;
+		for (size_t columnNumber = 0; columnNumber != columns.size(); ++columnNumber) {
+			if (columns[columnNumber].activeFly == -1 && columns[columnNumber].name == "trackedFrame") {
+				shardFrameCount = columns[columnNumber].count;
+			}
+		}
+		if (shardNumber != 0 && columns.size() != columnData.size()) {
+			throw std::runtime_error("\"" + shardDirectory + "\" doesn't have the same attributes as the shards before it");
+		}
+		for (size_t columnNumber = 0; columnNumber != columns.size(); ++columnNumber) {
+			const TrackFile::Column& column = columns[columnNumber];
+			if (column.activeFly < -1 || column.activeFly >= static_cast<int>(getFlyCount()) || column.passiveFly != -1 || column.count != shardFrameCount) {
+				throw std::runtime_error("\"" + shardDirectory + "\" has an invalid column \"" + column.name + "\"");
+			}
+			const std::pair<int, std::string> key(column.activeFly, column.name);
+			ColumnMap::iterator iter = columnData.find(key);
+			if (iter == columnData.end()) {
+				if (shardNumber != 0) {
+					throw std::runtime_error("\"" + shardDirectory + "\" doesn't have the same attributes as the shards before it");
 				}
+				iter = columnData.insert(std::make_pair(key, std::make_pair(column.type, std::vector<char>()))).first;
 			}
-		} else { // not occluded because of touching flies
+			if (iter->second.first != column.type) {
+				throw std::runtime_error("\"" + column.name + "\" in \"" + shardDirectory + "\" is of type " + column.type + " instead of " + iter->second.first);
+			}
+			iter->second.second.insert(iter->second.second.end(), column.data, column.data + column.byteCount);
+		}
+		shardBegins.push_back(frameCount);
+		frameCount += shardFrameCount;
+
+		if (mergeContours) {
+			// every contour file starts with the empty contour, which the merged file only needs once
+			const uint64_t skippedBytes = (shardNumber == 0) ? 0 : sizeof(size_t);
+			contourOffsets.push_back(contourFileSize - skippedBytes);
+			contourFileSize += appendFile(contourFile, shardDirectory + "/contour.bin", skippedBytes);
+		}
+		if (mergeHistograms) {
+			appendFile(histogramFile, shardDirectory + "/smoothHistogram.bin256f", 0);
+		}
+	}
+
+	for (ColumnMap::iterator iter = columnData.begin(); iter != columnData.end(); ++iter) {
+		AttributeCollection& attributes = (iter->first.first == -1) ? static_cast<AttributeCollection&>(frameAttributes) : flyAttributes[iter->first.first];
+		if (!attributes.has(iter->first.second) || attributes.get(iter->first.second).getType() != iter->second.first) {
+			throw std::runtime_error("the shards have an unknown attribute \"" + iter->first.second + "\" of type " + iter->second.first);
+		}
+		const std::vector<char>& data = iter->second.second;
+		attributes.getEmpty(iter->first.second).assignBinaries(data.empty() ? NULL : &data[0], data.size());
+	}
+
+	const std::vector<uint32_t>& videoFrame = frameAttributes.get<uint32_t>("videoFrame").getData();
+	for (size_t shardNumber = 1; shardNumber != shardBegins.size(); ++shardNumber) {
+		const size_t seam = shardBegins[shardNumber];
+		if (seam == 0 || seam == frameCount) {
+			continue;
+		}
+		if (videoFrame[seam] <= videoFrame[seam - 1]) {
+			throw std::runtime_error("\"" + shardDirectories[shardNumber] + "\" overlaps the shard before it");
+		}
+		if (videoFrame[seam] != videoFrame[seam - 1] + 1) {
+			std::cerr << "warning: frames " << videoFrame[seam - 1] + 1 << " to " << videoFrame[seam] - 1 << " are missing from the shards of arena " << id << std::endl;
+		}
+	}
+
+	// each shard counted its tracked frames from 0; count them as if the shards had been tracked in one go
+	std::vector<uint32_t>& trackedFrame = frameAttributes.get<uint32_t>("trackedFrame").getData();
+	std::vector<float>& trackedTime = frameAttributes.get<float>("trackedTime").getData();
+	std::vector<float>& trackedFrameRelative = frameAttributes.get<float>("trackedFrameRelative").getData();
+	for (size_t frameNumber = 0; frameNumber != frameCount; ++frameNumber) {
+		trackedFrame[frameNumber] = frameNumber;
+		trackedTime[frameNumber] = trackedFrame[frameNumber] / static_cast<float>(sourceFrameRate);
+		trackedFrameRelative[frameNumber] = 1.0f * frameNumber / frameCount;
+	}
+
+	if (mergeContours) {
+		for (size_t shardNumber = 0; shardNumber != shardBegins.size(); ++shardNumber) {
+			const size_t begin = shardBegins[shardNumber];
+			const size_t end = (shardNumber + 1 == shardBegins.size()) ? frameCount : shardBegins[shardNumber + 1];
+			rebaseContourOffsets(frameAttributes.get<uint32_t>("bodyContourOffset").getData(), begin, end, contourOffsets[shardNumber]);
+			rebaseContourOffsets(frameAttributes.get<uint32_t>("wingContourOffset").getData(), begin, end, contourOffsets[shardNumber]);
 			for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
-				flyAttributes[flyNumber].appendFly(frames[frameNumber].fly(flyNumber));
+				rebaseContourOffsets(flyAttributes[flyNumber].get<uint32_t>("bodyContourOffset").getData(), begin, end, contourOffsets[shardNumber]);
+				rebaseContourOffsets(flyAttributes[flyNumber].get<uint32_t>("wingContourOffset").getData(), begin, end, contourOffsets[shardNumber]);
+				rebaseContourOffsets(flyAttributes[flyNumber].get<uint32_t>("bocContourOffset").getData(), begin, end, contourOffsets[shardNumber]);
 			}
 		}
 	}
-	
-	// free some memory
-	std::vector<TrackedFrame> emptyFrames;
-	frames.swap(emptyFrames);
+
+	// within a shard, track() has lined up the flies of consecutive frames unless one of them is occluded; do the same where two shards meet
+	// boc scores of occlusions that span a seam are lost, though, since each shard only sees its part of the occlusion
+	const std::vector<MyBool>& isOcclusionTouched = frameAttributes.get<MyBool>("isOcclusionTouched").getData();
+	std::vector<std::vector<size_t> > sources;	// for each shard, which of its flies becomes fly i of the merged attributes
+	for (size_t shardNumber = 0; shardNumber != shardBegins.size(); ++shardNumber) {
+		std::vector<size_t> identity(getFlyCount());
+		for (size_t flyNumber = 0; flyNumber != identity.size(); ++flyNumber) {
+			identity[flyNumber] = flyNumber;
+		}
+		sources.push_back(identity);
+		const size_t seam = shardBegins[shardNumber];
+		if (seam == 0 || seam == frameCount || isOcclusionTouched[seam - 1] || isOcclusionTouched[seam]) {
+			continue;
+		}
+		cv::Mat distanceMatrix(getFlyCount(), getFlyCount(), CV_32F);
+		for (size_t flyBefore = 0; flyBefore != getFlyCount(); ++flyBefore) {
+			const Vf2 before = flyAttributes[sources[shardNumber - 1][flyBefore]].get<Vf2>("bodyCentroidTracked").getData()[seam - 1];
+			for (size_t flyNow = 0; flyNow != getFlyCount(); ++flyNow) {
+				distanceMatrix.at<float>(flyBefore, flyNow) = (before - flyAttributes[flyNow].get<Vf2>("bodyCentroidTracked").getData()[seam]).norm();
+			}
+		}
+		sources.back() = hungarian(distanceMatrix);
+	}
+	FlyAttributes::permute(flyAttributes, shardBegins, sources);
 }
 
 void Arena::prepareInterpolation()
@@ -1344,6 +1699,30 @@ void Arena::writeSegmentationStatistics(std::ostream& out) const
 	out << '\n';
 }
 
+// adds weight * costs / mean(costs) to combinedCosts, so that each criterion contributes independently of its unit
+void addNormalizedCosts(cv::Mat& combinedCosts, const cv::Mat& costs, float weight)
+{
+	double sum = 0;
+	size_t count = 0;
+	for (int row = 0; row != costs.rows; ++row) {
+		for (int col = 0; col != costs.cols; ++col) {
+			if (costs.at<float>(row, col) == costs.at<float>(row, col)) {
+				sum += costs.at<float>(row, col);
+				++count;
+			}
+		}
+	}
+	if (weight == 0 || count == 0 || sum <= 0) {
+		return;
+	}
+	const float factor = weight * count / sum;
+	for (int row = 0; row != costs.rows; ++row) {
+		for (int col = 0; col != costs.cols; ++col) {
+			combinedCosts.at<float>(row, col) += factor * costs.at<float>(row, col);
+		}
+	}
+}
+
 void Arena::calculateTScores(float tPosLogisticRegressionCoefficient, float tBocLogisticRegressionCoefficient)
 {
 	const Attribute<MyBool>& interpolated = frameAttributes.getFilled<MyBool>("interpolated");
@@ -1429,6 +1808,80 @@ void Arena::calculateTScores(float tPosLogisticRegressionCoefficient, float tBoc
 			// video doesn't end in an occlusion, so we add a 0 to satisfy the hofacker precondition
 			occlusionMap.append(getFrameCount(), getFrameCount());
 			occlusionMap.appendScores(0, 0, 0, tPosLogisticRegressionCoefficient, tBocLogisticRegressionCoefficient);
+		} else {
+			// with more flies, each occlusion gets the assignment of the flies before it to those after it with the lowest position and movement costs,
+			// and the same tPos as for 2 flies for each pair of flies, weighing where they go in that assignment against swapping them;
+			// the t attributes of the occlusion are those of the pair that is most likely swapped
+			const size_t flyCount = getFlyCount();
+			std::vector<const Attribute<Vf2>*> centroids;
+			for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+				centroids.push_back(&flyAttributes[flyNumber].getFilled<Vf2>("bodyCentroidTracked"));
+			}
+			HungarianWorkspace workspace;
+			std::vector<size_t> assignment;
+			std::vector<float> tPosSwap(flyCount * flyCount, 0);
+			cv::Mat positionCosts(flyCount, flyCount, CV_32F);
+			cv::Mat movementCosts(flyCount, flyCount, CV_32F);
+			cv::Mat combinedCosts(flyCount, flyCount, CV_32F);
+
+			// there's nothing to match for the occlusions that have been scored already
+			occlusionMap.assignment.resize(occlusionNumber);
+			occlusionMap.tPosSwap.resize(occlusionNumber);
+			while (occlusionNumber != occlusionMap.size()) {
+				if (occlusionMap.end[occlusionNumber] == getFrameCount()) {
+					// video ends in this occlusion, so we don't know about t
+					occlusionMap.appendScores(0, 0, 0, tPosLogisticRegressionCoefficient, tBocLogisticRegressionCoefficient);
+					occlusionMap.assignment.push_back(std::vector<size_t>());
+					occlusionMap.tPosSwap.push_back(std::vector<float>());
+					goto DONE_CALCULATING_SCORES;
+				}
+
+				size_t beforeOcclusion = occlusionMap.begin[occlusionNumber] - 1;
+				size_t afterOcclusion = occlusionMap.end[occlusionNumber];
+				const bool knowsMovement = beforeOcclusion >= 2 && !interpolated[beforeOcclusion - 2] && !interpolated[beforeOcclusion - 1] && !interpolated[beforeOcclusion] &&
+					afterOcclusion + 2 < interpolated.size() && !interpolated[afterOcclusion] && !interpolated[afterOcclusion + 1] && !interpolated[afterOcclusion + 2];
+				for (size_t flyBefore = 0; flyBefore != flyCount; ++flyBefore) {
+					const Attribute<Vf2>& centroidBefore = *centroids[flyBefore];
+					for (size_t flyAfter = 0; flyAfter != flyCount; ++flyAfter) {
+						const Attribute<Vf2>& centroidAfter = *centroids[flyAfter];
+						positionCosts.at<float>(flyBefore, flyAfter) = (centroidBefore[beforeOcclusion] - centroidAfter[afterOcclusion]).norm();
+						movementCosts.at<float>(flyBefore, flyAfter) = knowsMovement ?
+							((centroidBefore[beforeOcclusion] - centroidBefore[beforeOcclusion - 2]) - (centroidAfter[afterOcclusion + 2] - centroidAfter[afterOcclusion])).norm() :
+							0;
+						combinedCosts.at<float>(flyBefore, flyAfter) = 0;
+					}
+				}
+				addNormalizedCosts(combinedCosts, positionCosts, 1);
+				addNormalizedCosts(combinedCosts, movementCosts, 1);
+				hungarian(combinedCosts, workspace, assignment);
+
+				float swappedPosScore = 1;
+				float swappedMovScore = 0;
+				for (size_t first = 0; first != flyCount; ++first) {
+					for (size_t second = first + 1; second != flyCount; ++second) {
+						float straightDistance = positionCosts.at<float>(first, assignment[first]) + positionCosts.at<float>(second, assignment[second]);
+						float swappedDistance = positionCosts.at<float>(first, assignment[second]) + positionCosts.at<float>(second, assignment[first]);
+						const float thisPosScore = (straightDistance + swappedDistance > 0) ? (swappedDistance - straightDistance) / (straightDistance + swappedDistance) : 0;
+						tPosSwap[first * flyCount + second] = tPosSwap[second * flyCount + first] = prob2logodd(logistic(thisPosScore * tPosLogisticRegressionCoefficient));
+						if (thisPosScore < swappedPosScore) {
+							straightDistance = movementCosts.at<float>(first, assignment[first]) + movementCosts.at<float>(second, assignment[second]);
+							swappedDistance = movementCosts.at<float>(first, assignment[second]) + movementCosts.at<float>(second, assignment[first]);
+							swappedPosScore = thisPosScore;
+							swappedMovScore = (straightDistance + swappedDistance > 0) ? (swappedDistance - straightDistance) / (straightDistance + swappedDistance) : 0;
+						}
+					}
+				}
+
+				occlusionMap.appendScores(swappedPosScore, swappedMovScore, 0, tPosLogisticRegressionCoefficient, tBocLogisticRegressionCoefficient);
+				occlusionMap.assignment.push_back(assignment);
+				occlusionMap.tPosSwap.push_back(tPosSwap);
+				++occlusionNumber;
+			}
+			// keep the same layout as for 2 flies, including the trailing 0-occlusion
+			occlusionMap.append(getFrameCount(), getFrameCount());
+			occlusionMap.appendScores(0, 0, 0, tPosLogisticRegressionCoefficient, tBocLogisticRegressionCoefficient);
+			occlusionMap.assignment.push_back(std::vector<size_t>());
+			occlusionMap.tPosSwap.push_back(std::vector<float>());
 		}
 	}
 
@@ -1465,20 +1918,23 @@ void Arena::solveOcclusions(float sSizeWeight, bool discardMissegmentations)
 	Attribute<float>& sSizeProb = frameAttributes.getEmpty<float>("sSizeProb");
 	Attribute<float>& sSize = frameAttributes.getEmpty<float>("sSize");
 	Attribute<float>& sCombined = frameAttributes.getEmpty<float>("sCombined");
+	std::vector<Attribute<uint32_t>*> idSources;
+	for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
+		idSources.push_back(&flyAttributes[flyNumber].getEmpty<uint32_t>("idSource"));
+	}
 
 	// this will be overridden in addAnnotation() if there is an annotation
 	occlusionInspected.resize(getFrameCount());
 
-	if (getFlyCount() != 1 && getFlyCount() != 2) {
-		throw std::logic_error("cannot solve occlusions if flyCount is not 1 or 2");
-	}
-
 	if (occlusionMap.size() == 0 || getFlyCount() == 1) {
 		//TODO: move these initializations out of the if ... this is a source of bugs
 		idPermutation = std::vector<uint32_t>(getFrameCount(), 0);
 		sSizeProb = std::vector<float>(getFrameCount(), 0.5);
 		sSize = std::vector<float>(getFrameCount(), 0);
 		sCombined = std::vector<float>(getFrameCount(), 0);
+		for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
+			*idSources[flyNumber] = std::vector<uint32_t>(getFrameCount(), static_cast<uint32_t>(flyNumber));
+		}
 	} else if (getFlyCount() == 2) {
 		//TODO: make this work for an arbitrary number of flies
 		const Attribute<float>& fly0BodyArea = flyAttributes[0].getFilled<float>("bodyAreaEccentricityCorrectedTracked");
@@ -1547,8 +2003,22 @@ void Arena::solveOcclusions(float sSizeWeight, bool discardMissegmentations)
 			}
 		}
 		flyAttributes[0].swap(flyAttributes[1], swapMask);
+		for (size_t flyNumber = 0; flyNumber != 2; ++flyNumber) {
+			Attribute<uint32_t>& idSource = *idSources[flyNumber];
+			idSource.resize(getFrameCount());
+			for (size_t frameNumber = 0; frameNumber != getFrameCount(); ++frameNumber) {
+				idSource[frameNumber] = static_cast<uint32_t>(swapMask[frameNumber] ? 1 - flyNumber : flyNumber);
+			}
+		}
 
 		//TODO: what about pairAttributes?! FOR NOW they're all derived and calculated later, so it's OK!
+	} else {
+		// hofacker() can only decide whether the two flies swap identities, so for more flies hofackerPermutations() decides on a permutation of them
+		idPermutation = std::vector<uint32_t>(getFrameCount(), 0);
+		sSizeProb = std::vector<float>(getFrameCount(), 0.5);
+		sSize = std::vector<float>(getFrameCount(), 0);
+		sCombined = std::vector<float>(getFrameCount(), 0);
+		solveOcclusionsByAssignment(sSizeWeight, discardMissegmentations);
 	}
 
 /*	// sort flies by size - TODO: shouldn't be necessary unless there are NO occlusions or the sSize weight is 0
@@ -1575,6 +2045,113 @@ void Arena::solveOcclusions(float sSizeWeight, bool discardMissegmentations)
 	//idPermutation.getData() = std::vector<size_t>(idPermutation.size());
 }
 
+// the index of the permutation in the lexicographically sorted list of all permutations of its elements; only fits for up to 12 elements, since 13! > 2^32
+uint32_t getPermutationIndex(const std::vector<size_t>& permutation)
+{
+	assert(permutation.size() <= 12);
+	uint32_t index = 0;
+	for (size_t position = 0; position != permutation.size(); ++position) {
+		uint32_t smallerLaterCount = 0;
+		for (size_t later = position + 1; later != permutation.size(); ++later) {
+			if (permutation[later] < permutation[position]) {
+				++smallerLaterCount;
+			}
+		}
+		index = index * static_cast<uint32_t>(permutation.size() - position) + smallerLaterCount;
+	}
+	return index;
+}
+
+void Arena::solveOcclusionsByAssignment(float sSizeWeight, bool discardMissegmentations)
+{
+	const size_t flyCount = getFlyCount();
+	const Attribute<MyBool>& isMissegmented = frameAttributes.getFilled<MyBool>("isMissegmented");
+	Attribute<uint32_t>& idPermutation = frameAttributes.getFilled<uint32_t>("idPermutation");
+	Attribute<float>& sSizeProb = frameAttributes.getFilled<float>("sSizeProb");
+	Attribute<float>& sSize = frameAttributes.getFilled<float>("sSize");
+	Attribute<float>& sCombined = frameAttributes.getFilled<float>("sCombined");
+	std::vector<const std::vector<float>*> bodyAreas;
+	for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+		bodyAreas.push_back(&flyAttributes[flyNumber].getFilled<float>("bodyAreaEccentricityCorrectedTracked").getData());
+	}
+
+	// from frame rangeBegins[r] on, fly i is the one tracked as fly sources[r][i]
+	std::vector<size_t> rangeBegins(1, 0);
+	std::vector<std::vector<size_t> > sources(1, std::vector<size_t>(flyCount));
+	for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+		sources.back()[flyNumber] = flyNumber;
+	}
+
+	// calculateTScores() has made the occlusions begin with the first frame and end with the last, so the sequences lie between them
+	const size_t sequenceCount = occlusionMap.size() - 1;
+	if (sequenceCount != 0) {
+		// the same sign test as SequenceMap for each pair of flies
+		std::vector<std::vector<float> > sizeScores(sequenceCount, std::vector<float>(flyCount * flyCount, 0));
+		std::vector<std::vector<float> > sScores(sequenceCount, std::vector<float>(flyCount * flyCount, 0));
+		for (size_t sequenceNumber = 0; sequenceNumber != sequenceCount; ++sequenceNumber) {
+			const size_t sequenceBegin = occlusionMap.end[sequenceNumber];
+			const size_t sequenceEnd = std::max(sequenceBegin, occlusionMap.begin[sequenceNumber + 1]);
+			for (size_t first = 0; first != flyCount; ++first) {
+				for (size_t second = first + 1; second != flyCount; ++second) {
+					float p = 0;
+					if (discardMissegmentations) {
+						p = signTest(bodyAreas[first]->begin() + sequenceBegin, bodyAreas[first]->begin() + sequenceEnd, bodyAreas[second]->begin() + sequenceBegin, isMissegmented.getData().begin() + sequenceBegin);
+					} else {
+						p = signTest(bodyAreas[first]->begin() + sequenceBegin, bodyAreas[first]->begin() + sequenceEnd, bodyAreas[second]->begin() + sequenceBegin);
+					}
+					const float firstIsLarger = prob2logodd(p);
+					sizeScores[sequenceNumber][first * flyCount + second] = firstIsLarger;
+					sizeScores[sequenceNumber][second * flyCount + first] = -firstIsLarger;
+					sScores[sequenceNumber][first * flyCount + second] = firstIsLarger * sSizeWeight;
+					sScores[sequenceNumber][second * flyCount + first] = -firstIsLarger * sSizeWeight;
+				}
+			}
+		}
+
+		// the occlusions between the sequences, without the first and the last one
+		std::vector<std::vector<size_t> > assignments(occlusionMap.assignment.begin() + 1, occlusionMap.assignment.end() - 1);
+		std::vector<std::vector<float> > tScores(occlusionMap.tPosSwap.begin() + 1, occlusionMap.tPosSwap.end() - 1);
+		std::vector<std::vector<size_t> > identities = hofackerPermutations(flyCount, sScores, assignments, tScores);
+
+		// each occlusion keeps the identities of the frame before it, so the split bodies line up with the bodies before the occlusion
+		rangeBegins.clear();
+		sources.clear();
+		for (size_t sequenceNumber = 0; sequenceNumber != sequenceCount; ++sequenceNumber) {
+			rangeBegins.push_back((sequenceNumber == 0) ? 0 : occlusionMap.end[sequenceNumber]);
+			sources.push_back(identities[sequenceNumber]);
+
+			// write s values into frameAttributes for the sequence; they are positive when the identities are ordered by size
+			const float sequenceSize = hofackerPermutationsScore(sizeScores[sequenceNumber], identities[sequenceNumber]);
+			for (size_t frameNumber = occlusionMap.end[sequenceNumber]; frameNumber < occlusionMap.begin[sequenceNumber + 1]; ++frameNumber) {
+				sSizeProb[frameNumber] = logistic(sequenceSize);
+				sSize[frameNumber] = sequenceSize;
+				sCombined[frameNumber] = sequenceSize * sSizeWeight;
+			}
+		}
+	}
+
+	// rearrange all fly attributes "att" computed so far so that flyAttributes[i].att is the attribute vector "att" for fly i
+	FlyAttributes::permute(flyAttributes, rangeBegins, sources);
+
+	// the permutation itself is kept per fly, since its index in idPermutation only fits into 32 bits for up to 12 flies
+	std::vector<Attribute<uint32_t>*> idSources;
+	for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+		idSources.push_back(&flyAttributes[flyNumber].getEmpty<uint32_t>("idSource"));
+		idSources.back()->resize(getFrameCount());
+	}
+	for (size_t rangeNumber = 0; rangeNumber != rangeBegins.size(); ++rangeNumber) {
+		const uint32_t permutationIndex = (flyCount <= 12) ? getPermutationIndex(sources[rangeNumber]) : std::numeric_limits<uint32_t>::max();
+		const size_t rangeEnd = (rangeNumber + 1 == rangeBegins.size()) ? getFrameCount() : rangeBegins[rangeNumber + 1];
+		for (size_t frameNumber = rangeBegins[rangeNumber]; frameNumber != rangeEnd; ++frameNumber) {
+			idPermutation[frameNumber] = permutationIndex;
+			for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+				(*idSources[flyNumber])[frameNumber] = static_cast<uint32_t>(sources[rangeNumber][flyNumber]);
+			}
+		}
+	}
+	//TODO: what about pairAttributes?! FOR NOW they're all derived and calculated later, so it's OK!
+}
+
 void Arena::addAnnotations(const std::string& fileName)
 {
 	std::ifstream in(fileName.c_str());
@@ -3073,11 +3650,7 @@ void Arena::deriveNew()
 
 void Arena::importTrackingData(std::istream& in)
 {
-	flyAttributes.resize(getFlyCount());
-	pairAttributes.resize(getFlyCount());
-	for (size_t activeFly = 0; activeFly != getFlyCount(); ++activeFly) {
-		pairAttributes[activeFly].resize(getFlyCount());
-	}
+	resizeAttributes();
 
 	std::string table;
 	in.seekg(0, std::ios::end);   
@@ -3149,6 +3722,59 @@ void Arena::importTrackingData(std::istream& in)
 		}
 	}
 
+	clearDerivedAttributes();
+}
+
+void Arena::importTrackFile(const std::string& filePath)
+{
+	resizeAttributes();
+
+	TrackFile trackFile(filePath);
+	const std::vector<TrackFile::Column>& columns = trackFile.getColumns();
+	for (size_t columnNumber = 0; columnNumber != columns.size(); ++columnNumber) {
+		const TrackFile::Column& column = columns[columnNumber];
+		AttributeCollection* attributes = NULL;
+		if (column.activeFly == -1 && column.passiveFly == -1) {	// frame attribute
+			attributes = &frameAttributes;
+		} else if (column.activeFly < 0 || column.activeFly >= static_cast<int>(getFlyCount()) || column.passiveFly < -1 || column.passiveFly >= static_cast<int>(getFlyCount())) {
+			std::cerr << "importTrackFile: fly number out of range in column " << columnNumber << "; skipping...\n";
+			continue;
+		} else if (column.passiveFly == -1) {	// fly attribute
+			attributes = &flyAttributes[column.activeFly];
+		} else {	// pair attribute
+			attributes = &pairAttributes[column.activeFly][column.passiveFly];
+		}
+		if (!attributes->has(column.name)) {
+			std::cerr << "importTrackFile: unknown attribute name in column " << columnNumber << "; skipping...\n";
+			continue;
+		}
+		AbstractAttribute& attribute = attributes->getEmpty(column.name);
+		if (attribute.getType() != column.type) {
+			std::cerr << "importTrackFile: column " << columnNumber << " is of type " << column.type << " instead of " << attribute.getType() << "; skipping...\n";
+			continue;
+		}
+		attribute.assignBinaries(column.data, column.byteCount);
+		if (attribute.size() != column.count) {
+			std::cerr << "importTrackFile: column " << columnNumber << " is not valid; skipping...\n";
+			attribute.clear();
+			continue;
+		}
+	}
+
+	clearDerivedAttributes();
+}
+
+void Arena::resizeAttributes()
+{
+	flyAttributes.resize(getFlyCount());
+	pairAttributes.resize(getFlyCount());
+	for (size_t activeFly = 0; activeFly != getFlyCount(); ++activeFly) {
+		pairAttributes[activeFly].resize(getFlyCount());
+	}
+}
+
+void Arena::clearDerivedAttributes()
+{
 	// clear attributes that shouldn't be available at this point
 	frameAttributes.clearDerivedAttributes();
 	for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
@@ -3184,6 +3810,24 @@ void Arena::exportTrackingData(std::ostream& out) const
 	out << ::transpose(trans.str());
 }
 
+void Arena::exportTrackFile(const std::string& filePath) const
+{
+	TrackFileWriter trackFile(filePath);
+	trackFile.add(frameAttributes);
+	for (size_t flyNumber = 0; flyNumber != getFlyCount(); ++flyNumber) {
+		trackFile.add(flyAttributes[flyNumber], flyNumber);
+	}
+	for (size_t activeFly = 0; activeFly != getFlyCount(); ++activeFly) {
+		for (size_t passiveFly = 0; passiveFly != getFlyCount(); ++passiveFly) {
+			if (activeFly == passiveFly) {
+				continue;
+			}
+			trackFile.add(pairAttributes[activeFly][passiveFly], activeFly, passiveFly);
+		}
+	}
+	trackFile.close();
+}
+
 void Arena::exportAttributes(const std::string& outDirPath) const
 {
 	std::string frameDirPath = outDirPath + "/frame";
@@ -18,19 +18,31 @@
 #include "FrameAttributes.hpp"
 #include "PairAttributes.hpp"
 #include "OcclusionMap.hpp"
+#include "segmentation.hpp"
 
 class Arena {
 public:
 	Arena(const std::string& id, double sourceFrameRate, size_t flyCount, const cv::Rect& boundingBox, float diameter, float borderSize, const cv::Mat& mask, const cv::Mat& background);
 
 	std::string getId() const;
+	void setTrackingDirectory(const std::string& directory);	// where track() writes contour.bin, smoothHistogram.bin256f and the checkpoints; the directory of the arena by default
 	cv::Rect getBoundingBox() const;
 	cv::Mat getMask() const;
 	TrackedFrame& frame(size_t i);
 	size_t getFrameCount() const;
 	size_t getFlyCount() const;
-	void track(const cv::Mat& entireFrame, const size_t videoFrameNumber, const size_t videoFrameTotalCount, const size_t trackFrameTotalCount, cv::Mat& visualizedContours, float thresholdOffset, float minFlyBodySizeSquareMillimeter, float maxFlyBodySizeSquareMillimeter, bool gradientCorrection, bool fullyMergeMissegmentations, bool splitBodies, bool splitWings, bool saveContours, bool saveHistograms);
+	void track(const cv::Mat& entireFrame, const size_t videoFrameNumber, const size_t videoFrameTotalCount, const size_t trackFrameTotalCount, cv::Mat& arenaContours, float thresholdOffset, float minFlyBodySizeSquareMillimeter, float maxFlyBodySizeSquareMillimeter, bool gradientCorrection, bool fullyMergeMissegmentations, bool splitBodies, bool splitWings, bool saveContours, bool saveHistograms, bool incrementalWaveRemoval, bool streamAttributes);	// arenaContours is set to the bounding box of the frame with the tracked flies drawn on it
 	void normalizeTrackingData();	// converts data to vector of attributes format
+
+	// checkpoints of the tracking state, see checkpoint.hpp
+	void writeCheckpoint(size_t nextVideoFrame, const std::string& fingerprint) const;	// nextVideoFrame is the first frame that hasn't been tracked yet
+	std::vector<size_t> getCheckpointFrames(const std::string& fingerprint) const;	// the nextVideoFrame of each checkpoint that can be resumed
+	void resumeFromCheckpoint(size_t nextVideoFrame, const std::string& fingerprint);	// instead of tracking the frames before nextVideoFrame again
+	void removeCheckpoints() const;
+
+	// tracking a video in shards, each with its own tracking directory, and merging them for postprocessing
+	void exportShard(const std::string& filePath) const;	// after normalizeTrackingData
+	void mergeShards(const std::vector<std::string>& shardDirectories);	// in the order of their frames; instead of tracking or importing, and writes contour.bin and smoothHistogram.bin256f
 	void prepareInterpolation();	// figures out which frames will have to be interpolated
 	void buildSequenceMaps();
 	void detectMissegmentations(float minFlyBodySizeSquareMillimeter, float maxFlyBodySizeSquareMillimeter);
@@ -58,6 +70,8 @@ public:
 
 	void importTrackingData(std::istream& in);
 	void exportTrackingData(std::ostream& out) const;
+	void importTrackFile(const std::string& filePath);	// the binary counterpart of importTrackingData, see TrackFile.hpp
+	void exportTrackFile(const std::string& filePath) const;
 	void exportAttributes(const std::string& outDirPath) const;
 	std::vector<FlyAttributes>& getFlyAttributes();
 	void writeMean(std::ostream& out) const;
@@ -68,6 +82,12 @@ public:
 
 private:
 	size_t writeContour(const std::vector<std::vector<cv::Point> >& contour);
+	void appendToAttributes(const TrackedFrame& trackedFrame);	// used by normalizeTrackingData, and while tracking if the attributes are streamed
+	void solveOcclusionsByAssignment(float sSizeWeight, bool discardMissegmentations);	// used by solveOcclusions for more than 2 flies, with the assignments of calculateTScores
+
+	// helper functions for Arena::importTrackingData and Arena::importTrackFile
+	void resizeAttributes();
+	void clearDerivedAttributes();
 
 	// helper functions for Arena::writeBehavior
 	void writeFrameBehavior(std::ostream& out, std::string attributeName, size_t frameEnd, size_t framesPerBin, size_t binCount, const char delimiter = '\t') const;
@@ -86,6 +106,7 @@ private:
 	cv::Mat background;
 	cv::Mat smoothBackground;
 	std::vector<TrackedFrame> frames;
+	std::string trackingDirectory;
 
 	FrameAttributes frameAttributes;
 	std::vector<FlyAttributes> flyAttributes;	// [flyNumber]
@@ -96,6 +117,8 @@ private:
 
 	boost::shared_ptr<std::ofstream> smoothHistogramFile;
 
+	RowMedians waveRowMedians;	// carried over from frame to frame if the vertical wave is removed incrementally
+
 	OcclusionMap occlusionMap;
 };
 
@@ -12,6 +12,7 @@ TODO: Most of the interface should be removed at a later point...we're only prov
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include "../../common/source/MyBool.hpp"
 #include "../../common/source/MyTraits.hpp"
 #include "../../common/source/serialization.hpp"
@@ -54,8 +55,10 @@ public:
 	virtual void writeMean(std::ostream& out) const = 0;
 	virtual void read(std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end) = 0;
 	virtual void readBinaries(const std::string& filePath) = 0;
+	virtual void assignBinaries(const char* begin, size_t byteCount) = 0;	// replaces the data with what writeBinaries wrote
 	virtual void swap(AbstractAttribute& other) = 0;
 	virtual void swap(AbstractAttribute& other, const std::vector<bool>& mask) = 0;
+	virtual void copyRange(const AbstractAttribute& source, size_t begin, size_t end) = 0;	// overwrites the elements [begin, end) with those of source, which must be of the same type and size
 #if !defined(MATEBOOK_GUI)
 	virtual void tracked(const Fly& fly) {};
 	virtual void tracked(const TrackedFrame& frame) {};
@@ -259,6 +262,17 @@ public:
 		}
 	}
 
+	void assignBinaries(const char* begin, size_t byteCount)
+	{
+		if (byteCount % sizeof(T) != 0) {
+			throw std::invalid_argument("attribute \"" + shortname + "\": " + stringify(byteCount) + " bytes is not a multiple of " + stringify(sizeof(T)));
+		}
+		data.resize(byteCount / sizeof(T));
+		if (!data.empty()) {
+			std::memcpy(&data[0], begin, byteCount);
+		}
+	}
+
 	void swap(AbstractAttribute& other)
 	{
 		Attribute<T>& otherDowncast = *assert_cast<Attribute<T>*>(&other);	//TODO: assert_cast is only defined for pointers
@@ -279,6 +293,13 @@ public:
 			}
 		}
 	}
+
+	void copyRange(const AbstractAttribute& source, size_t begin, size_t end)
+	{
+		const Attribute<T>& sourceDowncast = *assert_cast<const Attribute<T>*>(&source);	//TODO: assert_cast is only defined for pointers
+		assert(data.size() == sourceDowncast.data.size() && begin <= end && end <= data.size());
+		std::copy(sourceDowncast.data.begin() + begin, sourceDowncast.data.begin() + end, data.begin() + begin);
+	}
     
 protected:
 	std::string shortname;
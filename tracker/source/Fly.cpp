@@ -5,6 +5,7 @@
 #include "../../common/source/geometry.hpp"
 #include "score2prob.hpp"
 #include "prob2logodd.hpp"
+#include "checkpoint.hpp"
 
 Fly::Fly(const cv::Mat& frame, const cv::Mat& foreground, const cv::Mat& bodyMask, const std::vector<std::vector<cv::Point> >& bodyContour, bool bodySplit, size_t bodyContourOffset, size_t bocContourOffset, const std::vector<std::vector<cv::Point> >& wingContour, size_t wingContourOffset) :
 	bodyContour(bodyContour),
@@ -428,6 +429,76 @@ uint32_t Fly::get_wingContourSize() const
 	return wingContourSize;
 }
 
+Fly::Fly(std::istream& checkpoint) :
+	bodyContour(readCheckpointContour(checkpoint)),
+	wingContour(readCheckpointContour(checkpoint)),
+	bodySplit(readCheckpointValue<bool>(checkpoint)),
+	bodyContourOffset(readCheckpointValue<uint64_t>(checkpoint)),
+	bocContourOffset(readCheckpointValue<uint64_t>(checkpoint)),
+	wingContourOffset(readCheckpointValue<uint64_t>(checkpoint)),
+	bodyContourSize(readCheckpointValue<uint64_t>(checkpoint)),
+	wingContourSize(readCheckpointValue<uint64_t>(checkpoint)),
+	bodyEllipseBB(readCheckpointValue<cv::RotatedRect>(checkpoint)),
+	wingEllipseBB(readCheckpointValue<cv::RotatedRect>(checkpoint)),
+	bodyAreaBB(readCheckpointValue<cv::Rect>(checkpoint)),
+	wingAreaBB(readCheckpointValue<cv::Rect>(checkpoint)),
+	headingFromColor(readCheckpointValue<float>(checkpoint)),
+	headingFromBody(readCheckpointValue<float>(checkpoint)),
+	bodyPixelCount(readCheckpointValue<unsigned int>(checkpoint)),
+	bottomRightWingTip(readCheckpointValue<cv::Point2f>(checkpoint)),
+	bottomLeftWingTip(readCheckpointValue<cv::Point2f>(checkpoint)),
+	topLeftWingTip(readCheckpointValue<cv::Point2f>(checkpoint)),
+	topRightWingTip(readCheckpointValue<cv::Point2f>(checkpoint)),
+	bottomRightBodyArea(readCheckpointValue<float>(checkpoint)),
+	bottomLeftBodyArea(readCheckpointValue<float>(checkpoint)),
+	topLeftBodyArea(readCheckpointValue<float>(checkpoint)),
+	topRightBodyArea(readCheckpointValue<float>(checkpoint)),
+	bottomRightWingArea(readCheckpointValue<float>(checkpoint)),
+	bottomLeftWingArea(readCheckpointValue<float>(checkpoint)),
+	topLeftWingArea(readCheckpointValue<float>(checkpoint)),
+	topRightWingArea(readCheckpointValue<float>(checkpoint)),
+	bottomRightWingAngle(readCheckpointValue<float>(checkpoint)),
+	bottomLeftWingAngle(readCheckpointValue<float>(checkpoint)),
+	topLeftWingAngle(readCheckpointValue<float>(checkpoint)),
+	topRightWingAngle(readCheckpointValue<float>(checkpoint))
+{
+}
+
+void Fly::writeCheckpoint(std::ostream& out) const
+{
+	writeCheckpointContour(out, bodyContour);
+	writeCheckpointContour(out, wingContour);
+	writeCheckpointValue(out, bodySplit);
+	writeCheckpointValue<uint64_t>(out, bodyContourOffset);
+	writeCheckpointValue<uint64_t>(out, bocContourOffset);
+	writeCheckpointValue<uint64_t>(out, wingContourOffset);
+	writeCheckpointValue<uint64_t>(out, bodyContourSize);
+	writeCheckpointValue<uint64_t>(out, wingContourSize);
+	writeCheckpointValue(out, bodyEllipseBB);
+	writeCheckpointValue(out, wingEllipseBB);
+	writeCheckpointValue(out, bodyAreaBB);
+	writeCheckpointValue(out, wingAreaBB);
+	writeCheckpointValue(out, headingFromColor);
+	writeCheckpointValue(out, headingFromBody);
+	writeCheckpointValue(out, bodyPixelCount);
+	writeCheckpointValue(out, bottomRightWingTip);
+	writeCheckpointValue(out, bottomLeftWingTip);
+	writeCheckpointValue(out, topLeftWingTip);
+	writeCheckpointValue(out, topRightWingTip);
+	writeCheckpointValue(out, bottomRightBodyArea);
+	writeCheckpointValue(out, bottomLeftBodyArea);
+	writeCheckpointValue(out, topLeftBodyArea);
+	writeCheckpointValue(out, topRightBodyArea);
+	writeCheckpointValue(out, bottomRightWingArea);
+	writeCheckpointValue(out, bottomLeftWingArea);
+	writeCheckpointValue(out, topLeftWingArea);
+	writeCheckpointValue(out, topRightWingArea);
+	writeCheckpointValue(out, bottomRightWingAngle);
+	writeCheckpointValue(out, bottomLeftWingAngle);
+	writeCheckpointValue(out, topLeftWingAngle);
+	writeCheckpointValue(out, topRightWingAngle);
+}
+
 void Fly::eraseContours()
 {
 	std::vector<std::vector<cv::Point> > emptyBodyContour;
@@ -14,6 +14,8 @@ This way the NEW_TRACKING_ATTRIBUTE macro can derive the name of the getter auto
 #include "opencv2/highgui/highgui.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 
+#include <iostream>
+
 #include "../../common/source/MyBool.hpp"
 #include "../../common/source/Vec.hpp"
 
@@ -68,6 +70,9 @@ public:
 	float get_topRightWingAngle() const;
 
 	void eraseContours();	// to free memory
+
+	explicit Fly(std::istream& checkpoint);	// reads what writeCheckpoint wrote, see checkpoint.hpp
+	void writeCheckpoint(std::ostream& out) const;
 	
 private:
 	std::vector<std::vector<cv::Point> > bodyContour;
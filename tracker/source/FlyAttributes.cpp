@@ -1,4 +1,5 @@
 #include "FlyAttributes.hpp"
+#include <algorithm>
 
 #include <stdint.h>
 #include "../../common/source/Vec.hpp"
@@ -54,6 +55,9 @@ FlyAttributes::FlyAttributes() : AttributeCollection()
 	NEW_TRACKING_ATTRIBUTE(trackingAttributes, float, "", headingFromColor, "Heading score based on the color distribution within the fly body.", "");
 	NEW_TRACKING_ATTRIBUTE(trackingAttributes, float, "", headingFromBody, "Heading score based on the shape of the fly body.", "");
 
+	// assigned when solving occlusions
+	NEW_FLY_ATTRIBUTE(derivedAttributes, uint32_t, "", idSource, "The number of the fly during tracking whose data this fly has in this frame, after identities have been assigned.", "");
+
 	// interpolated
 	NEW_FLY_ATTRIBUTE(derivedAttributes, float, "", bodyArea, "Fly body area.", "px");
 	NEW_FLY_ATTRIBUTE(derivedAttributes, float, "", bodyAreaEccentricityCorrected, "Fly body area after correcting for posture.", "px");
@@ -160,6 +164,38 @@ void FlyAttributes::swap(FlyAttributes& other, const std::vector<bool>& mask)
 	}
 }
 
+void FlyAttributes::permute(std::vector<FlyAttributes>& flyAttributes, const std::vector<size_t>& rangeBegins, const std::vector<std::vector<size_t> >& sources)
+{
+	assert(rangeBegins.size() == sources.size());
+	if (flyAttributes.empty()) {
+		return;
+	}
+	for (AttributeMap::iterator iter = flyAttributes[0].attributeMap.begin(); iter != flyAttributes[0].attributeMap.end(); ++iter) {
+		const size_t frameCount = iter->second->size();
+		if (frameCount == 0) {
+			continue;
+		}
+
+		// keep a copy of every fly's data, since each range reads from flies that earlier ranges may already have overwritten
+		std::vector<AbstractAttribute*> originals;
+		for (size_t flyNumber = 0; flyNumber != flyAttributes.size(); ++flyNumber) {
+			originals.push_back(flyAttributes[flyNumber].get(iter->first).clone());
+		}
+		for (size_t rangeNumber = 0; rangeNumber != rangeBegins.size(); ++rangeNumber) {
+			const size_t begin = std::min(rangeBegins[rangeNumber], frameCount);
+			const size_t end = (rangeNumber + 1 == rangeBegins.size()) ? frameCount : std::min(rangeBegins[rangeNumber + 1], frameCount);
+			for (size_t flyNumber = 0; flyNumber != flyAttributes.size(); ++flyNumber) {
+				if (sources[rangeNumber][flyNumber] != flyNumber) {
+					flyAttributes[flyNumber].get(iter->first).copyRange(*originals[sources[rangeNumber][flyNumber]], begin, end);
+				}
+			}
+		}
+		for (size_t flyNumber = 0; flyNumber != originals.size(); ++flyNumber) {
+			delete originals[flyNumber];
+		}
+	}
+}
+
 void FlyAttributes::clearDerivedAttributes()
 {
 	for (std::vector<std::string>::const_iterator iter = derivedAttributes.begin(); iter != derivedAttributes.end(); ++iter) {
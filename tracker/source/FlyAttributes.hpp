@@ -20,6 +20,8 @@ public:
 #endif
 
 	void swap(FlyAttributes& other, const std::vector<bool>& mask);
+	// the generalization of swap() to any number of flies: from frame rangeBegins[r] on, flyAttributes[i] takes the data of flyAttributes[sources[r][i]]
+	static void permute(std::vector<FlyAttributes>& flyAttributes, const std::vector<size_t>& rangeBegins, const std::vector<std::vector<size_t> >& sources);
 	void clearDerivedAttributes();
 
 private:
@@ -52,7 +52,7 @@ FrameAttributes::FrameAttributes() : AttributeCollection()
 	NEW_FRAME_ATTRIBUTE(derivedAttributes, float, "", tMovProb, "Motion-based probability for occlusion resolution.", "");
 	NEW_FRAME_ATTRIBUTE(derivedAttributes, float, "", tMov, "Motion-based logodd for occlusion resolution.", "");
 	NEW_FRAME_ATTRIBUTE(derivedAttributes, float, "tCombined", tCombined, "Weighted and combined t values for occluded sequences.", "");
-	NEW_FRAME_ATTRIBUTE(derivedAttributes, uint32_t, "", idPermutation, "In a sorted list of permutations, this is the index of the permutation that was applied to the flies to assign the correct identities.", "");
+	NEW_FRAME_ATTRIBUTE(derivedAttributes, uint32_t, "", idPermutation, "In a sorted list of permutations, this is the index of the permutation that was applied to the flies to assign the correct identities. For more than 12 flies the index doesn't fit and this is 4294967295; idSource of each fly holds the permutation.", "");
 	NEW_FRAME_ATTRIBUTE(derivedAttributes, MyBool, "", courtship, "Whether any flies are courting in this frame.", "");
 	NEW_FRAME_ATTRIBUTE(derivedAttributes, MyBool, "", wingExtCallableDuringOcclusion, "Whether wingExt can be called during occlusions.", "");
 
@@ -0,0 +1,57 @@
+#include "FrameDecoder.hpp"
+#include "FrameRing.hpp"
+#include "../../mediawrapper/source/mediawrapper.hpp"
+
+#include <stdexcept>
+#include <boost/bind.hpp>
+
+FrameDecoder::FrameDecoder(mw::InputVideo& video, FrameRing& frameRing, size_t frameBegin, size_t frameEnd) :
+	video(video),
+	frameRing(frameRing),
+	frameBegin(frameBegin),
+	frameEnd(frameEnd),
+	thread(boost::bind(&FrameDecoder::decode, this))
+{
+}
+
+FrameDecoder::~FrameDecoder()
+{
+	frameRing.stop();
+	thread.join();
+}
+
+void FrameDecoder::decode()
+{
+	std::string error;
+	try {
+		decodeFrames();
+	} catch (const std::exception& e) {
+		error = e.what();
+		if (error.empty()) {
+			error = "unknown error";
+		}
+	} catch (...) {
+		error = "unknown exception";
+	}
+	frameRing.close(error);
+}
+
+void FrameDecoder::decodeFrames()
+{
+	const cv::Mat* previousFrame = NULL;
+	for (size_t frameNumber = frameBegin; frameNumber != frameEnd; ++frameNumber) {
+		cv::Mat* frame = frameRing.beginWrite();
+		if (!frame) {	// the consumer has stopped
+			return;
+		}
+		if (!video.seek(frameNumber)) {
+			return;
+		}
+		// decode straight into the ring; if that fails we keep the last frame we got, like tracking did before it was pipelined
+		if (!video.readFrame(PIX_FMT_BGR24, frame->data, static_cast<int>(frame->step)) && previousFrame && previousFrame != frame) {
+			previousFrame->copyTo(*frame);
+		}
+		frameRing.endWrite(frameNumber);
+		previousFrame = frame;
+	}
+}
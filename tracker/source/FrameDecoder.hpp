@@ -0,0 +1,36 @@
+#ifndef FrameDecoder_hpp
+#define FrameDecoder_hpp
+
+#include <boost/thread/thread.hpp>
+
+namespace mw {
+	class InputVideo;
+}
+class FrameRing;
+
+/*
+A FrameDecoder decodes the frames [frameBegin, frameEnd) of a video into a FrameRing on its own thread, so decoding the next frames overlaps with tracking the current one.
+The ring is closed when all frames have been decoded, when seeking fails or when decoding throws; in the latter case the error message is passed on through the ring.
+The video must not be used by anyone else while the decoder is alive.
+The destructor stops the ring and waits for the thread to finish, so leaving the tracking loop early (or with an exception) is safe.
+*/
+class FrameDecoder {
+public:
+	FrameDecoder(mw::InputVideo& video, FrameRing& frameRing, size_t frameBegin, size_t frameEnd);
+	~FrameDecoder();
+
+private:
+	FrameDecoder(const FrameDecoder&);	// not copyable
+	FrameDecoder& operator=(const FrameDecoder&);
+
+	void decode();
+	void decodeFrames();
+
+	mw::InputVideo& video;
+	FrameRing& frameRing;
+	size_t frameBegin;
+	size_t frameEnd;
+	boost::thread thread;	// must be the last member so everything else is initialized when the thread starts
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "FrameRing.hpp"
+#include <stdexcept>
+
+FrameRing::FrameRing(size_t capacity, cv::Size frameSize, int frameType) :
+	frames(),
+	videoFrameNumbers(capacity),
+	readIndex(0),
+	writeIndex(0),
+	filledCount(0),
+	closed(false),
+	stopped(false),
+	error(),
+	writeWaitTime(0),
+	readWaitTime(0)
+{
+	if (capacity == 0) {
+		throw std::invalid_argument("FrameRing needs a capacity of at least 1");
+	}
+	frames.reserve(capacity);
+	for (size_t frameNumber = 0; frameNumber != capacity; ++frameNumber) {
+		frames.push_back(cv::Mat(frameSize, frameType));	// allocated here, so no allocations are needed while decoding
+	}
+}
+
+size_t FrameRing::getCapacity() const
+{
+	return frames.size();
+}
+
+cv::Mat* FrameRing::beginWrite()
+{
+	boost::mutex::scoped_lock lock(mutex);
+	if (filledCount == frames.size() && !stopped) {
+		Stopwatch waiting;
+		waiting.start();
+		while (filledCount == frames.size() && !stopped) {
+			frameRead.wait(lock);
+		}
+		waiting.stop();
+		writeWaitTime += waiting.read();
+	}
+	if (stopped) {
+		return NULL;
+	}
+	return &frames[writeIndex];
+}
+
+void FrameRing::endWrite(size_t videoFrameNumber)
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		videoFrameNumbers[writeIndex] = videoFrameNumber;
+		writeIndex = (writeIndex + 1) % frames.size();
+		++filledCount;
+	}
+	frameWritten.notify_one();
+}
+
+void FrameRing::close(const std::string& newError)
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		closed = true;
+		error = newError;
+	}
+	frameWritten.notify_one();
+}
+
+const cv::Mat* FrameRing::beginRead(size_t& videoFrameNumber)
+{
+	boost::mutex::scoped_lock lock(mutex);
+	if (filledCount == 0 && !closed) {
+		Stopwatch waiting;
+		waiting.start();
+		while (filledCount == 0 && !closed) {
+			frameWritten.wait(lock);
+		}
+		waiting.stop();
+		readWaitTime += waiting.read();
+	}
+	if (filledCount == 0) {	// closed and drained
+		return NULL;
+	}
+	videoFrameNumber = videoFrameNumbers[readIndex];
+	return &frames[readIndex];
+}
+
+void FrameRing::endRead()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		readIndex = (readIndex + 1) % frames.size();
+		--filledCount;
+	}
+	frameRead.notify_one();
+}
+
+void FrameRing::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		stopped = true;
+	}
+	frameRead.notify_one();
+}
+
+std::string FrameRing::getError() const
+{
+	boost::mutex::scoped_lock lock(mutex);
+	return error;
+}
+
+Duration FrameRing::takeWriteWaitTime()
+{
+	boost::mutex::scoped_lock lock(mutex);
+	Duration ret = writeWaitTime;
+	writeWaitTime = 0;
+	return ret;
+}
+
+Duration FrameRing::takeReadWaitTime()
+{
+	boost::mutex::scoped_lock lock(mutex);
+	Duration ret = readWaitTime;
+	readWaitTime = 0;
+	return ret;
+}
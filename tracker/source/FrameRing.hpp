@@ -0,0 +1,56 @@
+#ifndef FrameRing_hpp
+#define FrameRing_hpp
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+#include <string>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "../../common/source/Stopwatch.hpp"
+
+/*
+A FrameRing is a bounded ring of pre-allocated frames that is shared between one producer (decoding the video) and one consumer (tracking).
+Frames are handed over in the order they were written.
+The producer blocks in beginWrite() while all frames are in use, so the decoder can never run more than capacity frames ahead of tracking.
+The consumer blocks in beginRead() until a decoded frame is available.
+Both sides add up the time they spend waiting for the other side, which tells us which of the two stages is the bottleneck.
+*/
+class FrameRing {
+public:
+	FrameRing(size_t capacity, cv::Size frameSize, int frameType);
+
+	size_t getCapacity() const;
+
+	// producer side
+	cv::Mat* beginWrite();	// returns NULL if the consumer has stopped reading
+	void endWrite(size_t videoFrameNumber);
+	void close(const std::string& error = std::string());	// no more frames will be written; a non-empty error is passed on to the consumer
+
+	// consumer side
+	const cv::Mat* beginRead(size_t& videoFrameNumber);	// returns NULL once the ring has been closed and all frames have been read
+	void endRead();
+	void stop();	// no more frames will be read
+
+	std::string getError() const;
+	Duration takeWriteWaitTime();	// time spent in beginWrite() waiting for a free frame since the last call
+	Duration takeReadWaitTime();	// time spent in beginRead() waiting for a decoded frame since the last call
+
+private:
+	std::vector<cv::Mat> frames;
+	std::vector<size_t> videoFrameNumbers;
+	size_t readIndex;
+	size_t writeIndex;
+	size_t filledCount;	// frames that have been written but not yet released by endRead()
+	bool closed;
+	bool stopped;
+	std::string error;
+	Duration writeWaitTime;
+	Duration readWaitTime;
+
+	mutable boost::mutex mutex;
+	boost::condition_variable frameWritten;
+	boost::condition_variable frameRead;
+};
+
+#endif
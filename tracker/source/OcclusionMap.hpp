@@ -29,6 +29,11 @@ public:
 
 	std::vector<float> tCombined;
 
+	// for more than 2 flies, the tracked fly after the occlusion that each tracked fly before it most likely becomes, or empty if there's nothing to match;
+	// tPosSwap[a * flyCount + b] is the tPos of that assignment against swapping where tracked flies a and b go, see hofackerPermutations()
+	std::vector<std::vector<std::size_t> > assignment;
+	std::vector<std::vector<float> > tPosSwap;
+
 private:
 };
 
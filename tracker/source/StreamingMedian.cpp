@@ -0,0 +1,154 @@
+#include "StreamingMedian.hpp"
+#include "../../common/source/ThreadPool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <boost/bind.hpp>
+
+const size_t rowsPerBand = 8;	// the rows of a band are processed by the same thread
+
+StreamingMedian::StreamingMedian(cv::Size size, int type, size_t base, size_t levels) :
+	size(size),
+	type(type),
+	rowBytes(size.width * CV_ELEM_SIZE(type)),
+	base(base),
+	levels(levels),
+	fill(levels, 0),
+	samples(),
+	sampleCount(0)
+{
+	if (CV_MAT_DEPTH(type) != CV_8U) {
+		throw std::invalid_argument("StreamingMedian only supports 8 bit images");
+	}
+	if (base < 1 || levels < 1) {
+		throw std::invalid_argument("StreamingMedian needs a base and a number of levels of at least 1");
+	}
+	samples.resize(levels * size.height * rowBytes * base);
+}
+
+size_t StreamingMedian::getCapacity(size_t base, size_t levels)
+{
+	size_t capacity = 1;
+	for (size_t level = 0; level != levels; ++level) {
+		capacity *= base;
+	}
+	return capacity;
+}
+
+size_t StreamingMedian::getCapacity() const
+{
+	return getCapacity(base, levels);
+}
+
+size_t StreamingMedian::getSampleCount() const
+{
+	return sampleCount;
+}
+
+size_t StreamingMedian::getMemoryUsage() const
+{
+	return samples.size();
+}
+
+void StreamingMedian::add(const cv::Mat& image, ThreadPool& threadPool)
+{
+	if (image.size() != size || image.type() != type) {
+		throw std::invalid_argument("StreamingMedian::add: the image does not match the size and type of the previous ones");
+	}
+	if (sampleCount == getCapacity()) {
+		throw std::logic_error("StreamingMedian::add: capacity exceeded");
+	}
+
+	threadPool.run(boost::bind(&StreamingMedian::storeBand, this, &image, _1), getBandCount());
+	++fill[0];
+	++sampleCount;
+
+	// full buffers move their median one level up; the top level is never full before the capacity is reached
+	for (size_t level = 0; level + 1 != levels && fill[level] == base; ++level) {
+		threadPool.run(boost::bind(&StreamingMedian::promoteBand, this, level, _1), getBandCount());
+		fill[level] = 0;
+		++fill[level + 1];
+	}
+}
+
+cv::Mat StreamingMedian::getMedian(ThreadPool& threadPool) const
+{
+	if (sampleCount == 0) {
+		throw std::logic_error("StreamingMedian::getMedian: no images have been added");
+	}
+	cv::Mat median(size, type);
+	threadPool.run(boost::bind(&StreamingMedian::medianBand, this, &median, _1), getBandCount());
+	return median;
+}
+
+unsigned char* StreamingMedian::getSamples(size_t level, size_t row)
+{
+	return &samples[(level * size.height + row) * rowBytes * base];
+}
+
+const unsigned char* StreamingMedian::getSamples(size_t level, size_t row) const
+{
+	return &samples[(level * size.height + row) * rowBytes * base];
+}
+
+size_t StreamingMedian::getBandCount() const
+{
+	return (size.height + rowsPerBand - 1) / rowsPerBand;
+}
+
+void StreamingMedian::storeBand(const cv::Mat* image, size_t band)
+{
+	size_t rowEnd = std::min<size_t>((band + 1) * rowsPerBand, size.height);
+	for (size_t row = band * rowsPerBand; row != rowEnd; ++row) {
+		const unsigned char* source = image->ptr<unsigned char>(row);
+		unsigned char* target = getSamples(0, row) + fill[0];
+		for (size_t byte = 0; byte != rowBytes; ++byte, target += base) {
+			*target = source[byte];
+		}
+	}
+}
+
+void StreamingMedian::promoteBand(size_t level, size_t band)
+{
+	size_t rowEnd = std::min<size_t>((band + 1) * rowsPerBand, size.height);
+	for (size_t row = band * rowsPerBand; row != rowEnd; ++row) {
+		unsigned char* source = getSamples(level, row);
+		unsigned char* target = getSamples(level + 1, row) + fill[level + 1];
+		for (size_t byte = 0; byte != rowBytes; ++byte, source += base, target += base) {
+			// the buffer is emptied afterwards, so it's fine to reorder it
+			std::nth_element(source, source + base / 2, source + base);
+			*target = source[base / 2];
+		}
+	}
+}
+
+void StreamingMedian::medianBand(cv::Mat* median, size_t band) const
+{
+	// gather the (value, weight) pairs of all levels; the weights are the number of images a value stands for
+	std::vector<std::pair<unsigned char, size_t> > weighted;
+	weighted.reserve(base * levels);
+	size_t rowEnd = std::min<size_t>((band + 1) * rowsPerBand, size.height);
+	for (size_t row = band * rowsPerBand; row != rowEnd; ++row) {
+		unsigned char* target = median->ptr<unsigned char>(row);
+		for (size_t byte = 0; byte != rowBytes; ++byte) {
+			weighted.clear();
+			size_t weight = 1;
+			for (size_t level = 0; level != levels; ++level, weight *= base) {
+				const unsigned char* values = getSamples(level, row) + byte * base;
+				for (size_t sample = 0; sample != fill[level]; ++sample) {
+					weighted.push_back(std::make_pair(values[sample], weight));
+				}
+			}
+			std::sort(weighted.begin(), weighted.end());
+			size_t cumulativeWeight = 0;
+			std::vector<std::pair<unsigned char, size_t> >::const_iterator iter = weighted.begin();
+			for (; iter + 1 != weighted.end(); ++iter) {
+				cumulativeWeight += iter->second;
+				if (2 * cumulativeWeight >= sampleCount) {
+					break;
+				}
+			}
+			target[byte] = iter->first;
+		}
+	}
+}
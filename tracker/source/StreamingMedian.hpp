@@ -0,0 +1,48 @@
+#ifndef StreamingMedian_hpp
+#define StreamingMedian_hpp
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+class ThreadPool;
+
+/*
+A StreamingMedian estimates the median of every byte over a sequence of equally sized 8 bit images in a single pass with bounded memory.
+It uses the remedian: the values of each byte are collected in a buffer holding base values; once the buffer is full its median is stored one level up and the buffer is emptied.
+With L levels up to base^L images can be added while only base*L values per byte are kept in memory.
+The result is the weighted median of what's left in the buffers, where a value on level l stands for base^l images.
+The values collected for one byte are stored next to each other, so the median of a byte only touches a single cache line;
+the work is split into bands of rows that are distributed across the threads of a ThreadPool.
+*/
+class StreamingMedian {
+public:
+	StreamingMedian(cv::Size size, int type, size_t base = 7, size_t levels = 3);
+
+	static size_t getCapacity(size_t base, size_t levels);
+	size_t getCapacity() const;	// the maximum number of images that can be added
+	size_t getSampleCount() const;	// the number of images added so far
+	size_t getMemoryUsage() const;	// in bytes
+
+	void add(const cv::Mat& image, ThreadPool& threadPool);
+	cv::Mat getMedian(ThreadPool& threadPool) const;
+
+private:
+	unsigned char* getSamples(size_t level, size_t row);
+	const unsigned char* getSamples(size_t level, size_t row) const;
+	size_t getBandCount() const;
+	void storeBand(const cv::Mat* image, size_t band);
+	void promoteBand(size_t level, size_t band);
+	void medianBand(cv::Mat* median, size_t band) const;
+
+	cv::Size size;
+	int type;
+	size_t rowBytes;
+	size_t base;
+	size_t levels;
+	std::vector<size_t> fill;	// number of values in the buffers of each level
+	std::vector<unsigned char> samples;	// indexed by [level][row][byte in row][sample]
+	size_t sampleCount;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "TrackFile.hpp"
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+
+const uint32_t TrackFile::version = 1;
+
+const char trackFileMagic[8] = {'M', 'B', 'T', 'R', 'A', 'C', 'K', '\0'};
+const uint64_t trackFileHeaderSize = sizeof(trackFileMagic) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+const uint64_t trackFileColumnAlignment = 8;
+
+// reads a value from the mapped file and advances position, which must leave room for it
+template<class T>
+T readTrackFileValue(const char* begin, uint64_t size, uint64_t& position)
+{
+	if (size - position < sizeof(T)) {
+		throw std::runtime_error("track file is truncated");
+	}
+	T value;
+	std::memcpy(&value, begin + position, sizeof(T));
+	position += sizeof(T);
+	return value;
+}
+
+std::string readTrackFileString(const char* begin, uint64_t size, uint64_t& position)
+{
+	uint32_t length = readTrackFileValue<uint32_t>(begin, size, position);
+	if (size - position < length) {
+		throw std::runtime_error("track file is truncated");
+	}
+	std::string value(begin + position, length);
+	position += length;
+	return value;
+}
+
+TrackFile::TrackFile(const std::string& fileName) :
+	file(fileName),
+	columns()
+{
+	const char* begin = file.data();
+	const uint64_t size = file.size();
+	if (size < trackFileHeaderSize || std::memcmp(begin, trackFileMagic, sizeof(trackFileMagic)) != 0) {
+		throw std::runtime_error("\"" + fileName + "\" is not a track file");
+	}
+	uint64_t position = sizeof(trackFileMagic);
+	const uint32_t fileVersion = readTrackFileValue<uint32_t>(begin, size, position);
+	if (fileVersion != version) {
+		throw std::runtime_error("\"" + fileName + "\" has an unsupported track file version");
+	}
+	readTrackFileValue<uint32_t>(begin, size, position);	// reserved
+	position = readTrackFileValue<uint64_t>(begin, size, position);	// the directory
+	if (position < trackFileHeaderSize || position > size) {
+		throw std::runtime_error("\"" + fileName + "\" has no valid directory; was it closed properly?");
+	}
+
+	const uint32_t columnCount = readTrackFileValue<uint32_t>(begin, size, position);
+	columns.reserve(columnCount);
+	for (uint32_t columnNumber = 0; columnNumber != columnCount; ++columnNumber) {
+		Column column;
+		column.name = readTrackFileString(begin, size, position);
+		column.type = readTrackFileString(begin, size, position);
+		column.activeFly = readTrackFileValue<int32_t>(begin, size, position);
+		column.passiveFly = readTrackFileValue<int32_t>(begin, size, position);
+		column.offset = readTrackFileValue<uint64_t>(begin, size, position);
+		column.count = readTrackFileValue<uint64_t>(begin, size, position);
+		column.byteCount = readTrackFileValue<uint64_t>(begin, size, position);
+		if (column.offset < trackFileHeaderSize || column.offset > size || size - column.offset < column.byteCount) {
+			throw std::runtime_error("column \"" + column.name + "\" lies outside of \"" + fileName + "\"");
+		}
+		column.data = begin + column.offset;
+		columns.push_back(column);
+	}
+}
+
+const std::vector<TrackFile::Column>& TrackFile::getColumns() const
+{
+	return columns;
+}
+
+TrackFileWriter::TrackFileWriter(const std::string& fileName) :
+	fileName(fileName),
+	out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+	offset(trackFileHeaderSize),
+	columns()
+{
+	if (!out) {
+		throw std::runtime_error("could not open \"" + fileName + "\" for writing");
+	}
+	const uint32_t reserved = 0;
+	const uint64_t directoryOffset = 0;	// patched by close()
+	out.write(trackFileMagic, sizeof(trackFileMagic));
+	out.write((const char*)&TrackFile::version, sizeof(TrackFile::version));
+	out.write((const char*)&reserved, sizeof(reserved));
+	out.write((const char*)&directoryOffset, sizeof(directoryOffset));
+}
+
+TrackFileWriter::~TrackFileWriter()
+{
+	try {
+		close();
+	} catch (std::exception& e) {
+		std::cerr << "warning: " << e.what() << std::endl;
+	}
+}
+
+void TrackFileWriter::add(const std::string& name, const AbstractAttribute& attribute, int activeFly, int passiveFly)
+{
+	if (!out.is_open()) {
+		throw std::logic_error("track file \"" + fileName + "\" has already been closed");
+	}
+	while (offset % trackFileColumnAlignment != 0) {
+		out.put(0);
+		++offset;
+	}
+	TrackFile::Column column;
+	column.name = name;
+	column.type = attribute.getType();
+	column.activeFly = activeFly;
+	column.passiveFly = passiveFly;
+	column.offset = offset;
+	column.count = attribute.size();
+	column.data = NULL;
+	const std::streampos columnBegin = out.tellp();
+	attribute.writeBinaries(out);
+	column.byteCount = static_cast<uint64_t>(out.tellp() - columnBegin);
+	if (!out) {
+		throw std::runtime_error("could not write column \"" + name + "\" to \"" + fileName + "\"");
+	}
+	columns.push_back(column);
+	offset += column.byteCount;
+}
+
+void TrackFileWriter::add(const AttributeCollection& attributes, int activeFly, int passiveFly)
+{
+	std::vector<std::string> names = attributes.getNames();
+	for (std::vector<std::string>::const_iterator iter = names.begin(); iter != names.end(); ++iter) {
+		const AbstractAttribute& attribute = attributes.get(*iter);
+		if (attribute.getShortName().empty()) {
+			continue;
+		}
+		add(*iter, attribute, activeFly, passiveFly);
+	}
+}
+
+void TrackFileWriter::close()
+{
+	if (!out.is_open()) {
+		return;
+	}
+	const uint64_t directoryOffset = offset;
+	const uint32_t columnCount = columns.size();
+	out.write((const char*)&columnCount, sizeof(columnCount));
+	for (std::vector<TrackFile::Column>::const_iterator iter = columns.begin(); iter != columns.end(); ++iter) {
+		const uint32_t nameLength = iter->name.size();
+		const uint32_t typeLength = iter->type.size();
+		const int32_t activeFly = iter->activeFly;
+		const int32_t passiveFly = iter->passiveFly;
+		out.write((const char*)&nameLength, sizeof(nameLength));
+		out.write(iter->name.data(), nameLength);
+		out.write((const char*)&typeLength, sizeof(typeLength));
+		out.write(iter->type.data(), typeLength);
+		out.write((const char*)&activeFly, sizeof(activeFly));
+		out.write((const char*)&passiveFly, sizeof(passiveFly));
+		out.write((const char*)&iter->offset, sizeof(iter->offset));
+		out.write((const char*)&iter->count, sizeof(iter->count));
+		out.write((const char*)&iter->byteCount, sizeof(iter->byteCount));
+	}
+	out.seekp(sizeof(trackFileMagic) + sizeof(uint32_t) + sizeof(uint32_t));
+	out.write((const char*)&directoryOffset, sizeof(directoryOffset));
+	const bool written = out.good();
+	out.close();
+	if (!written) {
+		throw std::runtime_error("could not write the directory of \"" + fileName + "\"");
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef TrackFile_hpp
+#define TrackFile_hpp
+
+/*
+The binary track file stores the per-frame attributes of an arena column by column, in the byte order of the machine that wrote it.
+
+	header:     char magic[8] = "MBTRACK", uint32_t version, uint32_t reserved, uint64_t directoryOffset
+	columns:    the raw values of one attribute each, as written by AbstractAttribute::writeBinaries, every column starting at a multiple of 8 bytes
+	directory:  uint32_t columnCount, then for each column:
+	            uint32_t nameLength, char name[nameLength], uint32_t typeLength, char type[typeLength],
+	            int32_t activeFly, int32_t passiveFly, uint64_t offset, uint64_t count, uint64_t byteCount
+
+Frame attributes have activeFly == passiveFly == -1, fly attributes have passiveFly == -1.
+Since the directory comes last, TrackFileWriter can write each column as soon as it gets it and only has to keep the directory in memory.
+TrackFile maps the whole file and hands out pointers to the columns without copying them.
+*/
+
+#include "AttributeCollection.hpp"
+#include "../../common/source/MappedFile.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+class TrackFile {
+public:
+	struct Column {
+		std::string name;
+		std::string type;
+		int activeFly;
+		int passiveFly;
+		uint64_t offset;	// from the beginning of the file
+		uint64_t count;	// number of values
+		uint64_t byteCount;
+		const char* data;
+	};
+
+	TrackFile(const std::string& fileName);
+
+	const std::vector<Column>& getColumns() const;
+
+	static const uint32_t version;
+
+private:
+	MappedFile file;
+	std::vector<Column> columns;
+};
+
+class TrackFileWriter {
+public:
+	TrackFileWriter(const std::string& fileName);
+	~TrackFileWriter();	// closes the file if close() hasn't been called
+
+	void add(const std::string& name, const AbstractAttribute& attribute, int activeFly = -1, int passiveFly = -1);
+	void add(const AttributeCollection& attributes, int activeFly = -1, int passiveFly = -1);	// adds every attribute with a short name, like AttributeCollection::write does
+	void close();	// writes the directory
+
+private:
+	TrackFileWriter(const TrackFileWriter&);
+	TrackFileWriter& operator=(const TrackFileWriter&);
+
+	std::string fileName;
+	std::ofstream out;
+	uint64_t offset;	// where the next column goes
+	std::vector<TrackFile::Column> columns;	// with data set to NULL
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include "../../common/source/mathematics.hpp"
 #include "hungarian.hpp"
+#include "checkpoint.hpp"
 
 TrackedFrame::TrackedFrame(
 	cv::Size frameSize,
@@ -166,6 +167,61 @@ void TrackedFrame::rearrangeFlies(const TrackedFrame& lastFrame)
 	}
 }
 
+std::vector<Fly> readCheckpointFlies(std::istream& checkpoint)
+{
+	std::vector<Fly> flies;
+	const uint32_t flyCount = readCheckpointValue<uint32_t>(checkpoint);
+	for (uint32_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+		flies.push_back(Fly(checkpoint));
+	}
+	return flies;
+}
+
+TrackedFrame::TrackedFrame(std::istream& checkpoint) :
+	frameSize(readCheckpointValue<cv::Size>(checkpoint)),
+	sourceFrameRate(readCheckpointValue<float>(checkpoint)),
+	videoFrame(readCheckpointValue<uint64_t>(checkpoint)),
+	trackedFrame(readCheckpointValue<uint64_t>(checkpoint)),
+	videoFrameRelative(readCheckpointValue<float>(checkpoint)),
+	trackedFrameRelative(readCheckpointValue<float>(checkpoint)),
+	flies(readCheckpointFlies(checkpoint)),
+	knownFlyCount(readCheckpointValue<uint64_t>(checkpoint)),
+	missegmented(readCheckpointValue<bool>(checkpoint)),
+	isOcclusionTouched(readCheckpointValue<bool>(checkpoint)),
+	bodyThreshold(readCheckpointValue<unsigned char>(checkpoint)),
+	wingThreshold(readCheckpointValue<unsigned char>(checkpoint)),
+	bodyContourOffset(readCheckpointValue<uint64_t>(checkpoint)),
+	wingContourOffset(readCheckpointValue<uint64_t>(checkpoint)),
+	carry0(readCheckpointPoints(checkpoint)),
+	carry1(readCheckpointPoints(checkpoint)),
+	bocScore(readCheckpointValue<float>(checkpoint))
+{
+}
+
+void TrackedFrame::writeCheckpoint(std::ostream& out) const
+{
+	writeCheckpointValue(out, frameSize);
+	writeCheckpointValue(out, sourceFrameRate);
+	writeCheckpointValue<uint64_t>(out, videoFrame);
+	writeCheckpointValue<uint64_t>(out, trackedFrame);
+	writeCheckpointValue(out, videoFrameRelative);
+	writeCheckpointValue(out, trackedFrameRelative);
+	writeCheckpointValue<uint32_t>(out, flies.size());
+	for (size_t flyNumber = 0; flyNumber != flies.size(); ++flyNumber) {
+		flies[flyNumber].writeCheckpoint(out);
+	}
+	writeCheckpointValue<uint64_t>(out, knownFlyCount);
+	writeCheckpointValue(out, missegmented);
+	writeCheckpointValue(out, isOcclusionTouched);
+	writeCheckpointValue(out, bodyThreshold);
+	writeCheckpointValue(out, wingThreshold);
+	writeCheckpointValue<uint64_t>(out, bodyContourOffset);
+	writeCheckpointValue<uint64_t>(out, wingContourOffset);
+	writeCheckpointPoints(out, carry0);
+	writeCheckpointPoints(out, carry1);
+	writeCheckpointValue(out, bocScore);
+}
+
 void TrackedFrame::eraseContours()
 {
 	for (size_t flyNumber = 0; flyNumber != flies.size(); ++flyNumber) {
@@ -3,6 +3,7 @@
 
 #include "Fly.hpp"
 #include <vector>
+#include <iostream>
 #include <stdint.h>
 #include "../../common/source/MyBool.hpp"
 #include "../../common/source/Vec.hpp"
@@ -48,6 +49,9 @@ public:
 	void rearrangeFlies(const TrackedFrame& lastFrame);
 	void eraseContours();
 
+	explicit TrackedFrame(std::istream& checkpoint);	// reads what writeCheckpoint wrote, see checkpoint.hpp
+	void writeCheckpoint(std::ostream& out) const;
+
 private:
 	cv::Size frameSize;
 	float sourceFrameRate;
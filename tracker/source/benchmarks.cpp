@@ -0,0 +1,391 @@
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "benchmarks.hpp"
+#include "global.hpp"
+#include "getBackground.hpp"
+#include "segmentation.hpp"
+#include "reconstruct.hpp"
+#include "hungarian.hpp"
+#include "../../common/source/Vec.hpp"
+#include "../../common/source/MyBool.hpp"
+#include "../../common/source/ordfilt.hpp"
+#include "../../common/source/mathematics.hpp"
+#include "../../common/source/serialization.hpp"
+
+BenchmarkComparison::BenchmarkComparison(const std::string& name, const std::string& referenceName, const std::string& replacementName) :
+	reference(),
+	replacement(),
+	name(name),
+	referenceName(referenceName),
+	replacementName(replacementName),
+	differingCount(0),
+	comparedCount(0)
+{
+}
+
+void BenchmarkComparison::compare(bool differs)
+{
+	compare(differs ? 1 : 0, 1);
+}
+
+void BenchmarkComparison::compare(size_t differingCount, size_t comparedCount)
+{
+	this->differingCount += differingCount;
+	this->comparedCount += comparedCount;
+}
+
+bool BenchmarkComparison::differs() const
+{
+	return differingCount != 0;
+}
+
+void BenchmarkComparison::print(std::ostream& out, const std::string& unit) const
+{
+	out << name << ": " << referenceName << " " << reference.read() << " seconds, " << replacementName << " " << replacement.read() << " seconds";
+	if (replacement.read() > 0) {
+		out << ", speedup " << reference.read() / replacement.read();
+	}
+	out << ", differing " << unit << ": " << differingCount << " of " << comparedCount << std::endl;
+	if (differs()) {
+		std::cerr << "error: " << name << ": " << replacementName << " differs from " << referenceName << " in " << differingCount << " " << unit << std::endl;
+	}
+}
+
+int runBackgroundBenchmark(mw::InputVideo& video, unsigned int threadCount, const std::string& imageFormat)
+{
+	BenchmarkComparison comparison("background", "courtship", "streaming with " + stringify(threadCount) + " thread(s)");
+	comparison.reference.start();
+	cv::Mat bufferedBackground = getBackground(video, "courtship", threadCount);
+	comparison.reference.stop();
+	comparison.replacement.start();
+	cv::Mat streamingBackground = getBackground(video, "streaming", threadCount);
+	comparison.replacement.stop();
+
+	cv::Mat difference;
+	cv::absdiff(bufferedBackground, streamingBackground, difference);
+	comparison.compare(cv::countNonZero(difference.reshape(1)), difference.total() * difference.channels());
+	comparison.print(std::cout, "color values");
+	double maxDifference;
+	cv::minMaxLoc(difference.reshape(1), NULL, &maxDifference);
+	cv::Scalar meanDifference = cv::mean(difference);
+	std::cout << "difference per color channel: mean " << (meanDifference[0] + meanDifference[1] + meanDifference[2]) / 3 << ", max " << maxDifference << std::endl;
+	cv::imwrite(global::outDir + "/background_courtship" + imageFormat, bufferedBackground);
+	cv::imwrite(global::outDir + "/background_streaming" + imageFormat, streamingBackground);
+	return 0;
+}
+
+int runDecodingBenchmark(mw::InputVideo& video, size_t frameBegin, size_t frameEnd, unsigned int maxThreadCount, mw::VideoCodec::threadType threadType)
+{
+	// the video is opened anew for each thread count so every run starts from the same state
+	const size_t benchmarkFrameCount = 1000;
+	size_t benchmarkEnd = std::min(frameEnd, frameBegin + benchmarkFrameCount);
+	cv::Mat frame(cv::Size(video.getFrameWidth(), video.getFrameHeight()), CV_8UC3);
+	for (unsigned int decodingThreads = 1; decodingThreads <= maxThreadCount; ++decodingThreads) {
+		mw::InputVideo benchmarkVideo(global::videoFile, decodingThreads, threadType);
+		size_t decodedFrames = 0;
+		Stopwatch stopwatch;
+		stopwatch.start();
+		for (size_t frameNumber = frameBegin; frameNumber != benchmarkEnd; ++frameNumber) {
+			if (benchmarkVideo.seek(frameNumber) && benchmarkVideo.readFrame(PIX_FMT_BGR24, frame.data, static_cast<int>(frame.step))) {
+				++decodedFrames;
+			}
+		}
+		stopwatch.stop();
+		Duration decodingTime = stopwatch.read();
+		std::cout << "decoding with " << decodingThreads << " " << (threadType == mw::VideoCodec::sliceThreading ? "slice" : "frame") << " thread(s): " << decodedFrames << " frames in " << decodingTime << " seconds, " << (decodingTime > 0 ? decodedFrames / decodingTime : 0) << " frames/s" << std::endl;
+	}
+	return 0;
+}
+
+int runSegmentationBenchmark(mw::InputVideo& video, size_t frameBegin, unsigned int repetitionCount)
+{
+	// a frame one second later is the background and the whole frame is the arena
+	const int width = video.getFrameWidth();
+	const int height = video.getFrameHeight();
+	cv::Mat background(cv::Size(width, height), CV_8UC3);
+	cv::Mat frame(cv::Size(width, height), CV_8UC3);
+	cv::Mat nextFrame(cv::Size(width, height), CV_8UC3);
+	if (!video.seek(frameBegin) || !video.readFrame(PIX_FMT_BGR24, frame.data, static_cast<int>(frame.step)) ||
+		!video.seek(frameBegin + 1) || !video.readFrame(PIX_FMT_BGR24, nextFrame.data, static_cast<int>(nextFrame.step)) ||
+		!video.seek(frameBegin + static_cast<size_t>(video.getFrameRate())) || !video.readFrame(PIX_FMT_BGR24, background.data, static_cast<int>(background.step))) {
+		std::cerr << "error: could not read the frames for the segmentation benchmark" << std::endl;
+		return -1;
+	}
+	cv::Mat mask(frame.size(), CV_8UC1, cv::Scalar(0));
+	cv::ellipse(mask, cv::Point(width / 2, height / 2), cv::Size(width / 2, height / 2), 0, 0, 360, cv::Scalar(255), -1);
+	cv::Mat bodies;
+	cvtColor(background - frame, bodies, CV_BGR2GRAY);
+	threshold(bodies, bodies, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+	const unsigned char saturateAbove = 100;
+
+	// the fused kernels against the OpenCV calls they replace
+	BenchmarkComparison kernels("segmentation", "separate passes", "fused kernels");
+	cv::Mat referenceForeground, referenceWings, referenceVisualization(frame.size(), CV_8UC3);
+	kernels.reference.start();
+	for (unsigned int repetition = 0; repetition != repetitionCount; ++repetition) {
+		cvtColor(background - frame, referenceForeground, CV_BGR2GRAY);
+		referenceForeground = referenceForeground & mask;
+		cvtColor(background - frame, referenceWings, CV_BGR2GRAY);
+		referenceWings = stretch(removeVerticalWave(referenceWings) & mask & ~bodies, 0, saturateAbove);
+		cvtColor(referenceWings, referenceVisualization, CV_GRAY2BGR);
+	}
+	kernels.reference.stop();
+
+	cv::Mat fusedForeground, fusedWings, fusedVisualization(frame.size(), CV_8UC3);
+	kernels.replacement.start();
+	for (unsigned int repetition = 0; repetition != repetitionCount; ++repetition) {
+		grayForeground(background, frame, mask, fusedForeground);
+		wingForeground(background, frame, mask, bodies, fusedWings);
+		stretchAndVisualize(fusedWings, 0, saturateAbove, fusedVisualization);
+	}
+	kernels.replacement.stop();
+	kernels.compare(cv::countNonZero(referenceForeground != fusedForeground), referenceForeground.total());
+	kernels.compare(cv::countNonZero(referenceWings != fusedWings), referenceWings.total());
+	kernels.compare(cv::countNonZero(cv::Mat(referenceVisualization != fusedVisualization).reshape(1)), referenceVisualization.total() * referenceVisualization.channels());
+	kernels.print(std::cout, "pixel values");
+
+	// the row medians of the vertical wave removal on their own, alternating between two consecutive frames
+	cv::Mat grays[2];
+	cvtColor(background - frame, grays[0], CV_BGR2GRAY);
+	cvtColor(background - nextFrame, grays[1], CV_BGR2GRAY);
+	BenchmarkComparison counting("row medians", "sorting", "counting");
+	std::vector<unsigned char> sortedMedians(grays[0].rows);
+	counting.reference.start();
+	for (unsigned int repetition = 0; repetition != repetitionCount; ++repetition) {
+		cv::Mat gray = grays[repetition % 2].clone();
+		for (int row = 0; row != gray.rows; ++row) {
+			unsigned char* rowPointer = gray.ptr<uchar>(row);
+			std::nth_element(rowPointer, rowPointer + gray.cols / 2, rowPointer + gray.cols);
+			sortedMedians[row] = rowPointer[gray.cols / 2];
+		}
+	}
+	counting.reference.stop();
+
+	std::vector<unsigned char> countedMedians(grays[0].rows);
+	counting.replacement.start();
+	for (unsigned int repetition = 0; repetition != repetitionCount; ++repetition) {
+		const cv::Mat& gray = grays[repetition % 2];
+		for (int row = 0; row != gray.rows; ++row) {
+			countedMedians[row] = rowMedian(gray.ptr<uchar>(row), gray.cols);
+		}
+	}
+	counting.replacement.stop();
+
+	BenchmarkComparison updating("row medians", "sorting", "updating from the previous frame");
+	updating.reference = counting.reference;
+	std::vector<unsigned char> updatedMedians(grays[0].rows);
+	RowMedians rowMedians;
+	rowMedians.reset(grays[0].rows, grays[0].cols);
+	updating.replacement.start();
+	for (unsigned int repetition = 0; repetition != repetitionCount; ++repetition) {
+		const cv::Mat& gray = grays[repetition % 2];
+		for (int row = 0; row != gray.rows; ++row) {
+			updatedMedians[row] = rowMedians.update(row, gray.ptr<uchar>(row));
+		}
+	}
+	updating.replacement.stop();
+
+	// the last repetition used the same frame for all of them
+	for (size_t row = 0; row != sortedMedians.size(); ++row) {
+		counting.compare(countedMedians[row] != sortedMedians[row]);
+		updating.compare(updatedMedians[row] != sortedMedians[row]);
+	}
+	counting.print(std::cout, "rows");
+	updating.print(std::cout, "rows");
+	return (kernels.differs() || counting.differs() || updating.differs()) ? 1 : 0;
+}
+
+int runReconstructBenchmark(int width, int height, unsigned int imageCount)
+{
+	// random masks of varying density and size, with a few marker pixels, some of them outside the mask
+	cv::RNG rng(0);
+	BenchmarkComparison comparison("reconstruct", "pixel by pixel", "span by span");
+	for (unsigned int imageNumber = 0; imageNumber != imageCount; ++imageNumber) {
+		cv::Size size(rng.uniform(1, width / 4 + 2), rng.uniform(1, height / 4 + 2));
+		cv::Mat noise(size, CV_8UC1);
+		rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+		cv::Mat mask = noise < rng.uniform(0, 256);
+		rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+		cv::Mat marker = noise < rng.uniform(0, 8);
+		unsigned int conn = (imageNumber % 2) ? 8 : 4;
+
+		comparison.reference.start();
+		cv::Mat stackResult = stackReconstruct(marker, mask, conn);
+		comparison.reference.stop();
+
+		comparison.replacement.start();
+		cv::Mat spanResult = reconstruct(marker, mask, conn);
+		comparison.replacement.stop();
+
+		comparison.compare(cv::countNonZero((stackResult > 0) != (spanResult > 0)) != 0);
+	}
+	comparison.print(std::cout, "images");
+	return comparison.differs() ? 1 : 0;
+}
+
+// the number of values that differ, counting NaNs as equal to each other
+template<class T>
+size_t countDiffering(const std::vector<T>& first, const std::vector<T>& second)
+{
+	size_t differingCount = 0;
+	for (size_t index = 0; index != first.size(); ++index) {
+		const bool firstIsNaN = first[index] != first[index];
+		const bool secondIsNaN = second[index] != second[index];
+		differingCount += (firstIsNaN != secondIsNaN) || (!firstIsNaN && first[index] != second[index]);
+	}
+	return differingCount;
+}
+
+std::vector<ptrdiff_t> makeNeighborhood(ptrdiff_t width)
+{
+	std::vector<ptrdiff_t> neighborhood;
+	for (ptrdiff_t offset = -(width / 2); offset <= (width / 2); ++offset) {
+		neighborhood.push_back(offset);
+	}
+	return neighborhood;
+}
+
+int runOrdfiltBenchmark(const std::vector<OrdfiltBenchmarkFilter>& filters, double frameRate, int width, int height, size_t frameCount)
+{
+	// a median filter, then erosion and dilation, on boolean signals with bouts of up to 10 seconds
+	cv::RNG rng(0);
+	std::vector<MyBool> bouts(frameCount);
+	for (size_t frameNumber = 0; frameNumber != bouts.size(); ) {
+		const bool value = rng.uniform(0, 2) != 0;
+		for (size_t boutEnd = std::min<size_t>(bouts.size(), frameNumber + rng.uniform(1, static_cast<int>(10 * frameRate) + 2)); frameNumber != boutEnd; ++frameNumber) {
+			bouts[frameNumber] = (rng.uniform(0, 20) == 0) ? !value : value;
+		}
+	}
+	bool anyDiffers = false;
+	for (std::vector<OrdfiltBenchmarkFilter>::const_iterator filter = filters.begin(); filter != filters.end(); ++filter) {
+		const ptrdiff_t medianFilterWidth = roundToOdd(filter->medianFilterSeconds * frameRate);
+		const ptrdiff_t erodeDilateWidth = roundToOdd(filter->persistenceSeconds * frameRate);
+		const std::vector<ptrdiff_t> medianNeighborhood = makeNeighborhood(medianFilterWidth);
+		const std::vector<ptrdiff_t> erodeDilateNeighborhood = makeNeighborhood(erodeDilateWidth);
+
+		BenchmarkComparison comparison(filter->name + " (" + stringify(medianFilterWidth) + " and " + stringify(erodeDilateWidth) + " frames wide)", "nth_element", "sliding");
+		comparison.reference.start();
+		std::vector<MyBool> referenceResult = ordfilt_nth_element(bouts, 0.5, medianNeighborhood);
+		referenceResult = ordfilt_nth_element(referenceResult, 0, erodeDilateNeighborhood);
+		referenceResult = ordfilt_nth_element(referenceResult, 1, erodeDilateNeighborhood);
+		comparison.reference.stop();
+
+		comparison.replacement.start();
+		std::vector<MyBool> slidingResult = ordfilt(bouts, 0.5, medianNeighborhood);
+		slidingResult = ordfilt(slidingResult, 0, erodeDilateNeighborhood);
+		slidingResult = ordfilt(slidingResult, 1, erodeDilateNeighborhood);
+		comparison.replacement.stop();
+
+		comparison.compare(countDiffering(referenceResult, slidingResult), bouts.size());
+		comparison.print(std::cout, "frames");
+		anyDiffers = anyDiffers || comparison.differs();
+	}
+
+	// median filtered floats, some of them NaN, and rows of a background filtered as in getBackground
+	std::vector<float> values(frameCount);
+	for (size_t frameNumber = 0; frameNumber != values.size(); ++frameNumber) {
+		values[frameNumber] = (rng.uniform(0, 1000) == 0) ? std::numeric_limits<float>::quiet_NaN() : rng.uniform(0.0f, 100.0f);
+	}
+	const std::vector<ptrdiff_t> neighborhood = makeNeighborhood(151);
+
+	BenchmarkComparison floats("floats (151 frames wide)", "nth_element", "sliding");
+	floats.reference.start();
+	std::vector<float> referenceValues = ordfilt_nth_element(values, 0.5, neighborhood);
+	floats.reference.stop();
+	floats.replacement.start();
+	std::vector<float> slidingValues = ordfilt(values, 0.5, neighborhood);
+	floats.replacement.stop();
+	floats.compare(countDiffering(referenceValues, slidingValues), values.size());
+	floats.print(std::cout, "frames");
+
+	std::vector<unsigned char> row(width);
+	for (size_t col = 0; col != row.size(); ++col) {
+		row[col] = static_cast<unsigned char>(rng.uniform(0, 256));
+	}
+	BenchmarkComparison rows("background rows (151 pixels wide, mirrored)", "nth_element", "sliding");
+	for (int rowNumber = 0; rowNumber != 3 * height; ++rowNumber) {
+		std::random_shuffle(row.begin(), row.end());
+		rows.reference.start();
+		std::vector<unsigned char> referenceRow = ordfilt_mirror_nth_element(row, 0.5, neighborhood);
+		rows.reference.stop();
+		rows.replacement.start();
+		std::vector<unsigned char> slidingRow = ordfilt_mirror(row, 0.5, neighborhood);
+		rows.replacement.stop();
+		rows.compare(referenceRow != slidingRow);
+	}
+	rows.print(std::cout, "rows");
+	return (anyDiffers || floats.differs() || rows.differs()) ? 1 : 0;
+}
+
+int runHungarianBenchmark(int width, int height, unsigned int problemCount)
+{
+	// distances between the flies before and after an occlusion, each fly having moved a little
+	const size_t flyCountCount = 9;
+	const size_t flyCounts[flyCountCount] = {2, 3, 4, 6, 8, 12, 16, 24, 32};
+	const size_t maxExhaustiveFlyCount = 8;
+	cv::RNG rng(0);
+	HungarianWorkspace workspace;
+	std::vector<size_t> rowToColumn;
+	bool anyDiffers = false;
+	for (size_t flyCountIndex = 0; flyCountIndex != flyCountCount; ++flyCountIndex) {
+		const size_t flyCount = flyCounts[flyCountIndex];
+		std::vector<cv::Mat> costs;
+		for (unsigned int problemNumber = 0; problemNumber != problemCount; ++problemNumber) {
+			std::vector<Vf2> before(flyCount);
+			std::vector<Vf2> after(flyCount);
+			for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+				before[flyNumber][0] = rng.uniform(0.0f, static_cast<float>(width));
+				before[flyNumber][1] = rng.uniform(0.0f, static_cast<float>(height));
+				after[flyNumber][0] = before[flyNumber][0] + rng.uniform(-20.0f, 20.0f);
+				after[flyNumber][1] = before[flyNumber][1] + rng.uniform(-20.0f, 20.0f);
+			}
+			std::random_shuffle(after.begin(), after.end());
+			costs.push_back(cv::Mat(flyCount, flyCount, CV_32F));
+			for (size_t flyBefore = 0; flyBefore != flyCount; ++flyBefore) {
+				for (size_t flyAfter = 0; flyAfter != flyCount; ++flyAfter) {
+					costs.back().at<float>(flyBefore, flyAfter) = (before[flyBefore] - after[flyAfter]).norm();
+				}
+			}
+		}
+
+		// the exhaustive search is the reference, as far as it is feasible
+		BenchmarkComparison comparison(stringify(flyCount) + " flies", "exhaustive", "hungarian");
+		std::vector<double> hungarianCosts(costs.size(), 0);
+		comparison.replacement.start();
+		for (size_t problemNumber = 0; problemNumber != costs.size(); ++problemNumber) {
+			hungarian(costs[problemNumber], workspace, rowToColumn);
+			for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+				hungarianCosts[problemNumber] += costs[problemNumber].at<float>(flyNumber, rowToColumn[flyNumber]);
+			}
+		}
+		comparison.replacement.stop();
+		if (flyCount > maxExhaustiveFlyCount) {
+			std::cout << flyCount << " flies: hungarian " << comparison.replacement.read() << " seconds" << std::endl;
+			continue;
+		}
+
+		std::vector<double> exhaustiveCosts(costs.size(), 0);
+		comparison.reference.start();
+		for (size_t problemNumber = 0; problemNumber != costs.size(); ++problemNumber) {
+			std::vector<size_t> exhaustive = exhaustiveAssignment(costs[problemNumber]);
+			for (size_t flyNumber = 0; flyNumber != flyCount; ++flyNumber) {
+				exhaustiveCosts[problemNumber] += costs[problemNumber].at<float>(flyNumber, exhaustive[flyNumber]);
+			}
+		}
+		comparison.reference.stop();
+
+		// the assignments themselves may differ where two of them cost the same
+		for (size_t problemNumber = 0; problemNumber != costs.size(); ++problemNumber) {
+			comparison.compare(std::abs(hungarianCosts[problemNumber] - exhaustiveCosts[problemNumber]) > 1e-4 * std::max(1.0, exhaustiveCosts[problemNumber]));
+		}
+		comparison.print(std::cout, "total costs");
+		anyDiffers = anyDiffers || comparison.differs();
+	}
+	return anyDiffers ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#ifndef benchmarks_hpp
+#define benchmarks_hpp
+
+/*
+The -benchmark* options of the tracker. Each of them times an implementation against the one it replaced, or a setting against its alternatives,
+on the input video or on random data of its size, and prints how long each took and whether their results differ.
+They return the exit code for the tracker, which ends after running one of them: 1 if a replacement gave different results than its reference, so that
+"make check" fails, and 0 otherwise. The streaming background is an estimate, so -benchmarkBackground only reports how far it is off, and -benchmarkDecoding
+has nothing to compare.
+*/
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "../../common/source/Stopwatch.hpp"
+#include "../../mediawrapper/source/mediawrapper.hpp"
+
+// the time a reference implementation and the one replacing it took, and how many of their results differ
+class BenchmarkComparison {
+public:
+	BenchmarkComparison(const std::string& name, const std::string& referenceName, const std::string& replacementName);
+
+	void compare(bool differs);	// one result of each
+	void compare(size_t differingCount, size_t comparedCount);
+
+	bool differs() const;	// whether any of the results compared so far differ
+	void print(std::ostream& out, const std::string& unit) const;	// unit is what was compared, e.g. "images"; also reports differences on std::cerr
+
+	// each implementation runs between start() and stop() of its stopwatch, which add up over several runs
+	Stopwatch reference;
+	Stopwatch replacement;
+
+private:
+	std::string name;
+	std::string referenceName;
+	std::string replacementName;
+	size_t differingCount;
+	size_t comparedCount;
+};
+
+// the filters of one of the derive* functions of Arena
+struct OrdfiltBenchmarkFilter {
+	std::string name;
+	float medianFilterSeconds;
+	float persistenceSeconds;
+};
+
+int runBackgroundBenchmark(mw::InputVideo& video, unsigned int threadCount, const std::string& imageFormat);	// the courtship background held in memory against the streaming estimate
+int runDecodingBenchmark(mw::InputVideo& video, size_t frameBegin, size_t frameEnd, unsigned int maxThreadCount, mw::VideoCodec::threadType threadType);	// 1..maxThreadCount decoding threads
+int runSegmentationBenchmark(mw::InputVideo& video, size_t frameBegin, unsigned int repetitionCount);	// the fused segmentation kernels and the row medians, on the first frame
+int runReconstructBenchmark(int width, int height, unsigned int imageCount);	// on random masks of up to a quarter of the video size
+int runOrdfiltBenchmark(const std::vector<OrdfiltBenchmarkFilter>& filters, double frameRate, int width, int height, size_t frameCount);	// on random signals of frameCount frames and random rows of the video width
+int runHungarianBenchmark(int width, int height, unsigned int problemCount);	// on random identity assignments for 2 to 32 flies
+
+#endif
@@ -0,0 +1,84 @@
+#include "checkpoint.hpp"
+#include <fstream>
+#include <cstring>
+
+const char checkpointMagic[8] = "MBCHKPT";
+const char checkpointEndMagic[8] = "MBCKEND";
+const uint32_t checkpointVersion = 1;
+
+void writeCheckpointString(std::ostream& out, const std::string& string)
+{
+	writeCheckpointValue<uint32_t>(out, string.size());
+	out.write(string.data(), string.size());
+}
+
+std::string readCheckpointString(std::istream& in)
+{
+	const uint32_t length = readCheckpointValue<uint32_t>(in);
+	std::string string(length, '\0');
+	if (length && !in.read(&string[0], length)) {
+		throw std::runtime_error("checkpoint is truncated");
+	}
+	return string;
+}
+
+void writeCheckpointPoints(std::ostream& out, const std::vector<cv::Point>& points)
+{
+	writeCheckpointValue<uint32_t>(out, points.size());
+	for (size_t pointNumber = 0; pointNumber != points.size(); ++pointNumber) {
+		writeCheckpointValue<int32_t>(out, points[pointNumber].x);
+		writeCheckpointValue<int32_t>(out, points[pointNumber].y);
+	}
+}
+
+std::vector<cv::Point> readCheckpointPoints(std::istream& in)
+{
+	std::vector<cv::Point> points(readCheckpointValue<uint32_t>(in));
+	for (size_t pointNumber = 0; pointNumber != points.size(); ++pointNumber) {
+		points[pointNumber].x = readCheckpointValue<int32_t>(in);
+		points[pointNumber].y = readCheckpointValue<int32_t>(in);
+	}
+	return points;
+}
+
+void writeCheckpointContour(std::ostream& out, const std::vector<std::vector<cv::Point> >& contour)
+{
+	writeCheckpointValue<uint32_t>(out, contour.size());
+	for (size_t segmentNumber = 0; segmentNumber != contour.size(); ++segmentNumber) {
+		writeCheckpointPoints(out, contour[segmentNumber]);
+	}
+}
+
+std::vector<std::vector<cv::Point> > readCheckpointContour(std::istream& in)
+{
+	std::vector<std::vector<cv::Point> > contour(readCheckpointValue<uint32_t>(in));
+	for (size_t segmentNumber = 0; segmentNumber != contour.size(); ++segmentNumber) {
+		contour[segmentNumber] = readCheckpointPoints(in);
+	}
+	return contour;
+}
+
+size_t getCheckpointFrame(const std::string& fileName, const std::string& fingerprint)
+{
+	std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (!in) {
+		return 0;
+	}
+	try {
+		char magic[sizeof(checkpointMagic)];
+		in.seekg(-static_cast<std::streamoff>(sizeof(checkpointEndMagic)), std::ios::end);
+		if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, checkpointEndMagic, sizeof(magic)) != 0) {
+			return 0;
+		}
+		in.seekg(0, std::ios::beg);
+		if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, checkpointMagic, sizeof(magic)) != 0) {
+			return 0;
+		}
+		if (readCheckpointValue<uint32_t>(in) != checkpointVersion || readCheckpointString(in) != fingerprint) {
+			return 0;
+		}
+		return readCheckpointValue<uint64_t>(in);
+	} catch (const std::runtime_error&) {
+		return 0;
+	}
+}
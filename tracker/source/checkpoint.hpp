@@ -0,0 +1,59 @@
+#ifndef checkpoint_hpp
+#define checkpoint_hpp
+
+/*
+A checkpoint holds everything Arena::track carries from one frame to the next, so that tracking can be resumed where it stopped and give the same output as if it never had.
+It is written to checkpoint.bin in the tracking directory of the arena (see Arena::setTrackingDirectory) in the byte order and struct layout of the machine that wrote it; the previous one is kept as checkpoint.previous.bin.
+
+	header:     char magic[8] = "MBCHKPT", uint32_t version, string fingerprint, uint64_t nextVideoFrame,
+	            uint8_t hasContourFile, uint64_t contourFileSize, uint8_t hasHistogramFile, uint64_t histogramFileSize
+	columns:    uint32_t columnCount, then for each frame and fly attribute accumulated so far:
+	            string name, string type, int32_t fly (-1 for frame attributes), uint64_t count, uint64_t byteCount, char data[byteCount]
+	frames:     uint32_t frameCount, then the TrackedFrame objects that haven't been moved into the attributes yet
+	end:        char magic[8] = "MBCKEND"
+
+Strings are stored as uint32_t length followed by the characters.
+The fingerprint describes the settings the checkpoint was tracked with; a checkpoint is only resumed with the same one.
+Since the contour and histogram files only ever grow, resuming truncates them to the sizes they had when the checkpoint was written.
+*/
+
+#include "opencv2/core/core.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+
+template<class T>
+void writeCheckpointValue(std::ostream& out, const T& value)
+{
+	out.write((const char*)&value, sizeof(value));
+}
+
+template<class T>
+T readCheckpointValue(std::istream& in)
+{
+	T value;
+	if (!in.read((char*)&value, sizeof(value))) {
+		throw std::runtime_error("checkpoint is truncated");
+	}
+	return value;
+}
+
+void writeCheckpointString(std::ostream& out, const std::string& string);
+std::string readCheckpointString(std::istream& in);
+
+void writeCheckpointPoints(std::ostream& out, const std::vector<cv::Point>& points);
+std::vector<cv::Point> readCheckpointPoints(std::istream& in);
+
+void writeCheckpointContour(std::ostream& out, const std::vector<std::vector<cv::Point> >& contour);
+std::vector<std::vector<cv::Point> > readCheckpointContour(std::istream& in);
+
+extern const char checkpointMagic[8];
+extern const char checkpointEndMagic[8];
+extern const uint32_t checkpointVersion;
+
+// the nextVideoFrame of a complete checkpoint written with the given fingerprint, or 0 if the file is missing, incomplete or doesn't match
+size_t getCheckpointFrame(const std::string& fileName, const std::string& fingerprint);
+
+#endif
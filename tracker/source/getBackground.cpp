@@ -1,26 +1,21 @@
 #include "getBackground.hpp"
 #include "../../common/source/StrideIterator.hpp"
 #include "../../common/source/ordfilt.hpp"
+#include "../../common/source/ThreadPool.hpp"
+#include "StreamingMedian.hpp"
 #include <stdexcept>
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include "../../mediawrapper/source/VideoFrame.hpp"
 
-cv::Mat getBackground(mw::InputVideo& sourceVideo, const std::string& type)
+// median of frames spaced bgExtractionSpacing seconds apart, all of which are held in memory
+cv::Mat getBufferedMedian(mw::InputVideo& sourceVideo, int sourceWidth, int sourceHeight, double sourceFrameRate, unsigned int sourceFrameCount)
 {
 	// configuration
 	const unsigned int bgExtractionSpacing = 50;		// seconds between frames used for background extraction
 	const unsigned int bgExtractionMaxMem = 512;	// MB to use for background extraction (at most)
 
-	// get the meta data for the video
-	int sourceWidth = sourceVideo.getFrameWidth();
-	int sourceHeight = sourceVideo.getFrameHeight();
-	double sourceFrameRate = sourceVideo.getFrameRate();
-	unsigned int sourceFrameCount = sourceVideo.getNumberOfFrames();
-	if (!(sourceWidth > 0 && sourceHeight > 0 && sourceFrameRate > 0 && sourceFrameCount > 0)) {
-		throw std::runtime_error("error: video meta data did not pass sanity check");
-	}
-
 	// for background extraction choose evenly spaced frames
 	int bytesPerFrame = sourceWidth * sourceHeight * 3;
 	int bgExtractionFrameCount = sourceFrameCount / (sourceFrameRate * bgExtractionSpacing);
@@ -42,16 +37,12 @@ cv::Mat getBackground(mw::InputVideo& sourceVideo, const std::string& type)
 	if (bgExtractionFrameCount == 1) {
 		// special case: use the middle frame
 		sourceVideo.seekApprox(sourceFrameCount / 2);
-		if (unsigned char* frameData = sourceVideo.getFrameBuffer(PIX_FMT_BGR24)) {
-			std::copy(frameData, frameData + bytesPerFrame, bgExtractionFrames);
-		}
+		sourceVideo.readFrame(PIX_FMT_BGR24, bgExtractionFrames, sourceWidth * 3);
 	} else {
 		int offset = (sourceFrameRate * bgExtractionSpacing) / 2;
 		for (unsigned int frame = 0; frame != bgExtractionFrameCount; ++frame) {
 			sourceVideo.seekApprox(offset + frame * sourceFrameRate * bgExtractionSpacing);
-			if (unsigned char* frameData = sourceVideo.getFrameBuffer(PIX_FMT_BGR24)) {
-				std::copy(frameData, frameData + bytesPerFrame, bgExtractionFrames + frame * bytesPerFrame);
-			}
+			sourceVideo.readFrame(PIX_FMT_BGR24, bgExtractionFrames + frame * bytesPerFrame, sourceWidth * 3);
 		}
 	}
 
@@ -66,6 +57,59 @@ cv::Mat getBackground(mw::InputVideo& sourceVideo, const std::string& type)
 	delete bgExtractionFrames;
 	bgExtractionFrames = NULL;
 	//cvtColor(bgMedian, bgMedian, CV_RGB2BGR);	// OpenCV functions like imshow expect BGR
+	return bgMedian;
+}
+
+// approximate median of frames read in a single pass, using a StreamingMedian whose memory use doesn't depend on the number of frames
+cv::Mat getStreamingMedian(mw::InputVideo& sourceVideo, int sourceWidth, int sourceHeight, double sourceFrameRate, unsigned int sourceFrameCount, size_t threadCount)
+{
+	// configuration
+	const unsigned int bgExtractionMinSpacing = 5;	// seconds between frames used for background extraction (at least)
+	const size_t remedianBase = 7;
+	const size_t remedianLevels = 3;	// allows for 7^3 = 343 frames
+
+	// choose evenly spaced frames, as many as the StreamingMedian can take
+	size_t bgExtractionFrameCount = sourceFrameCount / (sourceFrameRate * bgExtractionMinSpacing);
+	bgExtractionFrameCount = std::max<size_t>(1, std::min(bgExtractionFrameCount, StreamingMedian::getCapacity(remedianBase, remedianLevels)));
+	double bgExtractionSpacing = static_cast<double>(sourceFrameCount) / bgExtractionFrameCount;	// in frames
+
+	ThreadPool threadPool(threadCount);
+	StreamingMedian streamingMedian(cv::Size(sourceWidth, sourceHeight), CV_8UC3, remedianBase, remedianLevels);
+	std::cout << "info: using " << static_cast<float>(streamingMedian.getMemoryUsage()) / 1024 / 1024 << " MB for streaming background extraction from " << bgExtractionFrameCount << " frames" << std::endl;
+	cv::Mat frame(cv::Size(sourceWidth, sourceHeight), CV_8UC3);
+	for (size_t frameNumber = 0; frameNumber != bgExtractionFrameCount; ++frameNumber) {
+		sourceVideo.seekApprox(static_cast<int64_t>((frameNumber + 0.5) * bgExtractionSpacing));
+		if (sourceVideo.readFrame(PIX_FMT_BGR24, frame.data, static_cast<int>(frame.step))) {
+			streamingMedian.add(frame, threadPool);
+		}
+	}
+	if (streamingMedian.getSampleCount() == 0) {
+		throw std::runtime_error("error: could not read any frames for background extraction");
+	}
+	return streamingMedian.getMedian(threadPool);
+}
+
+cv::Mat getBackground(mw::InputVideo& sourceVideo, const std::string& type, size_t threadCount)
+{
+	// get the meta data for the video
+	int sourceWidth = sourceVideo.getFrameWidth();
+	int sourceHeight = sourceVideo.getFrameHeight();
+	double sourceFrameRate = sourceVideo.getFrameRate();
+	unsigned int sourceFrameCount = sourceVideo.getNumberOfFrames();
+	if (!(sourceWidth > 0 && sourceHeight > 0 && sourceFrameRate > 0 && sourceFrameCount > 0)) {
+		throw std::runtime_error("error: video meta data did not pass sanity check");
+	}
+
+	cv::Mat bgMedian;
+	int64_t discardedFrameCount = sourceVideo.getDiscardedFrameCount();
+	if (type == "streaming") {
+		bgMedian = getStreamingMedian(sourceVideo, sourceWidth, sourceHeight, sourceFrameRate, sourceFrameCount, threadCount);
+	} else if (type == "courtship" || type == "moonwalk") {
+		bgMedian = getBufferedMedian(sourceVideo, sourceWidth, sourceHeight, sourceFrameRate, sourceFrameCount);
+	} else {
+		throw std::invalid_argument("unknown background type: " + type);
+	}
+	std::cout << "info: " << sourceVideo.getDiscardedFrameCount() - discardedFrameCount << " frames have been decoded and discarded while seeking for background extraction" << std::endl;
 
 	if (type == "moonwalk") {
 		// median filter every row of every color channel using a 1-by-151 structuring element
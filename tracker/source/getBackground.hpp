@@ -7,6 +7,8 @@
 
 #include "../../mediawrapper/source/mediawrapper.hpp"
 
-cv::Mat getBackground(mw::InputVideo& video, const std::string& type);
+// type "courtship" takes the median of frames held in memory; "moonwalk" additionally median filters the rows of that background
+// type "streaming" estimates the median in a single pass over more frames with memory that doesn't grow with the video length, using threadCount threads
+cv::Mat getBackground(mw::InputVideo& video, const std::string& type, size_t threadCount = 1);
 
 #endif
@@ -1,4 +1,5 @@
 #include "global.hpp"
+#include <cstddef>
 
 namespace global
 {
@@ -6,4 +7,5 @@ namespace global
 	std::string videoFile;
 	std::string settingsFile;
 	std::string outDir;
+	StageTimings* stageTimings = NULL;
 }
@@ -3,12 +3,15 @@
 
 #include <string>
 
+class StageTimings;
+
 namespace global
 {
 	extern std::string executable;
 	extern std::string videoFile;
 	extern std::string settingsFile;
 	extern std::string outDir;
+	extern StageTimings* stageTimings;	// NULL unless the stages are benchmarked
 }
 
 #endif
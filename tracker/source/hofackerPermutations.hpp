@@ -0,0 +1,254 @@
+#ifndef hofackerPermutations_hpp
+#define hofackerPermutations_hpp
+
+/*
+The counterpart of hofacker() for more than 2 flies.
+Instead of a sign, each sequence gets a permutation that says which tracked fly has which identity, and the permutations are chosen to optimize the
+total score of all sequence and occlusion observations. Identities are ordered by size, so identity i is expected to be larger than identity j for i < j;
+with 2 flies, this is the sign of the sequence scores in hofacker().
+There are N! permutations, so instead of keeping the best score for each of them, only the beamWidth best partial solutions are kept after each occlusion,
+and across an occlusion only its most likely assignment and the single swaps of two flies in it are considered.
+With 2 flies, both permutations are always kept, so the result is exact like that of hofacker().
+
+parameters:
+  flyCount: the number of flies N
+  sScores: for each sequence, N * N scores (as logodds); sScores[k][a * N + b] is positive when tracked fly a is larger than tracked fly b, and sScores[k][b * N + a] = -sScores[k][a * N + b]
+  assignments: for the occlusion between sequence k and k + 1, the tracked fly after the occlusion that each tracked fly before it most likely becomes; empty if nothing is known, so the flies keep their identities
+  tScores: for the same occlusions, N * N scores (as logodds); tScores[k][a * N + b] is positive when assignments[k] is more likely than swapping where tracked flies a and b go
+  beamWidth: the number of partial solutions that are kept
+
+returns:
+  vector<vector<size_t> >: for each sequence, the tracked fly that has each identity
+*/
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+
+template<class T>
+struct HofackerPermutationsStep {
+	T score;
+	size_t parent;	// in the step before
+	size_t swapFirst;	// the tracked flies before the occlusion whose targets were swapped; swapFirst == swapSecond if none were
+	size_t swapSecond;
+	std::vector<size_t> identities;	// only kept for the current step
+};
+
+// the score of a sequence for the given identities
+template<class T>
+T hofackerPermutationsScore(const std::vector<T>& sScores, const std::vector<size_t>& identities)
+{
+	const size_t n = identities.size();
+	T score = 0;
+	for (size_t i = 0; i != n; ++i) {
+		for (size_t j = i + 1; j != n; ++j) {
+			score += sScores[identities[i] * n + identities[j]];
+		}
+	}
+	return score;
+}
+
+// how much the score of a sequence changes when the tracked flies of identities i < j are exchanged; only the identities between them matter
+template<class T>
+T hofackerPermutationsSwapDelta(const std::vector<T>& sScores, const std::vector<size_t>& identities, size_t i, size_t j)
+{
+	const size_t n = identities.size();
+	const size_t x = identities[i];
+	const size_t y = identities[j];
+	T delta = sScores[y * n + x] - sScores[x * n + y];
+	for (size_t k = i + 1; k != j; ++k) {
+		const size_t z = identities[k];
+		delta += sScores[y * n + z] - sScores[x * n + z] + sScores[z * n + x] - sScores[z * n + y];
+	}
+	return delta;
+}
+
+// the identities after an occlusion, where the tracked fly with each identity goes according to the assignment, except that the targets of swapFirst and swapSecond are exchanged
+inline void hofackerPermutationsFollow(const std::vector<size_t>& identitiesBefore, const std::vector<size_t>& assignment, size_t swapFirst, size_t swapSecond, std::vector<size_t>& identitiesAfter)
+{
+	identitiesAfter = identitiesBefore;
+	if (assignment.empty()) {
+		return;
+	}
+	for (size_t i = 0; i != identitiesAfter.size(); ++i) {
+		const size_t before = identitiesBefore[i];
+		identitiesAfter[i] = assignment[(before == swapFirst) ? swapSecond : ((before == swapSecond) ? swapFirst : before)];
+	}
+}
+
+// keeps the best of the steps with the same identities, and of those the beamWidth best ones; the order among equal scores is kept
+template<class T>
+void hofackerPermutationsPrune(std::vector<HofackerPermutationsStep<T> >& steps, size_t beamWidth)
+{
+	// sorting the indices instead of the steps saves copying their identities
+	std::vector<std::pair<T, size_t> > order;
+	for (size_t stepNumber = 0; stepNumber != steps.size(); ++stepNumber) {
+		order.push_back(std::make_pair(-steps[stepNumber].score, stepNumber));
+	}
+	std::sort(order.begin(), order.end());
+	std::map<std::vector<size_t>, bool> seen;
+	std::vector<HofackerPermutationsStep<T> > kept;
+	for (size_t orderNumber = 0; orderNumber != order.size() && kept.size() != beamWidth; ++orderNumber) {
+		const HofackerPermutationsStep<T>& step = steps[order[orderNumber].second];
+		if (seen.insert(std::make_pair(step.identities, true)).second) {
+			kept.push_back(step);
+		}
+	}
+	steps.swap(kept);
+}
+
+template<class T>
+std::vector<std::vector<size_t> > hofackerPermutations(size_t flyCount, const std::vector<std::vector<T> >& sScores, const std::vector<std::vector<size_t> >& assignments, const std::vector<std::vector<T> >& tScores, size_t beamWidth = 32)
+{
+	if (sScores.empty()) {
+		return std::vector<std::vector<size_t> >();
+	}
+	if (sScores.size() != assignments.size() + 1 || assignments.size() != tScores.size()) {
+		throw std::domain_error("hofackerPermutations: sScores.size() must be assignments.size() + 1 and tScores.size() + 1");
+	}
+	if (beamWidth == 0) {
+		throw std::domain_error("hofackerPermutations: beamWidth must be positive");
+	}
+	const size_t n = flyCount;
+
+	// the first sequence starts from the flies ordered by how many of the others they are larger than, and any single swap of them;
+	// with up to 5 flies, from any of their permutations
+	std::vector<std::vector<HofackerPermutationsStep<T> > > steps(sScores.size());
+	{
+		std::vector<std::pair<T, size_t> > largerThan;
+		for (size_t a = 0; a != n; ++a) {
+			T sum = 0;
+			for (size_t b = 0; b != n; ++b) {
+				sum += sScores[0][a * n + b];
+			}
+			largerThan.push_back(std::make_pair(-sum, a));
+		}
+		std::sort(largerThan.begin(), largerThan.end());
+		HofackerPermutationsStep<T> first;
+		for (size_t i = 0; i != n; ++i) {
+			first.identities.push_back(largerThan[i].second);
+		}
+		first.score = hofackerPermutationsScore(sScores[0], first.identities);
+		first.parent = 0;
+		first.swapFirst = first.swapSecond = 0;
+		steps[0].push_back(first);
+		if (n <= 5) {
+			std::vector<size_t> order(n);
+			for (size_t i = 0; i != n; ++i) {
+				order[i] = i;
+			}
+			while (std::next_permutation(order.begin(), order.end())) {
+				HofackerPermutationsStep<T> permuted = first;
+				for (size_t i = 0; i != n; ++i) {
+					permuted.identities[i] = first.identities[order[i]];
+				}
+				permuted.score = hofackerPermutationsScore(sScores[0], permuted.identities);
+				steps[0].push_back(permuted);
+			}
+		} else {
+			for (size_t i = 0; i != n; ++i) {
+				for (size_t j = i + 1; j != n; ++j) {
+					HofackerPermutationsStep<T> swapped = first;
+					swapped.score += hofackerPermutationsSwapDelta(sScores[0], first.identities, i, j);
+					std::swap(swapped.identities[i], swapped.identities[j]);
+					steps[0].push_back(swapped);
+				}
+			}
+		}
+		hofackerPermutationsPrune(steps[0], beamWidth);
+	}
+
+	std::vector<size_t> identities;
+	std::vector<size_t> identityOf(n);	// of each tracked fly after the occlusion
+	std::vector<std::pair<T, std::pair<size_t, size_t> > > swaps;
+	std::vector<HofackerPermutationsStep<T> > candidates;
+	std::vector<std::pair<T, size_t> > order;
+	for (size_t occlusionNumber = 0; occlusionNumber != assignments.size(); ++occlusionNumber) {
+		const std::vector<size_t>& assignment = assignments[occlusionNumber];
+		const std::vector<T>& s = sScores[occlusionNumber + 1];
+		const std::vector<T>& t = tScores[occlusionNumber];
+
+		// only the N swaps that are most likely instead of the assignment are tried; the others would be between flies that didn't come close
+		swaps.clear();
+		if (!assignment.empty()) {
+			for (size_t a = 0; a != n; ++a) {
+				for (size_t b = a + 1; b != n; ++b) {
+					swaps.push_back(std::make_pair(t[a * n + b], std::make_pair(a, b)));
+				}
+			}
+			std::sort(swaps.begin(), swaps.end());
+			swaps.resize(std::min(swaps.size(), n));
+		}
+
+		// the candidates only get their identities once they are among the best, which saves copying them for all others
+		const std::vector<HofackerPermutationsStep<T> >& previousSteps = steps[occlusionNumber];
+		candidates.clear();
+		for (size_t parent = 0; parent != previousSteps.size(); ++parent) {
+			hofackerPermutationsFollow(previousSteps[parent].identities, assignment, 0, 0, identities);
+			HofackerPermutationsStep<T> kept;
+			kept.score = previousSteps[parent].score + hofackerPermutationsScore(s, identities);
+			kept.parent = parent;
+			kept.swapFirst = kept.swapSecond = 0;
+			candidates.push_back(kept);
+			if (swaps.empty()) {
+				continue;
+			}
+
+			for (size_t i = 0; i != n; ++i) {
+				identityOf[identities[i]] = i;
+			}
+			for (size_t swapNumber = 0; swapNumber != swaps.size(); ++swapNumber) {
+				// swapping where a and b go exchanges the tracked flies of their identities after the occlusion
+				const size_t a = swaps[swapNumber].second.first;
+				const size_t b = swaps[swapNumber].second.second;
+				const size_t i = std::min(identityOf[assignment[a]], identityOf[assignment[b]]);
+				const size_t j = std::max(identityOf[assignment[a]], identityOf[assignment[b]]);
+				HofackerPermutationsStep<T> swapped = kept;
+				swapped.score += hofackerPermutationsSwapDelta(s, identities, i, j) - 2 * swaps[swapNumber].first;
+				swapped.swapFirst = a;
+				swapped.swapSecond = b;
+				candidates.push_back(swapped);
+			}
+		}
+
+		order.clear();
+		for (size_t candidateNumber = 0; candidateNumber != candidates.size(); ++candidateNumber) {
+			order.push_back(std::make_pair(-candidates[candidateNumber].score, candidateNumber));
+		}
+		std::sort(order.begin(), order.end());
+		std::map<std::vector<size_t>, bool> seen;
+		std::vector<HofackerPermutationsStep<T> >& nextSteps = steps[occlusionNumber + 1];
+		for (size_t orderNumber = 0; orderNumber != order.size() && nextSteps.size() != beamWidth; ++orderNumber) {
+			const HofackerPermutationsStep<T>& candidate = candidates[order[orderNumber].second];
+			hofackerPermutationsFollow(previousSteps[candidate.parent].identities, assignment, candidate.swapFirst, candidate.swapSecond, identities);
+			if (seen.insert(std::make_pair(identities, true)).second) {
+				nextSteps.push_back(candidate);
+				nextSteps.back().identities = identities;
+			}
+		}
+
+		// only the first step needs its identities for rebuilding the solution
+		if (occlusionNumber != 0) {
+			for (size_t stepNumber = 0; stepNumber != steps[occlusionNumber].size(); ++stepNumber) {
+				std::vector<size_t>().swap(steps[occlusionNumber][stepNumber].identities);
+			}
+		}
+	}
+
+	// follow the best solution back to the first sequence, and then forward again to rebuild the identities of each sequence
+	std::vector<size_t> chosen(sScores.size());
+	chosen.back() = 0;	// the steps are sorted
+	for (size_t sequenceNumber = sScores.size() - 1; sequenceNumber != 0; --sequenceNumber) {
+		chosen[sequenceNumber - 1] = steps[sequenceNumber][chosen[sequenceNumber]].parent;
+	}
+	std::vector<std::vector<size_t> > ret(sScores.size());
+	ret[0] = steps[0][chosen[0]].identities;
+	for (size_t occlusionNumber = 0; occlusionNumber != assignments.size(); ++occlusionNumber) {
+		const HofackerPermutationsStep<T>& step = steps[occlusionNumber + 1][chosen[occlusionNumber + 1]];
+		hofackerPermutationsFollow(ret[occlusionNumber], assignments[occlusionNumber], step.swapFirst, step.swapSecond, ret[occlusionNumber + 1]);
+	}
+	return ret;
+}
+
+#endif
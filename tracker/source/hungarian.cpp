@@ -2,11 +2,118 @@
 #include <limits>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
 #include <cmath>
+#include <cassert>
+
+HungarianWorkspace::HungarianWorkspace() :
+	rowPotentials(),
+	columnPotentials(),
+	minSlacks(),
+	columnToRow(),
+	previousColumns(),
+	visited()
+{
+}
+
+bool isFinite(float value)
+{
+	return value == value && std::abs(value) <= std::numeric_limits<float>::max();
+}
+
+void HungarianWorkspace::solve(const float* costs, size_t size, std::vector<size_t>& rowToColumn)
+{
+	const double infinity = std::numeric_limits<double>::infinity();
+
+	// costs that are not finite (e.g. from NaN positions) are replaced by a cost that is higher than the difference between any two sums of finite costs
+	double largestCost = 0;
+	bool allFinite = true;
+	for (size_t i = 0; i != size * size; ++i) {
+		if (isFinite(costs[i])) {
+			largestCost = std::max<double>(largestCost, std::abs(costs[i]));
+		} else {
+			allFinite = false;
+		}
+	}
+	const double replacementCost = 2 * (size + 1) * (largestCost + 1);
+
+	rowPotentials.assign(size + 1, 0);
+	columnPotentials.assign(size + 1, 0);
+	columnToRow.assign(size + 1, 0);
+	previousColumns.assign(size + 1, 0);
+	minSlacks.resize(size + 1);
+	visited.resize(size + 1);
+
+	for (size_t row = 1; row <= size; ++row) {
+		// grow a tree of tight edges from the new row until it reaches an unassigned column
+		columnToRow[0] = row;
+		size_t column = 0;
+		std::fill(minSlacks.begin(), minSlacks.end(), infinity);
+		std::fill(visited.begin(), visited.end(), 0);
+		do {
+			visited[column] = 1;
+			const size_t pathRow = columnToRow[column];
+			const float* pathRowCosts = costs + (pathRow - 1) * size;
+			double delta = infinity;
+			size_t nextColumn = 0;
+			for (size_t otherColumn = 1; otherColumn <= size; ++otherColumn) {
+				if (!visited[otherColumn]) {
+					const float cost = pathRowCosts[otherColumn - 1];
+					const double slack = (allFinite || isFinite(cost) ? cost : replacementCost) - rowPotentials[pathRow] - columnPotentials[otherColumn];
+					if (slack < minSlacks[otherColumn]) {
+						minSlacks[otherColumn] = slack;
+						previousColumns[otherColumn] = column;
+					}
+					if (minSlacks[otherColumn] < delta) {
+						delta = minSlacks[otherColumn];
+						nextColumn = otherColumn;
+					}
+				}
+			}
+			assert(nextColumn != 0);
+			for (size_t otherColumn = 0; otherColumn <= size; ++otherColumn) {
+				if (visited[otherColumn]) {
+					rowPotentials[columnToRow[otherColumn]] += delta;
+					columnPotentials[otherColumn] -= delta;
+				} else {
+					minSlacks[otherColumn] -= delta;
+				}
+			}
+			column = nextColumn;
+		} while (columnToRow[column] != 0);
+
+		// flip the assignments along the path
+		do {
+			const size_t previousColumn = previousColumns[column];
+			columnToRow[column] = columnToRow[previousColumn];
+			column = previousColumn;
+		} while (column != 0);
+	}
+
+	rowToColumn.resize(size);
+	for (size_t column = 1; column <= size; ++column) {
+		rowToColumn[columnToRow[column] - 1] = column - 1;
+	}
+}
+
+void hungarian(const cv::Mat& costs, HungarianWorkspace& workspace, std::vector<size_t>& rowToColumn)
+{
+	if (costs.rows != costs.cols || costs.type() != CV_32F || !costs.isContinuous()) {
+		throw std::invalid_argument("hungarian: costs has to be a continuous square array of floats");
+	}
+	workspace.solve(costs.ptr<float>(), costs.rows, rowToColumn);
+}
 
 std::vector<size_t> hungarian(const cv::Mat& costs)
 {
-	//TODO: implement the actual hungarian algorithm...for now we're cheating using an exhaustive search, which may be faster for small N
+	HungarianWorkspace workspace;
+	std::vector<size_t> rowToColumn;
+	hungarian(costs, workspace, rowToColumn);
+	return rowToColumn;
+}
+
+std::vector<size_t> exhaustiveAssignment(const cv::Mat& costs)
+{
 	assert(costs.rows == costs.cols && costs.type() == CV_32F);
 	std::vector<size_t> indirection(costs.rows);
 	for (int i = 0; i != indirection.size(); ++i) {
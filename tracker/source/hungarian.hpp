@@ -1,8 +1,36 @@
 #ifndef hungarian_hpp
 #define hungarian_hpp
 
+/*
+hungarian() assigns each row of a square matrix of costs to a different column so that the sum of the costs is minimal.
+It adds one row after the other, each time following the shortest augmenting path with respect to the dual potentials of the rows and columns,
+which takes O(N^3) time for N rows.
+A HungarianWorkspace keeps all buffers between calls, so solving many problems of the same size, e.g. one per frame, doesn't allocate memory.
+Costs that are not finite count as higher than any finite ones, so the assignment avoids as many of them as possible.
+*/
+
 #include "opencv2/core/core.hpp"
+#include <vector>
+
+class HungarianWorkspace {
+public:
+	HungarianWorkspace();
+
+	// costs points to size * size floats, row by row; rowToColumn[row] is set to the column assigned to row
+	void solve(const float* costs, size_t size, std::vector<size_t>& rowToColumn);
+
+private:
+	// all indexed by column + 1, with column 0 standing for the row that is being added
+	std::vector<double> rowPotentials;	// indexed by row + 1
+	std::vector<double> columnPotentials;
+	std::vector<double> minSlacks;	// the smallest reduced cost from a row on the current path to the column
+	std::vector<size_t> columnToRow;	// the row + 1 assigned to the column, or 0
+	std::vector<size_t> previousColumns;	// the column before the column on the current path
+	std::vector<char> visited;
+};
 
 std::vector<size_t> hungarian(const cv::Mat& costs);	// costs has to be a square array of floats
+void hungarian(const cv::Mat& costs, HungarianWorkspace& workspace, std::vector<size_t>& rowToColumn);	// same as above, but doesn't allocate once workspace and rowToColumn have been used for this size
+std::vector<size_t> exhaustiveAssignment(const cv::Mat& costs);	// tries all N! assignments; only for checking hungarian()
 
 #endif
@@ -6,9 +6,14 @@
 #include <set>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
 #include "global.hpp"
 #include "../../common/source/Stopwatch.hpp"
+#include "../../common/source/StageTimings.hpp"
+#include "../../common/source/allocationCount.hpp"
 #include "Fly.hpp"
 #include "getBackground.hpp"
 #include "getBodyThreshold.hpp"
@@ -22,6 +27,103 @@
 #include "../../mediawrapper/source/mediawrapper.hpp"
 #include "../../mediawrapper/source/VideoFrame.hpp"
 #include "../../common/source/debug.hpp"
+#include "../../common/source/ThreadPool.hpp"
+#include "FrameRing.hpp"
+#include "FrameDecoder.hpp"
+#include "benchmarks.hpp"
+
+// calls Arena::track for one arena of the current frame; used to distribute the arenas across the threads of a ThreadPool
+// the frame is shared read-only and every arena only writes to its own element of arenaContours and to its own files
+struct ArenaTrackingTask {
+	std::vector<Arena>* arenas;
+	const cv::Mat* frame;
+	std::vector<cv::Mat>* arenaContours;
+	size_t videoFrameNumber;
+	size_t videoFrameTotalCount;
+	size_t trackFrameTotalCount;
+	float thresholdOffset;
+	float minFlyBodySize;
+	float maxFlyBodySize;
+	bool gradientCorrection;
+	bool fullyMergeMissegmentations;
+	bool splitBodies;
+	bool splitWings;
+	bool saveContours;
+	bool saveHistograms;
+	bool incrementalWaveRemoval;
+	bool streamAttributes;
+
+	void operator()(size_t arenaNumber) const
+	{
+		(*arenas)[arenaNumber].track(*frame, videoFrameNumber, videoFrameTotalCount, trackFrameTotalCount, (*arenaContours)[arenaNumber], thresholdOffset, minFlyBodySize, maxFlyBodySize, gradientCorrection, fullyMergeMissegmentations, splitBodies, splitWings, saveContours, saveHistograms, incrementalWaveRemoval, streamAttributes);
+	}
+};
+
+// writes the stage timings as profile.json into the directory of each arena, leaving out the stages of the other arenas
+// jobs tracking single arenas of the same video share the output directory, so profile.json goes there only if there are no arenas
+// additionally writes all stages to benchmarkJson and the trace to profileTrace, if they are given
+void writeStageTimings(const std::vector<Arena>& arenas, const std::string& benchmarkJson, const std::string& profileTrace)
+{
+	if (!global::stageTimings) {
+		return;
+	}
+	std::vector<std::pair<std::string, std::vector<std::string> > > profiles;	// file name and excluded scopes
+	for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+		std::vector<std::string> otherArenas;
+		for (size_t otherNumber = 0; otherNumber != arenas.size(); ++otherNumber) {
+			if (otherNumber != arenaNumber) {
+				otherArenas.push_back("arena " + arenas[otherNumber].getId());
+			}
+		}
+		profiles.push_back(std::make_pair(global::outDir + "/" + arenas[arenaNumber].getId() + "/profile.json", otherArenas));
+	}
+	if (arenas.empty()) {
+		profiles.push_back(std::make_pair(global::outDir + "/profile.json", std::vector<std::string>()));
+	}
+	if (!benchmarkJson.empty()) {
+		profiles.push_back(std::make_pair(benchmarkJson, std::vector<std::string>()));
+	}
+	for (size_t profileNumber = 0; profileNumber != profiles.size(); ++profileNumber) {
+		std::ofstream file(profiles[profileNumber].first.c_str());
+		global::stageTimings->writeJson(file, profiles[profileNumber].second);
+		if (!file) {
+			std::cerr << "warning: could not write the stage timings to \"" << profiles[profileNumber].first << "\"" << std::endl;
+		}
+	}
+	if (!profileTrace.empty()) {
+		std::ofstream file(profileTrace.c_str());
+		global::stageTimings->writeChromeTrace(file);
+		if (!file) {
+			std::cerr << "warning: could not write the trace to \"" << profileTrace << "\"" << std::endl;
+		}
+	}
+}
+
+// describes everything a checkpoint depends on besides the video, so that we don't resume from one tracked with other settings
+std::string getCheckpointFingerprint(size_t frameBegin, size_t frameEnd)
+{
+	std::ifstream settingsFile(global::settingsFile.c_str(), std::ios::in | std::ios::binary);
+	std::string settings((std::istreambuf_iterator<char>(settingsFile)), std::istreambuf_iterator<char>());	// extra parentheses are required: "most vexing parse"
+	return "frames " + stringify(frameBegin) + " " + stringify(frameEnd) + "\n" + settings;
+}
+
+// the shard_<first frame> directories that -shard wrote into the directory of an arena, in the order of their frames
+std::vector<std::string> getShardDirectories(const std::string& arenaDirectory)
+{
+	std::vector<std::pair<size_t, std::string> > shards;
+	std::vector<std::string> entries = ls(arenaDirectory);
+	for (std::vector<std::string>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter) {
+		if (iter->compare(0, 6, "shard_") == 0 && isDirectory(arenaDirectory + "/" + *iter)) {
+			shards.push_back(std::make_pair(static_cast<size_t>(std::strtoul(iter->c_str() + 6, NULL, 10)), arenaDirectory + "/" + *iter));
+		}
+	}
+	std::sort(shards.begin(), shards.end());
+	std::vector<std::string> ret;
+	for (size_t shardNumber = 0; shardNumber != shards.size(); ++shardNumber) {
+		ret.push_back(shards[shardNumber].second);
+	}
+	return ret;
+}
 
 int main(int argc, char* const argv[])
 {
@@ -43,13 +145,47 @@ int main(int argc, char* const argv[])
 		bool preprocess; commandLine.add("preprocess", preprocess);
 		bool track; commandLine.add("track", track);
 		bool postprocess; commandLine.add("postprocess", postprocess);
+		unsigned int threadCount = 1; commandLine.add("threads", threadCount);	// 0 means one thread per core
+		unsigned int bufferedFrames = 4; commandLine.add("buffer", bufferedFrames);	// how many frames decoding may run ahead of tracking
+		std::string backgroundType("courtship"); commandLine.add("background", backgroundType);	// "courtship", "moonwalk" or "streaming"
+		bool benchmarkBackground = false; commandLine.add("benchmarkBackground", benchmarkBackground);
+		unsigned int benchmarkDecoding = 0; commandLine.add("benchmarkDecoding", benchmarkDecoding);	// decode with 1..N threads and report the frame rates
+		bool incrementalWaveRemoval = false; commandLine.add("incrementalWaveRemoval", incrementalWaveRemoval);	// update the row medians of each arena from the previous frame instead of counting them anew
+		bool streamAttributes = false; commandLine.add("streamAttributes", streamAttributes);	// move each tracked frame into the attributes as soon as no later frame can change it, so memory doesn't grow with the number of tracked frames kept around
+		float checkpointInterval = 0; commandLine.add("checkpointInterval", checkpointInterval);	// write a checkpoint of every arena after each N seconds of video tracked; implies streamAttributes
+		bool resume = false; commandLine.add("resume", resume);	// continue tracking from the latest checkpoint all arenas have, if there is one
+		bool shard = false; commandLine.add("shard", shard);	// only track the frames from begin to end, into shard_<first frame> in the directory of each arena, for -merge to put together
+		bool merge = false; commandLine.add("merge", merge);	// instead of tracking, merge the shards of each arena and postprocess them as one
+		bool trackTsv = false; commandLine.add("trackTsv", trackTsv);	// also export the track as a transposed table, track.tsv, next to the binary track.bin
+		unsigned int benchmarkSegmentation = 0; commandLine.add("benchmarkSegmentation", benchmarkSegmentation);	// run the segmentation kernels N times on the first frame
+		unsigned int benchmarkReconstruct = 0; commandLine.add("benchmarkReconstruct", benchmarkReconstruct);	// compare both reconstructions on N random images
+		unsigned int benchmarkOrdfilt = 0; commandLine.add("benchmarkOrdfilt", benchmarkOrdfilt);	// compare the sliding and the nth_element order filters on random signals of N frames
+		std::string benchmarkJson; commandLine.add("benchmarkJson", benchmarkJson);	// also write the timings of the stages of all arenas to this file, e.g. to compare builds with test/benchCompare.pl
+		std::string profileTrace; commandLine.add("profileTrace", profileTrace);	// write every timed call to this file in the Chrome trace event format
+		unsigned int benchmarkHungarian = 0; commandLine.add("benchmarkHungarian", benchmarkHungarian);	// solve N random identity assignments for 2 to 32 flies and compare with the exhaustive search where that is feasible
 		commandLine.importProgramArguments(argc, argv);
+		if (threadCount == 0) {
+			threadCount = ThreadPool::getHardwareConcurrency();
+		}
+		if (checkpointInterval > 0) {
+			streamAttributes = true;	// otherwise every checkpoint would have to hold all frames tracked so far
+		}
+		StageTimings stageTimings;
+		global::stageTimings = &stageTimings;
+		stageTimings.setInfo("video", global::videoFile);
+		stageTimings.setInfo("threads", stringify(threadCount));
+		stageTimings.setInfo("countsAllocations", countsAllocations() ? "true" : "false");
+		if (!profileTrace.empty()) {
+			stageTimings.enableTrace();
+		}
 
 		Settings trackerSettings;
 		bool attachDebugger; trackerSettings.add("debug", attachDebugger);
 		bool visualize; trackerSettings.add("visualize", visualize);
 		bool saveContours; trackerSettings.add("contours", saveContours);
 		bool saveHistograms; trackerSettings.add("histograms", saveHistograms);
+		int decoding_threadCount = 1; trackerSettings.add("decoding_threadCount", decoding_threadCount);	// 0 means one thread per core
+		int decoding_threadType = mw::VideoCodec::frameThreading; trackerSettings.add("decoding_threadType", decoding_threadType);
 
 		int shape = CIRCLE; trackerSettings.add("shape", shape);
 		int interior = EITHER; trackerSettings.add("interior", interior);
@@ -160,7 +296,7 @@ int main(int argc, char* const argv[])
 */
 		} catch (...) {
 			//TODO: fix usage
-			std::cerr << "usage: " << global::executable << " -in \"C:/path/to/input video file.MTS\" -out \"C:/path/to/output directory/\" [-preprocess] [-track] [-postprocess] [-visualize] [-arena N] [-settings file]" << std::endl;
+			std::cerr << "usage: " << global::executable << " -in \"C:/path/to/input video file.MTS\" -out \"C:/path/to/output directory/\" [-preprocess] [-track] [-postprocess] [-visualize] [-arena N] [-threads N] [-buffer N] [-background courtship|moonwalk|streaming] [-incrementalWaveRemoval] [-streamAttributes] [-checkpointInterval seconds] [-resume] [-shard] [-merge] [-trackTsv] [-benchmarkBackground] [-benchmarkDecoding N] [-benchmarkSegmentation N] [-benchmarkReconstruct N] [-benchmarkOrdfilt N] [-benchmarkHungarian N] [-benchmarkJson file] [-profileTrace file] [-settings file]" << std::endl;
 			return 1;
 		}
 
@@ -168,7 +304,8 @@ int main(int argc, char* const argv[])
 
 		// load the source video
 		mw::initialize();
-		mw::InputVideo sourceVideo(global::videoFile);
+		mw::VideoCodec::threadType decodingThreadType = (decoding_threadType == mw::VideoCodec::sliceThreading) ? mw::VideoCodec::sliceThreading : mw::VideoCodec::frameThreading;
+		mw::InputVideo sourceVideo(global::videoFile, decoding_threadCount, decodingThreadType);
 
 		// get the meta data for the video
 		int sourceWidth = sourceVideo.getFrameWidth();
@@ -179,18 +316,54 @@ int main(int argc, char* const argv[])
 			std::cerr << "error: video meta data did not pass sanity check" << std::endl;
 			return -1;
 		}
-		std::cout << "info: resolution " << sourceWidth << "x" << sourceHeight << ", fps " << sourceFrameRate << ", frames " << sourceFrameCount << std::endl;
+		std::cout << "info: resolution " << sourceWidth << "x" << sourceHeight << ", fps " << sourceFrameRate << ", frames " << sourceFrameCount << ", decoding threads " << sourceVideo.getVideoCodec()->getThreadCount() << (sourceVideo.getVideoCodec()->usesFrameThreading() ? " (frames)" : "") << std::endl;
+
+		if (benchmarkBackground) {
+			return runBackgroundBenchmark(sourceVideo, threadCount, imageFormat);
+		}
 
 		// determine the range of frames to be processed
 		size_t frameBegin = static_cast<size_t>(sourceFrameRate * timeBegin);
 		size_t frameEnd = std::min(sourceFrameCount, static_cast<size_t>(sourceFrameRate * timeEnd));
+
+		if (benchmarkDecoding != 0) {
+			return runDecodingBenchmark(sourceVideo, frameBegin, frameEnd, benchmarkDecoding, decodingThreadType);
+		}
+
+		if (benchmarkSegmentation != 0) {
+			return runSegmentationBenchmark(sourceVideo, frameBegin, benchmarkSegmentation);
+		}
+
+		if (benchmarkReconstruct != 0) {
+			return runReconstructBenchmark(sourceWidth, sourceHeight, benchmarkReconstruct);
+		}
+
+		if (benchmarkOrdfilt != 0) {
+			// the filters of the derive* functions of Arena
+			const OrdfiltBenchmarkFilter filters[] = {
+				{"copulating", copulating_medianFilterWidth, copulating_persistence},
+				{"orienting", orienting_medianFilterWidth, orienting_persistence},
+				{"rayEllipseOrienting", rayEllipseOrienting_medianFilterWidth, rayEllipseOrienting_persistence},
+				{"following", following_medianFilterWidth, following_persistence},
+				{"circling", circling_medianFilterWidth, circling_persistence},
+				{"wingExt", wingExtension_angleMedianFilterWidth, wingExtension_persistence}
+			};
+			return runOrdfiltBenchmark(std::vector<OrdfiltBenchmarkFilter>(filters, filters + sizeof(filters) / sizeof(filters[0])), sourceFrameRate, sourceWidth, sourceHeight, benchmarkOrdfilt);
+		}
+
+		if (benchmarkHungarian != 0) {
+			return runHungarianBenchmark(sourceWidth, sourceHeight, benchmarkHungarian);
+		}
 		
 		// preprocessing: either generate or load bgMedian and arenas
 		cv::Mat bgMedian;
 		std::vector<Arena> arenas;
 		if (preprocess) {
 			// get the background
-			bgMedian = getBackground(sourceVideo, "courtship");	//TODO: pass frameBegin and frameEnd to take only that range into account when generating the background?
+			StageScope preprocessScope(global::stageTimings, "preprocess");
+			StageTimer timer(global::stageTimings);
+			bgMedian = getBackground(sourceVideo, backgroundType, threadCount);	//TODO: pass frameBegin and frameEnd to take only that range into account when generating the background?
+			timer.lap("getBackground");
 			if (visualize) {
 				cv::namedWindow("bgMedian", CV_WINDOW_AUTOSIZE);
 				cv::imshow("bgMedian", bgMedian);
@@ -199,7 +372,9 @@ int main(int argc, char* const argv[])
 			cv::imwrite(global::outDir + "/background" + imageFormat, bgMedian);
 
 			// find the arenas and pick only the selected ones
+			timer.lap("writeBackground");
 			std::vector<Arena> arenasFound = findArenas(bgMedian, (Shape)shape, sourceFrameRate, fliesPerArena, diameter, arenaBorderSize, (Interior)interior);	//TODO: check range of shape and interior
+			timer.lap("findArenas");
 			if (processArenaSubsetOnly) {
 				for (std::vector<Arena>::const_iterator iter = arenasFound.begin(); iter != arenasFound.end(); ++iter) {
 					if (arenasToProcess.find(iter->getId()) != arenasToProcess.end()) {
@@ -281,64 +456,196 @@ int main(int argc, char* const argv[])
 		}
 
 		if (preprocess && !track) {
+			writeStageTimings(arenas, benchmarkJson, profileTrace);
 			return 0;
 		}
 
 		// tracking: either generate or load normalized tracking data (frameAttributes, flyAttributes and occlusionMap) per arena
 		if (track) {
-			Stopwatch stopwatch;
-			stopwatch.start();
-			cv::Mat frame(cv::Size(sourceWidth, sourceHeight), CV_8UC3);
-			cv::Mat visualizedContours(frame.size(), frame.type());
-			for (unsigned int frameNumber = frameBegin; frameNumber != frameEnd && cv::waitKey(30) < 0; ++frameNumber) {
-				if (!sourceVideo.seek(frameNumber)) {
-					break;
+			StageScope trackingScope(global::stageTimings, "tracking");
+			size_t trackingThreadCount = std::min<size_t>(threadCount, std::max<size_t>(arenas.size(), 1));	// more threads than arenas would idle
+			std::cout << "info: tracking " << arenas.size() << " arenas using " << trackingThreadCount << " thread(s)" << std::endl;
+			ThreadPool threadPool(trackingThreadCount);
+
+			// decoding runs on its own thread and fills the ring while the arenas of the previous frames are tracked
+			FrameRing frameRing(std::max(bufferedFrames, 1u), cv::Size(sourceWidth, sourceHeight), CV_8UC3);
+			cv::Mat visualizedContours(cv::Size(sourceWidth, sourceHeight), CV_8UC3);
+			std::vector<cv::Mat> arenaContours(arenas.size());	// the bounding boxes of arenas can overlap, so they are drawn separately and copied into visualizedContours after tracking
+
+			ArenaTrackingTask trackingTask;
+			trackingTask.arenas = &arenas;
+			trackingTask.arenaContours = &arenaContours;
+			trackingTask.videoFrameTotalCount = sourceFrameCount;
+			trackingTask.trackFrameTotalCount = frameEnd - frameBegin;
+			trackingTask.thresholdOffset = segmentation_thresholdOffset;
+			trackingTask.minFlyBodySize = segmentation_minFlyBodySize;
+			trackingTask.maxFlyBodySize = segmentation_maxFlyBodySize;
+			trackingTask.gradientCorrection = segmentation_gradientCorrection;
+			trackingTask.fullyMergeMissegmentations = fullyMergeMissegmentations;
+			trackingTask.splitBodies = splitBodies;
+			trackingTask.splitWings = splitWings;
+			trackingTask.saveContours = saveContours;
+			trackingTask.saveHistograms = saveHistograms;
+			trackingTask.incrementalWaveRemoval = incrementalWaveRemoval;
+			trackingTask.streamAttributes = streamAttributes;
+
+			if (shard) {
+				for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+					std::string shardDirectory(global::outDir + "/" + arenas[arenaNumber].getId() + "/shard_" + stringify(frameBegin));
+					makeDirectory(shardDirectory);
+					arenas[arenaNumber].setTrackingDirectory(shardDirectory);
 				}
-				if (unsigned char* frameData = sourceVideo.getFrameBuffer(PIX_FMT_BGR24)) {
-					std::copy(frameData, frameData + sourceWidth * sourceHeight * 3, frame.datastart);
-				}
-				//cvtColor(frame, frame, CV_RGB2BGR);	// OpenCV functions like imshow expect BGR
+			}
 
-				visualizedContours = frame.clone();
-				for (unsigned int arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
-					arenas[arenaNumber].track(frame, frameNumber, sourceFrameCount, frameEnd - frameBegin, visualizedContours, segmentation_thresholdOffset, segmentation_minFlyBodySize, segmentation_maxFlyBodySize, segmentation_gradientCorrection, fullyMergeMissegmentations, splitBodies, splitWings, saveContours, saveHistograms);
+			// resume from the latest checkpoint that all arenas have
+			const std::string checkpointFingerprint = getCheckpointFingerprint(frameBegin, frameEnd);
+			size_t nextFrame = frameBegin;
+			if (resume && !arenas.empty()) {
+				std::vector<size_t> commonFrames = arenas[0].getCheckpointFrames(checkpointFingerprint);
+				for (size_t arenaNumber = 1; arenaNumber != arenas.size(); ++arenaNumber) {
+					std::vector<size_t> arenaFrames = arenas[arenaNumber].getCheckpointFrames(checkpointFingerprint);
+					std::vector<size_t> stillCommon;
+					for (std::vector<size_t>::const_iterator iter = commonFrames.begin(); iter != commonFrames.end(); ++iter) {
+						if (std::find(arenaFrames.begin(), arenaFrames.end(), *iter) != arenaFrames.end()) {
+							stillCommon.push_back(*iter);
+						}
+					}
+					commonFrames.swap(stillCommon);
 				}
-				if (visualize) {
-					imshow("tracking", visualizedContours);
+				if (commonFrames.empty()) {
+					std::cout << "info: there is no checkpoint to resume from, tracking from the beginning" << std::endl;
+				} else {
+					nextFrame = *std::max_element(commonFrames.begin(), commonFrames.end());
+					std::cout << "info: resuming from the checkpoint at frame " << nextFrame << std::endl;
+					for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+						arenas[arenaNumber].resumeFromCheckpoint(nextFrame, checkpointFingerprint);
+					}
 				}
+			}
+			const size_t checkpointFrames = static_cast<size_t>(checkpointInterval * sourceFrameRate + 0.5f);
+			{
+				FrameDecoder frameDecoder(sourceVideo, frameRing, nextFrame, frameEnd);
+				Stopwatch stopwatch;
+				stopwatch.start();
+				StageTimer timer(global::stageTimings);
+				size_t frameNumber;
+				while (cv::waitKey(30) < 0) {
+					const cv::Mat* frame = frameRing.beginRead(frameNumber);
+					if (!frame) {
+						break;
+					}
+					timer.lap("waitForFrame");	// the arenas time their own work as "tracking/arena <id>/frame"
+					//cvtColor(frame, frame, CV_RGB2BGR);	// OpenCV functions like imshow expect BGR
+
+					trackingTask.frame = frame;
+					trackingTask.videoFrameNumber = frameNumber;
+					threadPool.run(trackingTask, arenas.size());
+					if (visualize) {
+						frame->copyTo(visualizedContours);
+						for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+							cv::Mat arenaPart(visualizedContours, arenas[arenaNumber].getBoundingBox());
+							arenaContours[arenaNumber].copyTo(arenaPart);
+						}
+					}
+					frameRing.endRead();
+					timer.lap("trackArenas");
+					nextFrame = frameNumber + 1;
+					if (checkpointFrames != 0 && (nextFrame - frameBegin) % checkpointFrames == 0) {
+						for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+							arenas[arenaNumber].writeCheckpoint(nextFrame, checkpointFingerprint);
+						}
+						timer.lap("checkpoint", arenas.size());
+					}
+					if (visualize) {
+						imshow("tracking", visualizedContours);
+					}
 
-				if (frameNumber % static_cast<int>(sourceFrameRate) == 0) {
-					stopwatch.stop();
-					std::cout << "@frame " << frameNumber << ": ";
-					std::cout << "1 second of video data processed in " << stopwatch.read() << " seconds" << std::endl;
-					stopwatch.set();
-					stopwatch.start();
+					if (frameNumber % static_cast<int>(sourceFrameRate) == 0) {
+						stopwatch.stop();
+						std::cout << "@frame " << frameNumber << ": ";
+						std::cout << "1 second of video data processed in " << stopwatch.read() << " seconds";
+						std::cout << " (decoding waited " << frameRing.takeWriteWaitTime() << " s for free buffers, tracking waited " << frameRing.takeReadWaitTime() << " s for decoded frames)" << std::endl;
+						stopwatch.set();
+						stopwatch.start();
+					}
+				}
+			}	// stops and joins the decoder
+			std::cout << "info: " << sourceVideo.getDiscardedFrameCount() << " frames have been decoded and discarded while seeking with " << sourceVideo.getKeyFrameCount() << " indexed keyframes" << std::endl;
+			if (!frameRing.getError().empty()) {
+				throw std::runtime_error("decoding failed: " + frameRing.getError());
+			}
+			if (checkpointFrames != 0) {
+				// lets a job that is killed during postprocessing skip tracking when it's resumed
+				for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+					arenas[arenaNumber].writeCheckpoint(nextFrame, checkpointFingerprint);
 				}
 			}
 
+			StageTimer timer(global::stageTimings);
 			for (unsigned int arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
 				arenas[arenaNumber].normalizeTrackingData();
+				timer.lap("arena " + arenas[arenaNumber].getId() + "/normalizeTrackingData", arenas[arenaNumber].getFrameCount());
+			}
+
+			if (shard) {
+				// postprocessing needs the whole video, so it waits for -merge
+				for (unsigned int arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+					arenas[arenaNumber].exportShard(global::outDir + "/" + arenas[arenaNumber].getId() + "/shard_" + stringify(frameBegin) + "/track.bin");
+					// exportShard throws if the shard couldn't be written, so the checkpoint is only removed once the shard is complete
+					arenas[arenaNumber].removeCheckpoints();
+					timer.lap("arena " + arenas[arenaNumber].getId() + "/exportShard");
+				}
+				trackingScope.end();
+				writeStageTimings(arenas, benchmarkJson, profileTrace);
+				return 0;
+			}
+		} else if (merge) {
+			StageScope mergeScope(global::stageTimings, "merge");
+			StageTimer timer(global::stageTimings);
+			for (unsigned int arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
+				const std::vector<std::string> shardDirectories = getShardDirectories(global::outDir + "/" + arenas[arenaNumber].getId());
+				if (shardDirectories.empty()) {
+					std::cerr << "warning: arena " << arenas[arenaNumber].getId() << " has no shards to merge" << std::endl;
+				}
+				arenas[arenaNumber].mergeShards(shardDirectories);
+				timer.lap("arena " + arenas[arenaNumber].getId(), arenas[arenaNumber].getFrameCount());
 			}
 		} else {
+			StageScope importScope(global::stageTimings, "import");
+			StageTimer timer(global::stageTimings);
 			for (unsigned int arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
-				std::string trackFileName(global::outDir + "/" + arenas[arenaNumber].getId() + "/track.tsv");
-				std::ifstream trackFile(trackFileName.c_str());
-				arenas[arenaNumber].importTrackingData(trackFile);
+				std::string trackFileName(global::outDir + "/" + arenas[arenaNumber].getId() + "/track.bin");
+				if (isFile(trackFileName)) {
+					arenas[arenaNumber].importTrackFile(trackFileName);
+				} else {
+					// output of older versions
+					std::string tsvFileName(global::outDir + "/" + arenas[arenaNumber].getId() + "/track.tsv");
+					std::ifstream tsvFile(tsvFileName.c_str());
+					arenas[arenaNumber].importTrackingData(tsvFile);
+				}
+				timer.lap("arena " + arenas[arenaNumber].getId(), arenas[arenaNumber].getFrameCount());
 			}
 		}
 
 		// postprocessing
+		StageScope postprocessScope(global::stageTimings, "postprocess");
 		for (unsigned int arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
 			std::cout << "postprocessing arena " << arenas[arenaNumber].getId() << std::endl;
+			const size_t frameCount = arenas[arenaNumber].getFrameCount();
+			StageScope arenaScope(global::stageTimings, "arena " + arenas[arenaNumber].getId(), frameCount);
+			StageTimer timer(global::stageTimings);
 
 			std::cout << "  prepareInterpolation" << std::endl;
 			arenas[arenaNumber].prepareInterpolation();
+			timer.lap("prepareInterpolation", frameCount);
 
 			std::cout << "  buildSequenceMaps" << std::endl;
 			arenas[arenaNumber].buildSequenceMaps();
+			timer.lap("buildSequenceMaps", frameCount);
 
 			std::cout << "  detectMissegmentations" << std::endl;
 			arenas[arenaNumber].detectMissegmentations(segmentation_minFlyBodySize, segmentation_maxFlyBodySize);
+			timer.lap("detectMissegmentations", frameCount);
 
 			std::cout << "  writing segmentation statistics" << std::endl;
 			{
@@ -346,16 +653,20 @@ int main(int argc, char* const argv[])
 				std::ofstream file(fileName.c_str());
 				arenas[arenaNumber].writeSegmentationStatistics(file);
 			}
+			timer.lap("writeSegmentationStatistics", frameCount);
 
 			std::cout << "  calculateTScores" << std::endl;
 			arenas[arenaNumber].calculateTScores(occlusions_tPos, occlusions_tBoc);
+			timer.lap("calculateTScores", frameCount);
 
 			std::cout << "  solveOcclusions" << std::endl;
 			arenas[arenaNumber].solveOcclusions(occlusions_sSize, discardMissegmentations);
+			timer.lap("solveOcclusions", frameCount);
 
 			if (annotation) {
 				std::cout << "  addAnnotations" << std::endl;
 				arenas[arenaNumber].addAnnotations(global::outDir + "/" + arenas[arenaNumber].getId() + "/annotation.tsv");
+				timer.lap("addAnnotations", frameCount);
 			}
 
 			std::cout << "  writing occlusion report" << std::endl;
@@ -364,45 +675,69 @@ int main(int argc, char* const argv[])
 				std::ofstream file(fileName.c_str());
 				arenas[arenaNumber].writeOcclusionReport(file);
 			}
+			timer.lap("writeOcclusionReport", frameCount);
 
 			std::cout << "  interpolateAttributes" << std::endl;
 			arenas[arenaNumber].interpolateAttributes();
+			timer.lap("interpolateAttributes", frameCount);
 
 			std::cout << "  deriveHeadingIndependentAttributes" << std::endl;
 			arenas[arenaNumber].deriveHeadingIndependentAttributes();
+			timer.lap("deriveHeadingIndependentAttributes", frameCount);
 
 			std::cout << "  solveHeading" << std::endl;
 			arenas[arenaNumber].solveHeading(heading_sMotion, heading_sWings, heading_sMaxMotionWings, heading_sColor, heading_tBefore);
+			timer.lap("solveHeading", frameCount);
 
 			std::cout << "  interpolateOrientation" << std::endl;
 			arenas[arenaNumber].interpolateOrientation();
+			timer.lap("interpolateOrientation", frameCount);
 
 			std::cout << "  selectQuadrants" << std::endl;
 			arenas[arenaNumber].selectQuadrants();
+			timer.lap("selectQuadrants", frameCount);
 
 			std::cout << "  deriveHeadingDependentAttributes" << std::endl;
 			arenas[arenaNumber].deriveHeadingDependentAttributes();
+			timer.lap("deriveHeadingDependentAttributes", frameCount);
 
 			std::cout << "  convertUnits" << std::endl;
 			arenas[arenaNumber].convertUnits();
+			timer.lap("convertUnits", frameCount);
 
 			std::cout << "  deriveEvents" << std::endl;
 			arenas[arenaNumber].deriveCopulating(copulating_medianFilterWidth, copulating_persistence);
+			timer.lap("deriveCopulating", frameCount);
 			arenas[arenaNumber].deriveOrienting(orienting_maxAngle, orienting_minDistance, orienting_maxDistance, orienting_maxSpeedSelf, orienting_maxSpeedOther, orienting_medianFilterWidth, orienting_persistence);
+			timer.lap("deriveOrienting", frameCount);
 			arenas[arenaNumber].deriveRayEllipseOrienting(rayEllipseOrienting_growthOther, rayEllipseOrienting_maxAngle, rayEllipseOrienting_minDistance, rayEllipseOrienting_maxDistance, rayEllipseOrienting_maxSpeedSelf, rayEllipseOrienting_maxSpeedOther, rayEllipseOrienting_medianFilterWidth, rayEllipseOrienting_persistence);
+			timer.lap("deriveRayEllipseOrienting", frameCount);
 			arenas[arenaNumber].deriveFollowing(following_maxChangeOfDistance, following_maxAngle, following_minDistance, following_maxDistance, following_minSpeed, following_maxMovementDirectionDifference, following_medianFilterWidth, following_persistence);
+			timer.lap("deriveFollowing", frameCount);
 			arenas[arenaNumber].deriveCircling(circling_minDistance, circling_maxDistance, circling_maxAngle, circling_minSpeedSelf, circling_maxSpeedOther, circling_minAngleDifference, circling_minSidewaysSpeed, circling_medianFilterWidth, circling_persistence);
+			timer.lap("deriveCircling", frameCount);
 			arenas[arenaNumber].deriveWingExt(wingExtension_minAngle, wingExtension_tailQuadrantAreaRatio, wingExtension_directionTolerance, wingExtension_minBoc, wingExtension_angleMedianFilterWidth, wingExtension_areaMedianFilterWidth, wingExtension_persistence);
+			timer.lap("deriveWingExt", frameCount);
 			arenas[arenaNumber].deriveCourtship(circlingWeight, copulatingWeight, followingWeight, orientingWeight, rayEllipseOrientingWeight, wingExtWeight);
+			timer.lap("deriveCourtship", frameCount);
 			arenas[arenaNumber].deriveNew();
+			timer.lap("deriveNew", frameCount);
 		}
 
+		postprocessScope.end();
+
 		// export the data
 		std::cout << "exporting the data" << std::endl;
+		StageScope exportScope(global::stageTimings, "export");
+		StageTimer exportTimer(global::stageTimings);
 		for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
-			std::string trackFileName(global::outDir + "/" + arenas[arenaNumber].getId() + "/track.tsv");
-			std::ofstream trackFile(trackFileName.c_str());
-			arenas[arenaNumber].exportTrackingData(trackFile);
+			arenas[arenaNumber].exportTrackFile(global::outDir + "/" + arenas[arenaNumber].getId() + "/track.bin");
+			if (trackTsv) {
+				std::string tsvFileName(global::outDir + "/" + arenas[arenaNumber].getId() + "/track.tsv");
+				std::ofstream tsvFile(tsvFileName.c_str());
+				arenas[arenaNumber].exportTrackingData(tsvFile);
+			}
+			exportTimer.lap("arena " + arenas[arenaNumber].getId() + "/track");
 		}
 
 		for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
@@ -414,9 +749,13 @@ int main(int argc, char* const argv[])
 
 				// create file to indicate successful tracking
 				std::ofstream((global::outDir + "/" + arenas[arenaNumber].getId() + "/track_done_success.txt").c_str()).close();
+				if (track) {
+					arenas[arenaNumber].removeCheckpoints();
+				}
 			} else {
 				std::cerr << "warning: could not create \"" << trackDirectory << "\"" << std::endl;
 			}
+			exportTimer.lap("arena " + arenas[arenaNumber].getId() + "/attributes");
 		}
 
 		for (size_t arenaNumber = 0; arenaNumber != arenas.size(); ++arenaNumber) {
@@ -446,6 +785,10 @@ int main(int argc, char* const argv[])
 			std::ofstream file(fileName.c_str());
 			arenas[arenaNumber].writePositionCorrelation(file);
 		}
+		exportTimer.lap("summaries");
+		exportScope.end();
+
+		writeStageTimings(arenas, benchmarkJson, profileTrace);
 
 	#if !defined(_DEBUG)
 	} catch (std::exception& e) {
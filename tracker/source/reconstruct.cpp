@@ -1,8 +1,98 @@
 #include "reconstruct.hpp"
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
 #include "../../common/source/arrayOperations.hpp"
 
+// a part of a row in which reconstruct() still has to look for pixels to fill
+struct ReconstructionRange {
+	int row;
+	int colBegin;
+	int colEnd;	// one past the last column
+};
+
+// the smallest rectangle containing all nonzero pixels of image, which is empty if there are none
+cv::Rect nonZeroBoundingBox(const cv::Mat& image)
+{
+	int rowBegin = image.rows;
+	int rowEnd = 0;
+	int colBegin = image.cols;
+	int colEnd = 0;
+	for (int row = 0; row != image.rows; ++row) {
+		const unsigned char* imageRow = image.ptr<unsigned char>(row);
+		int col = 0;
+		while (col != image.cols && !imageRow[col]) {
+			++col;
+		}
+		if (col == image.cols) {
+			continue;
+		}
+		rowBegin = std::min(rowBegin, row);
+		rowEnd = row + 1;
+		colBegin = std::min(colBegin, col);
+		col = image.cols;
+		while (!imageRow[col - 1]) {
+			--col;
+		}
+		colEnd = std::max(colEnd, col);
+	}
+	if (rowBegin >= rowEnd) {
+		return cv::Rect();
+	}
+	return cv::Rect(colBegin, rowBegin, colEnd - colBegin, rowEnd - rowBegin);
+}
+
+// queues the ranges around the pixels [colBegin, colEnd) of row, reaching one pixel further diagonally for 8-connectivity
+void pushNeighborRanges(std::vector<ReconstructionRange>& ranges, int row, int colBegin, int colEnd, int diagonalReach, bool includeRow, const cv::Rect& roi)
+{
+	ReconstructionRange range;
+	if (includeRow) {
+		range.row = row;
+		range.colBegin = std::max(colBegin - 1, roi.x);
+		range.colEnd = std::min(colEnd + 1, roi.x + roi.width);
+		ranges.push_back(range);
+	}
+	range.colBegin = std::max(colBegin - diagonalReach, roi.x);
+	range.colEnd = std::min(colEnd + diagonalReach, roi.x + roi.width);
+	if (row > roi.y) {
+		range.row = row - 1;
+		ranges.push_back(range);
+	}
+	if (row + 1 < roi.y + roi.height) {
+		range.row = row + 1;
+		ranges.push_back(range);
+	}
+}
+
+// fills every pixel that is set in mask but not yet in result and can be reached from the queued ranges
+void fillRanges(std::vector<ReconstructionRange>& ranges, const cv::Mat& mask, cv::Mat& result, int diagonalReach, const cv::Rect& roi)
+{
+	const int roiColEnd = roi.x + roi.width;
+	while (!ranges.empty()) {
+		ReconstructionRange range = ranges.back();
+		ranges.pop_back();
+		const unsigned char* maskRow = mask.ptr<unsigned char>(range.row);
+		unsigned char* resultRow = result.ptr<unsigned char>(range.row);
+		for (int col = range.colBegin; col < range.colEnd; ++col) {
+			if (!maskRow[col] || resultRow[col]) {
+				continue;
+			}
+			// grow the pixel into the longest span of fillable pixels in this row
+			int spanBegin = col;
+			while (spanBegin > roi.x && maskRow[spanBegin - 1] && !resultRow[spanBegin - 1]) {
+				--spanBegin;
+			}
+			int spanEnd = col + 1;
+			while (spanEnd < roiColEnd && maskRow[spanEnd] && !resultRow[spanEnd]) {
+				++spanEnd;
+			}
+			std::fill(resultRow + spanBegin, resultRow + spanEnd, 1);
+			pushNeighborRanges(ranges, range.row, spanBegin, spanEnd, diagonalReach, false, roi);	// the pixels left and right of the span cannot be filled
+			col = spanEnd;
+		}
+	}
+}
+
 cv::Mat reconstruct(const cv::Mat& marker, const cv::Mat& mask, unsigned int conn)
 {
 	if (marker.size() != mask.size()) {
@@ -13,6 +103,53 @@ cv::Mat reconstruct(const cv::Mat& marker, const cv::Mat& mask, unsigned int con
 		throw std::runtime_error("reconstruct: connectivity needs to be 4 or 8");
 	}
 
+	if (marker.elemSize() != 1 || mask.elemSize() != 1) {
+		throw std::runtime_error("reconstruct: requires single channel 8 bit Mat");
+	}
+
+	cv::Mat result = marker.clone();
+
+	// only pixels inside the mask can change, and only marker pixels inside or right next to it can make them change
+	cv::Rect roi = nonZeroBoundingBox(mask);
+	if (roi.area() == 0) {
+		return result;
+	}
+	roi = cv::Rect(roi.x - 1, roi.y - 1, roi.width + 2, roi.height + 2) & cv::Rect(0, 0, mask.cols, mask.rows);
+	const int roiColEnd = roi.x + roi.width;
+	const int diagonalReach = (conn == 8) ? 1 : 0;
+
+	// start filling from the neighbors of each horizontal run of marker pixels
+	std::vector<ReconstructionRange> ranges;
+	for (int row = roi.y; row != roi.y + roi.height; ++row) {
+		const unsigned char* markerRow = marker.ptr<unsigned char>(row);
+		int col = roi.x;
+		while (col != roiColEnd) {
+			if (!markerRow[col]) {
+				++col;
+				continue;
+			}
+			int runBegin = col;
+			while (col != roiColEnd && markerRow[col]) {
+				++col;
+			}
+			pushNeighborRanges(ranges, row, runBegin, col, diagonalReach, true, roi);
+			fillRanges(ranges, mask, result, diagonalReach, roi);
+		}
+	}
+
+	return result;
+}
+
+cv::Mat stackReconstruct(const cv::Mat& marker, const cv::Mat& mask, unsigned int conn)
+{
+	if (marker.size() != mask.size()) {
+		throw std::runtime_error("reconstruct: marker and mask sizes don't match");
+	}
+
+	if (conn != 4 && conn != 8) {
+		throw std::runtime_error("reconstruct: connectivity needs to be 4 or 8");
+	}
+
 	cv::Mat result = marker.clone();
 
 	if (!(marker.isContinuous() && mask.isContinuous() && result.isContinuous())) {
@@ -145,33 +282,15 @@ std::vector<bool> reconstruct(const std::vector<bool>& marker, const std::vector
 	std::vector<bool> result = marker;
 	const size_t elementCount = result.size();
 
-	std::vector<size_t> offsetsToFill; // we'll use this like a stack
-	offsetsToFill.reserve(elementCount / 16); // seems reasonable
-	
-	// push the offsets of the pixels which are set in the marker onto the stack
-	for (size_t offset = 0; offset != elementCount; ++offset) {
-		if (marker[offset]) {
-			offsetsToFill.push_back(offset);
+	// in 1D, a pixel is filled from the left or from the right, so one pass in each direction is enough
+	for (size_t offset = 1; offset < elementCount; ++offset) {
+		if (!result[offset] && mask[offset] && result[offset - 1]) {
+			result[offset] = true;
 		}
 	}
-
-	while (!offsetsToFill.empty()) {
-		// fill this pixel
-		size_t offset = offsetsToFill.back();
-		offsetsToFill.pop_back();
-		result[offset] = true;
-		
-		if (offset > 0) { // we may go left
-			size_t nextOffset = offset - 1;
-			if (!result[nextOffset] && mask[nextOffset]) {
-				offsetsToFill.push_back(nextOffset);
-			}
-		}
-		if (offset + 1 < elementCount) { // we may go right
-			size_t nextOffset = offset + 1;
-			if (!result[nextOffset] && mask[nextOffset]) {
-				offsetsToFill.push_back(nextOffset);
-			}
+	for (size_t offset = elementCount; offset-- > 1; ) {
+		if (!result[offset - 1] && mask[offset - 1] && result[offset]) {
+			result[offset - 1] = true;
 		}
 	}
 
@@ -187,33 +306,15 @@ std::vector<MyBool> reconstruct(const std::vector<MyBool>& marker, const std::ve
 	std::vector<MyBool> result = marker;
 	const size_t elementCount = result.size();
 
-	std::vector<size_t> offsetsToFill; // we'll use this like a stack
-	offsetsToFill.reserve(elementCount / 16); // seems reasonable
-	
-	// push the offsets of the pixels which are set in the marker onto the stack
-	for (size_t offset = 0; offset != elementCount; ++offset) {
-		if (marker[offset]) {
-			offsetsToFill.push_back(offset);
+	// in 1D, a pixel is filled from the left or from the right, so one pass in each direction is enough
+	for (size_t offset = 1; offset < elementCount; ++offset) {
+		if (!result[offset] && mask[offset] && result[offset - 1]) {
+			result[offset] = true;
 		}
 	}
-
-	while (!offsetsToFill.empty()) {
-		// fill this pixel
-		size_t offset = offsetsToFill.back();
-		offsetsToFill.pop_back();
-		result[offset] = true;
-		
-		if (offset > 0) { // we may go left
-			size_t nextOffset = offset - 1;
-			if (!result[nextOffset] && mask[nextOffset]) {
-				offsetsToFill.push_back(nextOffset);
-			}
-		}
-		if (offset + 1 < elementCount) { // we may go right
-			size_t nextOffset = offset + 1;
-			if (!result[nextOffset] && mask[nextOffset]) {
-				offsetsToFill.push_back(nextOffset);
-			}
+	for (size_t offset = elementCount; offset-- > 1; ) {
+		if (!result[offset - 1] && mask[offset - 1] && result[offset]) {
+			result[offset - 1] = true;
 		}
 	}
 
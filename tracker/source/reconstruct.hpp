@@ -9,7 +9,8 @@
 
 #include "../../common/source/MyBool.hpp"
 
-cv::Mat reconstruct(const cv::Mat& marker, const cv::Mat& mask, unsigned int conn);
+cv::Mat reconstruct(const cv::Mat& marker, const cv::Mat& mask, unsigned int conn);	// fills span by span, looking only at the bounding box of the mask
+cv::Mat stackReconstruct(const cv::Mat& marker, const cv::Mat& mask, unsigned int conn);	// same result, filled pixel by pixel from a stack; the reference for -benchmarkReconstruct
 std::vector<bool> reconstruct(const std::vector<bool>& marker, const std::vector<bool>& mask);	// 1D
 std::vector<MyBool> reconstruct(const std::vector<MyBool>& marker, const std::vector<MyBool>& mask);	// 1D
 
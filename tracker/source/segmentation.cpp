@@ -0,0 +1,295 @@
+#include "segmentation.hpp"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SEGMENTATION_SSE2
+	#include <emmintrin.h>
+#endif
+
+// the fixed-point weights OpenCV uses for CV_BGR2GRAY on 8 bit images, so that we get the same gray values as cvtColor
+const int grayShift = 14;
+const int grayBlueWeight = 1868;	// 0.114 * (1 << grayShift)
+const int grayGreenWeight = 9617;	// 0.587 * (1 << grayShift)
+const int grayRedWeight = 4899;	// 0.299 * (1 << grayShift)
+
+// remove vertically moving wave as found in some of our older movies by subtracting from each row its median
+cv::Mat removeVerticalWave(const cv::Mat& image)
+{
+	cv::Mat ret = image.clone();
+	for (int row = 0; row != ret.rows; ++row) {
+		unsigned char* retRowPointer = ret.ptr<uchar>(row);
+		unsigned char* medianPointer = retRowPointer + ret.cols / 2;
+		std::nth_element(retRowPointer, medianPointer, retRowPointer + ret.cols);
+		unsigned char median = *medianPointer;
+		const unsigned char* imageRowPointer = image.ptr<uchar>(row);
+		for (int col = 0; col != ret.cols; ++col) {
+			if (imageRowPointer[col] >= median) {
+				retRowPointer[col] = imageRowPointer[col] - median;
+			} else {
+				// saturate
+				retRowPointer[col] = 0;
+			}
+		}
+	}
+	return ret;
+}
+
+cv::Mat stretch(const cv::Mat& image, const unsigned char newMin, const unsigned char newMax)
+{
+	cv::Mat ret = image.clone();
+	float factor = 255.0f / (newMax - newMin);
+	for (size_t i = 0; i != image.rows * image.cols; ++i) {
+		float newValue = (image.data[i] - newMin) * factor;
+		if (newValue < 0.0f) {
+			newValue = 0.0f;
+		}
+		if (newValue >= 255.0f) {
+			newValue = 255.0f;
+		}
+		ret.data[i] = static_cast<unsigned char>(newValue);
+	}
+	return ret;
+}
+
+RowMedians::RowMedians() :
+	cols(0),
+	previousValues(),
+	histograms(),
+	medians(),
+	belowMedianCounts()
+{
+}
+
+void RowMedians::reset(int rows, int cols)
+{
+	this->cols = cols;
+	previousValues.assign(rows * cols, 0);
+	histograms.assign(rows * 256, 0);
+	medians.assign(rows, -1);
+	belowMedianCounts.assign(rows, 0);
+}
+
+unsigned char RowMedians::update(int row, const unsigned char* values)
+{
+	unsigned char* previous = &previousValues[row * cols];
+	int* histogram = &histograms[row * 256];
+	int median = medians[row];
+	int belowMedian = belowMedianCounts[row];
+	if (median < 0) {
+		std::fill(histogram, histogram + 256, 0);
+		for (int col = 0; col != cols; ++col) {
+			++histogram[values[col]];
+		}
+		median = 0;
+		belowMedian = 0;
+	} else {
+		for (int col = 0; col != cols; ++col) {
+			unsigned char oldValue = previous[col];
+			unsigned char newValue = values[col];
+			if (oldValue != newValue) {
+				--histogram[oldValue];
+				++histogram[newValue];
+				belowMedian += (newValue < median) - (oldValue < median);
+			}
+		}
+	}
+	std::copy(values, values + cols, previous);
+
+	// move the median until position cols / 2 falls into its bin
+	const int position = cols / 2;
+	while (belowMedian > position) {
+		--median;
+		belowMedian -= histogram[median];
+	}
+	while (belowMedian + histogram[median] <= position) {
+		belowMedian += histogram[median];
+		++median;
+	}
+	medians[row] = median;
+	belowMedianCounts[row] = belowMedian;
+	return static_cast<unsigned char>(median);
+}
+
+int RowMedians::getRowCount() const
+{
+	return static_cast<int>(medians.size());
+}
+
+int RowMedians::getColCount() const
+{
+	return cols;
+}
+
+unsigned char rowMedian(const unsigned char* row, int cols)
+{
+	int histogram[256] = {0};
+	for (int col = 0; col != cols; ++col) {
+		++histogram[row[col]];
+	}
+	const int position = cols / 2;
+	int belowMedian = 0;
+	int median = 0;
+	while (belowMedian + histogram[median] <= position) {
+		belowMedian += histogram[median];
+		++median;
+	}
+	return static_cast<unsigned char>(median);
+}
+
+void checkForegroundArguments(const cv::Mat& background, const cv::Mat& frame, const cv::Mat& mask)
+{
+	if (background.type() != CV_8UC3 || frame.type() != CV_8UC3 || mask.type() != CV_8UC1) {
+		throw std::invalid_argument("foreground segmentation needs 8 bit BGR images and an 8 bit mask");
+	}
+	if (background.size() != frame.size() || mask.size() != frame.size()) {
+		throw std::invalid_argument("background, frame and mask must be of the same size");
+	}
+}
+
+// difference = background - frame, saturated at 0
+void subtractSaturated(const unsigned char* background, const unsigned char* frame, unsigned char* difference, int byteCount)
+{
+	int i = 0;
+#ifdef SEGMENTATION_SSE2
+	for (; i + 16 <= byteCount; i += 16) {
+		__m128i backgroundChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + i));
+		__m128i frameChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(difference + i), _mm_subs_epu8(backgroundChunk, frameChunk));
+	}
+#endif
+	for (; i != byteCount; ++i) {
+		difference[i] = background[i] > frame[i] ? background[i] - frame[i] : 0;
+	}
+}
+
+// converts a row of BGR pixels to gray, rounding the way cvtColor does
+void bgrToGray(const unsigned char* bgr, unsigned char* gray, int cols)
+{
+	for (int col = 0; col != cols; ++col, bgr += 3) {
+		gray[col] = static_cast<unsigned char>((bgr[0] * grayBlueWeight + bgr[1] * grayGreenWeight + bgr[2] * grayRedWeight + (1 << (grayShift - 1))) >> grayShift);
+	}
+}
+
+// result = gray & mask
+void maskBytes(const unsigned char* gray, const unsigned char* mask, unsigned char* result, int cols)
+{
+	int col = 0;
+#ifdef SEGMENTATION_SSE2
+	for (; col + 16 <= cols; col += 16) {
+		__m128i grayChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + col));
+		__m128i maskChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + col));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(result + col), _mm_and_si128(grayChunk, maskChunk));
+	}
+#endif
+	for (; col != cols; ++col) {
+		result[col] = gray[col] & mask[col];
+	}
+}
+
+// result = (gray - median, saturated at 0) & mask & ~bodies
+void removeMedianAndMask(const unsigned char* gray, unsigned char median, const unsigned char* mask, const unsigned char* bodies, unsigned char* result, int cols)
+{
+	int col = 0;
+#ifdef SEGMENTATION_SSE2
+	__m128i medianChunk = _mm_set1_epi8(static_cast<char>(median));
+	for (; col + 16 <= cols; col += 16) {
+		__m128i grayChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + col));
+		__m128i maskChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + col));
+		__m128i bodyChunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bodies + col));
+		__m128i waveRemoved = _mm_subs_epu8(grayChunk, medianChunk);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(result + col), _mm_andnot_si128(bodyChunk, _mm_and_si128(waveRemoved, maskChunk)));
+	}
+#endif
+	for (; col != cols; ++col) {
+		unsigned char waveRemoved = gray[col] >= median ? gray[col] - median : 0;
+		result[col] = waveRemoved & mask[col] & ~bodies[col];
+	}
+}
+
+void grayForeground(const cv::Mat& background, const cv::Mat& frame, const cv::Mat& mask, cv::Mat& foreground)
+{
+	checkForegroundArguments(background, frame, mask);
+	foreground.create(frame.size(), CV_8UC1);
+	if (frame.empty()) {
+		return;
+	}
+	const int cols = frame.cols;
+	std::vector<unsigned char> difference(3 * cols);
+	for (int row = 0; row != frame.rows; ++row) {
+		subtractSaturated(background.ptr<uchar>(row), frame.ptr<uchar>(row), &difference[0], 3 * cols);
+		unsigned char* foregroundRow = foreground.ptr<uchar>(row);
+		bgrToGray(&difference[0], foregroundRow, cols);
+		maskBytes(foregroundRow, mask.ptr<uchar>(row), foregroundRow, cols);
+	}
+}
+
+void wingForeground(const cv::Mat& background, const cv::Mat& frame, const cv::Mat& mask, const cv::Mat& bodies, cv::Mat& wings, RowMedians* rowMedians)
+{
+	checkForegroundArguments(background, frame, mask);
+	if (bodies.type() != CV_8UC1 || bodies.size() != frame.size()) {
+		throw std::invalid_argument("bodies must be an 8 bit image of the same size as the frame");
+	}
+	wings.create(frame.size(), CV_8UC1);
+	if (frame.empty()) {
+		return;
+	}
+	const int cols = frame.cols;
+	if (rowMedians && (rowMedians->getRowCount() != frame.rows || rowMedians->getColCount() != cols)) {
+		rowMedians->reset(frame.rows, cols);
+	}
+	std::vector<unsigned char> difference(3 * cols);
+	std::vector<unsigned char> gray(cols);
+	for (int row = 0; row != frame.rows; ++row) {
+		subtractSaturated(background.ptr<uchar>(row), frame.ptr<uchar>(row), &difference[0], 3 * cols);
+		bgrToGray(&difference[0], &gray[0], cols);
+		unsigned char median = rowMedians ? rowMedians->update(row, &gray[0]) : rowMedian(&gray[0], cols);
+		removeMedianAndMask(&gray[0], median, mask.ptr<uchar>(row), bodies.ptr<uchar>(row), wings.ptr<uchar>(row), cols);
+	}
+}
+
+void checkVisualizationArguments(const cv::Mat& image, const cv::Mat& visualization)
+{
+	if (image.type() != CV_8UC1 || visualization.type() != CV_8UC3 || image.size() != visualization.size()) {
+		throw std::invalid_argument("visualization must be an 8 bit BGR image of the same size as the gray image");
+	}
+}
+
+void stretchAndVisualize(cv::Mat& image, const unsigned char newMin, const unsigned char newMax, cv::Mat& visualization)
+{
+	checkVisualizationArguments(image, visualization);
+
+	// stretching all 256 possible values once gives us a lookup table that matches stretch() by construction
+	cv::Mat allValues(1, 256, CV_8UC1);
+	for (int value = 0; value != 256; ++value) {
+		allValues.data[value] = static_cast<unsigned char>(value);
+	}
+	cv::Mat table = stretch(allValues, newMin, newMax);
+
+	for (int row = 0; row != image.rows; ++row) {
+		unsigned char* imageRow = image.ptr<uchar>(row);
+		unsigned char* visualizationRow = visualization.ptr<uchar>(row);
+		for (int col = 0; col != image.cols; ++col) {
+			unsigned char value = table.data[imageRow[col]];
+			imageRow[col] = value;
+			visualizationRow[3 * col] = value;
+			visualizationRow[3 * col + 1] = value;
+			visualizationRow[3 * col + 2] = value;
+		}
+	}
+}
+
+void visualizeGray(const cv::Mat& image, cv::Mat& visualization)
+{
+	checkVisualizationArguments(image, visualization);
+	for (int row = 0; row != image.rows; ++row) {
+		const unsigned char* imageRow = image.ptr<uchar>(row);
+		unsigned char* visualizationRow = visualization.ptr<uchar>(row);
+		for (int col = 0; col != image.cols; ++col) {
+			visualizationRow[3 * col] = imageRow[col];
+			visualizationRow[3 * col + 1] = imageRow[col];
+			visualizationRow[3 * col + 2] = imageRow[col];
+		}
+	}
+}
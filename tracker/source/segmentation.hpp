@@ -0,0 +1,61 @@
+#ifndef segmentation_hpp
+#define segmentation_hpp
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+/*
+The per-pixel steps Arena::track uses to get from a frame to the images it thresholds.
+removeVerticalWave() and stretch() are the straightforward versions, each of them a full pass over the image.
+The other functions fuse these steps with the OpenCV calls around them and produce exactly the same result,
+but walk through the arena row by row so that all intermediate values stay in the cache.
+The byte-wise operations use SSE2 where the compiler supports it.
+*/
+
+/*
+RowMedians finds the medians of the rows of a sequence of images of the same size, e.g. the foreground of an arena in consecutive frames.
+Each row keeps its histogram and its median from the previous image.
+Only the pixels that have changed since then are counted again, and the median is moved from its previous bin instead of being searched for from 0.
+This pays off if most pixels stay the same from frame to frame, which depends on the camera noise.
+*/
+class RowMedians {
+public:
+	RowMedians();
+
+	void reset(int rows, int cols);	// forgets all previous rows
+	unsigned char update(int row, const unsigned char* values);	// returns the median of the cols values, which replace the ones previously passed for this row
+
+	int getRowCount() const;
+	int getColCount() const;
+
+private:
+	int cols;
+	std::vector<unsigned char> previousValues;	// [row][col]
+	std::vector<int> histograms;	// [row][value]
+	std::vector<int> medians;	// [row], or -1 if the row hasn't been counted yet
+	std::vector<int> belowMedianCounts;	// [row], the number of values smaller than the median
+};
+
+// the value std::nth_element would put at position cols / 2, found by counting the values instead of moving them
+unsigned char rowMedian(const unsigned char* row, int cols);
+
+// subtract from each row its median
+cv::Mat removeVerticalWave(const cv::Mat& image);
+
+// stretch the histogram of an image so that values between newMin and newMax are mapped to the full range of the data type
+cv::Mat stretch(const cv::Mat& image, const unsigned char newMin, const unsigned char newMax);
+
+// same as: cvtColor(background - frame, foreground, CV_BGR2GRAY); foreground = foreground & mask;
+void grayForeground(const cv::Mat& background, const cv::Mat& frame, const cv::Mat& mask, cv::Mat& foreground);
+
+// same as: cvtColor(background - frame, wings, CV_BGR2GRAY); wings = removeVerticalWave(wings) & mask & ~bodies;
+// the row medians are counted with rowMedian() or, if rowMedians is given, updated from the previous call
+void wingForeground(const cv::Mat& background, const cv::Mat& frame, const cv::Mat& mask, const cv::Mat& bodies, cv::Mat& wings, RowMedians* rowMedians = NULL);
+
+// same as: image = stretch(image, newMin, newMax); followed by copying image into all three channels of visualization
+void stretchAndVisualize(cv::Mat& image, const unsigned char newMin, const unsigned char newMax, cv::Mat& visualization);
+
+// copies the gray image into all three channels of visualization, which has to be of the same size
+void visualizeGray(const cv::Mat& image, cv::Mat& visualization);
+
+#endif